@@ -0,0 +1,142 @@
+/*
+ * Copyright (C) 2016 Canonical, Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3, as published
+ * by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranties of
+ * MERCHANTABILITY, SATISFACTORY QUALITY, or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Author: Pete Woods <pete.woods@canonical.com>
+ */
+
+#include <common/DBusMenuLayoutItem.h>
+
+#include <QDBusMetaType>
+#include <QDBusVariant>
+
+using namespace hud::common;
+
+QDBusArgument & operator<<(QDBusArgument &a, const DBusMenuLayoutItem &item) {
+	a.beginStructure();
+	a << item.id << item.properties;
+
+	// the children are sent as variants, as D-Bus types can't recurse
+	a.beginArray(qMetaTypeId<QDBusVariant>());
+	for (const DBusMenuLayoutItem &child : item.children) {
+		a << QDBusVariant(QVariant::fromValue(child));
+	}
+	a.endArray();
+
+	a.endStructure();
+	return a;
+}
+
+const QDBusArgument & operator>>(const QDBusArgument &a,
+		DBusMenuLayoutItem &item) {
+	a.beginStructure();
+	a >> item.id >> item.properties;
+
+	item.children.clear();
+	a.beginArray();
+	while (!a.atEnd()) {
+		QDBusVariant variant;
+		a >> variant;
+
+		DBusMenuLayoutItem child;
+		variant.variant().value<QDBusArgument>() >> child;
+		item.children << child;
+	}
+	a.endArray();
+
+	a.endStructure();
+	return a;
+}
+
+QDBusArgument & operator<<(QDBusArgument &a, const DBusMenuItem &item) {
+	a.beginStructure();
+	a << item.id << item.properties;
+	a.endStructure();
+	return a;
+}
+
+const QDBusArgument & operator>>(const QDBusArgument &a, DBusMenuItem &item) {
+	a.beginStructure();
+	a >> item.id >> item.properties;
+	a.endStructure();
+	return a;
+}
+
+QDBusArgument & operator<<(QDBusArgument &a, const DBusMenuItemKeys &item) {
+	a.beginStructure();
+	a << item.id << item.properties;
+	a.endStructure();
+	return a;
+}
+
+const QDBusArgument & operator>>(const QDBusArgument &a,
+		DBusMenuItemKeys &item) {
+	a.beginStructure();
+	a >> item.id >> item.properties;
+	a.endStructure();
+	return a;
+}
+
+DBusMenuLayoutItem::DBusMenuLayoutItem() :
+		id(0) {
+}
+
+DBusMenuLayoutItem::~DBusMenuLayoutItem() {
+}
+
+DBusMenuLayoutItem * DBusMenuLayoutItem::find(int itemId) {
+	if (id == itemId) {
+		return this;
+	}
+
+	for (DBusMenuLayoutItem &child : children) {
+		DBusMenuLayoutItem *item(child.find(itemId));
+		if (item) {
+			return item;
+		}
+	}
+
+	return nullptr;
+}
+
+void DBusMenuLayoutItem::registerMetaTypes() {
+	qRegisterMetaType<DBusMenuLayoutItem>();
+	qDBusRegisterMetaType<DBusMenuLayoutItem>();
+
+	qRegisterMetaType<DBusMenuItem>();
+	qDBusRegisterMetaType<DBusMenuItem>();
+
+	qRegisterMetaType<DBusMenuItemList>();
+	qDBusRegisterMetaType<DBusMenuItemList>();
+
+	qRegisterMetaType<DBusMenuItemKeys>();
+	qDBusRegisterMetaType<DBusMenuItemKeys>();
+
+	qRegisterMetaType<DBusMenuItemKeysList>();
+	qDBusRegisterMetaType<DBusMenuItemKeysList>();
+}
+
+DBusMenuItem::DBusMenuItem() :
+		id(0) {
+}
+
+DBusMenuItem::~DBusMenuItem() {
+}
+
+DBusMenuItemKeys::DBusMenuItemKeys() :
+		id(0) {
+}
+
+DBusMenuItemKeys::~DBusMenuItemKeys() {
+}
@@ -0,0 +1,113 @@
+/*
+ * Copyright (C) 2016 Canonical, Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3, as published
+ * by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranties of
+ * MERCHANTABILITY, SATISFACTORY QUALITY, or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Author: Pete Woods <pete.woods@canonical.com>
+ */
+
+#ifndef HUD_COMMON_DBUSMENULAYOUTITEM_H_
+#define HUD_COMMON_DBUSMENULAYOUTITEM_H_
+
+#include <QDBusArgument>
+#include <QList>
+#include <QStringList>
+#include <QVariantMap>
+
+namespace hud {
+namespace common {
+
+/**
+ * A menu item, and its children, as sent by com.canonical.dbusmenu
+ */
+class DBusMenuLayoutItem {
+public:
+	int id;
+	QVariantMap properties;
+	QList<DBusMenuLayoutItem> children;
+
+	explicit DBusMenuLayoutItem();
+
+	virtual ~DBusMenuLayoutItem();
+
+	/**
+	 * This item, or the descendant with the given ID. Returns null if there
+	 * isn't one.
+	 */
+	DBusMenuLayoutItem * find(int itemId);
+
+	static void registerMetaTypes();
+};
+
+/**
+ * The new properties of a menu item, as sent by ItemsPropertiesUpdated
+ */
+class DBusMenuItem {
+public:
+	int id;
+	QVariantMap properties;
+
+	explicit DBusMenuItem();
+
+	virtual ~DBusMenuItem();
+};
+
+typedef QList<DBusMenuItem> DBusMenuItemList;
+
+/**
+ * The names of a menu item's properties that went back to their defaults
+ */
+class DBusMenuItemKeys {
+public:
+	int id;
+	QStringList properties;
+
+	explicit DBusMenuItemKeys();
+
+	virtual ~DBusMenuItemKeys();
+};
+
+typedef QList<DBusMenuItemKeys> DBusMenuItemKeysList;
+
+}
+}
+
+Q_DECL_EXPORT
+QDBusArgument &operator<<(QDBusArgument &a,
+		const hud::common::DBusMenuLayoutItem &item);
+
+Q_DECL_EXPORT
+const QDBusArgument &operator>>(const QDBusArgument &a,
+		hud::common::DBusMenuLayoutItem &item);
+
+Q_DECL_EXPORT
+QDBusArgument &operator<<(QDBusArgument &a,
+		const hud::common::DBusMenuItem &item);
+
+Q_DECL_EXPORT
+const QDBusArgument &operator>>(const QDBusArgument &a,
+		hud::common::DBusMenuItem &item);
+
+Q_DECL_EXPORT
+QDBusArgument &operator<<(QDBusArgument &a,
+		const hud::common::DBusMenuItemKeys &item);
+
+Q_DECL_EXPORT
+const QDBusArgument &operator>>(const QDBusArgument &a,
+		hud::common::DBusMenuItemKeys &item);
+
+Q_DECLARE_METATYPE(hud::common::DBusMenuLayoutItem)
+Q_DECLARE_METATYPE(hud::common::DBusMenuItem)
+Q_DECLARE_METATYPE(hud::common::DBusMenuItemKeys)
+
+#endif /* HUD_COMMON_DBUSMENULAYOUTITEM_H_ */
@@ -19,9 +19,11 @@
 #include <common/DBusTypes.h>
 #include <common/Action.h>
 #include <common/ActionGroup.h>
+#include <common/DBusMenuLayoutItem.h>
 #include <common/Description.h>
 #include <common/MenuModel.h>
 #include <common/NameObject.h>
+#include <common/Source.h>
 #include <common/Suggestion.h>
 #include <common/WindowInfo.h>
 
@@ -53,6 +55,8 @@ void DBusTypes::registerMetaTypes() {
 	ActionGroup::registerMetaTypes();
 	Description::registerMetaTypes();
 	MenuModel::registerMetaTypes();
+	Source::registerMetaTypes();
+	DBusMenuLayoutItem::registerMetaTypes();
 }
 
 QString DBusTypes::queryPath(unsigned int id) {
@@ -24,6 +24,7 @@
 #include <common/Description.h>
 #include <common/MenuModel.h>
 #include <common/NameObject.h>
+#include <common/Source.h>
 #include <common/Suggestion.h>
 
 namespace hud {
@@ -0,0 +1,95 @@
+/*
+ * Copyright (C) 2016 Canonical, Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3, as published
+ * by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranties of
+ * MERCHANTABILITY, SATISFACTORY QUALITY, or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Author: Pete Woods <pete.woods@canonical.com>
+ */
+
+#include <common/MenuTree.h>
+
+using namespace hud::common;
+
+const int MenuTree::ROOT;
+
+MenuTree::MenuTree() {
+	Node root;
+	root.m_flags = ENABLED | SUBMENU;
+	m_nodes.push_back(root);
+}
+
+MenuTree::~MenuTree() {
+}
+
+int MenuTree::append(int parent, const Node &node) {
+	Q_ASSERT(parent >= 0 && parent < size());
+	Q_ASSERT(parent + m_nodes[parent].m_size == size());
+
+	int index(size());
+	m_nodes.push_back(node);
+
+	Node &added(m_nodes.back());
+	added.m_parent = parent;
+	added.m_size = 1;
+
+	for (int i(parent); i != -1; i = m_nodes[i].m_parent) {
+		++m_nodes[i].m_size;
+	}
+
+	return index;
+}
+
+int MenuTree::size() const {
+	return m_nodes.size();
+}
+
+const MenuTree::Node & MenuTree::node(int index) const {
+	return m_nodes[index];
+}
+
+int MenuTree::firstChild(int index) const {
+	return m_nodes[index].m_size > 1 ? index + 1 : -1;
+}
+
+int MenuTree::nextSibling(int index) const {
+	int parent(m_nodes[index].m_parent);
+	if (parent == -1) {
+		return -1;
+	}
+
+	int next(index + m_nodes[index].m_size);
+	if (next >= parent + m_nodes[parent].m_size) {
+		return -1;
+	}
+	return next;
+}
+
+void MenuTree::setFlag(Flag flag, bool on) {
+	for (Node &node : m_nodes) {
+		if (on) {
+			node.m_flags |= flag;
+		} else {
+			node.m_flags &= ~quint32(flag);
+		}
+	}
+}
+
+void MenuTree::setActivator(const Activator &activator) {
+	m_activator = activator;
+}
+
+void MenuTree::activate(int index) const {
+	if (m_activator && index > ROOT && index < size()) {
+		m_activator(*this, index);
+	}
+}
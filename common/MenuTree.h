@@ -0,0 +1,124 @@
+/*
+ * Copyright (C) 2016 Canonical, Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3, as published
+ * by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranties of
+ * MERCHANTABILITY, SATISFACTORY QUALITY, or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Author: Pete Woods <pete.woods@canonical.com>
+ */
+
+#ifndef HUD_COMMON_MENUTREE_H_
+#define HUD_COMMON_MENUTREE_H_
+
+#include <QSharedPointer>
+#include <QString>
+
+#include <functional>
+#include <vector>
+
+namespace hud {
+namespace common {
+
+/**
+ * A read-only snapshot of a menu, for indexing.
+ *
+ * The nodes live in a single array in depth-first order, with node 0 as the
+ * (label-less) root. Each node records how many nodes its subtree spans, so
+ * walking the tree never chases pointers.
+ *
+ * Nothing is executed through the tree directly; the menu source provides
+ * an activator that knows how to trigger a node.
+ */
+class MenuTree {
+public:
+	typedef QSharedPointer<MenuTree> Ptr;
+
+	typedef std::function<void(const MenuTree &tree, int node)> Activator;
+
+	static const int ROOT = 0;
+
+	enum Flag {
+		ENABLED = 1 << 0,
+		SEPARATOR = 1 << 1,
+		SUBMENU = 1 << 2,
+		PARAMETERIZED = 1 << 3,
+		SEARCH_BY_MNEMONIC = 1 << 4
+	};
+
+	struct Node {
+		/* The label, with '&' marking the mnemonic */
+		QString m_label;
+
+		QString m_accel;
+
+		QString m_actionName;
+
+		/* Null if the item doesn't provide any keywords */
+		QString m_keywords;
+
+		QString m_toolbarItem;
+
+		/* Where to find a parameterized action's own menu */
+		QString m_busName;
+
+		QString m_actionsPath;
+
+		QString m_menuPath;
+
+		int m_parent = -1;
+
+		int m_size = 1;
+
+		quint32 m_flags = ENABLED;
+
+		/* Lets the activator find the source's own representation */
+		quint32 m_handle = 0;
+
+		bool flag(Flag flag) const {
+			return (m_flags & flag) != 0;
+		}
+	};
+
+	MenuTree();
+
+	virtual ~MenuTree();
+
+	/**
+	 * Adds a node as the last child of parent. Nodes must be added in
+	 * depth-first order, so parent's subtree has to be the last one open.
+	 */
+	int append(int parent, const Node &node);
+
+	int size() const;
+
+	const Node & node(int index) const;
+
+	int firstChild(int index) const;
+
+	int nextSibling(int index) const;
+
+	void setFlag(Flag flag, bool on);
+
+	void setActivator(const Activator &activator);
+
+	void activate(int index) const;
+
+protected:
+	std::vector<Node> m_nodes;
+
+	Activator m_activator;
+};
+
+}
+}
+
+#endif /* HUD_COMMON_MENUTREE_H_ */
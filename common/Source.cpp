@@ -0,0 +1,53 @@
+/*
+ * Copyright (C) 2016 Canonical, Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3, as published
+ * by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranties of
+ * MERCHANTABILITY, SATISFACTORY QUALITY, or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Author: Pete Woods <pete.woods@canonical.com>
+ */
+
+#include <common/Source.h>
+
+#include <QDBusMetaType>
+
+using namespace hud::common;
+
+QDBusArgument & operator<<(QDBusArgument &argument, const Source &source) {
+	argument.beginStructure();
+	argument << source.m_windowId << source.m_context;
+	argument.endStructure();
+	return argument;
+}
+
+const QDBusArgument & operator>>(const QDBusArgument &argument,
+		Source &source) {
+	argument.beginStructure();
+	argument >> source.m_windowId >> source.m_context;
+	argument.endStructure();
+	return argument;
+}
+
+Source::Source() :
+		m_windowId(0) {
+}
+
+Source::~Source() {
+}
+
+void Source::registerMetaTypes() {
+	qRegisterMetaType<Source>();
+	qDBusRegisterMetaType<Source>();
+
+	qRegisterMetaType<QList<Source>>();
+	qDBusRegisterMetaType<QList<Source>>();
+}
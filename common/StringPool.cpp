@@ -0,0 +1,152 @@
+/*
+ * Copyright (C) 2016 Canonical, Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3, as published
+ * by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranties of
+ * MERCHANTABILITY, SATISFACTORY QUALITY, or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Author: Pete Woods <pete.woods@canonical.com>
+ */
+
+#include <common/StringPool.h>
+
+#include <QMutexLocker>
+
+using namespace hud::common;
+
+/* Purging walks the whole pool, so small pools aren't worth the bother */
+static const int MIN_PURGE_SIZE = 1024;
+
+StringPool & StringPool::instance() {
+	static StringPool pool;
+	return pool;
+}
+
+StringPool::StringPool() :
+		m_bytes(0), m_purgeSize(MIN_PURGE_SIZE) {
+}
+
+StringPool::~StringPool() {
+}
+
+bool StringPool::lookup(const QString &string, Id &id) const {
+	uint hash(qHash(string));
+	for (auto it(m_ids.constFind(hash)); it != m_ids.constEnd(); ++it) {
+		if (it.key() != hash) {
+			break;
+		}
+		if (m_entries.at(it.value()).m_string == string) {
+			id = it.value();
+			return true;
+		}
+	}
+	return false;
+}
+
+StringPool::Id StringPool::insert(const QString &string) {
+	Id id;
+	if (lookup(string, id)) {
+		return id;
+	}
+
+	if (m_entries.size() - m_free.size() >= m_purgeSize) {
+		purgeLocked();
+		m_purgeSize = qMax(MIN_PURGE_SIZE,
+				(m_entries.size() - m_free.size()) * 2);
+	}
+
+	Entry entry { string, 0 };
+	if (m_free.isEmpty()) {
+		id = m_entries.size();
+		m_entries.append(entry);
+	} else {
+		id = m_free.takeLast();
+		m_entries[id] = entry;
+	}
+	m_ids.insert(qHash(string), id);
+	m_bytes += string.size() * sizeof(QChar);
+
+	return id;
+}
+
+QString StringPool::intern(const QString &string) {
+	QMutexLocker lock(&m_mutex);
+	return m_entries.at(insert(string)).m_string;
+}
+
+StringPool::Id StringPool::acquire(const QString &string) {
+	QMutexLocker lock(&m_mutex);
+	Id id(insert(string));
+	++m_entries[id].m_refs;
+	return id;
+}
+
+void StringPool::release(Id id) {
+	QMutexLocker lock(&m_mutex);
+	if (id < Id(m_entries.size()) && m_entries.at(id).m_refs > 0) {
+		--m_entries[id].m_refs;
+	}
+}
+
+bool StringPool::find(const QString &string, Id &id) const {
+	QMutexLocker lock(&m_mutex);
+	return lookup(string, id);
+}
+
+QString StringPool::string(Id id) const {
+	QMutexLocker lock(&m_mutex);
+	if (id >= Id(m_entries.size()) || m_entries.at(id).m_refs < 0) {
+		return QString();
+	}
+	return m_entries.at(id).m_string;
+}
+
+int StringPool::purge() {
+	QMutexLocker lock(&m_mutex);
+	return purgeLocked();
+}
+
+int StringPool::purgeLocked() {
+	int purged(0);
+	for (int i(0); i < m_entries.size(); ++i) {
+		Entry &entry(m_entries[i]);
+		// nobody holds an ID, and the pool's copy is the only one left
+		if (entry.m_refs != 0 || !entry.m_string.isDetached()) {
+			continue;
+		}
+
+		m_ids.remove(qHash(entry.m_string), i);
+		m_bytes -= entry.m_string.size() * sizeof(QChar);
+		entry.m_string = QString();
+		entry.m_refs = -1;
+		m_free.append(i);
+		++purged;
+	}
+	return purged;
+}
+
+int StringPool::size() const {
+	QMutexLocker lock(&m_mutex);
+	return m_entries.size() - m_free.size();
+}
+
+qint64 StringPool::bytes() const {
+	QMutexLocker lock(&m_mutex);
+	return m_bytes;
+}
+
+qint64 StringPool::savedBytes(const QString &original,
+		const QString &interned) {
+	if (original.constData() == interned.constData()) {
+		return 0;
+	}
+	return original.size() * sizeof(QChar);
+}
@@ -0,0 +1,123 @@
+/*
+ * Copyright (C) 2016 Canonical, Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3, as published
+ * by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranties of
+ * MERCHANTABILITY, SATISFACTORY QUALITY, or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Author: Pete Woods <pete.woods@canonical.com>
+ */
+
+#ifndef HUD_COMMON_STRINGPOOL_H_
+#define HUD_COMMON_STRINGPOOL_H_
+
+#include <QHash>
+#include <QMutex>
+#include <QString>
+#include <QVector>
+
+namespace hud {
+namespace common {
+
+/**
+ * The process wide pool of interned strings.
+ *
+ * Interning a string returns the pool's copy, which shares its data with
+ * every other interned copy, so the duplicate can be freed. Callers that
+ * would rather key on a number can acquire an ID for a string instead,
+ * which stays the same until they release it.
+ *
+ * The pool drops a string once nobody holds an interned copy or an ID for
+ * it, looking for ones it can drop each time it doubles in size. It is
+ * safe to use from any thread.
+ */
+class StringPool {
+public:
+	typedef uint Id;
+
+	static StringPool & instance();
+
+	QString intern(const QString &string);
+
+	/**
+	 * Takes a reference on the ID for string, adding it if needed
+	 */
+	Id acquire(const QString &string);
+
+	void release(Id id);
+
+	/**
+	 * Looks up the ID of string without adding it to the pool
+	 */
+	bool find(const QString &string, Id &id) const;
+
+	QString string(Id id) const;
+
+	/**
+	 * Drops the strings nobody but the pool holds any more, returning how
+	 * many went
+	 */
+	int purge();
+
+	/**
+	 * The number of distinct strings in the pool
+	 */
+	int size() const;
+
+	/**
+	 * The bytes of character data held by the pool
+	 */
+	qint64 bytes() const;
+
+	/**
+	 * The bytes a caller's copy stops costing once it is replaced with
+	 * the interned one.
+	 */
+	static qint64 savedBytes(const QString &original, const QString &interned);
+
+protected:
+	StringPool();
+
+	virtual ~StringPool();
+
+	struct Entry {
+		QString m_string;
+
+		/* References taken through acquire(), or -1 for a free slot */
+		int m_refs;
+	};
+
+	Id insert(const QString &string);
+
+	bool lookup(const QString &string, Id &id) const;
+
+	int purgeLocked();
+
+	mutable QMutex m_mutex;
+
+	/* Keyed by hash, so the pool's own copy is the only one it holds */
+	QMultiHash<uint, Id> m_ids;
+
+	QVector<Entry> m_entries;
+
+	/* Slots left by purged strings, reused by new ones */
+	QVector<Id> m_free;
+
+	qint64 m_bytes;
+
+	/* The size at which a new string next triggers a purge */
+	int m_purgeSize;
+};
+
+}
+}
+
+#endif /* HUD_COMMON_STRINGPOOL_H_ */
@@ -16,6 +16,7 @@
 
 #include <libhud-client/hud-client.h>
 #include <libhud-client/HudClient.h>
+#include <libhud-client/HudResultsModel.h>
 #include <libhud-client/HudToolbarModel.h>
 #include <deelistmodel.h>
 
@@ -135,6 +136,51 @@ public:
 		g_variant_unref(v);
 	}
 
+	static const char * const * sliderAttributes(uint &count) {
+		static const char *attributes[] = { "label", "min", "max", "step",
+				"value", "live", "action" };
+		count = sizeof(attributes) / sizeof(attributes[0]);
+		return attributes;
+	}
+
+	/* Draws the pane straight from the attributes the service prefetched */
+	void parametersReady(GVariant *parameters) {
+		QVariantList items;
+		GVariantIter iter;
+		g_variant_iter_init(&iter, parameters);
+		GVariant *child;
+		while ((child = g_variant_iter_next_value(&iter)) != NULL) {
+			GVariant *attributes = g_variant_get_variant(child);
+			g_variant_unref(child);
+			if (!g_variant_is_of_type(attributes, G_VARIANT_TYPE_VARDICT)) {
+				g_variant_unref(attributes);
+				continue;
+			}
+
+			const gchar *type = NULL;
+			if (g_variant_lookup(attributes, "parameter-type", "&s", &type)
+					&& g_strcmp0(type, "slider") == 0) {
+				QVariantMap properties;
+				properties.insert("parameter-type", "slider");
+
+				uint count;
+				const char * const *names = sliderAttributes(count);
+				for (uint j = 0; j < count; ++j) {
+					GVariant *v = g_variant_lookup_value(attributes,
+							names[j], NULL);
+					if (v != NULL) {
+						properties.insert(names[j], QVariantFromGVariant(v));
+						g_variant_unref(v);
+					}
+				}
+				items << properties;
+			}
+			g_variant_unref(attributes);
+		}
+
+		emitParametrizedAction(items);
+	}
+
 	void modelReallyReady(bool needDisconnect) {
 		GMenuModel *menuModel = hud_client_param_get_model(
 				m_currentActionParam);
@@ -154,21 +200,23 @@ public:
 			const QString type = QString::fromUtf8(
 					g_variant_get_string(v, NULL));
 			if (type == "slider") {
-				const char *sliderAttributes[] = { "label", "min", "max",
-						"step", "value", "live", "action" };
 				QVariantMap properties;
 				properties.insert("parameter-type", "slider");
-				for (uint j = 0;
-						j
-								< sizeof(sliderAttributes)
-										/ sizeof(sliderAttributes[0]); ++j) {
-					addAttribute(properties, menuModel, i, sliderAttributes[j]);
+
+				uint count;
+				const char * const *names = sliderAttributes(count);
+				for (uint j = 0; j < count; ++j) {
+					addAttribute(properties, menuModel, i, names[j]);
 				}
 				items << properties;
 			}
 			g_variant_unref(v);
 		}
 
+		emitParametrizedAction(items);
+	}
+
+	void emitParametrizedAction(const QVariantList &items) {
 		DeeModel *model = hud_client_query_get_results_model(m_clientQuery);
 		DeeModelIter *iter = dee_model_get_iter_at_row(model,
 				m_currentActionIndex);
@@ -190,7 +238,7 @@ public:
 
 	HudClientQuery *m_clientQuery;
 
-	QScopedPointer<DeeListModel> m_results;
+	QScopedPointer<HudResultsModel> m_results;
 
 	QScopedPointer<DeeListModel> m_appstack;
 
@@ -204,7 +252,7 @@ public:
 HudClient::HudClient() :
 		p(new Priv(*this)) {
 	p->m_clientQuery = hud_client_query_new("");
-	p->m_results.reset(new DeeListModel());
+	p->m_results.reset(new HudResultsModel());
 	p->m_appstack.reset(new DeeListModel());
 	p->m_toolBarModel.reset(new HudToolBarModel(p->m_clientQuery));
 	p->m_currentActionParam = NULL;
@@ -247,8 +295,9 @@ HudClient::~HudClient() {
 }
 
 void HudClient::setQuery(const QString &new_query) {
-	hud_client_query_set_query(p->m_clientQuery,
-			new_query.toUtf8().constData());
+	// keystrokes arriving while the service searches are coalesced
+	hud_client_query_set_query_async(p->m_clientQuery,
+			new_query.toUtf8().constData(), NULL);
 }
 
 void HudClient::setAppstackApp(const QString &applicationId) {
@@ -281,7 +330,9 @@ void HudClient::updateParametrizedAction(const QVariant &values) {
 			const GVariantType *actionType =
 					g_action_group_get_action_parameter_type(ag,
 							action.toUtf8().constData());
-			if (g_variant_type_equal(actionType, G_VARIANT_TYPE_DOUBLE)
+			// a prefetched pane can be in use before the actions arrive
+			if ((actionType == NULL
+					|| g_variant_type_equal(actionType, G_VARIANT_TYPE_DOUBLE))
 					&& value.canConvert(QVariant::Double)) {
 				g_action_group_activate_action(ag, action.toUtf8().constData(),
 						g_variant_new_double(value.toDouble()));
@@ -332,9 +383,13 @@ void HudClient::executeCommand(int index) {
 		p->m_currentActionParam = hud_client_query_execute_param_command(
 				p->m_clientQuery, command_key, /* timestamp */0);
 		if (p->m_currentActionParam != NULL) {
+			GVariant *parameters = hud_client_param_get_parameters(
+					p->m_currentActionParam);
 			GMenuModel *menuModel = hud_client_param_get_model(
 					p->m_currentActionParam);
-			if (menuModel == NULL) {
+			if (parameters != NULL) {
+				p->parametersReady(parameters);
+			} else if (menuModel == NULL) {
 				g_signal_connect(p->m_currentActionParam,
 						HUD_CLIENT_PARAM_SIGNAL_MODEL_READY,
 						G_CALLBACK(Priv::modelReadyCB), p.data());
@@ -0,0 +1,361 @@
+/*
+ * Copyright (C) 2016 Canonical, Ltd.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <libhud-client/HudResultsModel.h>
+#include <common/query-columns.h>
+
+#include <dee.h>
+
+#include <QSet>
+#include <algorithm>
+#include <vector>
+
+using namespace hud::client;
+
+static QVariant toQVariant(GVariant *value) {
+	switch (g_variant_classify(value)) {
+	case G_VARIANT_CLASS_BOOLEAN:
+		return QVariant((bool) g_variant_get_boolean(value));
+	case G_VARIANT_CLASS_INT32:
+		return QVariant(g_variant_get_int32(value));
+	case G_VARIANT_CLASS_UINT32:
+		return QVariant(g_variant_get_uint32(value));
+	case G_VARIANT_CLASS_INT64:
+		return QVariant((qlonglong) g_variant_get_int64(value));
+	case G_VARIANT_CLASS_UINT64:
+		return QVariant((qulonglong) g_variant_get_uint64(value));
+	case G_VARIANT_CLASS_DOUBLE:
+		return QVariant(g_variant_get_double(value));
+	case G_VARIANT_CLASS_STRING:
+	case G_VARIANT_CLASS_OBJECT_PATH:
+		return QVariant(QString::fromUtf8(g_variant_get_string(value, NULL)));
+	case G_VARIANT_CLASS_VARIANT: {
+		GVariant *inner = g_variant_get_variant(value);
+		QVariant result(toQVariant(inner));
+		g_variant_unref(inner);
+		return result;
+	}
+	case G_VARIANT_CLASS_ARRAY:
+	case G_VARIANT_CLASS_TUPLE: {
+		QVariantList list;
+		gsize size = g_variant_n_children(value);
+		for (gsize i = 0; i < size; ++i) {
+			GVariant *child = g_variant_get_child_value(value, i);
+			list << toQVariant(child);
+			g_variant_unref(child);
+		}
+		return list;
+	}
+	default:
+		return QVariant();
+	}
+}
+
+class HudResultsModel::Priv {
+public:
+	explicit Priv(HudResultsModel &model) :
+			m_model(model), m_deeModel(nullptr), m_columns(0), m_inChangeset(
+					false), m_rowAdded(0), m_rowRemoved(0), m_rowChanged(0), m_changesetStarted(
+					0), m_changesetFinished(0) {
+	}
+
+	static void rowAddedCB(DeeModel* /*src*/, DeeModelIter *iter,
+			gpointer dst) {
+		static_cast<Priv*>(dst)->rowAdded(iter);
+	}
+
+	static void rowRemovedCB(DeeModel* /*src*/, DeeModelIter *iter,
+			gpointer dst) {
+		static_cast<Priv*>(dst)->rowRemoved(iter);
+	}
+
+	static void rowChangedCB(DeeModel* /*src*/, DeeModelIter *iter,
+			gpointer dst) {
+		static_cast<Priv*>(dst)->rowChanged(iter);
+	}
+
+	static void changesetStartedCB(DeeModel* /*src*/, gpointer dst) {
+		static_cast<Priv*>(dst)->m_inChangeset = true;
+	}
+
+	static void changesetFinishedCB(DeeModel* /*src*/, gpointer dst) {
+		static_cast<Priv*>(dst)->changesetFinished();
+	}
+
+	int rows() const {
+		return m_columns == 0 ? 0 : m_values.size() / m_columns;
+	}
+
+	qulonglong commandId(const std::vector<QVariant> &values, int row) const {
+		return values[row * m_columns + HUD_QUERY_RESULTS_COMMAND_ID].toULongLong();
+	}
+
+	void convertRows(std::vector<QVariant> &values) {
+		values.resize(dee_model_get_n_rows(m_deeModel) * m_columns);
+		auto out = values.begin();
+		DeeModelIter *iter = dee_model_get_first_iter(m_deeModel);
+		DeeModelIter *end = dee_model_get_last_iter(m_deeModel);
+		for (; iter != end; iter = dee_model_next(m_deeModel, iter)) {
+			convertRow(iter, out);
+			out += m_columns;
+		}
+	}
+
+	void convertRow(DeeModelIter *iter, std::vector<QVariant>::iterator out) {
+		for (int column = 0; column < m_columns; ++column) {
+			GVariant *value = dee_model_get_value(m_deeModel, iter, column);
+			*out++ = toQVariant(value);
+			g_variant_unref(value);
+		}
+	}
+
+	void rowAdded(DeeModelIter *iter) {
+		if (m_inChangeset) {
+			return;
+		}
+
+		int row = dee_model_get_position(m_deeModel, iter);
+
+		m_model.beginInsertRows(QModelIndex(), row, row);
+		auto it = m_values.insert(m_values.begin() + row * m_columns,
+				m_columns, QVariant());
+		convertRow(iter, it);
+		m_model.endInsertRows();
+
+		Q_EMIT m_model.countChanged();
+	}
+
+	void rowRemoved(DeeModelIter *iter) {
+		if (m_inChangeset) {
+			return;
+		}
+
+		// Emitted before the row goes, so it still has its position
+		int row = dee_model_get_position(m_deeModel, iter);
+
+		m_model.beginRemoveRows(QModelIndex(), row, row);
+		auto it = m_values.begin() + row * m_columns;
+		m_values.erase(it, it + m_columns);
+		m_model.endRemoveRows();
+
+		Q_EMIT m_model.countChanged();
+	}
+
+	void rowChanged(DeeModelIter *iter) {
+		if (m_inChangeset) {
+			return;
+		}
+
+		int row = dee_model_get_position(m_deeModel, iter);
+
+		convertRow(iter, m_values.begin() + row * m_columns);
+
+		QModelIndex index(m_model.index(row));
+		Q_EMIT m_model.dataChanged(index, index);
+	}
+
+	/*
+	 * The service replaces every row each time the query changes, so rather
+	 * than following each row through the changeset, match the rows up by
+	 * command ID once it's done. Rows that stay are moved or updated in place.
+	 */
+	void changesetFinished() {
+		m_inChangeset = false;
+
+		std::vector<QVariant> values;
+		convertRows(values);
+		const int oldRows(rows());
+		const int newRows(values.size() / m_columns);
+
+		QSet<qulonglong> newIds;
+		for (int row = 0; row < newRows; ++row) {
+			newIds << commandId(values, row);
+		}
+
+		// drop the rows that have gone, from the back so the rest stay put
+		for (int last = rows() - 1; last >= 0; --last) {
+			if (newIds.contains(commandId(m_values, last))) {
+				continue;
+			}
+			int first = last;
+			while (first > 0 && !newIds.contains(commandId(m_values, first - 1))) {
+				--first;
+			}
+			removeRows(first, last);
+			last = first;
+		}
+
+		for (int row = 0; row < newRows; ++row) {
+			auto in = values.begin() + row * m_columns;
+
+			int found = -1;
+			for (int old = row; old < rows(); ++old) {
+				if (commandId(m_values, old) == commandId(values, row)) {
+					found = old;
+					break;
+				}
+			}
+
+			if (found == -1) {
+				m_model.beginInsertRows(QModelIndex(), row, row);
+				m_values.insert(m_values.begin() + row * m_columns, in,
+						in + m_columns);
+				m_model.endInsertRows();
+				continue;
+			}
+
+			if (found != row) {
+				m_model.beginMoveRows(QModelIndex(), found, found, QModelIndex(),
+						row);
+				auto from = m_values.begin() + found * m_columns;
+				std::rotate(m_values.begin() + row * m_columns, from,
+						from + m_columns);
+				m_model.endMoveRows();
+			}
+
+			auto out = m_values.begin() + row * m_columns;
+			if (!std::equal(in, in + m_columns, out)) {
+				std::copy(in, in + m_columns, out);
+				QModelIndex index(m_model.index(row));
+				Q_EMIT m_model.dataChanged(index, index);
+			}
+		}
+
+		// only repeated IDs can leave rows behind
+		if (rows() > newRows) {
+			removeRows(newRows, rows() - 1);
+		}
+
+		if (rows() != oldRows) {
+			Q_EMIT m_model.countChanged();
+		}
+	}
+
+	void removeRows(int first, int last) {
+		m_model.beginRemoveRows(QModelIndex(), first, last);
+		m_values.erase(m_values.begin() + first * m_columns,
+				m_values.begin() + (last + 1) * m_columns);
+		m_model.endRemoveRows();
+	}
+
+	void disconnect() {
+		if (m_deeModel == nullptr) {
+			return;
+		}
+
+		g_signal_handler_disconnect(m_deeModel, m_rowAdded);
+		g_signal_handler_disconnect(m_deeModel, m_rowRemoved);
+		g_signal_handler_disconnect(m_deeModel, m_rowChanged);
+		g_signal_handler_disconnect(m_deeModel, m_changesetStarted);
+		g_signal_handler_disconnect(m_deeModel, m_changesetFinished);
+		g_clear_object(&m_deeModel);
+		m_inChangeset = false;
+	}
+
+	HudResultsModel &m_model;
+
+	DeeModel *m_deeModel;
+
+	int m_columns;
+
+	/* Row-major, m_columns values per row */
+	std::vector<QVariant> m_values;
+
+	/* Rows are left alone until the changeset is done */
+	bool m_inChangeset;
+
+	gulong m_rowAdded;
+
+	gulong m_rowRemoved;
+
+	gulong m_rowChanged;
+
+	gulong m_changesetStarted;
+
+	gulong m_changesetFinished;
+};
+
+HudResultsModel::HudResultsModel(QObject *parent) :
+		QAbstractListModel(parent), p(new Priv(*this)) {
+}
+
+HudResultsModel::~HudResultsModel() {
+	p->disconnect();
+}
+
+void HudResultsModel::setModel(DeeModel *model) {
+	if (model == p->m_deeModel) {
+		return;
+	}
+
+	beginResetModel();
+
+	p->disconnect();
+	p->m_values.clear();
+	p->m_columns = 0;
+
+	if (model != nullptr) {
+		p->m_deeModel = DEE_MODEL(g_object_ref(model));
+		p->m_columns = dee_model_get_n_columns(model);
+
+		p->convertRows(p->m_values);
+
+		p->m_rowAdded = g_signal_connect(model, "row-added",
+				G_CALLBACK(Priv::rowAddedCB), p.data());
+		p->m_rowRemoved = g_signal_connect(model, "row-removed",
+				G_CALLBACK(Priv::rowRemovedCB), p.data());
+		p->m_rowChanged = g_signal_connect(model, "row-changed",
+				G_CALLBACK(Priv::rowChangedCB), p.data());
+		p->m_changesetStarted = g_signal_connect(model, "changeset-started",
+				G_CALLBACK(Priv::changesetStartedCB), p.data());
+		p->m_changesetFinished = g_signal_connect(model, "changeset-finished",
+				G_CALLBACK(Priv::changesetFinishedCB), p.data());
+	}
+
+	endResetModel();
+
+	Q_EMIT countChanged();
+}
+
+int HudResultsModel::count() const {
+	return rowCount();
+}
+
+int HudResultsModel::rowCount(const QModelIndex &parent) const {
+	if (parent.isValid() || p->m_columns == 0) {
+		return 0;
+	}
+
+	return p->rows();
+}
+
+QVariant HudResultsModel::data(const QModelIndex &index, int role) const {
+	const int row = index.row();
+	if (!index.isValid() || row >= rowCount() || role < 0
+			|| role >= p->m_columns) {
+		return QVariant();
+	}
+
+	return p->m_values[row * p->m_columns + role];
+}
+
+QHash<int, QByteArray> HudResultsModel::roleNames() const {
+	QHash<int, QByteArray> roles;
+	for (int column = 0; column < p->m_columns; ++column) {
+		roles[column] = QString("column_%1").arg(column).toLatin1();
+	}
+	return roles;
+}
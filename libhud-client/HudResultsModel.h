@@ -0,0 +1,70 @@
+/*
+ * Copyright (C) 2016 Canonical, Ltd.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef HUDRESULTSMODEL_H
+#define HUDRESULTSMODEL_H
+
+#include <QAbstractListModel>
+#include <QScopedPointer>
+
+typedef struct _DeeModel DeeModel;
+
+namespace hud {
+namespace client {
+
+/**
+ * A list model over the query's results.
+ *
+ * Each row is converted from the Dee model once, when it is added or
+ * changed, and the values are kept in a flat array. The roles are the
+ * column numbers, the same as DeeListModel's.
+ *
+ * A Dee changeset is applied as a whole once it finishes, matching rows up
+ * by command ID, so results that survive a keystroke are moved or updated
+ * rather than removed and added again.
+ */
+class Q_DECL_EXPORT HudResultsModel: public QAbstractListModel {
+	class Priv;
+
+Q_OBJECT
+
+public:
+	explicit HudResultsModel(QObject *parent = 0);
+
+	~HudResultsModel();
+
+	void setModel(DeeModel *model);
+
+	Q_PROPERTY(int count READ count NOTIFY countChanged)
+	int count() const;
+
+	int rowCount(const QModelIndex &parent = QModelIndex()) const;
+
+	QVariant data(const QModelIndex &index, int role) const;
+
+	QHash<int, QByteArray> roleNames() const;
+
+Q_SIGNALS:
+	void countChanged();
+
+private:
+	QScopedPointer<Priv> p;
+};
+
+}
+}
+
+#endif
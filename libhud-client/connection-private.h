@@ -24,11 +24,16 @@
 #define __HUD_CLIENT_CONNECTION_PRIVATE_H__
 
 #include <gio/gio.h>
+#include <dee.h>
 #include "connection.h"
 
 G_BEGIN_DECLS
 
 GDBusConnection *     hud_client_connection_get_bus (HudClientConnection * connection);
+gboolean              hud_client_connection_take_prewarmed_query (HudClientConnection * connection,
+                                                                   gchar ** query_path,
+                                                                   DeeModel ** results,
+                                                                   DeeModel ** appstack);
 
 G_END_DECLS
 
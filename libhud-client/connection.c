@@ -20,9 +20,13 @@
 #include "config.h"
 #endif
 
+#include <dee.h>
+
 #include "connection.h"
+#include "connection-private.h"
 #include "service-iface.h"
 
+#include "common/query-columns.h"
 #include "common/shared-values.h"
 
 struct _HudClientConnectionPrivate {
@@ -33,6 +37,12 @@ struct _HudClientConnectionPrivate {
 	gboolean connected;
 	gulong name_owner_sig;
 	GCancellable * cancellable;
+	gboolean prewarm;
+	gboolean prewarm_pending;
+	guint prewarm_idle;
+	gchar * prewarm_path;
+	DeeModel * prewarm_results;
+	DeeModel * prewarm_appstack;
 };
 
 #define HUD_CLIENT_CONNECTION_GET_PRIVATE(o) \
@@ -55,6 +65,8 @@ static void hud_client_connection_finalize   (GObject *object);
 static void set_property (GObject * obj, guint id, const GValue * value, GParamSpec * pspec);
 static void get_property (GObject * obj, guint id, GValue * value, GParamSpec * pspec);
 static void name_owner_changed (GObject * object, GParamSpec * pspec, gpointer user_data);
+static void prewarm_start (HudClientConnection * connection);
+static void prewarm_clear (HudClientConnection * connection, gboolean close);
 
 G_DEFINE_TYPE (HudClientConnection, hud_client_connection, G_TYPE_OBJECT)
 
@@ -200,6 +212,13 @@ hud_client_connection_dispose (GObject *object)
 {
 	HudClientConnection * self = HUD_CLIENT_CONNECTION(object);
 
+	prewarm_clear(self, TRUE);
+
+	if (self->priv->prewarm_idle != 0) {
+		g_source_remove(self->priv->prewarm_idle);
+		self->priv->prewarm_idle = 0;
+	}
+
 	if (self->priv->cancellable != NULL) {
 		g_cancellable_cancel(self->priv->cancellable);
 		g_clear_object(&self->priv->cancellable);
@@ -253,8 +272,14 @@ name_owner_changed (G_GNUC_UNUSED GObject * object, G_GNUC_UNUSED GParamSpec * p
 	/* Cancel anything we had running */
 	if (!self->priv->connected) {
 		g_cancellable_cancel(self->priv->cancellable);
+		self->priv->prewarm_pending = FALSE;
+		/* The service has gone, and the prewarmed query with it */
+		prewarm_clear(self, FALSE);
 	} else {
 		g_cancellable_reset(self->priv->cancellable);
+		if (change) {
+			prewarm_start(self);
+		}
 	}
 
 	/* If there was a change, make sure others know about it */
@@ -315,6 +340,7 @@ struct _new_query_data_t {
 	HudClientConnection * con;
 	HudClientConnectionNewQueryCallback cb;
 	gpointer user_data;
+	gboolean reserve;
 };
 
 /* Called when the new query call comes back */
@@ -329,20 +355,43 @@ new_query_complete (GObject * object, GAsyncResult * res, gpointer user_data)
 	gint revision = 0;
 	GError * error = NULL;
 
-	_hud_service_com_canonical_hud_call_create_query_finish((_HudServiceComCanonicalHud *)object,
-	                                                        &query_object,
-	                                                        &results_name,
-	                                                        &appstack_name,
-	                                                        &revision,
-	                                                        res,
-	                                                        &error);
+	if (data->reserve) {
+		_hud_service_com_canonical_hud_call_create_reserve_query_finish((_HudServiceComCanonicalHud *)object,
+		                                                                &query_object,
+		                                                                &results_name,
+		                                                                &appstack_name,
+		                                                                &revision,
+		                                                                res,
+		                                                                &error);
+	} else {
+		_hud_service_com_canonical_hud_call_create_query_finish((_HudServiceComCanonicalHud *)object,
+		                                                        &query_object,
+		                                                        &results_name,
+		                                                        &appstack_name,
+		                                                        &revision,
+		                                                        res,
+		                                                        &error);
+	}
 
 	if (error != NULL) {
-		if (!g_error_matches(error, G_IO_ERROR, G_IO_ERROR_CANCELLED) && 
-				!g_error_matches(error, G_IO_ERROR, G_IO_ERROR_CLOSED)) {
+		/* Cancelled when the connection is disposed, so it may be gone,
+		   or when the service leaves, which clears the reserve itself */
+		if (g_error_matches(error, G_IO_ERROR, G_IO_ERROR_CANCELLED)) {
+			g_error_free(error);
+			g_free(data);
+			return;
+		}
+
+		if (!g_error_matches(error, G_IO_ERROR, G_IO_ERROR_CLOSED)) {
 			g_warning("Unable to allocate query: %s", error->message);
 		}
 		g_error_free(error);
+
+		/* Lets the reserve be asked for again */
+		if (data->reserve) {
+			data->cb(data->con, NULL, NULL, NULL, data->user_data);
+		}
+		g_free(data);
 		return;
 	}
 
@@ -429,3 +478,198 @@ hud_client_connection_get_bus (HudClientConnection * connection)
 	return connection->priv->bus;
 }
 
+/* Tell the service we're not going to use a query */
+static void
+close_query (HudClientConnection * connection, const gchar * path)
+{
+	if (connection->priv->bus == NULL || !connection->priv->connected) {
+		return;
+	}
+
+	g_dbus_connection_call(connection->priv->bus,
+	                       connection->priv->address,
+	                       path,
+	                       "com.canonical.hud.query",
+	                       "CloseQuery",
+	                       NULL, /* params */
+	                       NULL, /* ret type */
+	                       G_DBUS_CALL_FLAGS_NONE,
+	                       -1,
+	                       NULL,
+	                       NULL, NULL); /* callback */
+
+	return;
+}
+
+/* Drops the prewarmed query, telling the service we're done
+   with it if it's still around */
+static void
+prewarm_clear (HudClientConnection * connection, gboolean close)
+{
+	if (connection->priv->prewarm_path == NULL) {
+		return;
+	}
+
+	if (close) {
+		close_query(connection, connection->priv->prewarm_path);
+	}
+
+	g_clear_pointer(&connection->priv->prewarm_path, g_free);
+	g_clear_object(&connection->priv->prewarm_results);
+	g_clear_object(&connection->priv->prewarm_appstack);
+
+	return;
+}
+
+/* Got a query to keep in reserve */
+static void
+prewarm_query_cb (HudClientConnection * connection, const gchar * path, const gchar * results, const gchar * appstack, G_GNUC_UNUSED gpointer user_data)
+{
+	connection->priv->prewarm_pending = FALSE;
+
+	if (path == NULL || results == NULL || appstack == NULL) {
+		return;
+	}
+
+	if (!connection->priv->prewarm) {
+		/* Turned off while we were waiting */
+		close_query(connection, path);
+		return;
+	}
+
+	/* Creating the models starts them synchronizing, so they're
+	   ready by the time a query wants them */
+	connection->priv->prewarm_path = g_strdup(path);
+	connection->priv->prewarm_results = dee_shared_model_new(results);
+	dee_model_set_schema_full(connection->priv->prewarm_results, results_model_schema, G_N_ELEMENTS(results_model_schema));
+	connection->priv->prewarm_appstack = dee_shared_model_new(appstack);
+	dee_model_set_schema_full(connection->priv->prewarm_appstack, appstack_model_schema, G_N_ELEMENTS(appstack_model_schema));
+
+	return;
+}
+
+/* Ask the service for a query to keep in reserve */
+static void
+prewarm_start (HudClientConnection * connection)
+{
+	if (!connection->priv->prewarm
+	    || !connection->priv->connected
+	    || connection->priv->prewarm_pending
+	    || connection->priv->prewarm_path != NULL) {
+		return;
+	}
+
+	connection->priv->prewarm_pending = TRUE;
+
+	/* A reserve query leaves the menus alone until it's used, so
+	   keeping one doesn't count as the HUD being open */
+	new_query_data_t * data = g_new0(new_query_data_t, 1);
+	data->con = connection;
+	data->cb = prewarm_query_cb;
+	data->reserve = TRUE;
+
+	_hud_service_com_canonical_hud_call_create_reserve_query(connection->priv->proxy,
+		connection->priv->cancellable,
+		new_query_complete,
+		data);
+
+	return;
+}
+
+/* Refill the reserve once whoever took it has had a chance to run */
+static gboolean
+prewarm_idle (gpointer user_data)
+{
+	HudClientConnection * connection = HUD_CLIENT_CONNECTION(user_data);
+	connection->priv->prewarm_idle = 0;
+
+	prewarm_start(connection);
+
+	return G_SOURCE_REMOVE;
+}
+
+/**
+ * hud_client_connection_set_prewarm:
+ * @connection: A #HudClientConnection
+ * @prewarm: Whether to keep a query ready
+ *
+ * When @prewarm is set the connection keeps one query open on the
+ * HUD service, with its models already synchronized.  The next
+ * #HudClientQuery created on this connection takes it over instead
+ * of waiting for the service, and another one is prepared in the
+ * background.
+ *
+ * The reserved query is created with CreateReserveQuery, so it doesn't
+ * activate any window's menus until a #HudClientQuery takes it over and
+ * sets a search string or starts a voice query.
+ */
+void
+hud_client_connection_set_prewarm (HudClientConnection * connection, gboolean prewarm)
+{
+	g_return_if_fail(HUD_CLIENT_IS_CONNECTION(connection));
+
+	connection->priv->prewarm = prewarm;
+
+	if (prewarm) {
+		prewarm_start(connection);
+	} else {
+		prewarm_clear(connection, TRUE);
+	}
+
+	return;
+}
+
+/**
+ * hud_client_connection_has_prewarmed_query:
+ * @connection: A #HudClientConnection
+ *
+ * Checks whether a prewarmed query is waiting, with its models
+ * synchronized.
+ *
+ * Return value: If the next query will be ready straight away
+ */
+gboolean
+hud_client_connection_has_prewarmed_query (HudClientConnection * connection)
+{
+	g_return_val_if_fail(HUD_CLIENT_IS_CONNECTION(connection), FALSE);
+
+	return connection->priv->prewarm_path != NULL
+		&& dee_shared_model_is_synchronized(DEE_SHARED_MODEL(connection->priv->prewarm_results))
+		&& dee_shared_model_is_synchronized(DEE_SHARED_MODEL(connection->priv->prewarm_appstack));
+}
+
+/**
+ * hud_client_connection_take_prewarmed_query:
+ * @connection: A #HudClientConnection
+ * @query_path: (out) (transfer full): Path to the query object on DBus
+ * @results: (out) (transfer full): The results model
+ * @appstack: (out) (transfer full): The appstack model
+ *
+ * Hands over the prewarmed query, if there is one, and starts
+ * preparing the next.
+ *
+ * Return value: Whether there was a query to take
+ */
+gboolean
+hud_client_connection_take_prewarmed_query (HudClientConnection * connection, gchar ** query_path, DeeModel ** results, DeeModel ** appstack)
+{
+	g_return_val_if_fail(HUD_CLIENT_IS_CONNECTION(connection), FALSE);
+
+	if (connection->priv->prewarm_path == NULL) {
+		return FALSE;
+	}
+
+	*query_path = connection->priv->prewarm_path;
+	*results = connection->priv->prewarm_results;
+	*appstack = connection->priv->prewarm_appstack;
+
+	connection->priv->prewarm_path = NULL;
+	connection->priv->prewarm_results = NULL;
+	connection->priv->prewarm_appstack = NULL;
+
+	if (connection->priv->prewarm_idle == 0) {
+		connection->priv->prewarm_idle = g_idle_add_full(G_PRIORITY_LOW, prewarm_idle, connection, NULL);
+	}
+
+	return TRUE;
+}
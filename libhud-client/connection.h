@@ -101,6 +101,9 @@ void                    hud_client_connection_new_query  (HudClientConnection *
                                                           gpointer user_data);
 const gchar *           hud_client_connection_get_address (HudClientConnection * connection);
 gboolean                hud_client_connection_connected  (HudClientConnection * connection);
+void                    hud_client_connection_set_prewarm (HudClientConnection * connection,
+                                                          gboolean prewarm);
+gboolean                hud_client_connection_has_prewarmed_query (HudClientConnection * connection);
 
 /**
 	SECTION:connection
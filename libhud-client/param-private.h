@@ -0,0 +1,35 @@
+/*
+ * Copyright © 2016 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3, as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranties of
+ * MERCHANTABILITY, SATISFACTORY QUALITY, or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Author: Pete Woods <pete.woods@canonical.com>
+ */
+
+#if !defined (_HUD_CLIENT_H_INSIDE) && !defined (HUD_CLIENT_COMPILATION)
+#error "Only <hud-client.h> can be included directly."
+#endif
+
+#ifndef __HUD_CLIENT_PARAM_PRIVATE_H__
+#define __HUD_CLIENT_PARAM_PRIVATE_H__
+
+#include "param.h"
+
+G_BEGIN_DECLS
+
+void                  hud_client_param_set_parameters (HudClientParam * param,
+                                                        GVariant * parameters);
+
+G_END_DECLS
+
+#endif
@@ -21,6 +21,7 @@
 #endif
 
 #include "param.h"
+#include "param-private.h"
 #include <libhud-client/action-muxer.h>
 #include <gio/gio.h>
 
@@ -35,6 +36,9 @@ struct _HudClientParamPrivate {
 
 	/* These are the ones we care about */
 	GMenuModel * model;
+
+	/* Attributes of the model's items, if the service had them */
+	GVariant * parameters;
 	GActionGroup * base_actions;
 	GActionGroup * actions;
 
@@ -151,6 +155,7 @@ hud_client_param_finalize (GObject *object)
 	g_clear_pointer(&param->priv->base_action, g_free);
 	g_clear_pointer(&param->priv->action_path, g_free);
 	g_clear_pointer(&param->priv->model_path, g_free);
+	g_clear_pointer(&param->priv->parameters, g_variant_unref);
 
 	G_OBJECT_CLASS (hud_client_param_parent_class)->finalize (object);
 	return;
@@ -375,6 +380,39 @@ hud_client_param_get_model (HudClientParam * param)
 	return param->priv->model;
 }
 
+/**
+ * hud_client_param_get_parameters:
+ * @param: The #HudClientParam to query
+ *
+ * The attributes of each item in the pane's menu model, as the
+ * service prefetched them.  Lets the pane be drawn before the
+ * model itself has arrived.
+ *
+ * Return value: (transfer none) (allow-none): An "av" of "a{sv}"
+ *   attribute dictionaries, or NULL if the service didn't have them
+ */
+GVariant *
+hud_client_param_get_parameters (HudClientParam * param)
+{
+	g_return_val_if_fail(HUD_CLIENT_IS_PARAM(param), NULL);
+
+	return param->priv->parameters;
+}
+
+/* Keeps the attributes the service sent with the execute reply */
+void
+hud_client_param_set_parameters (HudClientParam * param, GVariant * parameters)
+{
+	g_return_if_fail(HUD_CLIENT_IS_PARAM(param));
+
+	g_clear_pointer(&param->priv->parameters, g_variant_unref);
+	if (parameters != NULL && g_variant_n_children(parameters) > 0) {
+		param->priv->parameters = g_variant_ref_sink(parameters);
+	}
+
+	return;
+}
+
 /**
  * hud_client_param_send_reset:
  * @param: The #HudClientParam to query
@@ -91,6 +91,7 @@ HudClientParam *       hud_client_param_new           (const gchar *     dbus_ad
 
 GActionGroup *         hud_client_param_get_actions   (HudClientParam * param);
 GMenuModel *           hud_client_param_get_model     (HudClientParam * param);
+GVariant *             hud_client_param_get_parameters (HudClientParam * param);
 
 void                   hud_client_param_send_reset    (HudClientParam * param);
 void                   hud_client_param_send_cancel   (HudClientParam * param);
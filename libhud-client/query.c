@@ -25,6 +25,7 @@
 #include "query.h"
 #include "connection.h"
 #include "connection-private.h"
+#include "param-private.h"
 #include "query-iface.h"
 #include "enum-types.h"
 #include "common/query-columns.h"
@@ -35,9 +36,15 @@ struct _HudClientQueryPrivate {
 	HudClientConnection * connection;
 	guint connection_changed_sig;
 	gchar * query;
+	gchar * update_in_flight;
+	gchar * update_pending;
+	GCancellable * update_cancellable;
 	DeeModel * results;
 	DeeModel * appstack;
 	GArray * toolbar;
+	GArray * rows;
+	GPtrArray * row_values;
+	guint64 rows_seqnum;
 };
 
 #define HUD_CLIENT_QUERY_GET_PRIVATE(o) \
@@ -60,11 +67,14 @@ static void hud_client_query_finalize    (GObject *object);
 static void set_property (GObject * obj, guint id, const GValue * value, GParamSpec * pspec);
 static void get_property (GObject * obj, guint id, GValue * value, GParamSpec * pspec);
 static void connection_status (HudClientConnection * connection, gboolean connected, HudClientQuery * query);
+static void rows_invalidate (HudClientQuery * cquery);
 static void new_query_cb (HudClientConnection * connection, const gchar * path, const gchar * results, const gchar * appstack, gpointer user_data);
+static gboolean setup_query (HudClientQuery * cquery, const gchar * path, DeeModel * results, DeeModel * appstack);
 
 G_DEFINE_TYPE (HudClientQuery, hud_client_query, G_TYPE_OBJECT)
 
 static guint signal_toolbar_updated = 0;
+static guint signal_results_updated = 0;
 static guint hud_client_query_signal_voice_query_loading;
 static guint hud_client_query_signal_voice_query_failed;
 static guint hud_client_query_signal_voice_query_listening;
@@ -109,6 +119,22 @@ hud_client_query_class_init (HudClientQueryClass *klass)
 	                                       g_cclosure_marshal_VOID__VOID,
 	                                       G_TYPE_NONE, 0, G_TYPE_NONE);
 
+	/**
+	 * HudClientQuery::results-updated:
+	 * @query: The query string the results are for
+	 * @revision: The service's revision of the results
+	 *
+	 * The service has finished updating the results for a query string
+	 * sent with hud_client_query_set_query_async().
+	 */
+	signal_results_updated = g_signal_new (HUD_CLIENT_QUERY_SIGNAL_RESULTS_UPDATED,
+	                                       HUD_CLIENT_TYPE_QUERY,
+	                                       G_SIGNAL_RUN_LAST,
+	                                       0, /* offset */
+	                                       NULL, NULL, /* Accumulator */
+	                                       g_cclosure_marshal_generic,
+	                                       G_TYPE_NONE, 2, G_TYPE_STRING, G_TYPE_INT);
+
 	/**
 	 * HudClientQuery::voice-query-loading:
 	 *
@@ -177,6 +203,11 @@ hud_client_query_init (HudClientQuery *self)
 	                                  FALSE, /* clear */
 	                                  sizeof(HudClientQueryToolbarItems));
 
+	self->priv->rows = g_array_new(FALSE, /* zero terminated */
+	                               TRUE, /* clear */
+	                               sizeof(HudClientResultRow));
+	self->priv->row_values = g_ptr_array_new_with_free_func((GDestroyNotify)g_variant_unref);
+
 	return;
 }
 
@@ -266,6 +297,7 @@ hud_client_query_constructed (GObject *object)
 static void
 connection_status (G_GNUC_UNUSED HudClientConnection * connection, gboolean connected, HudClientQuery * cquery)
 {
+	rows_invalidate(cquery);
 	g_clear_object(&cquery->priv->results);
 	g_clear_object(&cquery->priv->appstack);
 	g_clear_object(&cquery->priv->proxy);
@@ -276,6 +308,24 @@ connection_status (G_GNUC_UNUSED HudClientConnection * connection, gboolean conn
 		return;
 	}
 
+	/* A prewarmed query has its models ready, it just needs our
+	   search string. That first update is also what tells the service
+	   to start searching, so it's sent even for the empty string. */
+	gchar * path = NULL;
+	DeeModel * results = NULL;
+	DeeModel * appstack = NULL;
+	if (hud_client_connection_take_prewarmed_query(cquery->priv->connection, &path, &results, &appstack)) {
+		gboolean ready = setup_query(cquery, path, results, appstack);
+		g_free(path);
+
+		if (ready) {
+			gchar * query = g_strdup(cquery->priv->query);
+			hud_client_query_set_query_async(cquery, query, NULL);
+			g_free(query);
+			return;
+		}
+	}
+
 	hud_client_connection_new_query(cquery->priv->connection, cquery->priv->query, new_query_cb, g_object_ref(cquery));
 	return;
 }
@@ -303,15 +353,11 @@ parse_toolbar (_HudQueryComCanonicalHudQuery * proxy, G_GNUC_UNUSED GParamSpec *
 	return;
 }
 
-static void
-new_query_cb (G_GNUC_UNUSED HudClientConnection * connection, const gchar * path, const gchar * results, const gchar * appstack, gpointer user_data)
+/* Connects up a query object on the service, taking ownership
+   of the models */
+static gboolean
+setup_query (HudClientQuery * cquery, const gchar * path, DeeModel * results, DeeModel * appstack)
 {
-	if (path == NULL || results == NULL || appstack == NULL) {
-		g_object_unref(user_data);
-		return;
-	}
-
-	HudClientQuery * cquery = HUD_CLIENT_QUERY(user_data);
 	GError * error = NULL;
 
 	cquery->priv->proxy = _hud_query_com_canonical_hud_query_proxy_new_for_bus_sync(
@@ -326,15 +372,13 @@ new_query_cb (G_GNUC_UNUSED HudClientConnection * connection, const gchar * path
 	if (cquery->priv->proxy == NULL) {
 		g_debug("Unable to get proxy after getting query path: %s", error->message);
 		g_error_free(error);
-		g_object_unref(cquery);
-		return;
+		g_object_unref(results);
+		g_object_unref(appstack);
+		return FALSE;
 	}
 
-	/* Set up our models */
-	cquery->priv->results = dee_shared_model_new(results);
-	dee_model_set_schema_full(cquery->priv->results, results_model_schema, G_N_ELEMENTS(results_model_schema));
-	cquery->priv->appstack = dee_shared_model_new(appstack);
-	dee_model_set_schema_full(cquery->priv->appstack, appstack_model_schema, G_N_ELEMENTS(appstack_model_schema));
+	cquery->priv->results = results;
+	cquery->priv->appstack = appstack;
 
 	/* Watch for voice signals */
 	g_signal_connect_object (cquery->priv->proxy, "voice-query-loading",
@@ -352,6 +396,27 @@ new_query_cb (G_GNUC_UNUSED HudClientConnection * connection, const gchar * path
 
 	g_signal_emit(G_OBJECT(cquery), hud_client_query_signal_models_changed, 0);
 
+	return TRUE;
+}
+
+static void
+new_query_cb (G_GNUC_UNUSED HudClientConnection * connection, const gchar * path, const gchar * results, const gchar * appstack, gpointer user_data)
+{
+	if (path == NULL || results == NULL || appstack == NULL) {
+		g_object_unref(user_data);
+		return;
+	}
+
+	HudClientQuery * cquery = HUD_CLIENT_QUERY(user_data);
+
+	/* Set up our models */
+	DeeModel * results_model = dee_shared_model_new(results);
+	dee_model_set_schema_full(results_model, results_model_schema, G_N_ELEMENTS(results_model_schema));
+	DeeModel * appstack_model = dee_shared_model_new(appstack);
+	dee_model_set_schema_full(appstack_model, appstack_model_schema, G_N_ELEMENTS(appstack_model_schema));
+
+	setup_query(cquery, path, results_model, appstack_model);
+
 	g_object_unref(cquery);
 
 	return;
@@ -372,6 +437,11 @@ hud_client_query_dispose (GObject *object)
 		_hud_query_com_canonical_hud_query_call_close_query_sync(self->priv->proxy, NULL, NULL);
 	}
 
+	/* An update in flight holds a reference, so it finishes after this */
+	g_clear_pointer(&self->priv->update_pending, g_free);
+	g_clear_object(&self->priv->update_cancellable);
+
+	rows_invalidate(self);
 	g_clear_object(&self->priv->results);
 	g_clear_object(&self->priv->appstack);
 	g_clear_object(&self->priv->proxy);
@@ -387,7 +457,10 @@ hud_client_query_finalize (GObject *object)
 	HudClientQuery * self = HUD_CLIENT_QUERY(object);
 
 	g_clear_pointer(&self->priv->query, g_free);
+	g_clear_pointer(&self->priv->update_in_flight, g_free);
 	g_clear_pointer(&self->priv->toolbar, g_array_unref);
+	g_clear_pointer(&self->priv->rows, g_array_unref);
+	g_clear_pointer(&self->priv->row_values, g_ptr_array_unref);
 
 	G_OBJECT_CLASS (hud_client_query_parent_class)->finalize (object);
 	return;
@@ -479,6 +552,9 @@ hud_client_query_set_query (HudClientQuery * cquery, const gchar * query)
 	g_clear_pointer(&cquery->priv->query, g_free);
 	cquery->priv->query = g_strdup(query);
 
+	/* Anything still waiting to be sent is out of date now */
+	g_clear_pointer(&cquery->priv->update_pending, g_free);
+
 	if (cquery->priv->proxy != NULL) {
 		gint revision = 0;
 		_hud_query_com_canonical_hud_query_call_update_query_sync(cquery->priv->proxy, cquery->priv->query, &revision, NULL, NULL);
@@ -491,6 +567,101 @@ hud_client_query_set_query (HudClientQuery * cquery, const gchar * query)
 	return;
 }
 
+static void send_pending_update (HudClientQuery * cquery);
+
+static void
+update_query_cb (GObject * source, GAsyncResult * result, gpointer user_data)
+{
+	HudClientQuery * cquery = HUD_CLIENT_QUERY(user_data);
+	GError * error = NULL;
+	gint revision = 0;
+
+	gchar * sent = cquery->priv->update_in_flight;
+	cquery->priv->update_in_flight = NULL;
+
+	if (_hud_query_com_canonical_hud_query_call_update_query_finish((_HudQueryComCanonicalHudQuery *) source, &revision, result, &error)) {
+		g_signal_emit(G_OBJECT(cquery), signal_results_updated, 0, sent, revision);
+	} else {
+		if (!g_error_matches(error, G_IO_ERROR, G_IO_ERROR_CANCELLED)) {
+			g_warning("Unable to update query: %s", error->message);
+		}
+		g_error_free(error);
+	}
+
+	g_free(sent);
+
+	/* Whatever was typed while we waited goes out as one update */
+	send_pending_update(cquery);
+
+	g_object_unref(cquery);
+}
+
+static void
+send_pending_update (HudClientQuery * cquery)
+{
+	if (cquery->priv->update_pending == NULL || cquery->priv->update_in_flight != NULL) {
+		return;
+	}
+
+	if (cquery->priv->proxy == NULL
+			|| g_cancellable_is_cancelled(cquery->priv->update_cancellable)) {
+		/* A new query gets created with the latest string anyway */
+		g_clear_pointer(&cquery->priv->update_pending, g_free);
+		return;
+	}
+
+	cquery->priv->update_in_flight = cquery->priv->update_pending;
+	cquery->priv->update_pending = NULL;
+
+	_hud_query_com_canonical_hud_query_call_update_query(cquery->priv->proxy,
+		cquery->priv->update_in_flight,
+		cquery->priv->update_cancellable,
+		update_query_cb,
+		g_object_ref(cquery));
+}
+
+/**
+ * hud_client_query_set_query_async:
+ * @cquery: A #HudClientQuery
+ * @query: New query string
+ * @cancellable: (allow-none): Drops the update if cancelled
+ *
+ * Like hud_client_query_set_query(), but without waiting for the
+ * service.  Only one update is sent at a time; strings set while
+ * it's in flight are coalesced, and only the latest is sent when it
+ * returns.  Cancelling @cancellable abandons the update in flight
+ * and any waiting to be sent.
+ *
+ * The #HudClientQuery::results-updated signal says when the results
+ * for a string are ready.
+ */
+void
+hud_client_query_set_query_async (HudClientQuery * cquery, const gchar * query, GCancellable * cancellable)
+{
+	g_return_if_fail(HUD_CLIENT_IS_QUERY(cquery));
+	g_return_if_fail(cancellable == NULL || G_IS_CANCELLABLE(cancellable));
+
+	g_clear_pointer(&cquery->priv->query, g_free);
+	cquery->priv->query = g_strdup(query);
+
+	g_clear_object(&cquery->priv->update_cancellable);
+	if (cancellable != NULL) {
+		cquery->priv->update_cancellable = g_object_ref(cancellable);
+	}
+
+	if (cquery->priv->proxy != NULL) {
+		g_free(cquery->priv->update_pending);
+		cquery->priv->update_pending = g_strdup(query);
+		send_pending_update(cquery);
+	} else {
+		dbus_start_service(cquery);
+	}
+
+	g_object_notify(G_OBJECT(cquery), PROP_QUERY_S);
+
+	return;
+}
+
 /**
  * hud_client_query_get_query:
  * @cquery: A #HudClientQuery
@@ -705,9 +876,10 @@ hud_client_query_execute_param_command (HudClientQuery * cquery, GVariant * comm
 	gchar * action_path = NULL;
 	gchar * model_path = NULL;
 	gint section = 0;
+	GVariant * parameters = NULL;
 	GError * error = NULL;
 
-	_hud_query_com_canonical_hud_query_call_execute_parameterized_sync(cquery->priv->proxy, command_key, timestamp, &sender, &prefix, &base_action, &action_path, &model_path, &section, NULL, &error);
+	_hud_query_com_canonical_hud_query_call_execute_parameterized_with_parameters_sync(cquery->priv->proxy, command_key, timestamp, &sender, &prefix, &base_action, &action_path, &model_path, &section, &parameters, NULL, &error);
 
 	if (error != NULL) {
 		g_warning("Unable to execute paramereterized action: %s", error->message);
@@ -716,6 +888,11 @@ hud_client_query_execute_param_command (HudClientQuery * cquery, GVariant * comm
 	}
 
 	HudClientParam * param = hud_client_param_new(sender, prefix, base_action, action_path, model_path, section);
+	if (param != NULL) {
+		hud_client_param_set_parameters(param, parameters);
+	}
+
+	g_variant_unref(parameters);
 
 	g_free(prefix);
 	g_free(sender);
@@ -908,3 +1085,99 @@ hud_client_query_results_is_parameterized (HudClientQuery * cquery, DeeModelIter
 
 	return dee_model_get_bool(cquery->priv->results, row, HUD_QUERY_RESULTS_PARAMETERIZED);
 }
+
+/* Drops the cached rows, and the values they borrow from */
+static void
+rows_invalidate (HudClientQuery * cquery)
+{
+	if (cquery->priv->rows == NULL) {
+		return;
+	}
+
+	g_array_set_size(cquery->priv->rows, 0);
+	g_ptr_array_set_size(cquery->priv->row_values, 0);
+	cquery->priv->rows_seqnum = 0;
+
+	return;
+}
+
+/**
+ * hud_client_query_results_get_rows:
+ * @cquery: A #HudClientQuery
+ * @offset: The first row to get
+ * @count: How many rows to get
+ * @out: (array length=count): Caller allocated rows to fill in
+ *
+ * Fills in @out with up to @count rows of the results table, starting
+ * at @offset.  Rows are decoded once per revision of the results model,
+ * so calling this again for the same rows only copies them.
+ *
+ * The strings and variants in the rows are owned by @cquery.  They
+ * stay valid until the results model changes and this function is
+ * called again, or @cquery is destroyed.
+ *
+ * Return value: The number of rows filled in
+ */
+guint
+hud_client_query_results_get_rows (HudClientQuery * cquery, guint offset, guint count, HudClientResultRow * out)
+{
+	g_return_val_if_fail(HUD_CLIENT_IS_QUERY(cquery), 0);
+	g_return_val_if_fail(count == 0 || out != NULL, 0);
+
+	if (cquery->priv->results == NULL) {
+		return 0;
+	}
+
+	guint n_rows = dee_model_get_n_rows(cquery->priv->results);
+	guint64 seqnum = dee_serializable_model_get_seqnum(cquery->priv->results);
+
+	if (seqnum != cquery->priv->rows_seqnum || cquery->priv->rows->len != n_rows) {
+		rows_invalidate(cquery);
+		g_array_set_size(cquery->priv->rows, n_rows);
+		cquery->priv->rows_seqnum = seqnum;
+	}
+
+	if (offset >= n_rows) {
+		return 0;
+	}
+	count = MIN(count, n_rows - offset);
+
+	DeeModelIter * iter = NULL;
+	guint i;
+	for (i = 0; i < count; i++) {
+		HudClientResultRow * row = &g_array_index(cquery->priv->rows, HudClientResultRow, offset + i);
+
+		if (row->row == NULL) {
+			/* Only walk the model for rows we haven't seen */
+			if (iter == NULL) {
+				iter = dee_model_get_iter_at_row(cquery->priv->results, offset + i);
+			}
+
+			GVariant * values[HUD_QUERY_RESULTS_COUNT];
+			dee_model_get_row(cquery->priv->results, iter, values);
+
+			guint column;
+			for (column = 0; column < HUD_QUERY_RESULTS_COUNT; column++) {
+				g_ptr_array_add(cquery->priv->row_values, values[column]);
+			}
+
+			row->row = iter;
+			row->command_id = values[HUD_QUERY_RESULTS_COMMAND_ID];
+			row->command_name = g_variant_get_string(values[HUD_QUERY_RESULTS_COMMAND_NAME], NULL);
+			row->command_highlights = values[HUD_QUERY_RESULTS_COMMAND_HIGHLIGHTS];
+			row->description = g_variant_get_string(values[HUD_QUERY_RESULTS_DESCRIPTION], NULL);
+			row->description_highlights = values[HUD_QUERY_RESULTS_DESCRIPTION_HIGHLIGHTS];
+			row->shortcut = g_variant_get_string(values[HUD_QUERY_RESULTS_SHORTCUT], NULL);
+			row->distance = g_variant_get_uint32(values[HUD_QUERY_RESULTS_DISTANCE]);
+			row->parameterized = g_variant_get_boolean(values[HUD_QUERY_RESULTS_PARAMETERIZED]);
+		}
+
+		out[i] = *row;
+
+		if (iter != NULL) {
+			iter = dee_model_next(cquery->priv->results, row->row);
+		}
+	}
+
+	return count;
+}
@@ -52,10 +52,17 @@ G_BEGIN_DECLS
  * Signal to indicate when the toolbar has been updated
  */
 #define HUD_CLIENT_QUERY_SIGNAL_TOOLBAR_UPDATED   "toolbar-updated"
+/**
+ * HUD_CLIENT_QUERY_SIGNAL_RESULTS_UPDATED
+ *
+ * Signal to indicate when the service has updated the results for a query string
+ */
+#define HUD_CLIENT_QUERY_SIGNAL_RESULTS_UPDATED   "results-updated"
 
 typedef struct _HudClientQuery         HudClientQuery;
 typedef struct _HudClientQueryClass    HudClientQueryClass;
 typedef struct _HudClientQueryPrivate  HudClientQueryPrivate;
+typedef struct _HudClientResultRow     HudClientResultRow;
 
 /**
  * HudClientQueryPrivate:
@@ -85,6 +92,34 @@ struct _HudClientQuery {
 	HudClientQueryPrivate * priv;
 };
 
+/**
+ * HudClientResultRow:
+ * @row: The row in the results model
+ * @command_id: The command ID, to pass to hud_client_query_execute_command()
+ * @command_name: The human readable command name
+ * @command_highlights: The command highlights as a variant of type "a(ii)"
+ * @description: The human readable description
+ * @description_highlights: The description highlights as a variant of type "a(ii)"
+ * @shortcut: The human readable shortcut
+ * @distance: How far the command is from the query
+ * @parameterized: Whether the command is parameterized
+ *
+ * One row of the results, as filled in by
+ * hud_client_query_results_get_rows().  All the pointers are owned
+ * by the #HudClientQuery.
+ */
+struct _HudClientResultRow {
+	DeeModelIter * row;
+	GVariant * command_id;
+	const gchar * command_name;
+	GVariant * command_highlights;
+	const gchar * description;
+	GVariant * description_highlights;
+	const gchar * shortcut;
+	guint distance;
+	gboolean parameterized;
+};
+
 GType              hud_client_query_get_type              (void);
 
 HudClientQuery *   hud_client_query_new                   (const gchar *           query);
@@ -94,6 +129,9 @@ HudClientQuery *   hud_client_query_new_for_connection    (const gchar *
 /* Query Tools */
 void               hud_client_query_set_query             (HudClientQuery *        cquery,
                                                            const gchar *           query);
+void               hud_client_query_set_query_async       (HudClientQuery *        cquery,
+                                                           const gchar *           query,
+                                                           GCancellable *          cancellable);
 const gchar *      hud_client_query_get_query             (HudClientQuery *        cquery);
 
 void               hud_client_query_voice_query           (HudClientQuery *        cquery);
@@ -140,6 +178,10 @@ const gchar *      hud_client_query_results_get_shortcut   (HudClientQuery *
                                                             DeeModelIter *         row);
 gboolean           hud_client_query_results_is_parameterized (HudClientQuery *     cquery,
                                                             DeeModelIter *         row);
+guint              hud_client_query_results_get_rows       (HudClientQuery *       cquery,
+                                                            guint                  offset,
+                                                            guint                  count,
+                                                            HudClientResultRow *   out);
 
 /**
 	SECTION:query
@@ -150,7 +192,8 @@ gboolean           hud_client_query_results_is_parameterized (HudClientQuery *
 	A query is an open query to the HUD service which provides
 	Dee models for the results.  The query can update without changing
 	the search string (the application changes the entires) or can
-	be udated by calling hud_client_query_set_query().
+	be udated by calling hud_client_query_set_query(), or without
+	waiting for the service with hud_client_query_set_query_async().
 
 	When the usage of the Query is complete it should be unreferenced
 	as that will communicate to the applications that the HUD is closed
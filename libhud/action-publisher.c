@@ -503,6 +503,243 @@ hud_action_publisher_remove_descriptions (HudActionPublisher *publisher,
     }
 }
 
+static gint
+compare_description_pointers (gconstpointer a,
+                              gconstpointer b,
+                              gpointer      user_data)
+{
+  return compare_descriptions (*(HudActionDescription * const *) a,
+                               *(HudActionDescription * const *) b, user_data);
+}
+
+/* Accumulates neighbouring changes so they go out as one "items-changed" */
+typedef struct
+{
+  gint position;
+  gint removed;
+  gint added;
+} PendingChange;
+
+static void
+pending_change_begin (PendingChange *change,
+                      gint           position)
+{
+  if (change->position < 0)
+    change->position = position;
+}
+
+static void
+pending_change_flush (PendingChange      *change,
+                      HudActionPublisher *publisher)
+{
+  if (change->removed > 0 || change->added > 0)
+    g_menu_model_items_changed (G_MENU_MODEL (publisher->aux), change->position, change->removed, change->added);
+
+  change->position = -1;
+  change->removed = 0;
+  change->added = 0;
+}
+
+/*
+ * Merges the descriptions into the sequence in a single pass, emitting one
+ * "items-changed" for each run of neighbouring changes.  Each run is signalled
+ * as soon as it has been applied, so the model always matches what listeners
+ * have been told.
+ *
+ * If @replace is set, the existing descriptions from @begin up to (but not
+ * including) the identifier @end are removed unless they're in the array.
+ */
+static void
+merge_descriptions (HudActionPublisher    *publisher,
+                    HudActionDescription **descriptions,
+                    guint                  n_descriptions,
+                    gboolean               replace,
+                    GSequenceIter         *begin,
+                    const gchar           *end)
+{
+  HudActionDescription bound;
+  PendingChange change = { -1, 0, 0 };
+  GSequenceIter *iter;
+  GPtrArray *sorted;
+  gint position;
+  guint i;
+
+  /* The sort is stable, so the last of several equal descriptions wins */
+  sorted = g_ptr_array_sized_new (n_descriptions);
+  for (i = 0; i < n_descriptions; i++)
+    g_ptr_array_add (sorted, descriptions[i]);
+  g_ptr_array_sort_with_data (sorted, compare_description_pointers, NULL);
+
+  bound.identifier = (gchar *) end;
+  iter = begin;
+  position = g_sequence_iter_get_position (iter);
+  i = 0;
+
+  while (TRUE)
+    {
+      HudActionDescription *old = NULL;
+      HudActionDescription *new = NULL;
+      gint cmp;
+
+      while (i + 1 < sorted->len
+             && compare_descriptions (g_ptr_array_index (sorted, i), g_ptr_array_index (sorted, i + 1), NULL) == 0)
+        i++;
+
+      if (i < sorted->len)
+        new = g_ptr_array_index (sorted, i);
+
+      if (!g_sequence_iter_is_end (iter))
+        {
+          old = g_sequence_get (iter);
+          if (end != NULL && compare_descriptions (old, &bound, NULL) >= 0)
+            old = NULL;
+        }
+
+      if (old == NULL && new == NULL)
+        break;
+
+      if (old == NULL)
+        cmp = 1;
+      else if (new == NULL)
+        cmp = -1;
+      else
+        cmp = compare_descriptions (old, new, NULL);
+
+      if (cmp < 0 && !replace)
+        {
+          /* Nothing to do until the next new description, so skip straight to it */
+          pending_change_flush (&change, publisher);
+
+          if (new == NULL)
+            break;
+
+          iter = g_sequence_search (publisher->descriptions, new, compare_descriptions, NULL);
+          if (!g_sequence_iter_is_begin (iter)
+              && compare_descriptions (g_sequence_get (g_sequence_iter_prev (iter)), new, NULL) == 0)
+            iter = g_sequence_iter_prev (iter);
+          position = g_sequence_iter_get_position (iter);
+        }
+      else if (cmp < 0)
+        {
+          GSequenceIter *next = g_sequence_iter_next (iter);
+
+          pending_change_begin (&change, position);
+          disconnect_handler (old, publisher);
+          g_sequence_remove (iter);
+          iter = next;
+          change.removed++;
+        }
+      else if (cmp > 0)
+        {
+          pending_change_begin (&change, position);
+          g_sequence_insert_before (iter, g_object_ref (new));
+          g_signal_connect (new, "changed", G_CALLBACK (description_changed), publisher);
+          change.added++;
+          position++;
+          i++;
+        }
+      else if (old == new)
+        {
+          pending_change_flush (&change, publisher);
+          iter = g_sequence_iter_next (iter);
+          position++;
+          i++;
+        }
+      else
+        {
+          pending_change_begin (&change, position);
+          disconnect_handler (old, publisher);
+          g_sequence_set (iter, g_object_ref (new));
+          g_signal_connect (new, "changed", G_CALLBACK (description_changed), publisher);
+          iter = g_sequence_iter_next (iter);
+          change.removed++;
+          change.added++;
+          position++;
+          i++;
+        }
+    }
+
+  pending_change_flush (&change, publisher);
+
+  g_ptr_array_unref (sorted);
+}
+
+/**
+ * hud_action_publisher_add_descriptions:
+ * @publisher: the #HudActionPublisher
+ * @descriptions: (array length=n_descriptions): action descriptions
+ * @n_descriptions: the length of @descriptions
+ *
+ * Adds many descriptions at once, as if by calling
+ * hud_action_publisher_add_description() for each of them.
+ *
+ * The descriptions are sorted once and merged in a single pass, and
+ * neighbouring changes are reported to the HUD together, so this is
+ * much cheaper than adding a long list of recent documents or
+ * bookmarks one at a time.
+ */
+void
+hud_action_publisher_add_descriptions (HudActionPublisher    *publisher,
+                                       HudActionDescription **descriptions,
+                                       guint                  n_descriptions)
+{
+  g_return_if_fail (HUD_IS_ACTION_PUBLISHER (publisher));
+  g_return_if_fail (descriptions != NULL || n_descriptions == 0);
+
+  merge_descriptions (publisher, descriptions, n_descriptions, FALSE,
+                      g_sequence_get_begin_iter (publisher->descriptions), NULL);
+}
+
+/**
+ * hud_action_publisher_replace_descriptions:
+ * @publisher: the #HudActionPublisher
+ * @action_name: (allow-none): an action name
+ * @descriptions: (array length=n_descriptions): action descriptions
+ * @n_descriptions: the length of @descriptions
+ *
+ * Replaces all of the descriptions for @action_name, whatever their
+ * target, with @descriptions, which must all be for @action_name.  If
+ * @action_name is %NULL every description is replaced.
+ *
+ * Descriptions that are in both the old and new sets aren't reported
+ * to the HUD again, so refreshing a list of recent documents only
+ * costs as much as what actually changed.
+ */
+void
+hud_action_publisher_replace_descriptions (HudActionPublisher    *publisher,
+                                           const gchar           *action_name,
+                                           HudActionDescription **descriptions,
+                                           guint                  n_descriptions)
+{
+  HudActionDescription start;
+  GSequenceIter *begin;
+  gchar *end = NULL;
+  guint i;
+
+  g_return_if_fail (HUD_IS_ACTION_PUBLISHER (publisher));
+  g_return_if_fail (descriptions != NULL || n_descriptions == 0);
+
+  if (action_name == NULL)
+    {
+      merge_descriptions (publisher, descriptions, n_descriptions, TRUE,
+                          g_sequence_get_begin_iter (publisher->descriptions), NULL);
+      return;
+    }
+
+  for (i = 0; i < n_descriptions; i++)
+    g_return_if_fail (g_str_equal (descriptions[i]->action, action_name));
+
+  /* Every identifier for the action is "action_name(target)" */
+  start.identifier = g_strconcat (action_name, "(", NULL);
+  end = g_strconcat (action_name, ")", NULL);
+  begin = g_sequence_search (publisher->descriptions, &start, compare_descriptions, NULL);
+
+  merge_descriptions (publisher, descriptions, n_descriptions, TRUE, begin, end);
+
+  g_free (start.identifier);
+  g_free (end);
+}
+
 /**
  * hud_action_publisher_add_action_group:
  * @publisher: a #HudActionPublisher
@@ -111,6 +111,13 @@ HudActionPublisher *    hud_action_publisher_new_for_application        (GApplic
 
 void                    hud_action_publisher_add_description            (HudActionPublisher    *publisher,
                                                                          HudActionDescription  *description);
+void                    hud_action_publisher_add_descriptions           (HudActionPublisher    *publisher,
+                                                                         HudActionDescription **descriptions,
+                                                                         guint                  n_descriptions);
+void                    hud_action_publisher_replace_descriptions       (HudActionPublisher    *publisher,
+                                                                         const gchar           *action_name,
+                                                                         HudActionDescription **descriptions,
+                                                                         guint                  n_descriptions);
 
 void                    hud_action_publisher_add_action_group           (HudActionPublisher    *publisher,
                                                                          const gchar           *prefix,
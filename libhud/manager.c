@@ -42,8 +42,8 @@ struct _HudManagerPrivate {
 	_HudServiceIfaceComCanonicalHud * service_proxy;
 	_HudAppIfaceComCanonicalHudApplication * app_proxy;
 
-	GVariantBuilder * todo_add_acts;
-	GVariantBuilder * todo_add_desc;
+	GList           * todo_add_pubs;
+	GVariantBuilder * todo_remove;
 	GHashTable      * todo_active_contexts;
 	guint todo_idle;
 
@@ -175,8 +175,9 @@ hud_manager_dispose (GObject *object)
 		g_clear_object(&manager->priv->connection_cancel);
 	}
 
-	g_clear_pointer(&manager->priv->todo_add_acts, variant_builder_dispose);
-	g_clear_pointer(&manager->priv->todo_add_desc, variant_builder_dispose);
+	g_list_free_full(manager->priv->todo_add_pubs, g_object_unref);
+	manager->priv->todo_add_pubs = NULL;
+	g_clear_pointer(&manager->priv->todo_remove, variant_builder_dispose);
 
 	if (manager->priv->todo_idle != 0) {
 		g_source_remove(manager->priv->todo_idle);
@@ -188,6 +189,7 @@ hud_manager_dispose (GObject *object)
 	g_clear_object(&manager->priv->app_proxy);
 
 	g_list_free_full(manager->priv->publishers, g_object_unref);
+	manager->priv->publishers = NULL;
 	g_hash_table_remove_all(manager->priv->todo_active_contexts);
 	g_hash_table_remove_all(manager->priv->active_contexts);
 
@@ -285,6 +287,61 @@ add_sources_cb (GObject * obj, GAsyncResult * res, G_GNUC_UNUSED gpointer user_d
 	return;
 }
 
+/* Callback from removing sources */
+static void
+remove_sources_cb (GObject * obj, GAsyncResult * res, G_GNUC_UNUSED gpointer user_data)
+{
+	GError * error = NULL;
+	_hud_app_iface_com_canonical_hud_application_call_remove_sources_finish((_HudAppIfaceComCanonicalHudApplication *)obj, res, &error);
+
+	if (error != NULL) {
+		g_warning("Unable to remove sources: %s", error->message);
+		g_error_free(error);
+		return;
+	}
+
+	return;
+}
+
+/* Callback from updating sources */
+static void
+update_sources_cb (GObject * obj, GAsyncResult * res, G_GNUC_UNUSED gpointer user_data)
+{
+	GError * error = NULL;
+	_hud_app_iface_com_canonical_hud_application_call_update_sources_finish((_HudAppIfaceComCanonicalHudApplication *)obj, res, &error);
+
+	if (error != NULL) {
+		g_warning("Unable to update sources: %s", error->message);
+		g_error_free(error);
+		return;
+	}
+
+	return;
+}
+
+/* Adds the action groups and description of a publisher to the
+   lists we're about to send */
+static void
+append_publisher_sources (HudActionPublisher * pub, GVariantBuilder * actions, GVariantBuilder * descriptions)
+{
+	guint winid = hud_action_publisher_get_window_id(pub);
+	const gchar * conid = hud_action_publisher_get_context_id(pub);
+
+	GList * paction_group = NULL;
+	for (paction_group = hud_action_publisher_get_action_groups(pub); paction_group != NULL; paction_group = g_list_next(paction_group)) {
+		HudActionPublisherActionGroupSet * set = (HudActionPublisherActionGroupSet *)paction_group->data;
+
+		g_variant_builder_add(actions, "(usso)", winid, conid, set->prefix, set->path);
+	}
+
+	const gchar * descpath = hud_action_publisher_get_description_path(pub);
+	if (descpath != NULL) {
+		g_variant_builder_add(descriptions, "(uso)", winid, conid, descpath);
+	}
+
+	return;
+}
+
 static gboolean
 activate_todo_context (G_GNUC_UNUSED gpointer key,
 		       gpointer value,
@@ -300,8 +357,8 @@ activate_todo_context (G_GNUC_UNUSED gpointer key,
 static void
 process_todo_queues (HudManager * manager)
 {
-	if (manager->priv->todo_add_acts == NULL
-	    && manager->priv->todo_add_desc == NULL
+	if (manager->priv->todo_add_pubs == NULL
+	    && manager->priv->todo_remove == NULL
 	    && g_hash_table_size(manager->priv->todo_active_contexts) == 0) {
 		/* Nothing to process */
 		return;
@@ -312,37 +369,58 @@ process_todo_queues (HudManager * manager)
 		return;
 	}
 
-	GVariant * actions = NULL;
-	GVariant * descriptions = NULL;
+	GVariant * removed = NULL;
 
-	/* Build an actions list */
-	if (manager->priv->todo_add_acts != NULL) {
-		actions = g_variant_builder_end(manager->priv->todo_add_acts);
-		g_variant_builder_unref(manager->priv->todo_add_acts);
-		manager->priv->todo_add_acts = NULL;
-	} else {
-		actions = g_variant_new_array(G_VARIANT_TYPE("(usso)"), NULL, 0);
+	/* Build a removed sources list */
+	if (manager->priv->todo_remove != NULL) {
+		removed = g_variant_builder_end(manager->priv->todo_remove);
+		g_variant_builder_unref(manager->priv->todo_remove);
+		manager->priv->todo_remove = NULL;
 	}
 
-	/* Build a descriptions list */
-	if (manager->priv->todo_add_desc != NULL) {
-		descriptions = g_variant_builder_end(manager->priv->todo_add_desc);
-		g_variant_builder_unref(manager->priv->todo_add_desc);
-		manager->priv->todo_add_desc = NULL;
-	} else {
-		descriptions = g_variant_new_array(G_VARIANT_TYPE("(uso)"), NULL, 0);
-	}
+	/* Build the actions and descriptions lists, in the order the
+	   publishers were added */
+	if (manager->priv->todo_add_pubs != NULL) {
+		GVariantBuilder actions;
+		GVariantBuilder descriptions;
+		g_variant_builder_init(&actions, G_VARIANT_TYPE("a(usso)"));
+		g_variant_builder_init(&descriptions, G_VARIANT_TYPE("a(uso)"));
 
-	/* Should never happen, but let's get useful error messages if it does */
-	g_return_if_fail(actions != NULL);
-	g_return_if_fail(descriptions != NULL);
+		GList * pubs = g_list_reverse(manager->priv->todo_add_pubs);
+		manager->priv->todo_add_pubs = NULL;
 
-	_hud_app_iface_com_canonical_hud_application_call_add_sources(manager->priv->app_proxy,
-		actions,
-		descriptions,
-		NULL, /* cancelable */
-		add_sources_cb,
-		manager);
+		GList * pub;
+		for (pub = pubs; pub != NULL; pub = g_list_next(pub)) {
+			append_publisher_sources(HUD_ACTION_PUBLISHER(pub->data), &actions, &descriptions);
+		}
+
+		g_list_free_full(pubs, g_object_unref);
+
+		if (removed != NULL) {
+			/* Removals go first, so a context can be removed and
+			   added again in the same batch */
+			_hud_app_iface_com_canonical_hud_application_call_update_sources(manager->priv->app_proxy,
+				removed,
+				g_variant_builder_end(&actions),
+				g_variant_builder_end(&descriptions),
+				NULL, /* cancelable */
+				update_sources_cb,
+				manager);
+		} else {
+			_hud_app_iface_com_canonical_hud_application_call_add_sources(manager->priv->app_proxy,
+				g_variant_builder_end(&actions),
+				g_variant_builder_end(&descriptions),
+				NULL, /* cancelable */
+				add_sources_cb,
+				manager);
+		}
+	} else if (removed != NULL) {
+		_hud_app_iface_com_canonical_hud_application_call_remove_sources(manager->priv->app_proxy,
+			removed,
+			NULL, /* cancelable */
+			remove_sources_cb,
+			manager);
+	}
 
 	g_hash_table_foreach_remove(manager->priv->todo_active_contexts,
 				    activate_todo_context,
@@ -437,6 +515,14 @@ notify_name_owner (GObject * gobject, G_GNUC_UNUSED GParamSpec * pspec, gpointer
 			manager->priv->connection_cancel = g_cancellable_new();
 		}
 
+		/* Whatever replaces the service won't know about the sources
+		   we were going to remove */
+		g_clear_pointer(&manager->priv->todo_remove, variant_builder_dispose);
+
+		/* Anything still waiting to be sent gets queued again below */
+		g_list_free_full(manager->priv->todo_add_pubs, g_object_unref);
+		manager->priv->todo_add_pubs = NULL;
+
 		/* Put the current publishers on the todo list */
 		GList * old_publishers = manager->priv->publishers;
 		manager->priv->publishers = NULL;
@@ -587,64 +673,27 @@ hud_manager_add_actions (HudManager * manager, HudActionPublisher * pub)
 	/* Set up watching for new groups */
 	/* TODO */
 
-	/* Grab the window and context IDs for each of them */
-	GVariant * winid = g_variant_new_uint32(hud_action_publisher_get_window_id(pub));
-	GVariant * conid = g_variant_new_string(hud_action_publisher_get_context_id(pub));
-	g_variant_ref_sink(winid);
-	g_variant_ref_sink(conid);
-
-	/* Send the current groups out */
-	GList * ags_list = hud_action_publisher_get_action_groups(pub);
-
-	/* Build the variant builder if it doesn't exist */
-	if (ags_list != NULL && manager->priv->todo_add_acts == NULL) {
-		manager->priv->todo_add_acts = g_variant_builder_new(G_VARIANT_TYPE_ARRAY);
-	}
-
-	/* Grab the action groups and add them to the todo queue */
-	GList * paction_group = NULL;
-	for (paction_group = ags_list; paction_group != NULL; paction_group = g_list_next(paction_group)) {
-		HudActionPublisherActionGroupSet * set = (HudActionPublisherActionGroupSet *)paction_group->data;
-
-		g_variant_builder_open(manager->priv->todo_add_acts, G_VARIANT_TYPE_TUPLE);
-
-		g_variant_builder_add_value(manager->priv->todo_add_acts, winid);
-		g_variant_builder_add_value(manager->priv->todo_add_acts, conid);
-		g_variant_builder_add_value(manager->priv->todo_add_acts, g_variant_new_string(set->prefix));
-		g_variant_builder_add_value(manager->priv->todo_add_acts, g_variant_new_object_path(set->path));
-
-		g_variant_builder_close(manager->priv->todo_add_acts);
-	}
-
-	/* Grab the description and add them to the todo queue */
-	const gchar * descpath = hud_action_publisher_get_description_path(pub);
-
-	/* Build the variant builder if it doesn't exist */
-	if (descpath != NULL && manager->priv->todo_add_desc == NULL) {
-		manager->priv->todo_add_desc = g_variant_builder_new(G_VARIANT_TYPE_ARRAY);
-	}
-
-	if (descpath != NULL) {
-		g_variant_builder_open(manager->priv->todo_add_desc, G_VARIANT_TYPE_TUPLE);
-
-		g_variant_builder_add_value(manager->priv->todo_add_desc, winid);
-		g_variant_builder_add_value(manager->priv->todo_add_desc, conid);
-		g_variant_builder_add_value(manager->priv->todo_add_desc, g_variant_new_object_path(descpath));
-
-		g_variant_builder_close(manager->priv->todo_add_desc);
-	}
+	/* The action groups and description are sent from the idle, so
+	   all the publishers added before then go in one message */
+	manager->priv->todo_add_pubs = g_list_prepend(manager->priv->todo_add_pubs, g_object_ref(pub));
 
 	/* Should be if we're all set up */
 	if (manager->priv->connection_cancel == NULL && manager->priv->todo_idle == 0) {
 		manager->priv->todo_idle = g_idle_add(todo_handler, manager);
 	}
 
-	g_variant_unref(winid);  winid = NULL;
-	g_variant_unref(conid);  conid = NULL;
-
 	return;
 }
 
+/* Remove entries from the context tables that point to a publisher */
+static gboolean
+context_is_publisher (G_GNUC_UNUSED gpointer key,
+		      gpointer value,
+		      gpointer user_data)
+{
+	return value == user_data;
+}
+
 /**
  * hud_manager_remove_actions:
  * @manager: A #HudManager object
@@ -655,13 +704,42 @@ hud_manager_add_actions (HudManager * manager, HudActionPublisher * pub)
  * with weak pointer style destroy.
  */
 void
-hud_manager_remove_actions (HudManager * manager, G_GNUC_UNUSED HudActionPublisher * pub)
+hud_manager_remove_actions (HudManager * manager, HudActionPublisher * pub)
 {
 	g_return_if_fail(HUD_IS_MANAGER(manager));
 
-	/* TODO: We need DBus API for this */
-	/* TODO: make sure to check if the removed publisher was in the active_contexts
-	         or todo_active_contexts */
+	/* We hold a reference to every publisher we know about, so we can
+	   only look at @pub once we've found it in our list */
+	GList * link = g_list_find(manager->priv->publishers, pub);
+	if (link == NULL) {
+		return;
+	}
+
+	manager->priv->publishers = g_list_delete_link(manager->priv->publishers, link);
+
+	g_hash_table_foreach_remove(manager->priv->active_contexts, context_is_publisher, pub);
+	g_hash_table_foreach_remove(manager->priv->todo_active_contexts, context_is_publisher, pub);
+
+	link = g_list_find(manager->priv->todo_add_pubs, pub);
+	if (link != NULL) {
+		/* It was never sent, so there's nothing to tell the service */
+		manager->priv->todo_add_pubs = g_list_delete_link(manager->priv->todo_add_pubs, link);
+		g_object_unref(pub);
+	} else {
+		if (manager->priv->todo_remove == NULL) {
+			manager->priv->todo_remove = g_variant_builder_new(G_VARIANT_TYPE("a(us)"));
+		}
+
+		g_variant_builder_add(manager->priv->todo_remove, "(us)",
+			hud_action_publisher_get_window_id(pub),
+			hud_action_publisher_get_context_id(pub));
+
+		if (manager->priv->connection_cancel == NULL && manager->priv->todo_idle == 0) {
+			manager->priv->todo_idle = g_idle_add(todo_handler, manager);
+		}
+	}
+
+	g_object_unref(pub);
 
 	return;
 }
@@ -17,27 +17,384 @@
  */
 
 #include "QtGMenuExporter.h"
+#include <internal/QtGMenuExportModel.h>
 
+#include <QDebug>
+#include <QEvent>
+#include <QHash>
+#include <QKeySequence>
 #include <QMenu>
+#include <QSet>
+#include <QTimer>
+
+#undef signals
+#include <gio/gio.h>
 
 using namespace qtgmenu;
 
 namespace qtgmenu
 {
 
+// what we've published for one QMenu: a model of sections, each holding a run of items
+// between separators
+struct ExportedMenu
+{
+  QSharedPointer< GMenuModel > m_model;
+  std::vector< QSharedPointer< GMenuModel > > m_sections;
+};
+
 class QtGMenuExporterPrivate
 {
+public:
+  QtGMenuExporterPrivate( QtGMenuExporter& parent, QSharedPointer< GDBusConnection > connection );
+
+  void Track( QMenu* menu );
+  void Update( QMenu* menu );
+  QtGMenuExportItem Item( QAction* action );
+  QString ExportAction( QAction* action );
+
+  static void ActivateCallback( GSimpleAction* simple, GVariant* parameter, gpointer user_data );
+
+  QtGMenuExporter& m_parent;
+  QSharedPointer< GDBusConnection > m_connection;
+
+  QHash< QMenu*, ExportedMenu > m_menus;
+  QSet< QMenu* > m_dirty_menus;
+  QTimer m_update_timer;
+
+  QSharedPointer< GSimpleActionGroup > m_action_group;
+  QHash< QAction*, QString > m_action_names;
+  QHash< QString, QAction* > m_actions;
+  int m_next_action = 0;
+
+  guint m_menu_export_id = 0;
+  guint m_actions_export_id = 0;
 };
 
 } // namespace qtgmenu
 
+// Qt marks the mnemonic with '&', GLib with '_'
+static QString MnemonicLabel( const QString& text )
+{
+  QString label;
+  label.reserve( text.size() );
+
+  for( int i = 0; i < text.size(); ++i )
+  {
+    if( text[i] == '&' )
+    {
+      if( i + 1 < text.size() && text[i + 1] == '&' )
+      {
+        label += '&';
+        ++i;
+      }
+      else
+      {
+        label += '_';
+      }
+    }
+    else if( text[i] == '_' )
+    {
+      label += "__";
+    }
+    else
+    {
+      label += text[i];
+    }
+  }
+
+  return label;
+}
+
+// GLib's accelerator syntax, for the first key of the shortcut
+static QString Accelerator( const QKeySequence& shortcut )
+{
+  QString key = QKeySequence( shortcut[0] ).toString( QKeySequence::PortableText );
+
+  QString accel;
+  // in the order Qt writes them
+  for( const auto& modifier : { qMakePair( QString( "Meta+" ), QString( "<Meta>" ) ),
+      qMakePair( QString( "Ctrl+" ), QString( "<Control>" ) ),
+      qMakePair( QString( "Alt+" ), QString( "<Alt>" ) ),
+      qMakePair( QString( "Shift+" ), QString( "<Shift>" ) ) } )
+  {
+    if( key.startsWith( modifier.first ) && key.size() > modifier.first.size() )
+    {
+      accel += modifier.second;
+      key.remove( 0, modifier.first.size() );
+    }
+  }
+
+  if( key == "+" )
+  {
+    key = "plus";
+  }
+  else if( key == "-" )
+  {
+    key = "minus";
+  }
+  else if( key == "PgUp" )
+  {
+    key = "Page_Up";
+  }
+  else if( key == "PgDown" )
+  {
+    key = "Page_Down";
+  }
+
+  return accel + key;
+}
+
+QtGMenuExporterPrivate::QtGMenuExporterPrivate( QtGMenuExporter& parent,
+    QSharedPointer< GDBusConnection > connection )
+    : m_parent( parent ),
+      m_connection( connection ),
+      m_action_group( g_simple_action_group_new(), &g_object_unref )
+{
+  m_update_timer.setSingleShot( true );
+  m_update_timer.setInterval( 0 );
+}
+
+void QtGMenuExporterPrivate::Track( QMenu* menu )
+{
+  ExportedMenu& exported = m_menus[menu];
+  exported.m_model.reset( QtGMenuExportModel::New(), &g_object_unref );
+
+  menu->installEventFilter( &m_parent );
+  QObject::connect( menu, SIGNAL( destroyed( QObject* ) ), &m_parent,
+      SLOT( MenuDestroyed( QObject* ) ) );
+
+  Update( menu );
+}
+
+void QtGMenuExporterPrivate::Update( QMenu* menu )
+{
+  std::vector< std::vector< QtGMenuExportItem > > sections( 1 );
+
+  for( QAction* action : menu->actions() )
+  {
+    if( !action->isVisible() )
+    {
+      continue;
+    }
+
+    if( action->isSeparator() )
+    {
+      if( !sections.back().empty() )
+      {
+        sections.emplace_back();
+      }
+      continue;
+    }
+
+    sections.back().push_back( Item( action ) );
+  }
+
+  if( sections.size() > 1 && sections.back().empty() )
+  {
+    sections.pop_back();
+  }
+
+  // the section models are kept by position, so their links stay the same across updates
+  // and unchanged sections don't show up in the diff
+  ExportedMenu& exported = m_menus[menu];
+  while( exported.m_sections.size() < sections.size() )
+  {
+    exported.m_sections.emplace_back( QtGMenuExportModel::New(), &g_object_unref );
+  }
+  exported.m_sections.resize( sections.size() );
+
+  std::vector< QtGMenuExportItem > section_items;
+  for( size_t i = 0; i < sections.size(); ++i )
+  {
+    QtGMenuExportModel::SetItems( exported.m_sections[i].data(), std::move( sections[i] ) );
+
+    QtGMenuExportItem section;
+    section.SetLink( G_MENU_LINK_SECTION, exported.m_sections[i].data() );
+    section_items.push_back( section );
+  }
+
+  QtGMenuExportModel::SetItems( exported.m_model.data(), std::move( section_items ) );
+}
+
+QtGMenuExportItem QtGMenuExporterPrivate::Item( QAction* action )
+{
+  QtGMenuExportItem item;
+
+  item.SetAttribute( G_MENU_ATTRIBUTE_LABEL,
+      g_variant_new_string( MnemonicLabel( action->text() ).toUtf8().constData() ) );
+
+  if( QMenu* submenu = action->menu() )
+  {
+    if( !m_menus.contains( submenu ) )
+    {
+      Track( submenu );
+    }
+    item.SetLink( G_MENU_LINK_SUBMENU, m_menus[submenu].m_model.data() );
+  }
+  else
+  {
+    QString name = "app." + ExportAction( action );
+    item.SetAttribute( G_MENU_ATTRIBUTE_ACTION, g_variant_new_string( name.toUtf8().constData() ) );
+  }
+
+  if( !action->shortcut().isEmpty() )
+  {
+    item.SetAttribute( "accel",
+        g_variant_new_string( Accelerator( action->shortcut() ).toUtf8().constData() ) );
+  }
+
+  return item;
+}
+
+QString QtGMenuExporterPrivate::ExportAction( QAction* action )
+{
+  auto it = m_action_names.find( action );
+  if( it == m_action_names.end() )
+  {
+    QString name = QString( "action-%1" ).arg( m_next_action++ );
+    it = m_action_names.insert( action, name );
+    m_actions[name] = action;
+
+    GSimpleAction* simple = nullptr;
+    if( action->isCheckable() )
+    {
+      simple = g_simple_action_new_stateful( name.toUtf8().constData(), NULL,
+          g_variant_new_boolean( action->isChecked() ) );
+    }
+    else
+    {
+      simple = g_simple_action_new( name.toUtf8().constData(), NULL );
+    }
+
+    g_signal_connect( simple, "activate", G_CALLBACK( ActivateCallback ), this );
+    g_action_map_add_action( G_ACTION_MAP( m_action_group.data() ), G_ACTION( simple ) );
+    g_object_unref( simple );
+
+    QObject::connect( action, SIGNAL( destroyed( QObject* ) ), &m_parent,
+        SLOT( ActionDestroyed( QObject* ) ) );
+  }
+
+  // GSimpleAction only signals the state and enabled flag when they actually change
+  GAction* simple = g_action_map_lookup_action( G_ACTION_MAP( m_action_group.data() ),
+      it.value().toUtf8().constData() );
+  g_simple_action_set_enabled( G_SIMPLE_ACTION( simple ), action->isEnabled() );
+  if( action->isCheckable() && g_action_get_state_type( simple ) )
+  {
+    g_simple_action_set_state( G_SIMPLE_ACTION( simple ),
+        g_variant_new_boolean( action->isChecked() ) );
+  }
+
+  return it.value();
+}
+
+void QtGMenuExporterPrivate::ActivateCallback( GSimpleAction* simple, GVariant*,
+    gpointer user_data )
+{
+  QtGMenuExporterPrivate* self = reinterpret_cast< QtGMenuExporterPrivate* >( user_data );
+
+  // triggering a checkable action toggles it, and the change comes back to us as an event
+  QAction* action = self->m_actions.value( g_action_get_name( G_ACTION( simple ) ) );
+  if( action )
+  {
+    action->trigger();
+  }
+}
+
 QtGMenuExporter::QtGMenuExporter( const QString& dbusObjectPath, QMenu* menu,
-    const QDBusConnection& connection )
+    QSharedPointer< GDBusConnection > connection )
     : QObject( menu ),
-      d( new QtGMenuExporterPrivate() )
+      d( new QtGMenuExporterPrivate( *this, connection ) )
 {
+  connect( &d->m_update_timer, SIGNAL( timeout() ), this, SLOT( UpdateMenus() ) );
+
+  d->Track( menu );
+
+  QByteArray path = dbusObjectPath.toUtf8();
+  GError* error = NULL;
+
+  d->m_menu_export_id = g_dbus_connection_export_menu_model( connection.data(), path.constData(),
+      d->m_menus[menu].m_model.data(), &error );
+  if( error )
+  {
+    qWarning() << "Failed to export menu model:" << error->message;
+    g_clear_error( &error );
+  }
+
+  d->m_actions_export_id = g_dbus_connection_export_action_group( connection.data(),
+      path.constData(), G_ACTION_GROUP( d->m_action_group.data() ), &error );
+  if( error )
+  {
+    qWarning() << "Failed to export action group:" << error->message;
+    g_clear_error( &error );
+  }
 }
 
 QtGMenuExporter::~QtGMenuExporter()
 {
+  if( d->m_menu_export_id > 0 )
+  {
+    g_dbus_connection_unexport_menu_model( d->m_connection.data(), d->m_menu_export_id );
+  }
+
+  if( d->m_actions_export_id > 0 )
+  {
+    g_dbus_connection_unexport_action_group( d->m_connection.data(), d->m_actions_export_id );
+  }
+
+  for( QMenu* menu : d->m_menus.keys() )
+  {
+    menu->removeEventFilter( this );
+  }
+}
+
+bool QtGMenuExporter::eventFilter( QObject* watched, QEvent* event )
+{
+  switch( event->type() )
+  {
+  case QEvent::ActionAdded:
+  case QEvent::ActionRemoved:
+  case QEvent::ActionChanged:
+    d->m_dirty_menus.insert( static_cast< QMenu* >( watched ) );
+    d->m_update_timer.start();
+    break;
+  default:
+    break;
+  }
+
+  return QObject::eventFilter( watched, event );
+}
+
+void QtGMenuExporter::UpdateMenus()
+{
+  QSet< QMenu* > dirty_menus;
+  dirty_menus.swap( d->m_dirty_menus );
+
+  for( QMenu* menu : dirty_menus )
+  {
+    if( d->m_menus.contains( menu ) )
+    {
+      d->Update( menu );
+    }
+  }
+}
+
+void QtGMenuExporter::MenuDestroyed( QObject* menu )
+{
+  // any items linking to it keep its model alive until their own menu updates
+  d->m_menus.remove( static_cast< QMenu* >( menu ) );
+  d->m_dirty_menus.remove( static_cast< QMenu* >( menu ) );
+}
+
+void QtGMenuExporter::ActionDestroyed( QObject* action )
+{
+  QString name = d->m_action_names.take( static_cast< QAction* >( action ) );
+  if( name.isEmpty() )
+  {
+    return;
+  }
+
+  d->m_actions.remove( name );
+  g_action_map_remove_action( G_ACTION_MAP( d->m_action_group.data() ),
+      name.toUtf8().constData() );
 }
@@ -20,27 +20,41 @@
 #define QTGMENUEXPORTER_H
 
 #include <QObject>
-#include <QDBusConnection>
+#include <QSharedPointer>
 #include <memory>
 
 class QAction;
 class QMenu;
 
+class _GDBusConnection;
+typedef _GDBusConnection GDBusConnection;
+
 namespace qtgmenu
 {
 
 class QtGMenuExporterPrivate;
 
+// Publishes a QMenu as a GMenuModel, with its actions as a GActionGroup, both at the same
+// object path. The actions are exported without a prefix, so importers should name them "app".
+//
+// Changes to the menus and their actions are gathered up and sent once per event loop
+// iteration, as "items-changed" signals covering only the items that differ.
 class QtGMenuExporter final : public QObject
 {
 Q_OBJECT
 
 public:
-  QtGMenuExporter( const QString& dbusObjectPath, QMenu* menu, const QDBusConnection& connection =
-      QDBusConnection::sessionBus() );
+  QtGMenuExporter( const QString& dbusObjectPath, QMenu* menu,
+      QSharedPointer< GDBusConnection > connection );
   virtual ~QtGMenuExporter();
 
+protected:
+  bool eventFilter( QObject* watched, QEvent* event ) override;
+
 private Q_SLOTS:
+  void UpdateMenus();
+  void MenuDestroyed( QObject* menu );
+  void ActionDestroyed( QObject* action );
 
 private:
   Q_DISABLE_COPY(QtGMenuExporter)
@@ -18,8 +18,7 @@
 
 #include <QtGMenuImporter.h>
 #include <internal/QtGMenuImporterPrivate.h>
-
-#include <QMenu>
+#include <common/MenuTree.h>
 
 using namespace qtgmenu;
 
@@ -57,12 +56,22 @@ QSharedPointer<GActionGroup> QtGMenuImporter::GetGActionGroup( int index ) const
   return d->GetGActionGroup( index );
 }
 
-std::shared_ptr< QMenu > QtGMenuImporter::GetQMenu() const
+QSharedPointer< hud::common::MenuTree > QtGMenuImporter::GetMenuTree() const
 {
-  return d->GetQMenu();
+  return d->GetMenuTree();
 }
 
 void QtGMenuImporter::Refresh()
 {
   d->Refresh();
 }
+
+void QtGMenuImporter::Subscribe()
+{
+  d->Subscribe();
+}
+
+void QtGMenuImporter::Unsubscribe()
+{
+  d->Unsubscribe();
+}
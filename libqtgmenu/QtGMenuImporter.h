@@ -25,7 +25,13 @@
 #include <memory>
 #include <gio/gio.h>
 
-class QMenu;
+namespace hud
+{
+namespace common
+{
+class MenuTree;
+}
+}
 
 class _GMenuModel;
 typedef _GMenuModel GMenuModel;
@@ -53,13 +59,20 @@ public:
                    QObject* parent = 0 );
   virtual ~QtGMenuImporter();
 
+  // the GLib objects belong to the libqtgmenu worker thread, so only use them from there
   QSharedPointer<GMenuModel> GetGMenuModel() const;
   QSharedPointer<GActionGroup> GetGActionGroup( int index = 0 ) const;
 
-  std::shared_ptr< QMenu > GetQMenu() const;
+  QSharedPointer< hud::common::MenuTree > GetMenuTree() const;
 
   void Refresh();
 
+  // follows every sub menu level until Unsubscribe(), e.g. while a search is open
+  void Subscribe();
+
+  // lets go of the deeper levels once they've been left idle for a while
+  void Unsubscribe();
+
 Q_SIGNALS:
   void MenuItemsChanged();
 
@@ -0,0 +1,222 @@
+/*
+ * Copyright (C) 2016 Canonical, Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3, as published
+ * by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranties of
+ * MERCHANTABILITY, SATISFACTORY QUALITY, or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Author: Pete Woods <pete.woods@canonical.com>
+ */
+
+#include <QtGParameterImporter.h>
+#include <internal/QtGMenuUtils.h>
+#include <internal/QtGMenuWorker.h>
+
+#include <QMutex>
+#include <QMutexLocker>
+
+using namespace qtgmenu;
+
+// everything but the owner belongs to the worker thread
+struct QtGParameterImporter::State
+{
+  ~State()
+  {
+    if( m_model )
+    {
+      g_signal_handler_disconnect( m_model, m_model_handler );
+      g_object_unref( m_model );
+    }
+
+    if( m_base_model )
+    {
+      g_signal_handler_disconnect( m_base_model, m_base_handler );
+      g_object_unref( m_base_model );
+    }
+  }
+
+  void Start( QSharedPointer<GDBusConnection> connection, const QString& service,
+              const QDBusObjectPath& menu_path )
+  {
+    m_base_model = G_MENU_MODEL( g_dbus_menu_model_get( connection.data(),
+        service.toUtf8().constData(), menu_path.path().toUtf8().constData() ) );
+    m_base_handler = g_signal_connect( m_base_model, "items-changed",
+        G_CALLBACK( BaseItemsChangedCallback ), this );
+
+    // for a D-Bus menu, asking for the items is what subscribes to its group
+    FindModel();
+  }
+
+  // the position of the action's item in the base menu, or -1
+  int FindItem() const
+  {
+    const int n_items = g_menu_model_get_n_items( m_base_model );
+    if( n_items == 0 )
+    {
+      return -1;
+    }
+
+    // without a name, the menu's first item is the action's
+    if( m_action_name.isEmpty() )
+    {
+      return 0;
+    }
+
+    const QPair<QString, QString> wanted = QtGMenuUtils::splitPrefixAndName( m_action_name );
+
+    for( int index = 0; index < n_items; ++index )
+    {
+      gchar* action = nullptr;
+      g_menu_model_get_item_attribute( m_base_model, index, G_MENU_ATTRIBUTE_ACTION, "s", &action );
+      const QPair<QString, QString> split = QtGMenuUtils::splitPrefixAndName( QString::fromUtf8( action ) );
+      g_free( action );
+
+      // a bare name matches under any prefix, but "app.fade" is never "app.crossfade"
+      if( split.second == wanted.second && ( wanted.first.isEmpty() || split.first == wanted.first ) )
+      {
+        return index;
+      }
+    }
+
+    return -1;
+  }
+
+  void FindModel()
+  {
+    GMenuModel* model = nullptr;
+    const int index = FindItem();
+    if( index != -1 )
+    {
+      model = g_menu_model_get_item_link( m_base_model, index, G_MENU_LINK_SUBMENU );
+    }
+
+    // the base menu changes for all sorts of reasons, most of which leave our link as it was
+    if( model == m_model )
+    {
+      if( model )
+      {
+        g_object_unref( model );
+      }
+      return;
+    }
+
+    // the app has pointed the item at another menu, so follow that one instead
+    if( m_model )
+    {
+      g_signal_handler_disconnect( m_model, m_model_handler );
+      g_object_unref( m_model );
+      m_model_handler = 0;
+    }
+
+    m_model = model;
+    if( !m_model )
+    {
+      return;
+    }
+
+    m_model_handler = g_signal_connect( m_model, "items-changed",
+        G_CALLBACK( ModelItemsChangedCallback ), this );
+    ReadParameters();
+  }
+
+  void ReadParameters()
+  {
+    const int n_items = g_menu_model_get_n_items( m_model );
+    if( n_items == 0 )
+    {
+      return;
+    }
+
+    QVariantList parameters;
+    for( int i = 0; i < n_items; ++i )
+    {
+      QVariantMap attributes;
+
+      GMenuAttributeIter* it = g_menu_model_iterate_item_attributes( m_model, i );
+      const gchar* name = nullptr;
+      GVariant* value = nullptr;
+      while( g_menu_attribute_iter_get_next( it, &name, &value ) )
+      {
+        attributes[QString::fromUtf8( name )] = QtGMenuUtils::GVariantToQVariant( value );
+        g_variant_unref( value );
+      }
+      g_object_unref( it );
+
+      parameters << attributes;
+    }
+
+    QMutexLocker lock( &m_mutex );
+    if( m_owner )
+    {
+      QMetaObject::invokeMethod( m_owner, "SetParameters", Qt::QueuedConnection,
+          Q_ARG( QVariantList, parameters ) );
+    }
+  }
+
+  static void BaseItemsChangedCallback( GMenuModel*, gint, gint, gint, gpointer user_data )
+  {
+    reinterpret_cast< State* >( user_data )->FindModel();
+  }
+
+  static void ModelItemsChangedCallback( GMenuModel*, gint, gint, gint, gpointer user_data )
+  {
+    reinterpret_cast< State* >( user_data )->ReadParameters();
+  }
+
+  // guards m_owner, which the Qt side clears when it goes away
+  QMutex m_mutex;
+  QtGParameterImporter* m_owner = nullptr;
+
+  QString m_action_name;
+
+  GMenuModel* m_base_model = nullptr;
+  gulong m_base_handler = 0;
+
+  GMenuModel* m_model = nullptr;
+  gulong m_model_handler = 0;
+};
+
+QtGParameterImporter::QtGParameterImporter( const QString& service, const QDBusObjectPath& menu_path,
+                                            const QString& action_name,
+                                            QSharedPointer<GDBusConnection> connection, QObject* parent )
+    : QObject( parent ),
+      m_state( std::make_shared< State >() )
+{
+  m_state->m_owner = this;
+  m_state->m_action_name = action_name;
+
+  auto state = m_state;
+  QtGMenuWorker::Instance().Invoke( [state, connection, service, menu_path]()
+  {
+    state->Start( connection, service, menu_path );
+  } );
+}
+
+QtGParameterImporter::~QtGParameterImporter()
+{
+  {
+    QMutexLocker lock( &m_state->m_mutex );
+    m_state->m_owner = nullptr;
+  }
+
+  QtGMenuWorker::Instance().Release( m_state );
+}
+
+QVariantList QtGParameterImporter::GetParameters() const
+{
+  return m_parameters;
+}
+
+void QtGParameterImporter::SetParameters( QVariantList parameters )
+{
+  m_parameters = parameters;
+  Q_EMIT ParametersChanged();
+}
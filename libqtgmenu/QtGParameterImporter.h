@@ -0,0 +1,68 @@
+/*
+ * Copyright (C) 2016 Canonical, Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3, as published
+ * by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranties of
+ * MERCHANTABILITY, SATISFACTORY QUALITY, or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Author: Pete Woods <pete.woods@canonical.com>
+ */
+
+#ifndef QTGPARAMETERIMPORTER_H
+#define QTGPARAMETERIMPORTER_H
+
+#include <QObject>
+#include <QDBusObjectPath>
+#include <QSharedPointer>
+#include <QVariantList>
+#include <memory>
+#include <gio/gio.h>
+
+namespace qtgmenu
+{
+
+// Follows the menu behind a parameterized action, e.g. the sliders of a "Hue / Saturation" dialog.
+//
+// The action's own item is found in the menu at menu_path, and the attributes of every item in
+// its sub menu are handed back as one map each. The base menu is followed for as long as the
+// importer lives, so an item pointed at another sub menu is picked up. Like the menu importer,
+// the GDBus side lives on the libqtgmenu worker thread.
+class QtGParameterImporter final : public QObject
+{
+Q_OBJECT
+
+public:
+  QtGParameterImporter( const QString& service, const QDBusObjectPath& menu_path,
+                        const QString& action_name, QSharedPointer<GDBusConnection> connection,
+                        QObject* parent = 0 );
+  virtual ~QtGParameterImporter();
+
+  // empty until the parameter menu has arrived
+  QVariantList GetParameters() const;
+
+Q_SIGNALS:
+  void ParametersChanged();
+
+private Q_SLOTS:
+  void SetParameters( QVariantList parameters );
+
+private:
+  Q_DISABLE_COPY (QtGParameterImporter)
+
+  struct State;
+  std::shared_ptr< State > m_state;
+
+  QVariantList m_parameters;
+};
+
+} // namespace qtgmenu
+
+#endif // QTGPARAMETERIMPORTER_H
@@ -19,6 +19,8 @@
 #include <QtGActionGroup.h>
 #include <QtGMenuUtils.h>
 
+#include <QThread>
+
 using namespace qtgmenu;
 
 QtGActionGroup::QtGActionGroup( QSharedPointer<GDBusConnection> connection,
@@ -74,6 +76,8 @@ QSharedPointer<GActionGroup> QtGActionGroup::ActionGroup() const
 
 void QtGActionGroup::TriggerAction( QString action_name, bool checked )
 {
+  Q_ASSERT( thread() == QThread::currentThread() );
+
   QPair<QString, QString> split = QtGMenuUtils::splitPrefixAndName(action_name);
   const QString& prefix(split.first);
 
@@ -114,24 +118,36 @@ QString QtGActionGroup::FullName( const QString& prefix, const QString& action_n
   }
 }
 
-void QtGActionGroup::EmitStates()
+void QtGActionGroup::EmitStates( QStringList action_names )
 {
-  auto actions_list = g_action_group_list_actions( m_action_group.data() );
+  Q_ASSERT( thread() == QThread::currentThread() );
 
-  for( int i = 0; actions_list && actions_list[i]; ++i )
+  for( const QString& full_name : action_names )
   {
-    gchar* action_name = actions_list[i];
-
-    bool enabled = G_ACTION_GROUP_GET_IFACE( m_action_group.data() ) ->get_action_enabled( m_action_group.data(),
-        action_name );
-    emit ActionEnabled( FullName(m_action_prefix, action_name), enabled );
+    QPair<QString, QString> split = QtGMenuUtils::splitPrefixAndName( full_name );
+    if( split.first != m_action_prefix )
+    {
+      continue;
+    }
 
-    const GVariantType* type = g_action_group_get_action_parameter_type( m_action_group.data(),
-        action_name );
-    emit ActionParameterized( FullName(m_action_prefix, action_name), type != nullptr );
+    // actions we haven't heard of yet get their state when they're added
+    QByteArray action_utf = split.second.toUtf8();
+    if( g_action_group_has_action( m_action_group.data(), action_utf.constData() ) )
+    {
+      EmitState( full_name, action_utf.constData() );
+    }
   }
+}
+
+void QtGActionGroup::EmitState( const QString& full_name, const gchar* action_name )
+{
+  bool enabled = G_ACTION_GROUP_GET_IFACE( m_action_group.data() ) ->get_action_enabled( m_action_group.data(),
+      action_name );
+  emit ActionEnabled( full_name, enabled );
 
-  g_strfreev( actions_list );
+  const GVariantType* type = g_action_group_get_action_parameter_type( m_action_group.data(),
+      action_name );
+  emit ActionParameterized( full_name, type != nullptr );
 }
 
 void QtGActionGroup::ActionAddedCallback( GActionGroup* action_group, gchar* action_name,
@@ -140,15 +156,8 @@ void QtGActionGroup::ActionAddedCallback( GActionGroup* action_group, gchar* act
   QtGActionGroup* self = reinterpret_cast< QtGActionGroup* >( user_data );
   emit self->ActionAdded( action_name );
 
-  bool enabled = G_ACTION_GROUP_GET_IFACE( self->m_action_group.data() ) ->get_action_enabled(
-      self->m_action_group.data(), action_name );
-  if( !enabled )
-    emit self->ActionEnabled( FullName(self->m_action_prefix, action_name), enabled );
-
-  const GVariantType* type = g_action_group_get_action_parameter_type( self->m_action_group.data(),
-      action_name );
-  if( type != nullptr )
-    emit self->ActionParameterized( FullName(self->m_action_prefix, action_name), type != nullptr );
+  // the menu may be holding on to the state of an action removed earlier under this name
+  self->EmitState( FullName( self->m_action_prefix, action_name ), action_name );
 }
 
 void QtGActionGroup::ActionRemovedCallback( GActionGroup* action_group, gchar* action_name,
@@ -156,6 +165,7 @@ void QtGActionGroup::ActionRemovedCallback( GActionGroup* action_group, gchar* a
 {
   QtGActionGroup* self = reinterpret_cast< QtGActionGroup* >( user_data );
   emit self->ActionRemoved( action_name );
+  emit self->ActionDropped( FullName( self->m_action_prefix, action_name ) );
 }
 
 void QtGActionGroup::ActionEnabledCallback( GActionGroup* action_group, gchar* action_name,
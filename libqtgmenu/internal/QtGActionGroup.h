@@ -21,6 +21,7 @@
 
 #include <QObject>
 #include <QSharedPointer>
+#include <QStringList>
 #include <QVariant>
 
 #undef signals
@@ -29,6 +30,8 @@
 namespace qtgmenu
 {
 
+// Lives on the QtGMenuWorker, which has no Qt event loop, so the slots below must be called
+// directly on the group's own thread.
 class QtGActionGroup : public QObject
 {
 Q_OBJECT
@@ -49,12 +52,16 @@ Q_SIGNALS:
   void ActionParameterized( QString action_name, bool parameterized );
   void ActionStateChanged( QString action_name, QVariant value );
 
+  // carries the full name, as the menu holds on to the states of the actions it has been told about
+  void ActionDropped( QString action_name );
+
 private Q_SLOTS:
   void TriggerAction( QString action_name, bool checked );
-  void EmitStates();
+  void EmitStates( QStringList action_names );
 
 private:
   static QString FullName( const QString& prefix, const QString& name );
+  void EmitState( const QString& full_name, const gchar* action_name );
   static void ActionAddedCallback( GActionGroup* action_group, gchar* action_name,
       gpointer user_data );
   static void ActionRemovedCallback( GActionGroup* action_group, gchar* action_name,
@@ -0,0 +1,195 @@
+/*
+ * Copyright (C) 2016 Canonical, Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3, as published
+ * by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranties of
+ * MERCHANTABILITY, SATISFACTORY QUALITY, or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Author: Pete Woods <pete.woods@canonical.com>
+ */
+
+#include <QtGErrorReporter.h>
+
+#include <QDateTime>
+#include <QDBusConnection>
+#include <QDBusConnectionInterface>
+#include <QDebug>
+#include <QProcess>
+
+using namespace qtgmenu;
+
+static const char* RECOVERABLE_PROBLEM = "/usr/share/apport/recoverable_problem";
+
+// an application is reported at most once an hour
+static const int REPORT_INTERVAL = 60 * 60 * 1000;
+
+static const int MAX_QUEUED_REPORTS = 4;
+
+// how long apport gets before we give up on a report
+static const int REPORT_TIMEOUT = 30000;
+
+QtGErrorReporter& QtGErrorReporter::Instance()
+{
+  static QtGErrorReporter reporter(
+      qEnvironmentVariableIsSet( "HUD_RECOVERABLE_PROBLEM" ) ?
+          QString::fromUtf8( qgetenv( "HUD_RECOVERABLE_PROBLEM" ) ) :
+          QString( RECOVERABLE_PROBLEM ), REPORT_INTERVAL, MAX_QUEUED_REPORTS );
+  return reporter;
+}
+
+QtGErrorReporter::QtGErrorReporter( const QString& program, int interval, int max_queued )
+    : m_program( program ),
+      m_interval( interval ),
+      m_max_queued( max_queued )
+{
+  setObjectName( "qtgerrorreporter" );
+  start();
+}
+
+QtGErrorReporter::~QtGErrorReporter()
+{
+  {
+    QMutexLocker lock( &m_mutex );
+    m_stopping = true;
+    m_queue.clear();
+    m_queue_changed.wakeAll();
+  }
+
+  wait();
+}
+
+bool QtGErrorReporter::Report( const QString& bus_name, const Fields& fields )
+{
+  QMutexLocker lock( &m_mutex );
+
+  const qint64 now = QDateTime::currentMSecsSinceEpoch();
+
+  auto last = m_last_reported.find( bus_name );
+  if( last != m_last_reported.end() && now - last.value() < m_interval )
+  {
+    return false;
+  }
+
+  if( int( m_queue.size() ) >= m_max_queued )
+  {
+    qWarning() << "Too many recoverable errors queued, dropping report for" << bus_name;
+    return false;
+  }
+
+  // forget bus names that could be reported again, so the table doesn't grow forever
+  for( auto it = m_last_reported.begin(); it != m_last_reported.end(); )
+  {
+    if( now - it.value() >= m_interval )
+    {
+      it = m_last_reported.erase( it );
+    }
+    else
+    {
+      ++it;
+    }
+  }
+
+  m_last_reported[bus_name] = now;
+  m_queue.push_back( PendingReport{ bus_name, fields } );
+  m_queue_changed.wakeOne();
+
+  return true;
+}
+
+void QtGErrorReporter::run()
+{
+  while( true )
+  {
+    PendingReport report;
+
+    {
+      QMutexLocker lock( &m_mutex );
+      while( m_queue.empty() && !m_stopping )
+      {
+        m_queue_changed.wait( &m_mutex );
+      }
+
+      if( m_stopping )
+      {
+        return;
+      }
+
+      report = m_queue.front();
+      m_queue.pop_front();
+    }
+
+    Deliver( report );
+    emit Reported( report.m_bus_name );
+  }
+}
+
+static void write_pair(QIODevice& device, const QString& key, const QString& value, bool last = false)
+{
+  device.write(key.toUtf8());
+  device.write("", 1);
+  device.write(value.toUtf8());
+  if( !last )
+  {
+    device.write("", 1);
+  }
+
+  if( !value.isEmpty())
+  {
+    qWarning() << key << " =" << value;
+  }
+}
+
+void QtGErrorReporter::Deliver( const PendingReport& report )
+{
+  uint sender_pid = QDBusConnection::sessionBus().interface()->servicePid(
+            report.m_bus_name);
+  if( sender_pid == 0 ) {
+      qWarning() << "Failed to read PID, cannot report error";
+      return;
+  }
+
+  QProcess recoverable;
+  recoverable.setProcessChannelMode(QProcess::ForwardedChannels);
+  recoverable.start(m_program,
+              QStringList() << "-p" << QString::number(sender_pid));
+  if (!recoverable.waitForStarted())
+  {
+    qWarning() << "Failed to report recoverable error";
+    return;
+  }
+
+  for( int i = 0; i < report.m_fields.size(); ++i )
+  {
+    write_pair(recoverable, report.m_fields[i].first, report.m_fields[i].second,
+        i == report.m_fields.size() - 1);
+  }
+
+  recoverable.closeWriteChannel();
+
+  // keep an eye out for shutdown while apport takes its time
+  for( int waited = 0; recoverable.state() != QProcess::NotRunning
+      && !recoverable.waitForFinished( 100 ); waited += 100 )
+  {
+    bool stopping;
+    {
+      QMutexLocker lock( &m_mutex );
+      stopping = m_stopping;
+    }
+
+    if( stopping || waited >= REPORT_TIMEOUT )
+    {
+      qWarning() << "Gave up waiting to report recoverable error";
+      recoverable.kill();
+      recoverable.waitForFinished();
+      return;
+    }
+  }
+}
@@ -0,0 +1,88 @@
+/*
+ * Copyright (C) 2016 Canonical, Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3, as published
+ * by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranties of
+ * MERCHANTABILITY, SATISFACTORY QUALITY, or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Author: Pete Woods <pete.woods@canonical.com>
+ */
+
+#ifndef QTGERRORREPORTER_H
+#define QTGERRORREPORTER_H
+
+#include <QHash>
+#include <QList>
+#include <QMutex>
+#include <QPair>
+#include <QString>
+#include <QThread>
+#include <QWaitCondition>
+
+#include <deque>
+
+namespace qtgmenu
+{
+
+// Hands recoverable errors in applications' menus to apport, off the caller's thread.
+//
+// Looking up the sender's PID and feeding the report to apport can take seconds, so
+// reports are queued and written by a thread of our own. Each bus name is only reported
+// once per interval, and reports arriving while the queue is full are dropped.
+class QtGErrorReporter : public QThread
+{
+Q_OBJECT
+
+public:
+  typedef QList< QPair< QString, QString > > Fields;
+
+  static QtGErrorReporter& Instance();
+
+  QtGErrorReporter( const QString& program, int interval, int max_queued );
+
+  virtual ~QtGErrorReporter();
+
+  // never blocks, returns false if the report was dropped
+  bool Report( const QString& bus_name, const Fields& fields );
+
+Q_SIGNALS:
+  // the reporter has finished with a report, whether or not it could be delivered
+  void Reported( QString bus_name );
+
+protected:
+  void run() override;
+
+private:
+  struct PendingReport
+  {
+    QString m_bus_name;
+    Fields m_fields;
+  };
+
+  void Deliver( const PendingReport& report );
+
+  const QString m_program;
+  const int m_interval;
+  const int m_max_queued;
+
+  QMutex m_mutex;
+  QWaitCondition m_queue_changed;
+  std::deque< PendingReport > m_queue;
+
+  // when each bus name was last reported, in msecs since the epoch
+  QHash< QString, qint64 > m_last_reported;
+
+  bool m_stopping = false;
+};
+
+} // namespace qtgmenu
+
+#endif // QTGERRORREPORTER_H
@@ -0,0 +1,171 @@
+/*
+ * Copyright (C) 2016 Canonical, Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3, as published
+ * by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranties of
+ * MERCHANTABILITY, SATISFACTORY QUALITY, or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Author: Pete Woods <pete.woods@canonical.com>
+ */
+
+#include <QtGMenuExportModel.h>
+
+#include <algorithm>
+
+using namespace qtgmenu;
+
+typedef struct _QtGExportModel QtGExportModel;
+typedef struct _QtGExportModelClass QtGExportModelClass;
+
+struct _QtGExportModel
+{
+  GMenuModel parent_instance;
+
+  std::vector< QtGMenuExportItem >* items;
+};
+
+struct _QtGExportModelClass
+{
+  GMenuModelClass parent_class;
+};
+
+G_DEFINE_TYPE( QtGExportModel, qtg_export_model, G_TYPE_MENU_MODEL )
+
+#define QTG_EXPORT_MODEL( obj ) ( G_TYPE_CHECK_INSTANCE_CAST( ( obj ), qtg_export_model_get_type(), QtGExportModel ) )
+
+static gboolean qtg_export_model_is_mutable( GMenuModel* )
+{
+  return TRUE;
+}
+
+static gint qtg_export_model_get_n_items( GMenuModel* model )
+{
+  return QTG_EXPORT_MODEL( model )->items->size();
+}
+
+static void qtg_export_model_get_item_attributes( GMenuModel* model, gint position,
+    GHashTable** table )
+{
+  *table = g_hash_table_ref( ( *QTG_EXPORT_MODEL( model )->items )[position].m_attributes.data() );
+}
+
+static void qtg_export_model_get_item_links( GMenuModel* model, gint position, GHashTable** table )
+{
+  *table = g_hash_table_ref( ( *QTG_EXPORT_MODEL( model )->items )[position].m_links.data() );
+}
+
+static void qtg_export_model_finalize( GObject* object )
+{
+  delete QTG_EXPORT_MODEL( object )->items;
+
+  G_OBJECT_CLASS( qtg_export_model_parent_class )->finalize( object );
+}
+
+static void qtg_export_model_init( QtGExportModel* model )
+{
+  model->items = new std::vector< QtGMenuExportItem >();
+}
+
+static void qtg_export_model_class_init( QtGExportModelClass* klass )
+{
+  GObjectClass* object_class = G_OBJECT_CLASS( klass );
+  GMenuModelClass* model_class = G_MENU_MODEL_CLASS( klass );
+
+  object_class->finalize = qtg_export_model_finalize;
+
+  model_class->is_mutable = qtg_export_model_is_mutable;
+  model_class->get_n_items = qtg_export_model_get_n_items;
+  model_class->get_item_attributes = qtg_export_model_get_item_attributes;
+  model_class->get_item_links = qtg_export_model_get_item_links;
+}
+
+QtGMenuExportItem::QtGMenuExportItem()
+    : m_attributes( g_hash_table_new_full( g_str_hash, g_str_equal, g_free,
+          reinterpret_cast< GDestroyNotify >( &g_variant_unref ) ), &g_hash_table_unref ),
+      m_links( g_hash_table_new_full( g_str_hash, g_str_equal, g_free, &g_object_unref ),
+          &g_hash_table_unref )
+{
+}
+
+void QtGMenuExportItem::SetAttribute( const char* name, GVariant* value )
+{
+  g_hash_table_insert( m_attributes.data(), g_strdup( name ), g_variant_ref_sink( value ) );
+}
+
+void QtGMenuExportItem::SetLink( const char* name, GMenuModel* model )
+{
+  g_hash_table_insert( m_links.data(), g_strdup( name ), g_object_ref( model ) );
+}
+
+static bool TablesEqual( GHashTable* a, GHashTable* b, GEqualFunc equal )
+{
+  if( g_hash_table_size( a ) != g_hash_table_size( b ) )
+  {
+    return false;
+  }
+
+  GHashTableIter it;
+  gpointer key, value;
+  g_hash_table_iter_init( &it, a );
+  while( g_hash_table_iter_next( &it, &key, &value ) )
+  {
+    gpointer other = g_hash_table_lookup( b, key );
+    if( !other || !equal( value, other ) )
+    {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+bool QtGMenuExportItem::operator==( const QtGMenuExportItem& other ) const
+{
+  // links are the same only if they point at the same model
+  return TablesEqual( m_attributes.data(), other.m_attributes.data(), &g_variant_equal )
+      && TablesEqual( m_links.data(), other.m_links.data(), &g_direct_equal );
+}
+
+GMenuModel* QtGMenuExportModel::New()
+{
+  return G_MENU_MODEL( g_object_new( qtg_export_model_get_type(), NULL ) );
+}
+
+void QtGMenuExportModel::SetItems( GMenuModel* model, std::vector< QtGMenuExportItem > items )
+{
+  std::vector< QtGMenuExportItem >& current = *QTG_EXPORT_MODEL( model )->items;
+
+  // whatever matches at both ends is left alone
+  const int shortest = std::min( current.size(), items.size() );
+
+  int prefix = 0;
+  while( prefix < shortest && current[prefix] == items[prefix] )
+  {
+    ++prefix;
+  }
+
+  int suffix = 0;
+  while( suffix < shortest - prefix
+      && current[current.size() - 1 - suffix] == items[items.size() - 1 - suffix] )
+  {
+    ++suffix;
+  }
+
+  const int removed = current.size() - prefix - suffix;
+  const int added = items.size() - prefix - suffix;
+
+  current.swap( items );
+
+  if( removed > 0 || added > 0 )
+  {
+    g_menu_model_items_changed( model, prefix, removed, added );
+  }
+}
@@ -0,0 +1,60 @@
+/*
+ * Copyright (C) 2016 Canonical, Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3, as published
+ * by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranties of
+ * MERCHANTABILITY, SATISFACTORY QUALITY, or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Author: Pete Woods <pete.woods@canonical.com>
+ */
+
+#ifndef QTGMENUEXPORTMODEL_H
+#define QTGMENUEXPORTMODEL_H
+
+#include <QSharedPointer>
+
+#include <vector>
+
+#undef signals
+#include <gio/gio.h>
+
+namespace qtgmenu
+{
+
+// One exported item: its attributes (name to GVariant) and links (name to GMenuModel)
+struct QtGMenuExportItem
+{
+  QtGMenuExportItem();
+
+  void SetAttribute( const char* name, GVariant* value );
+  void SetLink( const char* name, GMenuModel* model );
+
+  bool operator==( const QtGMenuExportItem& other ) const;
+
+  QSharedPointer< GHashTable > m_attributes;
+  QSharedPointer< GHashTable > m_links;
+};
+
+// A GMenuModel whose items are replaced wholesale.
+//
+// Unlike GMenu, which signals every insertion and removal on its own, replacing the
+// items here emits a single "items-changed" covering only the range that differs.
+class QtGMenuExportModel final
+{
+public:
+  static GMenuModel* New();
+
+  static void SetItems( GMenuModel* model, std::vector< QtGMenuExportItem > items );
+};
+
+} // namespace qtgmenu
+
+#endif // QTGMENUEXPORTMODEL_H
@@ -18,6 +18,7 @@
 
 #include <QtGMenuImporterPrivate.h>
 #include <QtGMenuUtils.h>
+#include <QtGMenuWorker.h>
 
 #include <QDebug>
 #include <QDBusConnection>
@@ -25,6 +26,8 @@
 
 using namespace qtgmenu;
 
+static const int UNSUBSCRIBE_TIMEOUT = 60000;
+
 QtGMenuImporterPrivate::QtGMenuImporterPrivate( const QString& service, const QDBusObjectPath& menu_path,
                                                 const QMap<QString, QDBusObjectPath>& action_paths, QtGMenuImporter& parent,
                                                 const QDBusConnection& connection, QSharedPointer<GDBusConnection> gconnection)
@@ -43,6 +46,10 @@ QtGMenuImporterPrivate::QtGMenuImporterPrivate( const QString& service, const QD
   connect( &m_service_watcher, SIGNAL( serviceUnregistered( const QString& ) ), this,
       SLOT( ServiceUnregistered() ) );
 
+  m_unsubscribe_timer.setSingleShot( true );
+  m_unsubscribe_timer.setInterval( UNSUBSCRIBE_TIMEOUT );
+  connect( &m_unsubscribe_timer, SIGNAL( timeout() ), this, SLOT( UnsubscribeIdle() ) );
+
   Refresh();
 }
 
@@ -73,14 +80,21 @@ QSharedPointer<GActionGroup> QtGMenuImporterPrivate::GetGActionGroup( int index
   return m_action_groups[index]->ActionGroup();
 }
 
-std::shared_ptr< QMenu > QtGMenuImporterPrivate::GetQMenu()
+hud::common::MenuTree::Ptr QtGMenuImporterPrivate::GetMenuTree()
 {
-  if( m_menu_model == nullptr )
+  // snapshots are only built when asked for, so bursts nobody reads in between cost nothing
+  if( !m_menu_tree && m_menu_model )
   {
-    return nullptr;
+    auto menu_model = m_menu_model;
+    hud::common::MenuTree::Ptr menu_tree;
+    QtGMenuWorker::Instance().InvokeSync( [menu_model, &menu_tree]()
+    {
+      menu_tree = menu_model->GetMenuTree();
+    } );
+    m_menu_tree = menu_tree;
   }
 
-  return m_menu_model->GetQMenu();
+  return m_menu_tree;
 }
 
 void QtGMenuImporterPrivate::Refresh()
@@ -96,6 +110,44 @@ void QtGMenuImporterPrivate::Refresh()
   }
 }
 
+void QtGMenuImporterPrivate::Subscribe()
+{
+  m_unsubscribe_timer.stop();
+  m_subscribed = true;
+
+  if( m_menu_model )
+  {
+    auto menu_model = m_menu_model;
+    QtGMenuWorker::Instance().Invoke( [menu_model]()
+    {
+      menu_model->SubscribeAll();
+    } );
+  }
+}
+
+void QtGMenuImporterPrivate::Unsubscribe()
+{
+  // searches tend to come in quick succession, so hold on to the menus for a while
+  if( m_subscribed )
+  {
+    m_unsubscribe_timer.start();
+  }
+}
+
+void QtGMenuImporterPrivate::UnsubscribeIdle()
+{
+  m_subscribed = false;
+
+  if( m_menu_model )
+  {
+    auto menu_model = m_menu_model;
+    QtGMenuWorker::Instance().Invoke( [menu_model]()
+    {
+      menu_model->UnsubscribeAll();
+    } );
+  }
+}
+
 void QtGMenuImporterPrivate::ClearMenuModel()
 {
   if( m_menu_model == nullptr )
@@ -106,7 +158,8 @@ void QtGMenuImporterPrivate::ClearMenuModel()
   m_menu_model->disconnect();
   m_menu_actions_linked = false;
 
-  m_menu_model = nullptr;
+  m_menu_tree.reset();
+  QtGMenuWorker::Instance().Release( m_menu_model );
 }
 
 void QtGMenuImporterPrivate::ClearActionGroups()
@@ -114,6 +167,7 @@ void QtGMenuImporterPrivate::ClearActionGroups()
   for( auto& action_group : m_action_groups )
   {
     action_group->disconnect();
+    QtGMenuWorker::Instance().Release( action_group );
   }
 
   m_menu_actions_linked = false;
@@ -124,22 +178,33 @@ void QtGMenuImporterPrivate::LinkMenuActions()
 {
   if( m_menu_model && !m_action_groups.empty() && !m_menu_actions_linked )
   {
+    // both ends live on the worker, which has no Qt event loop to deliver queued calls
     for( auto& action_group : m_action_groups )
     {
       connect( m_menu_model.get(), SIGNAL( ActionTriggered( QString, bool ) ), action_group.get(),
-          SLOT( TriggerAction( QString, bool ) ) );
+          SLOT( TriggerAction( QString, bool ) ), Qt::DirectConnection );
 
-      connect( m_menu_model.get(), SIGNAL( MenuItemsChanged( QtGMenuModel*, int, int, int ) ),
-          action_group.get(), SLOT( EmitStates() ) );
+      connect( m_menu_model.get(), SIGNAL( ActionStatesNeeded( QStringList ) ),
+          action_group.get(), SLOT( EmitStates( QStringList ) ), Qt::DirectConnection );
 
       connect( action_group.get(), SIGNAL( ActionEnabled( QString, bool ) ), m_menu_model.get(),
-          SLOT( ActionEnabled( QString, bool ) ) );
+          SLOT( ActionEnabled( QString, bool ) ), Qt::DirectConnection );
 
       connect( action_group.get(), SIGNAL( ActionParameterized( QString, bool ) ),
-          m_menu_model.get(), SLOT( ActionParameterized( QString, bool ) ) );
+          m_menu_model.get(), SLOT( ActionParameterized( QString, bool ) ), Qt::DirectConnection );
+
+      connect( action_group.get(), SIGNAL( ActionDropped( QString ) ), m_menu_model.get(),
+          SLOT( ActionDropped( QString ) ), Qt::DirectConnection );
     }
 
     m_menu_actions_linked = true;
+
+    // states held by the menu came from the old action groups
+    auto menu_model = m_menu_model;
+    QtGMenuWorker::Instance().Invoke( [menu_model]()
+    {
+      menu_model->RequestActionStates();
+    } );
   }
 }
 
@@ -159,13 +224,23 @@ void QtGMenuImporterPrivate::RefreshGMenuModel()
   // clear the menu model for the refresh
   ClearMenuModel();
 
+  // the model's GDBus proxy has to be created on the worker for its signals to arrive there
   QString menu_path = m_menu_path.path();
-  m_menu_model = std::make_shared< QtGMenuModel > ( m_connection, m_service, menu_path, m_action_paths );
+  QtGMenuWorker::Instance().InvokeSync( [this, &menu_path]()
+  {
+    m_menu_model = std::make_shared< QtGMenuModel > ( m_connection, m_service, menu_path, m_action_paths );
+
+    if( m_subscribed )
+    {
+      m_menu_model->SubscribeAll();
+    }
+  } );
 
-  connect( m_menu_model.get(), SIGNAL( MenuItemsChanged( QtGMenuModel*, int, int,
-          int ) ), &m_parent, SIGNAL( MenuItemsChanged()) );
+  connect( m_menu_model.get(), SIGNAL( MenuTreeChanged() ), this, SLOT( MenuTreeChanged() ) );
 
   connect( m_menu_model.get(), SIGNAL( MenuInvalid() ), this, SLOT( MenuInvalid() ) );
+
+  LinkMenuActions();
 }
 
 void QtGMenuImporterPrivate::RefreshGActionGroup()
@@ -179,9 +254,12 @@ void QtGMenuImporterPrivate::RefreshGActionGroup()
     action_path_it.next();
 
     QString action_path = action_path_it.value().path();
-    m_action_groups.push_back(
-                std::make_shared<QtGActionGroup>(m_connection,
-                        action_path_it.key(), m_service, action_path));
+    QtGMenuWorker::Instance().InvokeSync( [this, &action_path_it, &action_path]()
+    {
+      m_action_groups.push_back(
+                  std::make_shared<QtGActionGroup>(m_connection,
+                          action_path_it.key(), m_service, action_path));
+    } );
 
     auto action_group = m_action_groups.back();
 
@@ -198,6 +276,18 @@ void QtGMenuImporterPrivate::RefreshGActionGroup()
   LinkMenuActions();
 }
 
+void QtGMenuImporterPrivate::MenuTreeChanged()
+{
+  // a replaced model's last change can still be on its way
+  if( sender() != m_menu_model.get() )
+  {
+    return;
+  }
+
+  m_menu_tree.reset();
+  emit m_parent.MenuItemsChanged();
+}
+
 void QtGMenuImporterPrivate::MenuInvalid()
 {
   disconnect( &m_service_watcher, SIGNAL( serviceRegistered( const QString& ) ), this,
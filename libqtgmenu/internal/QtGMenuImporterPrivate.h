@@ -24,7 +24,6 @@
 #include <internal/QtGActionGroup.h>
 
 #include <QDBusServiceWatcher>
-#include <QMenu>
 #include <QTimer>
 #include <memory>
 
@@ -47,10 +46,13 @@ public:
   QSharedPointer<GMenuModel> GetGMenuModel();
   QSharedPointer<GActionGroup> GetGActionGroup( int index = 0);
 
-  std::shared_ptr< QMenu > GetQMenu();
+  hud::common::MenuTree::Ptr GetMenuTree();
 
   void Refresh();
 
+  void Subscribe();
+  void Unsubscribe();
+
 private:
   void ClearMenuModel();
   void ClearActionGroups();
@@ -63,7 +65,9 @@ private Q_SLOTS:
 
   void RefreshGMenuModel();
   void RefreshGActionGroup();
+  void MenuTreeChanged();
   void MenuInvalid();
+  void UnsubscribeIdle();
 
 private:
   QDBusServiceWatcher m_service_watcher;
@@ -75,10 +79,17 @@ private:
   QDBusObjectPath m_menu_path;
   QMap<QString, QDBusObjectPath> m_action_paths;
 
+  // these live on the worker thread, so only use them from tasks run there
   std::shared_ptr< QtGMenuModel > m_menu_model = nullptr;
   std::vector< std::shared_ptr< QtGActionGroup > > m_action_groups;
 
+  // the model's latest snapshot, or null until one is asked for since it last changed
+  hud::common::MenuTree::Ptr m_menu_tree;
+
   bool m_menu_actions_linked = false;
+
+  bool m_subscribed = false;
+  QTimer m_unsubscribe_timer;
 };
 
 } // namespace qtgmenu
@@ -16,20 +16,50 @@
  * Author: Marcus Tomlinson <marcus.tomlinson@canonical.com>
  */
 
+#include <common/StringPool.h>
+#include <QtGErrorReporter.h>
 #include <QtGMenuModel.h>
 #include <QtGMenuUtils.h>
+#include <QtGMenuWorker.h>
 #include <QCoreApplication>
-#include <QDBusConnection>
-#include <QDBusConnectionInterface>
 #include <QDebug>
-#include <QProcess>
+#include <QKeySequence>
+#include <QPointer>
 #include <QRegularExpression>
+#include <QThread>
+
+#include <algorithm>
+#include <limits>
 
 using namespace qtgmenu;
+using hud::common::MenuTree;
+using hud::common::StringPool;
+
+// items past this position are only read from the GMenuModel once they're asked for
+static const int PAGE_SIZE = 100;
 
-static const int MAX_NUM_CHILDREN = 100;
+// the menu bar and its menus are always followed, anything deeper only on demand
+static const int EAGER_SUBMENU_DEPTH = 1;
 static const QRegularExpression SINGLE_UNDERSCORE("(?<![_])[_](?![_])");
 
+// replaces count elements at index with the replacement, shifting the tail at most once
+template< typename T >
+static void Splice( std::vector< T >& items, int index, int count, const std::vector< T >& replacement )
+{
+  const int overwritten = std::min( count, int( replacement.size() ) );
+  std::copy( replacement.begin(), replacement.begin() + overwritten, items.begin() + index );
+
+  if( count > overwritten )
+  {
+    items.erase( items.begin() + index + overwritten, items.begin() + index + count );
+  }
+  else
+  {
+    items.insert( items.begin() + index + overwritten, replacement.begin() + overwritten,
+        replacement.end() );
+  }
+}
+
 QtGMenuModel::QtGMenuModel( QSharedPointer<GDBusConnection> connection, const QString& bus_name,
                             const QString& menu_path, const QMap<QString, QDBusObjectPath>& action_paths )
     : QtGMenuModel( QSharedPointer<GMenuModel>(G_MENU_MODEL( g_dbus_menu_model_get( connection.data(),
@@ -38,22 +68,32 @@ QtGMenuModel::QtGMenuModel( QSharedPointer<GDBusConnection> connection, const QS
                     LinkType::Root, nullptr, 0 )
 {
   m_connection = connection;
-  m_bus_name = bus_name;
-  m_menu_path = menu_path;
+
+  // every item in the menu carries these
+  m_bus_name = StringPool::instance().intern( bus_name );
+  m_menu_path = StringPool::instance().intern( menu_path );
   m_action_paths = action_paths;
 }
 
+QtGMenuModel::QtGMenuModel( QSharedPointer<GMenuModel> model )
+    : QtGMenuModel( model, LinkType::Root, nullptr, 0 )
+{
+}
+
 QtGMenuModel::QtGMenuModel( QSharedPointer<GMenuModel> model, LinkType link_type, QtGMenuModel* parent, int index )
     : m_parent( parent ),
+      m_index( index ),
       m_model( model ),
       m_link_type( link_type ),
-      m_menu( new QMenu() ),
-      m_ext_menu( new QMenu() )
+      m_menu_item( std::make_shared< MenuItem >() )
 {
-  ConnectCallback();
+  m_menu_item->m_node.m_flags |= MenuTree::SUBMENU;
+  m_menu_item->m_submenu = this;
 
   if( m_parent )
   {
+    m_depth = m_parent->m_depth + ( m_link_type == LinkType::SubMenu ? 1 : 0 );
+
     m_connection = m_parent->m_connection;
     m_bus_name = m_parent->m_bus_name;
     m_menu_path = m_parent->m_menu_path;
@@ -67,7 +107,7 @@ QtGMenuModel::QtGMenuModel( QSharedPointer<GMenuModel> model, LinkType link_type
       qlabel.replace( SINGLE_UNDERSCORE, "&" );
       g_free( label );
 
-      m_ext_menu->setTitle( qlabel );
+      m_menu_item->m_node.m_label = StringPool::instance().intern( qlabel );
     }
 
     gchar* action_name = NULL;
@@ -75,10 +115,10 @@ QtGMenuModel::QtGMenuModel( QSharedPointer<GMenuModel> model, LinkType link_type
     if( g_menu_model_get_item_attribute( m_parent->m_model.data(), index,
             G_MENU_ATTRIBUTE_ACTION, "s", &action_name ) )
     {
-      qaction_name = QString::fromUtf8( action_name );
+      qaction_name = StringPool::instance().intern( QString::fromUtf8( action_name ) );
       g_free( action_name );
 
-      m_ext_menu->menuAction()->setProperty( c_property_actionName, qaction_name );
+      m_menu_item->m_node.m_actionName = qaction_name;
     }
 
     // if this model has a "commitLabel" property, it is a libhud parameterized action
@@ -89,11 +129,11 @@ QtGMenuModel::QtGMenuModel( QSharedPointer<GMenuModel> model, LinkType link_type
       g_free( commit_label );
 
       // is parameterized
-      m_ext_menu->menuAction()->setProperty( c_property_isParameterized, true );
+      m_menu_item->m_node.m_flags |= MenuTree::PARAMETERIZED;
 
       // dbus paths
-      m_ext_menu->menuAction()->setProperty( c_property_busName, m_bus_name );
-      m_ext_menu->menuAction()->setProperty( c_property_menuPath, m_menu_path );
+      m_menu_item->m_node.m_busName = m_bus_name;
+      m_menu_item->m_node.m_menuPath = m_menu_path;
 
       if( !qaction_name.isEmpty() )
       {
@@ -101,31 +141,35 @@ QtGMenuModel::QtGMenuModel( QSharedPointer<GMenuModel> model, LinkType link_type
         const QString& prefix(split.first);
         if( m_action_paths.contains(prefix) )
         {
-          m_ext_menu->menuAction()->setProperty( c_property_actionsPath, m_action_paths[prefix].path() );
+          m_menu_item->m_node.m_actionsPath = m_action_paths[prefix].path();
         }
       }
     }
   }
 
-  if( m_model )
+  if( m_link_type != LinkType::SubMenu || m_depth <= EAGER_SUBMENU_DEPTH || Root()->m_subscribe_all )
   {
-    m_size = std::min( MAX_NUM_CHILDREN, g_menu_model_get_n_items( m_model.data() ) );
+    Subscribe();
   }
-
-  ChangeMenuItems( 0, m_size, 0 );
 }
 
 QtGMenuModel::~QtGMenuModel()
 {
-  if( m_model )
+  if( m_changes_source )
   {
-    if( m_size > 0 )
-    {
-      ChangeMenuItems( 0, 0, m_size );
-    }
-    DisconnectCallback();
+    g_source_destroy( m_changes_source );
+    g_source_unref( m_changes_source );
   }
 
+  DisconnectCallback();
+
+  // nobody is left to tell about the change, so just drop our items
+  for( const MenuItem::Ptr& item : m_items )
+  {
+    ActionRemoved( item->m_node.m_actionName, item );
+  }
+  m_items.clear();
+
   m_children.clear();
 }
 
@@ -146,50 +190,110 @@ QtGMenuModel* QtGMenuModel::Parent() const
 
 QSharedPointer<QtGMenuModel> QtGMenuModel::Child( int index ) const
 {
-  if( m_children.contains( index ) )
+  if( index >= 0 && index < int( m_children.size() ) )
   {
-    return m_children.value( index );
+    return m_children[index];
   }
 
   return QSharedPointer<QtGMenuModel>();
 }
 
-std::shared_ptr< QMenu > QtGMenuModel::GetQMenu()
+MenuTree::Ptr QtGMenuModel::GetMenuTree()
 {
-  auto top_menu = std::make_shared< QMenu >();
+  MenuTree::Ptr tree( new MenuTree() );
 
-  AppendQMenu( top_menu );
+  // every item gets indexed, so this is when the rest of a long menu is read
+  FetchPendingItems();
+  AppendMenuTree( *tree, MenuTree::ROOT );
 
-  return top_menu;
+  // the tree is used on the Qt side and can outlive us, so check we're still here on our own thread
+  QPointer< QtGMenuModel > model( this );
+  tree->setActivator( [model]( const MenuTree& tree, int index )
+  {
+    QString action_name = tree.node( index ).m_actionName;
+    QtGMenuWorker::Instance().Invoke( [model, action_name]()
+    {
+      if( model )
+      {
+        model->TriggerAction( action_name );
+      }
+    } );
+  } );
+
+  return tree;
 }
 
-void QtGMenuModel::ActionTriggered( bool checked )
+void QtGMenuModel::TriggerAction( const QString& action_name )
 {
-  QAction* action = dynamic_cast< QAction* >( QObject::sender() );
-  emit ActionTriggered( action->property( c_property_actionName ).toString(), checked );
+  emit ActionTriggered( action_name, false );
 }
 
-void QtGMenuModel::ActionEnabled( QString action_name, bool enabled )
+void QtGMenuModel::RequestActionStates()
 {
-  auto action_it = m_actions.find( action_name );
-  if( action_it != end( m_actions ) )
+  m_action_states.clear();
+
+  for( const auto& action : m_actions )
   {
-    for( auto& action : action_it->second )
+    if( !action.first.isEmpty() )
     {
-      action->setEnabled( enabled );
+      m_unknown_actions.insert( action.first );
     }
   }
+
+  QueueChanges();
+}
+
+void QtGMenuModel::ActionEnabled( QString action_name, bool enabled )
+{
+  SetActionFlag( action_name, MenuTree::ENABLED, enabled );
 }
 
 void QtGMenuModel::ActionParameterized( QString action_name, bool parameterized )
 {
+  SetActionFlag( action_name, MenuTree::PARAMETERIZED, parameterized );
+}
+
+void QtGMenuModel::ActionDropped( QString action_name )
+{
+  // nothing can be triggered through the items until the action comes back with a state of its own
+  SetActionFlag( action_name, MenuTree::ENABLED, false );
+  m_action_states.erase( action_name );
+}
+
+void QtGMenuModel::SetActionFlag( const QString& action_name, MenuTree::Flag flag, bool on )
+{
+  Q_ASSERT( thread() == QThread::currentThread() );
+
+  auto state_it = m_action_states.find( action_name );
+  const bool known = state_it != m_action_states.end();
+
+  quint32 state = known ? state_it->second : quint32( MenuTree::ENABLED );
+  quint32 new_state = on ? ( state | flag ) : ( state & ~quint32( flag ) );
+
+  if( known && new_state == state )
+  {
+    return;
+  }
+  m_action_states[action_name] = new_state;
+
   auto action_it = m_actions.find( action_name );
   if( action_it != end( m_actions ) )
   {
-    for( auto& action : action_it->second )
+    for( auto& item : action_it->second )
     {
-      action->setProperty( c_property_isParameterized, parameterized );
+      if( on )
+      {
+        item->m_node.m_flags |= flag;
+      }
+      else
+      {
+        item->m_node.m_flags &= ~quint32( flag );
+      }
     }
+
+    // the Qt side only sees the change in a new snapshot
+    m_items_changed = true;
+    QueueChanges();
   }
 }
 
@@ -242,7 +346,7 @@ void QtGMenuModel::MenuItemsChangedCallback( GMenuModel* model, gint index, gint
   self->ChangeMenuItems( index, added, removed );
 }
 
-void QtGMenuModel::ChangeMenuItems( const int index, int added, const int removed )
+void QtGMenuModel::ChangeMenuItems( const int index, const int added, const int removed )
 {
   const int n_items = g_menu_model_get_n_items( m_model.data() );
 
@@ -252,102 +356,118 @@ void QtGMenuModel::ChangeMenuItems( const int index, int added, const int remove
     return;
   }
 
-  // Limit the menus exported to avoid memory wastage
-  if ( m_size + (added - removed) > MAX_NUM_CHILDREN )
-  {
-    added = MAX_NUM_CHILDREN - (m_size - removed);
-  }
+  ReplaceItems( index, added, removed, PAGE_SIZE );
+
+  Root()->m_items_changed = true;
+  QueueChanges();
+}
 
+void QtGMenuModel::ReplaceItems( const int index, const int added, const int removed, const int first_pending )
+{
   // process removed items first (see "items-changed" on the GMenuModel man page)
-  if( removed > 0 )
+  for( int i = index; i < index + removed; ++i )
   {
-    // remove QAction from 'index' of our QMenu, 'removed' times
-    for( int i = 0; i < removed; ++i )
+    if( m_items[i]->m_pending )
     {
-      if( index < m_menu->actions().size() )
-      {
-        QAction* at_action = m_menu->actions().at( index );
-        ActionRemoved( at_action->property( c_property_actionName ).toString(), at_action );
-        m_menu->removeAction( at_action );
-      }
+      --m_pending_count;
     }
-
-    // update m_children
-    for( int i = index; i < m_size; ++i )
+    else
     {
-      // remove children from index until ( index + removed )
-      if( i < ( index + removed ) )
-      {
-        m_children.take( i );
-      }
-      // shift children from ( index + removed ) to m_size into the now empty positions
-      else if( m_children.contains( i ) )
-      {
-        m_children.insert( i - removed, m_children.take( i ) );
-      }
+      ActionRemoved( m_items[i]->m_node.m_actionName, m_items[i] );
     }
-
-    // update m_size
-    m_size -= removed;
   }
 
-  // now process added items
-  if( added > 0 )
+  // build the added items up front, so the splice below moves our tail only once
+  std::vector< MenuItem::Ptr > new_items;
+  std::vector< QSharedPointer< QtGMenuModel > > new_children;
+  std::vector< MenuItem::Ptr > new_ext_items;
+  std::vector< int > new_ext_sizes;
+  new_items.reserve( added );
+  new_children.reserve( added );
+  new_ext_sizes.reserve( added );
+
+  for( int i = index; i < ( index + added ); ++i )
   {
-    // update m_children (start from the end and work backwards as not to overlap items as we shift them up)
-    for( int i = m_size - 1; i >= index; --i )
+    // try first to create a child model, though past the first page not even the links are read yet
+    QSharedPointer< QtGMenuModel > model;
+    if( i < first_pending )
     {
-      // shift 'added' items up from their current index to ( index + added )
-      if( m_children.contains( i ) )
-      {
-        m_children.insert( i + added, m_children.take( i ) );
-      }
+      model = CreateChild( this, m_model, i );
     }
+    MenuItem::Ptr new_item;
 
-    // update m_size
-    m_size += added;
+    // if this is a placeholder, which could still turn out to be any of the below
+    if( i >= first_pending )
+    {
+      new_item = std::make_shared< MenuItem >();
+      new_item->m_pending = true;
+      ++m_pending_count;
+    }
+    else if( !model )
+    {
+      new_item = CreateItem( i );
+      ActionAdded( new_item->m_node.m_actionName, new_item );
+    }
+    // else if this is a section model
+    else if( model->Type() == LinkType::Section )
+    {
+      ConnectChild( model );
 
-    // now add a new QAction to our QMenu for each new item
-    for( int i = index; i < ( index + added ); ++i )
+      new_item = std::make_shared< MenuItem >();
+      new_item->m_node.m_flags |= MenuTree::SEPARATOR;
+
+      new_ext_items.insert( new_ext_items.end(), model->m_ext_items.begin(), model->m_ext_items.end() );
+    }
+    // else if this is a sub menu model
+    else
     {
-      QAction* at_action = nullptr;
-      if( i < m_menu->actions().size() )
-      {
-        at_action = m_menu->actions().at( i );
-      }
+      ConnectChild( model );
 
-      // try first to create a child model
-      QSharedPointer< QtGMenuModel > model = CreateChild( this, m_model, i );
+      new_item = model->m_menu_item;
+      ActionAdded( new_item->m_node.m_actionName, new_item );
+    }
 
-      // if this is a menu item and not a model
-      if( !model )
-      {
-        QAction* new_action = CreateAction( i );
-        ActionAdded( new_action->property( c_property_actionName ).toString(), new_action );
-        m_menu->insertAction( at_action, new_action );
-      }
-      // else if this is a section model
-      else if( model->Type() == LinkType::Section )
-      {
-        InsertChild( model, i );
-        m_menu->insertSeparator( at_action );
-      }
-      // else if this is a sub menu model
-      else if( model->Type() == LinkType::SubMenu )
-      {
-        InsertChild( model, i );
-        ActionAdded( model->m_ext_menu->menuAction()->property( c_property_actionName ).toString(),
-                     model->m_ext_menu->menuAction() );
-        m_menu->insertMenu( at_action, model->m_ext_menu.data() );
-      }
+    new_ext_items.push_back( new_item );
+    new_ext_sizes.push_back( model && model->Type() == LinkType::Section ?
+        int( model->m_ext_items.size() ) + 1 : 1 );
+
+    new_items.push_back( new_item );
+    new_children.push_back( model );
+  }
+
+  // the flattened range the removed items covered
+  const int ext_offset = ExtOffset( index );
+  const int ext_removed = ExtOffset( index + removed ) - ext_offset;
+
+  Splice( m_items, index, removed, new_items );
+  Splice( m_children, index, removed, new_children );
+  m_size += added - removed;
+
+  if( added == removed )
+  {
+    // nothing moves, so only the replaced items' sizes change
+    for( int i = 0; i < added; ++i )
+    {
+      AddExtSize( index + i, new_ext_sizes[i] - m_ext_sizes[index + i] );
     }
   }
+  else
+  {
+    Splice( m_ext_sizes, index, removed, new_ext_sizes );
+    RebuildExtOffsets( index );
+  }
 
-  // update external menu
-  UpdateExtQMenu();
+  // only items that moved need renumbering, and the splice has already moved them
+  const int moved_end = added == removed ? index + added : int( m_children.size() );
+  for( int i = index; i < moved_end; ++i )
+  {
+    if( m_children[i] )
+    {
+      m_children[i]->m_index = i;
+    }
+  }
 
-  // now tell the outside world that items have changed
-  emit MenuItemsChanged( this, index, removed, added );
+  SpliceExtItems( ext_offset, ext_removed, new_ext_items );
 }
 
 void QtGMenuModel::ConnectCallback()
@@ -369,40 +489,195 @@ void QtGMenuModel::DisconnectCallback()
   m_items_changed_handler = 0;
 }
 
-void QtGMenuModel::InsertChild( QSharedPointer<QtGMenuModel> child, int index )
+void QtGMenuModel::Subscribe()
 {
-  if( m_children.contains( index ) )
+  if( m_subscribed )
   {
     return;
   }
 
-  child->m_parent = this;
-  m_children.insert( index, child );
+  // we let go of our model when unsubscribing, so find it again through our parent
+  if( !m_model && m_parent && m_parent->m_model && m_parent->Child( m_index ).data() == this )
+  {
+    m_model.reset( g_menu_model_get_item_link( m_parent->m_model.data(), m_index,
+        G_MENU_LINK_SUBMENU ), &g_object_unref );
+  }
+
+  if( !m_model )
+  {
+    return;
+  }
+
+  m_subscribed = true;
+  ConnectCallback();
+
+  // for a D-Bus menu, asking for the items is what subscribes to its group
+  ChangeMenuItems( 0, g_menu_model_get_n_items( m_model.data() ), 0 );
+}
+
+void QtGMenuModel::Unsubscribe()
+{
+  if( !m_subscribed )
+  {
+    return;
+  }
+
+  ChangeMenuItems( 0, 0, m_size );
+  DisconnectCallback();
+
+  // the group stays subscribed for as long as anybody holds its model
+  m_model.reset();
+  m_subscribed = false;
+}
+
+void QtGMenuModel::SubscribeAll()
+{
+  if( !m_parent )
+  {
+    m_subscribe_all = true;
+  }
+
+  Subscribe();
+
+  // sub menus that are still being fetched pick up m_subscribe_all when they're created
+  for( auto& child : m_children )
+  {
+    if( child )
+    {
+      child->SubscribeAll();
+    }
+  }
+}
+
+void QtGMenuModel::UnsubscribeAll()
+{
+  if( !m_parent )
+  {
+    m_subscribe_all = false;
+  }
+
+  for( auto& child : m_children )
+  {
+    if( !child )
+    {
+      continue;
+    }
+
+    if( child->m_link_type == LinkType::SubMenu && child->m_depth > EAGER_SUBMENU_DEPTH )
+    {
+      child->Unsubscribe();
+    }
+    else
+    {
+      child->UnsubscribeAll();
+    }
+  }
+}
 
-  connect( child.data(), SIGNAL( MenuItemsChanged( QtGMenuModel*, int, int, int ) ), this,
-      SIGNAL( MenuItemsChanged( QtGMenuModel*, int, int, int ) ) );
+void QtGMenuModel::ConnectChild( QSharedPointer<QtGMenuModel> child )
+{
+  child->m_parent = this;
 
   connect( child.data(), SIGNAL( ActionTriggered( QString, bool ) ), this,
       SIGNAL( ActionTriggered( QString, bool ) ) );
 
   connect( child.data(), SIGNAL( MenuInvalid() ), this, SIGNAL( MenuInvalid() ) );
+}
 
-  // emit signal informing subscribers that this child has added all of its menu items
-  emit MenuItemsChanged( child.data(), 0, 0, child->m_size );
+QtGMenuModel* QtGMenuModel::Root()
+{
+  QtGMenuModel* root = this;
+  while( root->m_parent )
+  {
+    root = root->m_parent;
+  }
+  return root;
 }
 
-QAction* QtGMenuModel::CreateAction( int index )
+void QtGMenuModel::QueueChanges()
 {
-  QAction* action = new QAction( m_menu.data() );
+  QtGMenuModel* root = Root();
+
+  // a burst of "items-changed" arrives within one main loop iteration, so tell the outside world once
+  if( !root->m_changes_source )
+  {
+    root->m_changes_source = g_idle_source_new();
+    g_source_set_callback( root->m_changes_source, EmitQueuedChangesCallback, root, NULL );
+    g_source_attach( root->m_changes_source, g_main_context_get_thread_default() );
+  }
+}
+
+gboolean QtGMenuModel::EmitQueuedChangesCallback( gpointer user_data )
+{
+  QtGMenuModel* self = reinterpret_cast< QtGMenuModel* >( user_data );
+  self->EmitQueuedChanges();
+  return G_SOURCE_REMOVE;
+}
 
-  // action label
+void QtGMenuModel::EmitQueuedChanges()
+{
+  g_source_unref( m_changes_source );
+  m_changes_source = nullptr;
+
+  if( !m_unknown_actions.isEmpty() )
+  {
+    QStringList action_names = m_unknown_actions.toList();
+    m_unknown_actions.clear();
+    emit ActionStatesNeeded( action_names );
+  }
+
+  if( m_items_changed )
+  {
+    m_items_changed = false;
+    emit MenuTreeChanged();
+  }
+}
+
+QtGMenuModel::MenuItem::Ptr QtGMenuModel::CreateItem( int index )
+{
+  auto item = std::make_shared< MenuItem >();
+  FetchItem( *item, index );
+  return item;
+}
+
+void QtGMenuModel::FetchPendingItems()
+{
+  if( m_pending_count > 0 )
+  {
+    // a placeholder can turn out to be a section or sub menu, so each is replaced like any other item
+    for( int i = 0; i < int( m_items.size() ) && m_pending_count > 0; ++i )
+    {
+      if( m_items[i]->m_pending )
+      {
+        ReplaceItems( i, 1, 1, std::numeric_limits< int >::max() );
+      }
+    }
+
+    // the snapshot being built already has these items, but their actions' states are still wanted
+    QueueChanges();
+  }
+
+  for( auto& child : m_children )
+  {
+    if( child )
+    {
+      child->FetchPendingItems();
+    }
+  }
+}
+
+void QtGMenuModel::FetchItem( MenuItem& item, int index ) const
+{
+  MenuTree::Node& node = item.m_node;
+
+  // item label
   gchar* label = NULL;
   if( g_menu_model_get_item_attribute( m_model.data(), index, G_MENU_ATTRIBUTE_LABEL, "s", &label ) ) {
     QString qlabel = QString::fromUtf8( label );
     qlabel.replace( SINGLE_UNDERSCORE, "&" );
     g_free( label );
 
-    action->setText( qlabel );
+    node.m_label = StringPool::instance().intern( qlabel );
   }
 
   // action name
@@ -410,203 +685,233 @@ QAction* QtGMenuModel::CreateAction( int index )
   if( g_menu_model_get_item_attribute( m_model.data(), index,
 	      G_MENU_ATTRIBUTE_ACTION, "s", &action_name ) )
   {
-    QString qaction_name = QString::fromUtf8( action_name );
+    node.m_actionName = StringPool::instance().intern( QString::fromUtf8( action_name ) );
     g_free( action_name );
-
-    action->setProperty( c_property_actionName, qaction_name );
   }
 
-  // is parameterized (set false by default until signal received)
-  action->setProperty( c_property_isParameterized, false );
+  // is parameterized (not flagged until signal received)
 
   // dbus paths
-  action->setProperty( c_property_busName, m_bus_name );
-  action->setProperty( c_property_menuPath, m_menu_path );
-
-  // action icon
-  GVariant* icon = g_menu_model_get_item_attribute_value( m_model.data(), index, G_MENU_ATTRIBUTE_ICON,
-      G_VARIANT_TYPE_VARIANT );
-
-  if( icon )
-  {
-    g_variant_unref( icon );
-  }
+  node.m_busName = m_bus_name;
+  node.m_menuPath = m_menu_path;
 
-  // action shortcut
+  // item shortcut
   gchar* shortcut = NULL;
   if( g_menu_model_get_item_attribute( m_model.data(), index, "accel", "s", &shortcut ) )
   {
     QString qshortcut = QString::fromUtf8( shortcut );
     g_free( shortcut );
 
-    action->setShortcut( QtGMenuUtils::QStringToQKeySequence( qshortcut ) );
+    node.m_accel = StringPool::instance().intern(
+        QtGMenuUtils::QStringToQKeySequence( qshortcut ).toString() );
   }
 
-  // action shortcut
+  // toolbar item
   gchar* toolbar_item = NULL;
   if( g_menu_model_get_item_attribute( m_model.data(), index, c_property_hud_toolbar_item, "s", &toolbar_item ) )
   {
-    QString qtoolbar_item = QString::fromUtf8( toolbar_item );
+    node.m_toolbarItem = StringPool::instance().intern( QString::fromUtf8( toolbar_item ) );
     g_free( toolbar_item );
-
-    action->setProperty( c_property_hud_toolbar_item, qtoolbar_item );
   }
 
-  // action keywords
+  // item keywords
   gchar* keywords = NULL;
   if( g_menu_model_get_item_attribute( m_model.data(), index, c_property_keywords, "s", &keywords ) )
   {
-    QVariant qkeywords = QString::fromUtf8( keywords );
+    node.m_keywords = StringPool::instance().intern( QString::fromUtf8( keywords ) );
     g_free( keywords );
-
-    action->setProperty( c_property_keywords, qkeywords );
   }
+}
 
-  // action trigger
-  connect( action, SIGNAL( triggered( bool ) ), this, SLOT( ActionTriggered( bool ) ) );
+void QtGMenuModel::AppendMenuItem( MenuTree& tree, int parent, const MenuItem& item )
+{
+  int index = tree.append( parent, item.m_node );
 
-  return action;
+  if( item.m_submenu )
+  {
+    AppendExtItems( tree, index, item.m_submenu->m_ext_items, false );
+  }
 }
 
-void QtGMenuModel::AppendQMenu( std::shared_ptr< QMenu > top_menu )
+void QtGMenuModel::AppendExtItems( MenuTree& tree, int parent, const std::vector< MenuItem::Ptr >& items,
+    bool skip_submenus )
 {
-  if( m_link_type == LinkType::Root )
+  // empty and nested sections leave runs of separators, so only keep those between items
+  const MenuItem* separator = nullptr;
+  bool appended = false;
+
+  for( const MenuItem::Ptr& item : items )
   {
-    for( QAction* action : m_ext_menu->actions() )
+    if( skip_submenus && item->m_submenu )
     {
-      if( !action->menu() )
-      {
-        top_menu->addAction( action );
-      }
+      continue;
+    }
+
+    if( item->m_node.flag( MenuTree::SEPARATOR ) )
+    {
+      separator = item.get();
+      continue;
     }
+
+    if( separator && appended )
+    {
+      tree.append( parent, separator->m_node );
+    }
+    separator = nullptr;
+
+    AppendMenuItem( tree, parent, *item );
+    appended = true;
+  }
+}
+
+void QtGMenuModel::AppendMenuTree( MenuTree& tree, int parent ) const
+{
+  // the root's sub menus are appended by the sub menu models themselves
+  if( m_link_type == LinkType::Root )
+  {
+    AppendExtItems( tree, parent, m_ext_items, true );
   }
   else if( m_link_type == LinkType::SubMenu )
   {
-    top_menu->addAction( m_ext_menu->menuAction() );
+    AppendMenuItem( tree, parent, *m_menu_item );
   }
 
   if( m_link_type != LinkType::SubMenu )
   {
     for( auto& child : m_children )
     {
-      child->AppendQMenu( top_menu );
+      if( child )
+      {
+        child->AppendMenuTree( tree, parent );
+      }
     }
   }
 }
 
-void QtGMenuModel::UpdateExtQMenu()
+int QtGMenuModel::ExtOffset( int index ) const
 {
-  m_ext_menu->clear();
+  int offset = 0;
+  for( int i = index; i > 0; i -= i & -i )
+  {
+    offset += m_ext_offsets[i];
+  }
+  return offset;
+}
 
-  for( int i = 0; i < m_menu->actions().size(); ++i )
+void QtGMenuModel::AddExtSize( int index, int delta )
+{
+  m_ext_sizes[index] += delta;
+  for( int i = index + 1; i < int( m_ext_offsets.size() ); i += i & -i )
   {
-    QAction* action = m_menu->actions().at( i );
+    m_ext_offsets[i] += delta;
+  }
+}
 
-    if( action->isSeparator() )
-    {
-      QSharedPointer<QtGMenuModel> child = Child( i );
-      if( !child || child->Type() != LinkType::Section )
-      {
-        continue;
-      }
+void QtGMenuModel::RebuildExtOffsets( int from )
+{
+  const int n = m_ext_sizes.size();
+  m_ext_offsets.resize( n + 1 );
 
-      for( QAction* sub_action : child->m_ext_menu->actions() )
-      {
-        m_ext_menu->addAction( sub_action );
-      }
-      m_ext_menu->addSeparator();
-    }
-    else
-    {
-      m_ext_menu->addAction( action );
-    }
+  // nodes up to from only cover items ahead of it, which haven't moved
+  std::vector< int > prefixes( n - from + 1 );
+  prefixes[0] = ExtOffset( from );
+  for( int i = from + 1; i <= n; ++i )
+  {
+    prefixes[i - from] = prefixes[i - from - 1] + m_ext_sizes[i - 1];
   }
 
-  if( m_ext_menu->actions().size() > 0 )
+  // each later node sums the sizes of the items it covers, which can reach back past from
+  for( int i = from + 1; i <= n; ++i )
   {
-    QAction* last_action = m_ext_menu->actions().last();
-    if( last_action && last_action->isSeparator() )
-    {
-      m_ext_menu->removeAction( last_action );
-    }
+    const int start = i - ( i & -i );
+    const int before = start >= from ? prefixes[start - from] : ExtOffset( start );
+    m_ext_offsets[i] = prefixes[i - from] - before;
   }
+}
+
+void QtGMenuModel::SpliceExtItems( int offset, int removed, const std::vector< MenuItem::Ptr >& added )
+{
+  Splice( m_ext_items, offset, removed, added );
 
-  // if this is a section within a parent menu, we need to update the parent menu as well
+  // if this is a section within a parent menu, the same range moves in the parent's items
   if( m_link_type == LinkType::Section && m_parent )
   {
-    m_parent->UpdateExtQMenu();
+    m_parent->SectionItemsChanged( this, offset, removed, added );
   }
 }
 
-void QtGMenuModel::ActionAdded( const QString& name, QAction* action )
+void QtGMenuModel::SectionItemsChanged( const QtGMenuModel* section, int offset, int removed,
+    const std::vector< MenuItem::Ptr >& added )
 {
-  // add action to top menu's m_actions
+  // a section that is still being built gets spliced in whole once it's done
+  const int index = section->m_index;
+  if( Child( index ).data() != section )
+  {
+    return;
+  }
+
+  AddExtSize( index, int( added.size() ) - removed );
+
+  SpliceExtItems( ExtOffset( index ) + offset, removed, added );
+}
+
+void QtGMenuModel::ActionAdded( const QString& name, MenuItem::Ptr item )
+{
+  // add item to top menu's m_actions
   if( m_parent )
   {
-    m_parent->ActionAdded( name, action );
+    m_parent->ActionAdded( name, item );
   }
   else
   {
-    // check if the action name is already in our map
-    if( m_actions.find( name ) != m_actions.end() )
+    // add the item to the list of items under this name, creating it if needs be
+    m_actions[name].push_back( item );
+
+    // take on a state we already know, or ask for it along with the rest of this burst
+    auto state_it = m_action_states.find( name );
+    if( state_it != m_action_states.end() )
     {
-      // add the QAction pointer to the list of actions under this name
-      m_actions[name].push_back( action );
+      const quint32 state_flags = MenuTree::ENABLED | MenuTree::PARAMETERIZED;
+      item->m_node.m_flags = ( item->m_node.m_flags & ~state_flags ) | state_it->second;
     }
-    else
+    else if( !name.isEmpty() )
     {
-      // otherwise insert the new action into the map
-      m_actions.insert( std::make_pair( name, std::vector< QAction* >{ action } ) );
+      m_unknown_actions.insert( name );
     }
   }
 }
 
-void QtGMenuModel::ActionRemoved( const QString& name, QAction* action )
+void QtGMenuModel::ActionRemoved( const QString& name, MenuItem::Ptr item )
 {
-  // remove action from top menu's m_actions
+  // remove item from top menu's m_actions
   if( m_parent )
   {
-    m_parent->ActionRemoved( name, action );
+    m_parent->ActionRemoved( name, item );
   }
   else
   {
-    // check if this action is actually in our map
-    if( m_actions.find( name ) != m_actions.end() )
+    // check if this item is actually in our map
+    auto action_it = m_actions.find( name );
+    if( action_it != m_actions.end() )
     {
-      // remove the QAction pointer from the list of actions under this name
-      auto& actionList = m_actions[name];
-      auto actionIt = std::find( actionList.begin(), actionList.end(), action );
+      // remove the item from the list of items under this name
+      auto& item_list = action_it->second;
+      auto item_it = std::find( item_list.begin(), item_list.end(), item );
 
-      if( actionIt != actionList.end())
+      if( item_it != item_list.end() )
       {
-        actionList.erase( actionIt );
+        item_list.erase( item_it );
       }
 
       // if there are no more references to this action, remove it from the map
-      if( actionList.size() == 0 )
+      if( item_list.empty() )
       {
-        m_actions.erase( name );
+        m_actions.erase( action_it );
       }
     }
   }
 }
 
-static void write_pair(QIODevice& device, const QString& key, const QString& value, bool last = false)
-{
-  device.write(key.toUtf8());
-  device.write("", 1);
-  device.write(value.toUtf8());
-  if( !last )
-  {
-    device.write("", 1);
-  }
-
-  if( !value.isEmpty())
-  {
-    qWarning() << key << " =" << value;
-  }
-}
-
 void QtGMenuModel::ReportRecoverableError(const int index, const int added, const int removed)
 {
   if( m_error_reported )
@@ -644,12 +949,12 @@ void QtGMenuModel::ReportRecoverableError(const int index, const int added, cons
 
   if( m_parent )
   {
-    parent_menu_label = m_parent->m_menu->menuAction()->text();
-    parent_menu_name = m_parent->m_menu->menuAction()->property( c_property_actionName ).toString();
+    parent_menu_label = m_parent->m_menu_item->m_node.m_label;
+    parent_menu_name = m_parent->m_menu_item->m_node.m_actionName;
 
-    for( QAction* action : m_parent->m_menu->actions() )
+    for( const MenuItem::Ptr& item : m_parent->m_items )
     {
-      parent_action_names += action->property( c_property_actionName ).toString() + ";";
+      parent_action_names += item->m_node.m_actionName + ";";
     }
 
     switch( m_parent->m_link_type )
@@ -673,11 +978,11 @@ void QtGMenuModel::ReportRecoverableError(const int index, const int added, cons
   QString link_type;
   QString action_paths;
 
-  menu_label = m_menu->menuAction()->text();
-  menu_name = m_menu->menuAction()->property( c_property_actionName ).toString();
-  for( QAction* action : m_menu->actions() )
+  menu_label = m_menu_item->m_node.m_label;
+  menu_name = m_menu_item->m_node.m_actionName;
+  for( const MenuItem::Ptr& item : m_items )
   {
-    action_names += action->property( c_property_actionName ).toString() + ";";
+    action_names += item->m_node.m_actionName + ";";
   }
 
   switch( m_link_type )
@@ -698,52 +1003,34 @@ void QtGMenuModel::ReportRecoverableError(const int index, const int added, cons
     action_paths += action.path() + ";";
   }
 
-  uint sender_pid = QDBusConnection::sessionBus().interface()->servicePid(
-            m_bus_name);
-  if( sender_pid == 0 ) {
-      qWarning() << "Failed to read PID, cannot report error";
-      return;
-  }
+  QtGErrorReporter::Fields fields;
+  fields << qMakePair( QString( "DuplicateSignature" ), QString( "GMenuModelItemsChangedInvalidIndex" ) );
+  fields << qMakePair( QString( "BusName" ), m_bus_name );
+  fields << qMakePair( QString( "Position" ), QString::number( index ) );
+  fields << qMakePair( QString( "Added" ), QString::number( added ) );
+  fields << qMakePair( QString( "Removed" ), QString::number( removed ) );
+  fields << qMakePair( QString( "ItemCount" ), QString::number( gmenu_item_count ) );
+  fields << qMakePair( QString( "ActionNames" ), gmenu_action_names );
 
-  QProcess recoverable;
-  recoverable.setProcessChannelMode(QProcess::ForwardedChannels);
-  recoverable.start("/usr/share/apport/recoverable_problem",
-              QStringList() << "-p" << QString::number(sender_pid));
-  if (recoverable.waitForStarted())
+  if( m_parent )
   {
-    write_pair(recoverable, "DuplicateSignature", "GMenuModelItemsChangedInvalidIndex");
-    write_pair(recoverable, "BusName", m_bus_name);
-    write_pair(recoverable, "Position", QString::number(index));
-    write_pair(recoverable, "Added", QString::number(added));
-    write_pair(recoverable, "Removed", QString::number(removed));
-    write_pair(recoverable, "ItemCount", QString::number(gmenu_item_count));
-    write_pair(recoverable, "ActionNames", gmenu_action_names);
-
-    if ( m_parent )
-    {
-      write_pair(recoverable, "ParentMenuLabel", parent_menu_label);
-      write_pair(recoverable, "ParentMenuName", parent_menu_name);
-      write_pair(recoverable, "ParentActionNames", parent_action_names);
-      write_pair(recoverable, "ParentLinkType", parent_link_type);
-    }
-
-    write_pair(recoverable, "MenuLabel", menu_label);
-    write_pair(recoverable, "MenuName", menu_name);
-    write_pair(recoverable, "ActionNames", action_names);
-    write_pair(recoverable, "LinkType", link_type);
+    fields << qMakePair( QString( "ParentMenuLabel" ), parent_menu_label );
+    fields << qMakePair( QString( "ParentMenuName" ), parent_menu_name );
+    fields << qMakePair( QString( "ParentActionNames" ), parent_action_names );
+    fields << qMakePair( QString( "ParentLinkType" ), parent_link_type );
+  }
 
-    write_pair(recoverable, "MenuPath", m_menu_path);
-    write_pair(recoverable, "ActionPaths", action_paths, true);
+  fields << qMakePair( QString( "MenuLabel" ), menu_label );
+  fields << qMakePair( QString( "MenuName" ), menu_name );
+  fields << qMakePair( QString( "ActionNames" ), action_names );
+  fields << qMakePair( QString( "LinkType" ), link_type );
 
-    recoverable.closeWriteChannel();
-    recoverable.waitForFinished();
+  fields << qMakePair( QString( "MenuPath" ), m_menu_path );
+  fields << qMakePair( QString( "ActionPaths" ), action_paths );
 
-    m_error_reported = true;
-  }
-  else
-  {
-    qWarning() << "Failed to report recoverable error";
-  }
+  // apport gets to take its time on the reporter's thread, not ours
+  QtGErrorReporter::Instance().Report( m_bus_name, fields );
+  m_error_reported = true;
 
   emit MenuInvalid();
 }
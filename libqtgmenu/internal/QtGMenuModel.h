@@ -19,10 +19,13 @@
 #ifndef QTGMENUMODEL_H
 #define QTGMENUMODEL_H
 
+#include <common/MenuTree.h>
+
 #include <QDBusObjectPath>
 #include <QObject>
 #include <QMap>
-#include <QMenu>
+#include <QSet>
+#include <QStringList>
 
 #include <memory>
 #include <deque>
@@ -33,6 +36,8 @@
 namespace qtgmenu
 {
 
+// Lives on the QtGMenuWorker when following an importer's menu. The worker has no Qt event
+// loop, so the slots below must be called directly on the model's own thread.
 class QtGMenuModel : public QObject
 {
 Q_OBJECT
@@ -44,6 +49,9 @@ public:
   };
 
   QtGMenuModel( QSharedPointer<GDBusConnection> connection, const QString& bus_name, const QString& menu_path, const QMap<QString, QDBusObjectPath>& action_paths );
+
+  // follows a menu that isn't on the bus, e.g. a GMenu of our own
+  explicit QtGMenuModel( QSharedPointer<GMenuModel> model );
   virtual ~QtGMenuModel();
 
   QSharedPointer<GMenuModel> Model() const;
@@ -52,29 +60,57 @@ public:
   QtGMenuModel* Parent() const;
   QSharedPointer<QtGMenuModel> Child( int index ) const;
 
-  std::shared_ptr< QMenu > GetQMenu();
+  hud::common::MenuTree::Ptr GetMenuTree();
+
+  void TriggerAction( const QString& action_name );
+
+  // asks again for the state of every action we reference, e.g. once the action groups are replaced
+  void RequestActionStates();
+
+  // sub menus below the top level are only followed while subscribed to
+  void SubscribeAll();
+  void UnsubscribeAll();
 
-  constexpr static const char* c_property_actionName = "actionName";
-  constexpr static const char* c_property_isParameterized = "isParameterized";
-  constexpr static const char* c_property_busName = "busName";
-  constexpr static const char* c_property_actionsPath = "actionsPath";
-  constexpr static const char* c_property_menuPath = "menuPath";
   constexpr static const char* c_property_keywords = "keywords";
   constexpr static const char* c_property_hud_toolbar_item = "hud-toolbar-item";
 
 Q_SIGNALS:
-  void MenuItemsChanged( QtGMenuModel* model, int index, int removed, int added );
+  // the menu has changed since the last snapshot, emitted once per main loop iteration however
+  // many changes arrived in it
+  void MenuTreeChanged();
+
+  // names the actions of new items whose state we haven't been told yet
+  void ActionStatesNeeded( QStringList action_names );
   void ActionTriggered( QString action_name, bool checked );
   void MenuInvalid();
 
 public Q_SLOTS:
   void ActionEnabled( QString action_name, bool enabled );
   void ActionParameterized( QString action_name, bool parameterized );
-
-private Q_SLOTS:
-  void ActionTriggered( bool );
+  void ActionDropped( QString action_name );
 
 private:
+  // a menu entry, shared between the model that owns it and its parents' flattened views
+  //
+  // Each entry costs roughly 200 bytes on 64 bit: the node (eight implicitly shared strings,
+  // which are interned, plus its counters and flags), the shared pointer's control block and
+  // one slot in each of m_items, m_children, m_ext_items and m_ext_sizes. Items past the first
+  // page are kept as empty placeholders, with neither their attributes nor their links read,
+  // until somebody asks for a snapshot to index. Items replaced again before then are never
+  // read at all.
+  struct MenuItem
+  {
+    typedef std::shared_ptr< MenuItem > Ptr;
+
+    hud::common::MenuTree::Node m_node;
+
+    // the model behind a sub menu entry
+    const QtGMenuModel* m_submenu = nullptr;
+
+    // the attributes haven't been read from the GMenuModel yet
+    bool m_pending = false;
+  };
+
   QtGMenuModel( QSharedPointer<GMenuModel> model, LinkType link_type, QtGMenuModel* parent, int index );
 
   static QSharedPointer<QtGMenuModel> CreateChild( QtGMenuModel* parent_qtgmenu, QSharedPointer<GMenuModel> parent_gmenu, int child_index );
@@ -82,26 +118,55 @@ private:
   static void MenuItemsChangedCallback( GMenuModel* model, gint index, gint removed, gint added,
       gpointer user_data );
 
-  void ChangeMenuItems( const int index, int added, const int removed );
+  void ChangeMenuItems( const int index, const int added, const int removed );
+
+  // items from first_pending on are left as placeholders until they're read
+  void ReplaceItems( const int index, const int added, const int removed, const int first_pending );
 
   void ConnectCallback();
   void DisconnectCallback();
 
-  void InsertChild( QSharedPointer<QtGMenuModel> child, int index );
+  void Subscribe();
+  void Unsubscribe();
+
+  void ConnectChild( QSharedPointer<QtGMenuModel> child );
 
-  QAction* CreateAction( int index );
+  MenuItem::Ptr CreateItem( int index );
+  void FetchItem( MenuItem& item, int index ) const;
+  void FetchPendingItems();
 
-  void AppendQMenu( std::shared_ptr< QMenu > top_menu );
-  void UpdateExtQMenu();
+  int ExtOffset( int index ) const;
+  void AddExtSize( int index, int delta );
+  void RebuildExtOffsets( int from );
+  void SpliceExtItems( int offset, int removed, const std::vector< MenuItem::Ptr >& added );
+  void SectionItemsChanged( const QtGMenuModel* section, int offset, int removed,
+      const std::vector< MenuItem::Ptr >& added );
 
-  void ActionAdded( const QString& name, QAction* action );
-  void ActionRemoved( const QString& name, QAction* action );
+  void QueueChanges();
+  static gboolean EmitQueuedChangesCallback( gpointer user_data );
+  void EmitQueuedChanges();
+  QtGMenuModel* Root();
+
+  void SetActionFlag( const QString& action_name, hud::common::MenuTree::Flag flag, bool on );
+
+  void AppendMenuTree( hud::common::MenuTree& tree, int parent ) const;
+  static void AppendMenuItem( hud::common::MenuTree& tree, int parent, const MenuItem& item );
+  static void AppendExtItems( hud::common::MenuTree& tree, int parent,
+      const std::vector< MenuItem::Ptr >& items, bool skip_submenus );
+
+  void ActionAdded( const QString& name, MenuItem::Ptr item );
+  void ActionRemoved( const QString& name, MenuItem::Ptr item );
 
   void ReportRecoverableError(const int index, const int added, const int removed);
 
 private:
   QtGMenuModel* m_parent = nullptr;
-  QMap< int, QSharedPointer<QtGMenuModel>> m_children;
+
+  // where we are in our parent's m_children, kept up to date as items come and go
+  int m_index = 0;
+
+  // the child model behind each of our items, or null for plain items
+  std::vector< QSharedPointer<QtGMenuModel> > m_children;
 
   QSharedPointer<GMenuModel> m_model;
   gulong m_items_changed_handler = 0;
@@ -109,16 +174,49 @@ private:
   LinkType m_link_type;
   int m_size = 0;
 
-  QScopedPointer<QMenu> m_menu;
-  QScopedPointer<QMenu> m_ext_menu;
+  // how many sub menus down from the root we are
+  int m_depth = 0;
+  bool m_subscribed = false;
+
+  // set on the root while every level is wanted
+  bool m_subscribe_all = false;
+
+  // our own items, with a separator standing in for each section
+  std::vector< MenuItem::Ptr > m_items;
+
+  // our items with each section's items spliced in ahead of its separator
+  std::vector< MenuItem::Ptr > m_ext_items;
+
+  // how many of our items are placeholders
+  int m_pending_count = 0;
+
+  // how many of m_ext_items each of our items accounts for
+  std::vector< int > m_ext_sizes;
+
+  // a Fenwick tree over m_ext_sizes, so finding where a section's items sit in m_ext_items
+  // doesn't walk every item ahead of it
+  std::vector< int > m_ext_offsets;
+
+  // the idle source that emits our queued changes, on the root
+  GSource* m_changes_source = nullptr;
+  bool m_items_changed = false;
+
+  // how a sub menu appears in its parent
+  MenuItem::Ptr m_menu_item;
 
   QSharedPointer<GDBusConnection> m_connection;
   QString m_bus_name;
   QString m_menu_path;
   QMap<QString, QDBusObjectPath> m_action_paths;
 
-  // a map of QActions indexed by their name and stored with a reference count
-  std::map< QString, std::vector< QAction* > > m_actions;
+  // a map of items indexed by their action name and stored with a reference count
+  std::map< QString, std::vector< MenuItem::Ptr > > m_actions;
+
+  // the last enabled and parameterized flags reported for each action, so repeats cost nothing
+  std::map< QString, quint32 > m_action_states;
+
+  // actions referenced by new items that we haven't been given a state for
+  QSet< QString > m_unknown_actions;
 
   bool m_error_reported = false;
 };
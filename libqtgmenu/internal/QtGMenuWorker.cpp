@@ -0,0 +1,110 @@
+/*
+ * Copyright (C) 2016 Canonical, Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3, as published
+ * by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranties of
+ * MERCHANTABILITY, SATISFACTORY QUALITY, or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Author: Pete Woods <pete.woods@canonical.com>
+ */
+
+#include <QtGMenuWorker.h>
+
+#include <QSemaphore>
+
+using namespace qtgmenu;
+
+QtGMenuWorker& QtGMenuWorker::Instance()
+{
+  static QtGMenuWorker worker;
+  return worker;
+}
+
+QtGMenuWorker::QtGMenuWorker()
+    : m_context( g_main_context_new() ),
+      m_loop( g_main_loop_new( m_context, FALSE ) )
+{
+  setObjectName( "qtgmenu" );
+  start();
+}
+
+QtGMenuWorker::~QtGMenuWorker()
+{
+  g_main_loop_quit( m_loop );
+  wait();
+
+  g_main_loop_unref( m_loop );
+  g_main_context_unref( m_context );
+}
+
+GMainContext* QtGMenuWorker::Context() const
+{
+  return m_context;
+}
+
+bool QtGMenuWorker::IsCurrentThread() const
+{
+  return QThread::currentThread() == this;
+}
+
+void QtGMenuWorker::Invoke( std::function< void() > task )
+{
+  if( IsCurrentThread() )
+  {
+    task();
+    return;
+  }
+
+  // not g_main_context_invoke(), which would run the task here if the worker
+  // hasn't acquired its context yet
+  GSource* source = g_idle_source_new();
+  g_source_set_priority( source, G_PRIORITY_DEFAULT );
+  g_source_set_callback( source, RunTask, new std::function< void() >( std::move( task ) ),
+      DestroyTask );
+  g_source_attach( source, m_context );
+  g_source_unref( source );
+}
+
+void QtGMenuWorker::InvokeSync( std::function< void() > task )
+{
+  if( IsCurrentThread() )
+  {
+    task();
+    return;
+  }
+
+  QSemaphore done;
+  Invoke( [&task, &done]()
+  {
+    task();
+    done.release();
+  } );
+  done.acquire();
+}
+
+void QtGMenuWorker::run()
+{
+  // the GDBus proxies pick up the thread default context when they subscribe to signals
+  g_main_context_push_thread_default( m_context );
+  g_main_loop_run( m_loop );
+  g_main_context_pop_thread_default( m_context );
+}
+
+gboolean QtGMenuWorker::RunTask( gpointer user_data )
+{
+  ( *reinterpret_cast< std::function< void() >* >( user_data ) )();
+  return G_SOURCE_REMOVE;
+}
+
+void QtGMenuWorker::DestroyTask( gpointer user_data )
+{
+  delete reinterpret_cast< std::function< void() >* >( user_data );
+}
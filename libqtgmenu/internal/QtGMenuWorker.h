@@ -0,0 +1,86 @@
+/*
+ * Copyright (C) 2016 Canonical, Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3, as published
+ * by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranties of
+ * MERCHANTABILITY, SATISFACTORY QUALITY, or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Author: Pete Woods <pete.woods@canonical.com>
+ */
+
+#ifndef QTGMENUWORKER_H
+#define QTGMENUWORKER_H
+
+#include <QThread>
+
+#include <functional>
+#include <memory>
+
+#undef signals
+#include <gio/gio.h>
+
+namespace qtgmenu
+{
+
+// A thread running its own GMainContext, which every GDBus menu and action proxy lives on.
+//
+// Chatty applications' D-Bus traffic is parsed here rather than on the thread answering
+// queries. Objects created on this thread must only be used and destroyed here too, so
+// the Qt side reaches them through Invoke() and hears back through queued signals.
+//
+// run() drives a GMainLoop and never calls exec(), so Qt events posted to objects living
+// here are never delivered: no queued connections into them, no QTimers and no
+// deleteLater(). Objects on the worker talk to each other through direct connections.
+class QtGMenuWorker : public QThread
+{
+public:
+  static QtGMenuWorker& Instance();
+
+  virtual ~QtGMenuWorker();
+
+  GMainContext* Context() const;
+
+  bool IsCurrentThread() const;
+
+  // runs the task on the worker, straight away if we're already on it
+  void Invoke( std::function< void() > task );
+
+  // as Invoke(), but waits for the task to finish
+  void InvokeSync( std::function< void() > task );
+
+  // drops our reference on the worker, so the object is destroyed there
+  template< typename T >
+  void Release( std::shared_ptr< T >& object )
+  {
+    auto holder = new std::shared_ptr< T >();
+    holder->swap( object );
+    Invoke( [holder]()
+    {
+      delete holder;
+    } );
+  }
+
+protected:
+  void run() override;
+
+private:
+  QtGMenuWorker();
+
+  static gboolean RunTask( gpointer user_data );
+  static void DestroyTask( gpointer user_data );
+
+  GMainContext* m_context = nullptr;
+  GMainLoop* m_loop = nullptr;
+};
+
+} // namespace qtgmenu
+
+#endif // QTGMENUWORKER_H
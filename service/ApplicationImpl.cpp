@@ -179,6 +179,34 @@ void ApplicationImpl::AddSources(const QList<Action> &actions,
 	}
 }
 
+/**
+ * Only the collectors for the given contexts are dropped, the rest of the
+ * application's sources are left alone.
+ */
+void ApplicationImpl::RemoveSources(const QList<Source> &sources) {
+	for (const Source &source : sources) {
+		WindowContext::Ptr window = windowContext(source.m_windowId);
+		if (window.isNull()) {
+			qWarning()
+					<< "Tried to remove model source for unknown window context"
+					<< source.m_windowId;
+			continue;
+		}
+
+		window->removeMenu(source.m_context);
+	}
+}
+
+/**
+ * Removals are applied first, so a context can be removed and re-added in
+ * the same batch.
+ */
+void ApplicationImpl::UpdateSources(const QList<Source> &removed,
+		const QList<Action> &actions, const QList<Description> &descriptions) {
+	RemoveSources(removed);
+	AddSources(actions, descriptions);
+}
+
 void ApplicationImpl::SetWindowContext(uint windowId, const QString &context) {
 	WindowContext::Ptr window = windowContext(windowId);
 	if (window.isNull()) {
@@ -23,6 +23,7 @@
 #include <common/ActionGroup.h>
 #include <common/Description.h>
 #include <common/MenuModel.h>
+#include <common/Source.h>
 #include <service/Application.h>
 #include <service/Window.h>
 
@@ -76,6 +77,12 @@ public Q_SLOTS:
 	void AddSources(const QList<hud::common::Action> &actions,
 			const QList<hud::common::Description> &descriptions);
 
+	void RemoveSources(const QList<hud::common::Source> &sources);
+
+	void UpdateSources(const QList<hud::common::Source> &removed,
+			const QList<hud::common::Action> &actions,
+			const QList<hud::common::Description> &descriptions);
+
 	void SetWindowContext(uint window, const QString &context);
 
 protected:
@@ -18,6 +18,7 @@
 
 #include <service/Collector.h>
 
+using namespace hud::common;
 using namespace hud::service;
 
 Collector::Collector(QObject *parent) :
@@ -28,8 +29,9 @@ Collector::Collector(QObject *parent) :
 Collector::~Collector() {
 }
 
-CollectorToken::CollectorToken(Collector::Ptr collector, QMenu *menu) :
-		m_collector(collector), m_menu(menu) {
+CollectorToken::CollectorToken(Collector::Ptr collector,
+		MenuTree::Ptr menuTree) :
+		m_collector(collector), m_menuTree(menuTree) {
 }
 
 CollectorToken::~CollectorToken() {
@@ -38,6 +40,10 @@ CollectorToken::~CollectorToken() {
 	}
 }
 
-QMenu * CollectorToken::menu() {
-	return m_menu;
+MenuTree::Ptr CollectorToken::menuTree() const {
+	return m_menuTree;
+}
+
+void CollectorToken::setMenuTree(MenuTree::Ptr menuTree) {
+	m_menuTree = menuTree;
 }
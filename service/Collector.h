@@ -19,11 +19,11 @@
 #ifndef HUD_SERVICE_COLLECTOR_H_
 #define HUD_SERVICE_COLLECTOR_H_
 
+#include <common/MenuTree.h>
 #include <service/Result.h>
 
 #include <QObject>
 #include <QSharedPointer>
-#include <QMenu>
 
 #include <memory>
 
@@ -37,13 +37,16 @@ class GMenuCollector;
 class CollectorToken: public QObject {
 Q_OBJECT
 public:
-	CollectorToken(std::shared_ptr<Collector> collector, QMenu *menu);
+	CollectorToken(std::shared_ptr<Collector> collector,
+			hud::common::MenuTree::Ptr menuTree);
 
 	typedef QSharedPointer<CollectorToken> Ptr;
 
 	virtual ~CollectorToken();
 
-	QMenu *menu();
+	hud::common::MenuTree::Ptr menuTree() const;
+
+	void setMenuTree(hud::common::MenuTree::Ptr menuTree);
 
 Q_SIGNALS:
 	void changed();
@@ -52,7 +55,7 @@ protected:
 
 	std::weak_ptr<Collector> m_collector;
 
-	QMenu *m_menu;
+	hud::common::MenuTree::Ptr m_menuTree;
 };
 
 class Collector: public QObject {
@@ -18,24 +18,153 @@
  */
 
 #include <service/DBusMenuCollector.h>
+#include <service/DBusMenuInterface.h>
 
-#include <dbusmenuimporter.h>
+#include <QDateTime>
 #include <QDebug>
-#include <QMenu>
+#include <QStringList>
 #include <stdexcept>
 
+using namespace hud::common;
 using namespace hud::service;
 
+static bool isEnabled(const DBusMenuLayoutItem &item) {
+	return item.properties.value("enabled", true).toBool();
+}
+
+static bool isSeparator(const DBusMenuLayoutItem &item) {
+	return item.properties.value("type").toString() == "separator";
+}
+
+static bool isSubmenu(const DBusMenuLayoutItem &item) {
+	return !item.children.isEmpty()
+			|| item.properties.value("children-display").toString()
+					== "submenu";
+}
+
+/* dbusmenu marks the mnemonic with '_', we use '&' */
+static QString label(const DBusMenuLayoutItem &item) {
+	QString text(item.properties.value("label").toString());
+
+	QString result;
+	result.reserve(text.size());
+	for (int i(0); i < text.size(); ++i) {
+		const QChar c(text.at(i));
+		if (c == '_') {
+			if (i + 1 < text.size() && text.at(i + 1) == '_') {
+				result.append(c);
+				++i;
+			} else {
+				result.append('&');
+			}
+		} else if (c == '&') {
+			result.append("&&");
+		} else {
+			result.append(c);
+		}
+	}
+	return result;
+}
+
+/* GTK's modifier names, and QKeySequence's, in QKeySequence's order */
+static const QList<QPair<QString, QString>> MODIFIERS( { { "Control", "Ctrl" },
+		{ "Alt", "Alt" }, { "Shift", "Shift" }, { "Super", "Meta" } });
+
+/* The rest of the keys arrive as GDK key names, e.g. "s" or "plus" */
+static QString keyName(const QString &key) {
+	if (key == "plus") {
+		return "+";
+	} else if (key == "minus") {
+		return "-";
+	} else if (key.size() == 1) {
+		return key.toUpper();
+	}
+	return key;
+}
+
+static QString chordText(const QStringList &chord) {
+	QStringList keys;
+	for (const auto &modifier : MODIFIERS) {
+		if (chord.contains(modifier.first)) {
+			keys << modifier.second;
+		}
+	}
+
+	for (const QString &key : chord) {
+		bool modifier(false);
+		for (const auto &m : MODIFIERS) {
+			modifier = modifier || key == m.first;
+		}
+		if (!modifier) {
+			keys << keyName(key);
+		}
+	}
+
+	return keys.join("+");
+}
+
+/* Shortcuts arrive as lists of key names, e.g. [["Control", "s"]] */
+static QString shortcut(const DBusMenuLayoutItem &item) {
+	QVariant value(item.properties.value("shortcut"));
+	if (!value.canConvert<QDBusArgument>()) {
+		return QString();
+	}
+
+	QList<QStringList> chords;
+	value.value<QDBusArgument>() >> chords;
+
+	QStringList result;
+	for (const QStringList &chord : chords) {
+		result << chordText(chord);
+	}
+	return result.join(", ");
+}
+
+static void appendItems(const DBusMenuLayoutItem &item, MenuTree &tree,
+		int parent) {
+	for (const DBusMenuLayoutItem &child : item.children) {
+		MenuTree::Node node;
+		node.m_label = label(child);
+		node.m_accel = shortcut(child);
+		node.m_handle = child.id;
+
+		node.m_flags = 0;
+		if (isEnabled(child)) {
+			node.m_flags |= MenuTree::ENABLED;
+		}
+		if (isSeparator(child)) {
+			node.m_flags |= MenuTree::SEPARATOR;
+		}
+
+		if (isSubmenu(child)) {
+			node.m_flags |= MenuTree::SUBMENU;
+			appendItems(child, tree, tree.append(parent, node));
+		} else {
+			tree.append(parent, node);
+		}
+	}
+}
+
 DBusMenuCollector::DBusMenuCollector(const QString &service,
-		const QDBusObjectPath &menuObjectPath) :
-		m_service(service), m_path(menuObjectPath) {
+		const QDBusObjectPath &menuObjectPath,
+		const QDBusConnection &connection) :
+		m_service(service), m_path(menuObjectPath), m_layoutChanged(false), m_propertiesChanged(
+				false) {
 
 	if (m_service.isEmpty()) {
 		return;
 	}
 
-	m_menuImporter.reset(
-		new DBusMenuImporter(m_service, m_path.path(), DBusMenuImporterType::SYNCHRONOUS));
+	m_interface.reset(
+			new ComCanonicalDbusmenuInterface(m_service, m_path.path(),
+					connection));
+
+	connect(m_interface.data(), SIGNAL(LayoutUpdated(uint, int)), this,
+			SLOT(layoutUpdated(uint, int)));
+	connect(m_interface.data(),
+			SIGNAL(ItemsPropertiesUpdated(hud::common::DBusMenuItemList, hud::common::DBusMenuItemKeysList)),
+			this,
+			SLOT(itemsPropertiesUpdated(const hud::common::DBusMenuItemList &, const hud::common::DBusMenuItemKeysList &)));
 
 	CollectorToken::Ptr collectorToken(m_collectorToken);
 	if(collectorToken) {
@@ -47,97 +176,180 @@ DBusMenuCollector::~DBusMenuCollector() {
 }
 
 bool DBusMenuCollector::isValid() const {
-	return !m_menuImporter.isNull();
+	return !m_interface.isNull();
 }
 
-void DBusMenuCollector::openMenu(QMenu *menu, unsigned int &limit) {
-	--limit;
-	if (limit == 0) {
-		QString error = "Hit DBusMenu safety valve opening menu at " + m_service
-				+ " " + m_path.path();
-		throw std::logic_error(error.toStdString());
+bool DBusMenuCollector::getLayout(DBusMenuLayoutItem &layout) {
+	QDBusPendingReply<uint, DBusMenuLayoutItem> reply(
+			m_interface->GetLayout(0, -1, QStringList()));
+	reply.waitForFinished();
+	if (reply.isError()) {
+		qWarning() << "Failed to get DBusMenu layout from" << m_service
+				<< m_path.path() << reply.error().message();
+		return false;
 	}
 
-	if (!menu) {
-		return;
-	}
+	layout = reply.argumentAt<1>();
+	return true;
+}
 
-	menu->aboutToShow();
+void DBusMenuCollector::sendEvent(int id, const QString &eventId) {
+	// Nobody waits for the reply
+	m_interface->Event(id, eventId, QDBusVariant(QString()),
+			QDateTime::currentDateTime().toTime_t());
+}
+
+void DBusMenuCollector::openMenu(const DBusMenuLayoutItem &item, bool &update,
+		unsigned int &limit) {
+	if (!m_openMenus.contains(item.id)) {
+		--limit;
+		if (limit == 0) {
+			QString error = "Hit DBusMenu safety valve opening menu at "
+					+ m_service + " " + m_path.path();
+			throw std::logic_error(error.toStdString());
+		}
 
-	for (int i(0); m_menuImporter && i < menu->actions().size(); ++i) {
-		QAction *action = menu->actions().at(i);
-		if (!action->isEnabled()) {
+		m_openMenus << item.id;
+
+		QDBusPendingReply<bool> reply(m_interface->AboutToShow(item.id));
+		reply.waitForFinished();
+		if (!reply.isError() && reply.value()) {
+			update = true;
+		}
+		sendEvent(item.id, "opened");
+	}
+
+	for (const DBusMenuLayoutItem &child : item.children) {
+		if (!isEnabled(child)) {
 			continue;
 		}
-		if (action->isSeparator()) {
+		if (isSeparator(child)) {
 			continue;
 		}
 
-		QMenu *child(action->menu());
-		if (child) {
-			openMenu(child, limit);
+		if (isSubmenu(child)) {
+			openMenu(child, update, limit);
 		}
 	}
 }
 
-void DBusMenuCollector::hideMenu(QMenu *menu, unsigned int &limit) {
-	--limit;
-	if (limit == 0) {
-		QString error = "Hit DBusMenu safety valve closing menu at " + m_service
-				+ " " + m_path.path();
-		throw std::logic_error(error.toStdString());
-	}
-
-	for (int i(0); i < menu->actions().size(); ++i) {
-		QAction *action = menu->actions().at(i);
-		QMenu *child(action->menu());
-		if (child) {
-			hideMenu(child, limit);
+void DBusMenuCollector::openMenus(DBusMenuLayoutItem &layout,
+		unsigned int &limit) {
+	// Opening a menu can fill in new submenus, so go round again until the
+	// layout stops changing
+	bool update(true);
+	while (update) {
+		update = false;
+		if (!getLayout(layout)) {
+			return;
 		}
+		openMenu(layout, update, limit);
 	}
+}
 
-	menu->aboutToHide();
+MenuTree::Ptr DBusMenuCollector::menuTree(const DBusMenuLayoutItem &layout) {
+	MenuTree::Ptr tree(new MenuTree());
+	appendItems(layout, *tree, MenuTree::ROOT);
 
-	if(!m_menuImporter) {
-		return;
-	}
+	// The tree can outlive us
+	std::weak_ptr<DBusMenuCollector> collector(shared_from_this());
+	tree->setActivator([collector](const MenuTree &tree, int index) {
+		if (DBusMenuCollector::Ptr c = collector.lock()) {
+			c->sendEvent(tree.node(index).m_handle, "clicked");
+		}
+	});
+
+	return tree;
 }
 
 QList<CollectorToken::Ptr> DBusMenuCollector::activate() {
 	CollectorToken::Ptr collectorToken(m_collectorToken);
 
-	if(m_menuImporter.isNull()) {
+	if(m_interface.isNull()) {
 		return QList<CollectorToken::Ptr>();
 	}
 
-	if (collectorToken.isNull()) {
+	if (collectorToken.isNull() || m_layoutChanged) {
+		// Menus we opened before stay open, so only new ones are sent events
 		try {
 			unsigned int limit(50);
-			openMenu(m_menuImporter->menu(), limit);
+			openMenus(m_layout, limit);
 		} catch (std::logic_error &e) {
 			qDebug() << e.what();
 		}
+	}
 
-		if(m_menuImporter.isNull()) {
-			return QList<CollectorToken::Ptr>();
-		}
+	if (collectorToken.isNull() || m_layoutChanged || m_propertiesChanged) {
+		m_layoutChanged = false;
+		m_propertiesChanged = false;
 
 		collectorToken.reset(
-				new CollectorToken(shared_from_this(), m_menuImporter->menu()));
+				new CollectorToken(shared_from_this(), menuTree(m_layout)));
 		m_collectorToken = collectorToken;
 	}
 
 	return QList<CollectorToken::Ptr>() << collectorToken;
 }
 
+void DBusMenuCollector::changed() {
+	CollectorToken::Ptr collectorToken(m_collectorToken);
+	if (collectorToken) {
+		collectorToken->changed();
+	}
+}
+
+void DBusMenuCollector::layoutUpdated(uint revision, int parent) {
+	Q_UNUSED(revision);
+	Q_UNUSED(parent);
+
+	m_layoutChanged = true;
+	changed();
+}
+
+void DBusMenuCollector::itemsPropertiesUpdated(
+		const DBusMenuItemList &updatedProps,
+		const DBusMenuItemKeysList &removedProps) {
+	// Items we haven't fetched turn up with the next layout anyway
+	for (const DBusMenuItem &update : updatedProps) {
+		DBusMenuLayoutItem *item(m_layout.find(update.id));
+		if (!item) {
+			continue;
+		}
+		for (auto it(update.properties.constBegin());
+				it != update.properties.constEnd(); ++it) {
+			item->properties[it.key()] = it.value();
+		}
+		m_propertiesChanged = true;
+	}
+
+	for (const DBusMenuItemKeys &removal : removedProps) {
+		DBusMenuLayoutItem *item(m_layout.find(removal.id));
+		if (!item) {
+			continue;
+		}
+		for (const QString &property : removal.properties) {
+			item->properties.remove(property);
+		}
+		m_propertiesChanged = true;
+	}
+
+	if (m_propertiesChanged) {
+		changed();
+	}
+}
+
 void DBusMenuCollector::deactivate() {
-	if(m_menuImporter.isNull()) {
+	if(m_interface.isNull()) {
 		return;
 	}
-	try {
-		unsigned int limit(50);
-		hideMenu(m_menuImporter->menu(), limit);
-	} catch (std::logic_error &e) {
-		qDebug() << e.what();
+
+	// An old token going away doesn't matter while a newer one is in use
+	if (!m_collectorToken.isNull()) {
+		return;
+	}
+
+	// Close the menus in the reverse order to how they were opened
+	while (!m_openMenus.isEmpty()) {
+		sendEvent(m_openMenus.takeLast(), "closed");
 	}
 }
@@ -20,41 +20,74 @@
 #ifndef HUD_SERVICE_DBUSMENUCOLLECTOR_H_
 #define HUD_SERVICE_DBUSMENUCOLLECTOR_H_
 
+#include <common/DBusMenuLayoutItem.h>
 #include <service/Collector.h>
 
+#include <QDBusConnection>
 #include <QDBusObjectPath>
 
-class DBusMenuImporter;
-
-QT_BEGIN_NAMESPACE
-class QMenu;
-QT_END_NAMESPACE
+class ComCanonicalDbusmenuInterface;
 
 namespace hud {
 namespace service {
 
 class DBusMenuCollector: public Collector,
 	public std::enable_shared_from_this<DBusMenuCollector> {
+Q_OBJECT
+
 public:
 	typedef std::shared_ptr<DBusMenuCollector> Ptr;
 
-	DBusMenuCollector(const QString &service, const QDBusObjectPath &menuObjectPath);
+	DBusMenuCollector(const QString &service, const QDBusObjectPath &menuObjectPath,
+			const QDBusConnection &connection);
 	virtual ~DBusMenuCollector();
 
 	virtual bool isValid() const override;
 	virtual QList<CollectorToken::Ptr> activate() override;
 
+protected Q_SLOTS:
+	void layoutUpdated(uint revision, int parent);
+
+	void itemsPropertiesUpdated(
+			const hud::common::DBusMenuItemList &updatedProps,
+			const hud::common::DBusMenuItemKeysList &removedProps);
+
 protected:
 	virtual void deactivate() override;
 
-	void openMenu(QMenu *menu, unsigned int &limit);
-	void hideMenu(QMenu *menu, unsigned int &limit);
+	void changed();
+
+	/**
+	 * Opens every submenu, so that the app fills in its lazy menus, and
+	 * fetches the resulting layout.
+	 */
+	void openMenus(hud::common::DBusMenuLayoutItem &layout, unsigned int &limit);
+
+	void openMenu(const hud::common::DBusMenuLayoutItem &item, bool &update,
+			unsigned int &limit);
+
+	bool getLayout(hud::common::DBusMenuLayoutItem &layout);
+
+	void sendEvent(int id, const QString &eventId);
+
+	hud::common::MenuTree::Ptr menuTree(
+			const hud::common::DBusMenuLayoutItem &layout);
 
 	QWeakPointer<CollectorToken> m_collectorToken;
-	QSharedPointer<DBusMenuImporter> m_menuImporter;
+	QSharedPointer<ComCanonicalDbusmenuInterface> m_interface;
 
 	QString m_service;
 	QDBusObjectPath m_path;
+
+	QList<int> m_openMenus;
+
+	hud::common::DBusMenuLayoutItem m_layout;
+
+	/* The app has changed the menu's structure since we last fetched it */
+	bool m_layoutChanged;
+
+	/* Properties have changed since we last built a tree */
+	bool m_propertiesChanged;
 };
 
 }
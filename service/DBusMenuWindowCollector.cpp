@@ -74,24 +74,6 @@ bool DBusMenuWindowCollector::isValid() const {
 	return m_collector || m_am_collector;
 }
 
-static void setPropertyForAllActions(QMenu *menu) {
-	if (!menu)
-		return;
-
-	for (QAction *action : menu->actions()) {
-		if (!action->isEnabled()) {
-			continue;
-		}
-
-		if (action->isSeparator()) {
-			continue;
-		}
-
-		action->setProperty("searchByMnemonic", true);
-		setPropertyForAllActions(action->menu());
-	}
-}
-
 QList<CollectorToken::Ptr> DBusMenuWindowCollector::activate() {
 	QList<CollectorToken::Ptr> ret;
 
@@ -99,7 +81,10 @@ QList<CollectorToken::Ptr> DBusMenuWindowCollector::activate() {
 		QList<CollectorToken::Ptr> tokens = m_am_collector->activate();
 
 		for (CollectorToken::Ptr token : tokens) {
-			setPropertyForAllActions(token->menu());
+			MenuTree::Ptr menuTree(token->menuTree());
+			if (menuTree) {
+				menuTree->setFlag(MenuTree::SEARCH_BY_MNEMONIC, true);
+			}
 		}
 
 		ret.append(tokens);
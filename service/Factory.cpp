@@ -22,6 +22,7 @@
 #include <service/AppmenuRegistrarInterface.h>
 #include <service/HardCodedSearchSettings.h>
 #include <service/HudServiceImpl.h>
+#include <service/ParameterCacheImpl.h>
 #include <service/WindowImpl.h>
 #include <service/QGSettingsSearchSettings.h>
 #include <service/QueryImpl.h>
@@ -31,6 +32,7 @@
 #include <common/DBusTypes.h>
 
 #include <libqtgmenu/QtGMenuImporter.h>
+#include <libqtgmenu/QtGParameterImporter.h>
 
 #include <QDBusConnection>
 #include <QDBusServiceWatcher>
@@ -98,7 +100,17 @@ Query::Ptr Factory::newQuery(const QString &query, const QString &sender,
 	return Query::Ptr(
 			new QueryImpl(m_queryCounter++, query, sender, emptyBehaviour,
 					*singletonHudService(), singletonApplicationList(),
-					singletonVoice(), sessionBus()));
+					singletonVoice(), singletonParameterCache(), false,
+					sessionBus()));
+}
+
+Query::Ptr Factory::newReserveQuery(const QString &sender) {
+	return Query::Ptr(
+			new QueryImpl(m_queryCounter++, "", sender,
+					Query::EmptyBehaviour::SHOW_SUGGESTIONS,
+					*singletonHudService(), singletonApplicationList(),
+					singletonVoice(), singletonParameterCache(), true,
+					sessionBus()));
 }
 
 ApplicationList::Ptr Factory::singletonApplicationList() {
@@ -135,6 +147,13 @@ Voice::Ptr Factory::singletonVoice() {
 	return m_voice;
 }
 
+ParameterCache::Ptr Factory::singletonParameterCache() {
+	if (m_parameterCache.isNull()) {
+		m_parameterCache.reset(new ParameterCacheImpl(*this));
+	}
+	return m_parameterCache;
+}
+
 Application::Ptr Factory::newApplication(const QString &applicationId) {
 	return Application::Ptr(
 			new ApplicationImpl(applicationId, *this, sessionBus()));
@@ -163,7 +182,8 @@ WindowContext::Ptr Factory::newWindowContext() {
 
 Collector::Ptr Factory::newDBusMenuCollector(const QString &service,
 		const QDBusObjectPath &menuObjectPath) {
-	return Collector::Ptr(new DBusMenuCollector(service, menuObjectPath));
+	return Collector::Ptr(
+			new DBusMenuCollector(service, menuObjectPath, sessionBus()));
 }
 
 Collector::Ptr Factory::newGMenuCollector(const QString &name,
@@ -180,6 +200,14 @@ QSharedPointer<qtgmenu::QtGMenuImporter> Factory::newQtGMenuImporter(
 					sessionBus(), gSessionBus()));
 }
 
+QSharedPointer<qtgmenu::QtGParameterImporter> Factory::newQtGParameterImporter(
+		const QString& service, const QDBusObjectPath& menu_path,
+		const QString& action_name) {
+	return QSharedPointer<qtgmenu::QtGParameterImporter>(
+			new qtgmenu::QtGParameterImporter(service, menu_path, action_name,
+					gSessionBus()));
+}
+
 Collector::Ptr Factory::newGMenuWindowCollector(unsigned int windowId,
 		const QString &applicationId) {
 	return Collector::Ptr(
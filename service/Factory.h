@@ -27,6 +27,7 @@
 #include <service/GMenuWindowCollector.h>
 #include <service/GMenuCollector.h>
 #include <service/ItemStore.h>
+#include <service/ParameterCache.h>
 #include <service/UsageTracker.h>
 #include <service/SearchSettings.h>
 #include <service/Voice.h>
@@ -38,6 +39,10 @@
 class ComCanonicalUnityWindowStackInterface;
 class ComCanonicalAppMenuRegistrarInterface;
 
+namespace qtgmenu {
+class QtGParameterImporter;
+}
+
 QT_BEGIN_NAMESPACE
 class QDBusServiceWatcher;
 QT_END_NAMESPACE
@@ -68,6 +73,8 @@ public:
 	virtual Query::Ptr newQuery(const QString &query, const QString &sender,
 			Query::EmptyBehaviour emptyBehaviour);
 
+	virtual Query::Ptr newReserveQuery(const QString &sender);
+
 	virtual ApplicationList::Ptr singletonApplicationList();
 
 	virtual UsageTracker::Ptr singletonUsageTracker();
@@ -76,6 +83,8 @@ public:
 
 	virtual Voice::Ptr singletonVoice();
 
+	virtual ParameterCache::Ptr singletonParameterCache();
+
 	virtual Application::Ptr newApplication(const QString &applicationId);
 
 	virtual ItemStore::Ptr newItemStore(const QString &applicationId);
@@ -99,6 +108,10 @@ public:
 			const QString& service, const QDBusObjectPath& menu_path,
 			const QMap<QString, QDBusObjectPath>& action_paths);
 
+	QSharedPointer<qtgmenu::QtGParameterImporter> newQtGParameterImporter(
+			const QString& service, const QDBusObjectPath& menu_path,
+			const QString& action_name);
+
 	virtual Collector::Ptr newGMenuWindowCollector(unsigned int windowId,
 			const QString &applicationId);
 
@@ -119,6 +132,8 @@ protected:
 
 	Voice::Ptr m_voice;
 
+	ParameterCache::Ptr m_parameterCache;
+
 	QSharedPointer<ComCanonicalUnityWindowStackInterface> m_windowStack;
 
 	QSharedPointer<ComCanonicalAppMenuRegistrarInterface> m_appmenu;
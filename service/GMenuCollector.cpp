@@ -50,12 +50,13 @@ bool GMenuCollector::isValid() const {
 QList<CollectorToken::Ptr> GMenuCollector::activate() {
 	CollectorToken::Ptr collectorToken(m_collectorToken);
 
-	std::shared_ptr<QMenu> menu(m_importer->GetQMenu());
-	if (collectorToken.isNull() || menu != m_menu) {
-		m_menu = menu;
-		collectorToken.reset(
-				new CollectorToken(shared_from_this(),
-						m_menu ? m_menu.get() : nullptr));
+	// the deeper menu levels turn up as changes once they're fetched
+	m_importer->Subscribe();
+
+	hud::common::MenuTree::Ptr menuTree(m_importer->GetMenuTree());
+	if (collectorToken.isNull() || menuTree != m_menuTree) {
+		m_menuTree = menuTree;
+		collectorToken.reset(new CollectorToken(shared_from_this(), m_menuTree));
 		m_collectorToken = collectorToken;
 	}
 
@@ -63,6 +64,10 @@ QList<CollectorToken::Ptr> GMenuCollector::activate() {
 }
 
 void GMenuCollector::deactivate() {
+	// an old token going away doesn't matter while a newer one is in use
+	if (m_collectorToken.isNull()) {
+		m_importer->Unsubscribe();
+	}
 }
 
 void GMenuCollector::menuItemsChanged() {
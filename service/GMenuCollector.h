@@ -68,7 +68,7 @@ protected:
 
 	QSharedPointer<qtgmenu::QtGMenuImporter> m_importer;
 
-	std::shared_ptr<QMenu> m_menu;
+	hud::common::MenuTree::Ptr m_menuTree;
 };
 
 }
@@ -84,6 +84,18 @@ QDBusObjectPath HudServiceImpl::CreateQuery(const QString &query,
 	return hudQuery->path();
 }
 
+QDBusObjectPath HudServiceImpl::CreateReserveQuery(QString &resultsName,
+		QString &appstackName, int &modelRevision) {
+	Query::Ptr hudQuery(m_factory.newReserveQuery(messageSender()));
+	m_queries[hudQuery->path()] = hudQuery;
+
+	resultsName = hudQuery->resultsModel();
+	appstackName = hudQuery->appstackModel();
+	modelRevision = 0;
+
+	return hudQuery->path();
+}
+
 Query::Ptr HudServiceImpl::closeQuery(const QDBusObjectPath &path) {
 	return m_queries.take(path);
 }
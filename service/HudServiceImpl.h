@@ -62,6 +62,9 @@ public Q_SLOTS:
 	QDBusObjectPath CreateQuery(const QString &query, QString &resultsName,
 			QString &appstackName, int &modelRevision);
 
+	QDBusObjectPath CreateReserveQuery(QString &resultsName,
+			QString &appstackName, int &modelRevision);
+
 	/*
 	 * Legacy interface below here
 	 */
@@ -18,61 +18,30 @@
 
 #include <service/Item.h>
 
-#include <QDebug>
-
+using namespace hud::common;
 using namespace hud::service;
 
-Item::Item(const QMenu *root, const QList<int> &index, int lastIndex) :
-		m_root(root), m_index(index), m_lastIndex(lastIndex) {
+Item::Item(MenuTree::Ptr tree, int node, const QString &commandName,
+		const QStringList &context) :
+		m_tree(tree), m_node(node), m_commandName(commandName), m_context(
+				context) {
 }
 
 Item::~Item() {
 }
 
-QList<QAction *> Item::context() const {
-	QList<QAction *> context;
-
-	const QMenu *menu(m_root);
-
-	const QList<int> &index(m_index);
-	for (int i : index) {
-		QList<QAction*> actions(menu->actions());
-		if (i >= actions.size()) {
-			qWarning() << "Action could not be found" << m_index << m_lastIndex;
-			break;
-		}
-		QAction *action(actions.at(i));
-		context.append(action);
-		menu = action->menu();
-	}
-
-	return context;
+const MenuTree::Node & Item::node() const {
+	return m_tree->node(m_node);
 }
 
-QAction * Item::action() const {
-	const QMenu *menu(m_root);
-
-	const QList<int> &index(m_index);
-	for (int i : index) {
-		QList<QAction*> actions(menu->actions());
-		if (i >= actions.size()) {
-			qWarning() << "Action could not be found" << m_index << m_lastIndex;
-			return nullptr;
-		}
-		QAction *action(actions.at(i));
-		menu = action->menu();
-	}
-
-	if (menu == nullptr) {
-		qWarning() << "Menu could not be found" << m_index << m_lastIndex;
-		return nullptr;
-	}
+const QString & Item::commandName() const {
+	return m_commandName;
+}
 
-	QList<QAction*> actions(menu->actions());
-	if (m_lastIndex >= actions.size()) {
-		qWarning() << "Action could not be found" << m_index << m_lastIndex;
-		return nullptr;
-	}
+const QStringList & Item::context() const {
+	return m_context;
+}
 
-	return actions.at(m_lastIndex);
+void Item::activate() const {
+	m_tree->activate(m_node);
 }
@@ -19,9 +19,10 @@
 #ifndef HUD_SERVICE_ITEM_H_
 #define HUD_SERVICE_ITEM_H_
 
+#include <common/MenuTree.h>
+
 #include <QSharedPointer>
-#include <QMenu>
-#include <QList>
+#include <QStringList>
 
 namespace hud {
 namespace service {
@@ -30,20 +31,33 @@ class Item {
 public:
 	typedef QSharedPointer<Item> Ptr;
 
-	Item(const QMenu *root, const QList<int> &index, int lastIndex);
+	Item(hud::common::MenuTree::Ptr tree, int node, const QString &commandName,
+			const QStringList &context);
 
 	virtual ~Item();
 
-	QList<QAction *> context() const;
+	const hud::common::MenuTree::Node & node() const;
+
+	/**
+	 * The cleaned up label of the item
+	 */
+	const QString & commandName() const;
 
-	QAction *action() const;
+	/**
+	 * The cleaned up labels of the menus leading to the item
+	 */
+	const QStringList & context() const;
+
+	void activate() const;
 
 protected:
-	const QMenu *m_root;
+	hud::common::MenuTree::Ptr m_tree;
+
+	int m_node;
 
-	QList<int> m_index;
+	QString m_commandName;
 
-	int m_lastIndex;
+	QStringList m_context;
 };
 
 }
@@ -17,123 +17,140 @@
  */
 
 #include <common/Localisation.h>
+#include <common/StringPool.h>
 #include <service/ItemStore.h>
 
 #include <columbus.hh>
-#include <QRegularExpression>
 #include <QDebug>
 #include <QDBusObjectPath>
+#include <QtConcurrentMap>
 #include <algorithm>
+#include <exception>
 
+using namespace hud::common;
 using namespace hud::service;
 using namespace Columbus;
 
-static const QRegularExpression SINGLE_AMPERSAND("(?<![&])[&](?![&])");
-static const QRegularExpression BAD_CHARACTERS("\\.\\.\\.|…");
-static const QRegularExpression WHITESPACE("\\s+");
-static const QRegularExpression WHITESPACE_OR_SEMICOLON("[;\\s]+");
+static const int MAX_RESULTS = 20;
+
+// Splitting up small stores costs more than it saves
+static const size_t MIN_SHARD_SIZE = 1000;
+
+// Enough to keep a typical machine's threads busy. It's fixed, rather
+// than worked out from the thread count, so the split, and with it the
+// scores, are the same everywhere.
+static const int MAX_SHARDS = 16;
+
+// Scoring a query against just the documents sharing enough trigrams with
+// it means indexing them first, which costs more than it saves unless they
+// are at most this fraction of the store
+static const size_t PREFILTER_RATIO = 2;
 
 ItemStore::ItemStore(const QString &applicationId,
 		UsageTracker::Ptr usageTracker, SearchSettings::Ptr settings) :
 		m_applicationId(applicationId), m_usageTracker(usageTracker), m_nextId(
-				0), m_settings(settings) {
-	ErrorValues &errorValues(m_matcher.getErrorValues());
-	errorValues.addStandardErrors();
-
-	m_matcher.getIndexWeights().setWeight(Word("context"), 0.5);
+				0), m_settings(settings), m_internedBytes(0), m_prefilter(true) {
+	configureMatcher(m_matcher);
 
 	connect(m_settings.data(), SIGNAL(changed()), this, SLOT(settingChanged()));
-	settingChanged();
 }
 
 ItemStore::~ItemStore() {
 }
 
-void ItemStore::settingChanged() {
-	ErrorValues &errorValues(m_matcher.getErrorValues());
+void ItemStore::configureMatcher(Matcher &matcher) const {
+	ErrorValues &errorValues(matcher.getErrorValues());
+	errorValues.addStandardErrors();
+
+	matcher.getIndexWeights().setWeight(Word("context"), 0.5);
+
+	applySettings(matcher);
+}
+
+void ItemStore::applySettings(Matcher &matcher) const {
+	ErrorValues &errorValues(matcher.getErrorValues());
 	errorValues.setInsertionError(m_settings->addPenalty());
 	errorValues.setDeletionError(m_settings->dropPenalty());
 	errorValues.setEndDeletionError(m_settings->endDropPenalty());
 	errorValues.setTransposeError(m_settings->swapPenalty());
 }
 
-static QString convertActionText(const QAction *action) {
-	return action->text().remove(SINGLE_AMPERSAND).replace("&&", "&");
+void ItemStore::settingChanged() {
+	applySettings(m_matcher);
+	for (Shard::Ptr shard : m_shards) {
+		applySettings(shard->m_matcher);
+	}
 }
 
-static QChar getMnemonic(const QAction *action) {
-	int ampersandIndex = action->text().indexOf(SINGLE_AMPERSAND);
-
-	if (ampersandIndex < 0 || ampersandIndex >= action->text().length() - 1) {
-		return 0;
-	}
+QString ItemStore::commandName(const QString &label) {
+	QString command;
+	TextNormaliser::stripMnemonic(label, command);
 
-	return action->text()[ampersandIndex+1].toLower();
+	// Submenus repeat the same handful of labels
+	QString interned(StringPool::instance().intern(command));
+	m_internedBytes += StringPool::savedBytes(command, interned);
+	return interned;
 }
 
-void ItemStore::indexMenu(const QMenu *menu, const QMenu *root,
-		const QStringList &stack, const QList<int> &index) {
-	int i(-1);
-	for (QAction *action : menu->actions()) {
-		++i;
+void ItemStore::indexMenu(MenuTree::Ptr tree, int parent,
+		const QStringList &stack, const QStringList &context) {
+	for (int i(tree->firstChild(parent)); i != -1; i = tree->nextSibling(i)) {
+		const MenuTree::Node &node(tree->node(i));
 
-		if (!action->isEnabled()) {
+		if (!node.flag(MenuTree::ENABLED)) {
 			continue;
 		}
-		if (action->isSeparator()) {
+		if (node.flag(MenuTree::SEPARATOR)) {
 			continue;
 		}
 
-		bool searchByMnemonic(action->property("searchByMnemonic").toBool());
+		QString name(commandName(node.m_label));
 
-		QStringList text(
-				convertActionText(action).remove(BAD_CHARACTERS).split(
-						WHITESPACE));
-
-		bool isParameterized(action->property("isParameterized").toBool());
+		QStringList text;
+		m_normaliser.tokenise(name, text);
 
 		// We don't descend into parameterized actions
-		QMenu *child(action->menu());
-		if (!isParameterized && child) {
+		if (node.flag(MenuTree::SUBMENU)
+				&& !node.flag(MenuTree::PARAMETERIZED)) {
 			QStringList childStack(stack);
 			childStack << text;
-			QList<int> childIndex(index);
-			childIndex << i;
-			indexMenu(child, root, childStack, childIndex);
+			QStringList childContext(context);
+			childContext << name;
+			indexMenu(tree, i, childStack, childContext);
 		} else {
 			Document document(m_nextId);
 
-			if (searchByMnemonic) {
-				QChar mnemonic = getMnemonic(action);
+			if (node.flag(MenuTree::SEARCH_BY_MNEMONIC)) {
+				QChar mnemonic = TextNormaliser::mnemonic(node.m_label);
 				m_mnemonic2DocumentId[mnemonic] = m_nextId;
 			}
 
 			WordList command;
 			for (const QString &word : text) {
-				command.addWord(Word(word.toUtf8().constData()));
+				command.addWord(Word(m_normaliser.utf8(word)));
+				m_ngramIndex.addWord(word, m_nextId);
 			}
 			document.addText(Word("command"), command);
 
 			WordList wordList;
-			QVariant keywords(action->property("keywords"));
-			QStringList context;
-			if (!keywords.isNull()) {
-				context = keywords.toString().split(WHITESPACE_OR_SEMICOLON);
+			QStringList contextWords;
+			if (!node.m_keywords.isNull()) {
+				m_normaliser.tokeniseKeywords(node.m_keywords, contextWords);
 			} else {
-				context = stack;
+				contextWords = stack;
 			}
-			for (const QString &word : context) {
-				wordList.addWord(Word(word.toUtf8().constData()));
+			for (const QString &word : contextWords) {
+				wordList.addWord(Word(m_normaliser.utf8(word)));
+				m_ngramIndex.addWord(word, m_nextId);
 			}
 			document.addText(Word("context"), wordList);
 
 			m_corpus.addDocument(document);
-			Item::Ptr item(new Item(root, index, i));
+			Item::Ptr item(new Item(tree, i, name, context));
 			m_items[m_nextId] = item;
 
-			QVariant toolbarItem(action->property("hud-toolbar-item"));
-			if (!toolbarItem.isNull()) {
-				m_toolbarItems[toolbarItem.toString()] = item;
+			if (!node.m_toolbarItem.isEmpty()) {
+				m_toolbarItems[node.m_toolbarItem] = item;
 			}
 
 			++m_nextId;
@@ -141,12 +158,47 @@ void ItemStore::indexMenu(const QMenu *menu, const QMenu *root,
 	}
 }
 
-void ItemStore::indexMenu(const QMenu *menu) {
-	if (menu == nullptr) {
+void ItemStore::indexMenu(MenuTree::Ptr tree) {
+	if (tree.isNull()) {
 		return;
 	}
-	indexMenu(menu, menu, QStringList(), QList<int>());
-	m_matcher.index(m_corpus);
+	indexMenu(tree, MenuTree::ROOT, QStringList(), QStringList());
+	if (!buildShards()) {
+		m_matcher.index(m_corpus);
+	}
+}
+
+bool ItemStore::buildShards() {
+	m_shards.clear();
+
+	int shardCount(
+			std::min(MAX_SHARDS, int(m_corpus.size() / MIN_SHARD_SIZE)));
+	if (shardCount < 2) {
+		return false;
+	}
+
+	for (int i(0); i < shardCount; ++i) {
+		Shard::Ptr shard(new Shard());
+		shard->m_offset = i;
+		m_shards << shard;
+	}
+
+	const Corpus &corpus(m_corpus);
+	QtConcurrent::blockingMap(m_shards,
+			[this, &corpus, shardCount](Shard::Ptr &shard) {
+		// Deal the documents out in turn, so each shard gets a similar mix.
+		// The matcher keeps only its index, so this slice can go once it is
+		// built, leaving m_corpus as the only copy of the documents.
+		Corpus slice;
+		for (size_t i(shard->m_offset); i < corpus.size(); i += shardCount) {
+			slice.addDocument(corpus.getDocument(i));
+		}
+
+		configureMatcher(shard->m_matcher);
+		shard->m_matcher.index(slice);
+	});
+
+	return true;
 }
 
 static void findHighlights(Result::HighlightList &highlights,
@@ -161,13 +213,13 @@ static void findHighlights(Result::HighlightList &highlights,
 	}
 }
 
-static QString convertToEntry(Item::Ptr item, const QAction *action) {
+QString ItemStore::convertToEntry(Item::Ptr item) {
 	QString result;
-	for (const QAction *context : item->context()) {
-		result.append(convertActionText(context));
+	for (const QString &context : item->context()) {
+		result.append(context);
 		result.append("||");
 	}
-	result.append(convertActionText(action));
+	result.append(item->commandName());
 	return result;
 }
 
@@ -183,15 +235,12 @@ void ItemStore::search(const QString &query,
 		QMap<unsigned int, DocumentID> tempResults;
 
 		for (auto it(m_items.constBegin()); it != m_items.constEnd(); ++it) {
-			const QAction* action = it.value()->action();
-			if (action) {
-				tempResults.insertMulti(
-						m_usageTracker->usage(m_applicationId,
-								convertToEntry(it.value(), action)), it.key());
-			}
+			tempResults.insertMulti(
+					m_usageTracker->usage(m_applicationId,
+							convertToEntry(it.value())), it.key());
 		}
 
-		int maxResults = std::min(m_items.size(), 20);
+		int maxResults = std::min(m_items.size(), MAX_RESULTS);
 		int count = 0;
 		QMapIterator<unsigned int, DocumentID> it(tempResults);
 		it.toBack();
@@ -202,17 +251,31 @@ void ItemStore::search(const QString &query,
 		}
 
 	} else {
-		QString cleanQuery(query);
-		cleanQuery.remove(BAD_CHARACTERS);
+		QStringList words;
+		m_normaliser.tokenise(query, words);
 
 		WordList queryList;
-		for (const QString &word : cleanQuery.split(WHITESPACE)) {
-			queryList.addWord(Word(word.toUtf8().constData()));
+		for (const QString &word : words) {
+			queryList.addWord(Word(m_normaliser.utf8(word)));
+		}
+
+		// Only the last word can still be in the middle of being typed
+		QSet<DocumentID> candidates;
+		bool filtered(m_prefilter);
+		for (int i(0); filtered && i < words.size(); ++i) {
+			bool prefix(i == words.size() - 1);
+			// A word too short to rule anything out could match any document
+			filtered = m_ngramIndex.findDocuments(words.at(i), prefix,
+					candidates);
 		}
 
 		try {
-			MatchResults matchResults(
-					m_matcher.onlineMatch(queryList, Word("command")));
+			QVector<Match> matches;
+			if (filtered) {
+				matchCandidates(queryList, candidates, matches);
+			} else {
+				match(queryList, matches);
+			}
 
 			int queryLength(query.length());
 
@@ -221,12 +284,9 @@ void ItemStore::search(const QString &query,
 				addResult(docId, stringMatcher, queryLength, 1.0, results);
 			}
 
-			size_t maxResults = std::min(matchResults.size(), size_t(20));
-
-			for (size_t i(0); i < maxResults; ++i) {
-				DocumentID id(matchResults.getDocumentID(i));
-				double relevancy(matchResults.getRelevancy(i));
-				addResult(id, stringMatcher, queryLength, relevancy, results);
+			for (const Match &match : matches) {
+				addResult(match.m_id, stringMatcher, queryLength,
+						match.m_relevancy, results);
 			}
 		} catch (std::invalid_argument &e) {
 		}
@@ -234,47 +294,136 @@ void ItemStore::search(const QString &query,
 
 }
 
-void ItemStore::addResult(DocumentID id, const QStringMatcher &stringMatcher,
-		const int queryLength, const double relevancy, QList<Result> &results) {
+/*
+ * Columbus weighs words by how often they appear in the index it built,
+ * so each shard's scores are only comparable with the other shards' of
+ * the same split. The split depends on nothing but the corpus, and ties
+ * are broken by document ID, so the merged results are the same on any
+ * machine.
+ */
+static bool rankMatches(const ItemStore::Match &a, const ItemStore::Match &b) {
+	if (a.m_relevancy != b.m_relevancy) {
+		return a.m_relevancy > b.m_relevancy;
+	}
+	return a.m_id < b.m_id;
+}
 
-	Item::Ptr item(m_items[id]);
-	const QAction *action(item->action());
+/* Columbus hands back its matches best first */
+static void appendMatches(const MatchResults &matchResults,
+		QVector<ItemStore::Match> &matches) {
+	size_t count(std::min(matchResults.size(), size_t(MAX_RESULTS)));
+	for (size_t i(0); i < count; ++i) {
+		ItemStore::Match match;
+		match.m_id = matchResults.getDocumentID(i);
+		match.m_relevancy = matchResults.getRelevancy(i);
+		matches << match;
+	}
+}
+
+void ItemStore::match(const WordList &query, QVector<Match> &matches) {
+	if (m_shards.isEmpty()) {
+		appendMatches(m_matcher.onlineMatch(query, Word("command")), matches);
+	} else {
+		matchShards(query, matches);
+	}
+}
+
+void ItemStore::matchCandidates(const WordList &query,
+		const QSet<DocumentID> &candidates, QVector<Match> &matches) {
+	// Nothing shares enough trigrams with the query to be within reach
+	if (candidates.isEmpty()) {
+		return;
+	}
 
-	if (!action) {
+	// Indexing the candidates only pays off while they are a small part of
+	// the store
+	if (size_t(candidates.size()) * PREFILTER_RATIO > m_corpus.size()) {
+		match(query, matches);
 		return;
 	}
 
-	QString commandName(convertActionText(action));
+	QList<DocumentID> ids(candidates.toList());
+	std::sort(ids.begin(), ids.end());
+
+	// IDs are handed out in the order documents are added to the corpus
+	Corpus corpus;
+	for (DocumentID id : ids) {
+		corpus.addDocument(m_corpus.getDocument(id));
+	}
+
+	Matcher matcher;
+	configureMatcher(matcher);
+	matcher.index(corpus);
+	appendMatches(matcher.onlineMatch(query, Word("command")), matches);
+}
+
+void ItemStore::matchShards(const WordList &query, QVector<Match> &matches) {
+	struct ShardMatch {
+		Shard::Ptr m_shard;
+
+		QVector<Match> m_matches;
+
+		std::exception_ptr m_error;
+	};
+
+	QVector<ShardMatch> shardMatches;
+	for (Shard::Ptr shard : m_shards) {
+		ShardMatch shardMatch;
+		shardMatch.m_shard = shard;
+		shardMatches << shardMatch;
+	}
+
+	QtConcurrent::blockingMap(shardMatches, [&query](ShardMatch &shardMatch) {
+		try {
+			appendMatches(
+					shardMatch.m_shard->m_matcher.onlineMatch(query,
+							Word("command")), shardMatch.m_matches);
+		} catch (...) {
+			shardMatch.m_error = std::current_exception();
+		}
+	});
+
+	for (const ShardMatch &shardMatch : shardMatches) {
+		// hand errors back to the caller as if there were only one matcher
+		if (shardMatch.m_error) {
+			std::rethrow_exception(shardMatch.m_error);
+		}
+		matches << shardMatch.m_matches;
+	}
+
+	// Ties are broken by ID, so the results don't depend on thread scheduling
+	int count(std::min(matches.size(), MAX_RESULTS));
+	std::partial_sort(matches.begin(), matches.begin() + count, matches.end(),
+			rankMatches);
+	matches.resize(count);
+}
+
+void ItemStore::addResult(DocumentID id, const QStringMatcher &stringMatcher,
+		const int queryLength, const double relevancy, QList<Result> &results) {
+
+	Item::Ptr item(m_items[id]);
+	const MenuTree::Node &node(item->node());
+
+	const QString &command(item->commandName());
 
 	Result::HighlightList commandHighlights;
-	findHighlights(commandHighlights, stringMatcher, queryLength, commandName);
+	findHighlights(commandHighlights, stringMatcher, queryLength, command);
 
 	QString description;
-	QVariant keywords(action->property("keywords"));
-	if (!keywords.isNull()) {
-		description = keywords.toString().replace(";", _(", "));
+	if (!node.m_keywords.isNull()) {
+		description = QString(node.m_keywords).replace(";", _(", "));
 	} else {
-		bool first(true);
-		for (const QAction *a : item->context()) {
-			if (first) {
-				first = false;
-			} else {
-				description.append(_(", "));
-			}
-			description.append(convertActionText(a));
-		}
+		description = item->context().join(_(", "));
 	}
 
 	Result::HighlightList descriptionHighlights;
 	findHighlights(descriptionHighlights, stringMatcher, queryLength,
 			description);
 
-	bool isParameterized(action->property("isParameterized").toBool());
-
 	results
-			<< Result(id, commandName, commandHighlights, description,
-					descriptionHighlights, action->shortcut().toString(),
-					relevancy * 100, isParameterized);
+			<< Result(id, command, commandHighlights, description,
+					descriptionHighlights, node.m_accel, relevancy * 100,
+					node.flag(MenuTree::PARAMETERIZED));
 
 }
 
@@ -284,15 +433,8 @@ void ItemStore::executeItem(Item::Ptr item) {
 		return;
 	}
 
-	QAction *action(item->action());
-
-	if (action == nullptr) {
-		qWarning() << "Tried to execute unknown command";
-		return;
-	}
-
-	action->activate(QAction::ActionEvent::Trigger);
-	m_usageTracker->markUsage(m_applicationId, convertToEntry(item, action));
+	item->activate();
+	m_usageTracker->markUsage(m_applicationId, convertToEntry(item));
 }
 
 void ItemStore::execute(unsigned long long int commandId) {
@@ -304,22 +446,33 @@ QString ItemStore::executeParameterized(unsigned long long commandId,
 		QString &prefix, QString &baseAction, QDBusObjectPath &actionPath,
 		QDBusObjectPath &modelPath) {
 
-	Item::Ptr item(m_items[commandId]);
+	Item::Ptr item(m_items.value(commandId));
 	if (item.isNull()) {
 		qWarning() << "Tried to execute unknown parameterized command"
 				<< commandId;
 		return QString();
 	}
 
-	QAction *action(item->action());
+	QString busName(
+			parameterized(commandId, prefix, baseAction, actionPath,
+					modelPath));
 
-	if (action == nullptr) {
-		qWarning() << "Tried to execute unknown parameterized command"
-				<< commandId;
+	m_usageTracker->markUsage(m_applicationId, convertToEntry(item));
+	return busName;
+}
+
+QString ItemStore::parameterized(unsigned long long commandId,
+		QString &prefix, QString &baseAction, QDBusObjectPath &actionPath,
+		QDBusObjectPath &modelPath) const {
+
+	Item::Ptr item(m_items.value(commandId));
+	if (item.isNull()) {
 		return QString();
 	}
 
-	QString name = action->property("actionName").toString();
+	const MenuTree::Node &node(item->node());
+
+	const QString &name(node.m_actionName);
 	int index = name.indexOf( '.' );
 	if (index == -1) {
 		baseAction = name;
@@ -328,11 +481,10 @@ QString ItemStore::executeParameterized(unsigned long long commandId,
 		baseAction = name.right(name.size() - index - 1);
 	}
 
-	actionPath = QDBusObjectPath(action->property("actionsPath").toString());
-	modelPath = QDBusObjectPath(action->property("menuPath").toString());
+	actionPath = QDBusObjectPath(node.m_actionsPath);
+	modelPath = QDBusObjectPath(node.m_menuPath);
 
-	m_usageTracker->markUsage(m_applicationId, convertToEntry(item, action));
-	return action->property("busName").toString();
+	return node.m_busName;
 }
 
 void ItemStore::executeToolbar(const QString &name) {
@@ -358,6 +510,14 @@ QList<QStringList> ItemStore::commands() const {
 	return commandsList;
 }
 
+qint64 ItemStore::internedBytes() const {
+	return m_internedBytes;
+}
+
+const QString & ItemStore::applicationId() const {
+	return m_applicationId;
+}
+
 QStringList ItemStore::toolbarItems() const {
 	return m_toolbarItems.keys();
 }
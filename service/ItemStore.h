@@ -19,15 +19,20 @@
 #ifndef HUD_SERVICE_ITEMSTORE_H_
 #define HUD_SERVICE_ITEMSTORE_H_
 
+#include <common/MenuTree.h>
 #include <service/Item.h>
+#include <service/NgramIndex.h>
 #include <service/Query.h>
 #include <service/Result.h>
 #include <service/SearchSettings.h>
+#include <service/TextNormaliser.h>
 #include <service/UsageTracker.h>
 
+#include <QHash>
 #include <QSharedPointer>
-#include <QMenu>
 #include <QStringList>
+#include <QStringMatcher>
+#include <QVector>
 #include <Corpus.hh>
 #include <Matcher.hh>
 
@@ -44,12 +49,18 @@ Q_OBJECT
 public:
 	typedef QSharedPointer<ItemStore> Ptr;
 
+	struct Match {
+		DocumentID m_id;
+
+		double m_relevancy;
+	};
+
 	ItemStore(const QString &applicationId, UsageTracker::Ptr usageTracker,
 			SearchSettings::Ptr searchSettings);
 
 	virtual ~ItemStore();
 
-	void indexMenu(const QMenu *menu);
+	void indexMenu(hud::common::MenuTree::Ptr tree);
 
 	void search(const QString &query, Query::EmptyBehaviour emptyBehaviour,
 			QList<Result> &results);
@@ -60,18 +71,34 @@ public:
 			QString &prefix, QString &baseAction, QDBusObjectPath &actionPath,
 			QDBusObjectPath &modelPath);
 
+	/**
+	 * Where to find a parameterized command's actions and menu, without
+	 * counting it as used. Returns an empty bus name for unknown commands.
+	 */
+	QString parameterized(unsigned long long commandId, QString &prefix,
+			QString &baseAction, QDBusObjectPath &actionPath,
+			QDBusObjectPath &modelPath) const;
+
 	void executeToolbar(const QString &item);
 
 	QList<QStringList> commands() const;
 
 	QStringList toolbarItems() const;
 
+	/**
+	 * The bytes of command text this store shares through the string pool,
+	 * rather than copying.
+	 */
+	qint64 internedBytes() const;
+
+	const QString & applicationId() const;
+
 protected Q_SLOTS:
 	void settingChanged();
 
 protected:
-	void indexMenu(const QMenu *menu, const QMenu *root,
-			const QStringList &stack, const QList<int> &index);
+	void indexMenu(hud::common::MenuTree::Ptr tree, int parent,
+			const QStringList &stack, const QStringList &context);
 
 	void addResult(DocumentID id, const QStringMatcher &stringMatcher,
 			const int queryLength, const double relevancy,
@@ -79,10 +106,47 @@ protected:
 
 	void executeItem(Item::Ptr item);
 
+	QString commandName(const QString &label);
+
+	static QString convertToEntry(Item::Ptr item);
+
+	void configureMatcher(Columbus::Matcher &matcher) const;
+
+	void applySettings(Columbus::Matcher &matcher) const;
+
+	/**
+	 * Every n-th document of the corpus, starting at m_offset, scored
+	 * independently
+	 */
+	struct Shard {
+		typedef QSharedPointer<Shard> Ptr;
+
+		size_t m_offset;
+
+		Columbus::Matcher m_matcher;
+	};
+
+	bool buildShards();
+
+	void match(const Columbus::WordList &query, QVector<Match> &matches);
+
+	/**
+	 * Scores only the candidates, which have to include every document
+	 * within reach of the query
+	 */
+	void matchCandidates(const Columbus::WordList &query,
+			const QSet<DocumentID> &candidates, QVector<Match> &matches);
+
+	void matchShards(const Columbus::WordList &query, QVector<Match> &matches);
+
 	Columbus::Corpus m_corpus;
 
 	Columbus::Matcher m_matcher;
 
+	QVector<Shard::Ptr> m_shards;
+
+	NgramIndex m_ngramIndex;
+
 	QString m_applicationId;
 
 	UsageTracker::Ptr m_usageTracker;
@@ -96,6 +160,13 @@ protected:
 	QMap<QString, Item::Ptr> m_toolbarItems;
 
 	QMap<QChar, int> m_mnemonic2DocumentId;
+
+	qint64 m_internedBytes;
+
+	/* Score only the documents the trigram index can't rule out */
+	bool m_prefilter;
+
+	TextNormaliser m_normaliser;
 };
 
 }
@@ -0,0 +1,135 @@
+/*
+ * Copyright (C) 2016 Canonical, Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3, as published
+ * by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranties of
+ * MERCHANTABILITY, SATISFACTORY QUALITY, or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Author: Pete Woods <pete.woods@canonical.com>
+ */
+
+#include <service/NgramIndex.h>
+
+#include <algorithm>
+
+using namespace hud::service;
+
+/*
+ * A single edit touches at most 3 trigrams, and a transposition at most 4
+ */
+static const int TRIGRAMS_PER_ERROR = 4;
+
+static const QChar PADDING(0);
+
+NgramIndex::NgramIndex() {
+}
+
+NgramIndex::~NgramIndex() {
+}
+
+void NgramIndex::clear() {
+	m_postings.clear();
+}
+
+QString NgramIndex::fold(const QString &word) {
+	QString decomposed(word.toLower().normalized(QString::NormalizationForm_D));
+
+	QString result;
+	result.reserve(decomposed.size());
+	for (const QChar &c : decomposed) {
+		// drop the accents, so "pref" can find "préférences"
+		if (c.category() != QChar::Mark_NonSpacing) {
+			result.append(c);
+		}
+	}
+	return result;
+}
+
+int NgramIndex::maxErrors(int length) {
+	if (length <= 1) {
+		return 0;
+	} else if (length <= 4) {
+		return 1;
+	}
+	return 2;
+}
+
+void NgramIndex::trigrams(const QString &folded, bool prefix,
+		QVector<quint64> &result) {
+	QString padded(2, PADDING);
+	padded.append(folded);
+	// an unfinished word can carry on past its last letter
+	if (!prefix) {
+		padded.append(PADDING);
+	}
+
+	for (int i(0); i + 2 < padded.size(); ++i) {
+		result.append(
+				(quint64(padded[i].unicode()) << 32)
+						| (quint64(padded[i + 1].unicode()) << 16)
+						| quint64(padded[i + 2].unicode()));
+	}
+
+	std::sort(result.begin(), result.end());
+	result.erase(std::unique(result.begin(), result.end()), result.end());
+}
+
+void NgramIndex::addWord(const QString &word, DocumentID id) {
+	QString folded(fold(word));
+	if (folded.isEmpty()) {
+		return;
+	}
+
+	QVector<quint64> grams;
+	trigrams(folded, false, grams);
+
+	for (quint64 gram : grams) {
+		// documents are added in ascending order, so this is enough to de-dupe
+		QVector<DocumentID> &postings(m_postings[gram]);
+		if (postings.isEmpty() || postings.last() != id) {
+			postings.append(id);
+		}
+	}
+}
+
+bool NgramIndex::findDocuments(const QString &word, bool prefix,
+		QSet<DocumentID> &documents) const {
+	QString folded(fold(word));
+
+	QVector<quint64> grams;
+	trigrams(folded, prefix, grams);
+
+	int threshold(
+			grams.size()
+					- TRIGRAMS_PER_ERROR * maxErrors(folded.size()));
+	if (folded.isEmpty() || threshold <= 0) {
+		return false;
+	}
+
+	QHash<DocumentID, int> counts;
+	for (quint64 gram : grams) {
+		auto it(m_postings.constFind(gram));
+		if (it == m_postings.constEnd()) {
+			continue;
+		}
+		for (DocumentID id : *it) {
+			++counts[id];
+		}
+	}
+
+	for (auto it(counts.constBegin()); it != counts.constEnd(); ++it) {
+		if (it.value() >= threshold) {
+			documents.insert(it.key());
+		}
+	}
+
+	return true;
+}
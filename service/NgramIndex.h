@@ -0,0 +1,72 @@
+/*
+ * Copyright (C) 2016 Canonical, Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3, as published
+ * by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranties of
+ * MERCHANTABILITY, SATISFACTORY QUALITY, or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Author: Pete Woods <pete.woods@canonical.com>
+ */
+
+#ifndef HUD_SERVICE_NGRAMINDEX_H_
+#define HUD_SERVICE_NGRAMINDEX_H_
+
+#include <QHash>
+#include <QSet>
+#include <QString>
+#include <QVector>
+#include <Corpus.hh>
+
+namespace hud {
+namespace service {
+
+/**
+ * An inverted index from character trigrams to the documents containing
+ * them.
+ *
+ * A word within k edits of the query word shares at least
+ * (number of query trigrams - 4k) trigrams with it, so counting shared
+ * trigrams per document rules out documents without losing any fuzzy
+ * matches.
+ */
+class NgramIndex {
+public:
+	NgramIndex();
+
+	virtual ~NgramIndex();
+
+	void addWord(const QString &word, DocumentID id);
+
+	/**
+	 * Adds every document sharing enough trigrams with word to documents.
+	 * Returns false, without adding anything, if word is too short to
+	 * rule any documents out.
+	 */
+	bool findDocuments(const QString &word, bool prefix,
+			QSet<DocumentID> &documents) const;
+
+	void clear();
+
+	static QString fold(const QString &word);
+
+	static int maxErrors(int length);
+
+protected:
+	static void trigrams(const QString &folded, bool prefix,
+			QVector<quint64> &result);
+
+	QHash<quint64, QVector<DocumentID>> m_postings;
+};
+
+}
+}
+
+#endif /* HUD_SERVICE_NGRAMINDEX_H_ */
@@ -0,0 +1,60 @@
+/*
+ * Copyright (C) 2016 Canonical, Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3, as published
+ * by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranties of
+ * MERCHANTABILITY, SATISFACTORY QUALITY, or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Author: Pete Woods <pete.woods@canonical.com>
+ */
+
+#ifndef HUD_SERVICE_PARAMETERCACHE_H_
+#define HUD_SERVICE_PARAMETERCACHE_H_
+
+#include <QDBusObjectPath>
+#include <QSharedPointer>
+#include <QVariantList>
+
+namespace hud {
+namespace service {
+
+/**
+ * Keeps the menus of parameterized actions, so their attributes (the
+ * parameter-type, min, max, step and value of each slider) can go out with
+ * the reply that opens them.
+ */
+class ParameterCache {
+public:
+	typedef QSharedPointer<ParameterCache> Ptr;
+
+	explicit ParameterCache();
+
+	virtual ~ParameterCache();
+
+	/**
+	 * Starts following the action's menu, if we aren't already.
+	 */
+	virtual void prefetch(const QString &busName, const QString &prefix,
+			const QString &baseAction, const QDBusObjectPath &modelPath) = 0;
+
+	/**
+	 * One attribute map per item of the action's menu, or empty if it
+	 * hasn't arrived yet.
+	 */
+	virtual QVariantList parameters(const QString &busName,
+			const QString &prefix, const QString &baseAction,
+			const QDBusObjectPath &modelPath) const = 0;
+};
+
+}
+}
+
+#endif /* HUD_SERVICE_PARAMETERCACHE_H_ */
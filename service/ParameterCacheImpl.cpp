@@ -0,0 +1,77 @@
+/*
+ * Copyright (C) 2016 Canonical, Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3, as published
+ * by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranties of
+ * MERCHANTABILITY, SATISFACTORY QUALITY, or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Author: Pete Woods <pete.woods@canonical.com>
+ */
+
+#include <service/Factory.h>
+#include <service/ParameterCacheImpl.h>
+
+#include <libqtgmenu/QtGParameterImporter.h>
+
+using namespace hud::service;
+
+ParameterCacheImpl::ParameterCacheImpl(Factory &factory, int capacity) :
+		m_factory(factory), m_capacity(capacity) {
+}
+
+ParameterCacheImpl::~ParameterCacheImpl() {
+}
+
+QString ParameterCacheImpl::actionName(const QString &prefix,
+		const QString &baseAction) {
+	if (prefix.isEmpty()) {
+		return baseAction;
+	}
+	return prefix + "." + baseAction;
+}
+
+QString ParameterCacheImpl::key(const QString &busName,
+		const QString &actionName, const QDBusObjectPath &modelPath) {
+	return busName + " " + modelPath.path() + " " + actionName;
+}
+
+void ParameterCacheImpl::prefetch(const QString &busName,
+		const QString &prefix, const QString &baseAction,
+		const QDBusObjectPath &modelPath) {
+	QString name(actionName(prefix, baseAction));
+	QString k(key(busName, name, modelPath));
+
+	if (m_importers.contains(k)) {
+		m_recent.removeOne(k);
+		m_recent.prepend(k);
+		return;
+	}
+
+	m_importers[k] = m_factory.newQtGParameterImporter(busName, modelPath,
+			name);
+	m_recent.prepend(k);
+
+	while (m_recent.size() > m_capacity) {
+		m_importers.remove(m_recent.takeLast());
+	}
+}
+
+QVariantList ParameterCacheImpl::parameters(const QString &busName,
+		const QString &prefix, const QString &baseAction,
+		const QDBusObjectPath &modelPath) const {
+	auto importer(
+			m_importers.value(
+					key(busName, actionName(prefix, baseAction), modelPath)));
+	if (importer.isNull()) {
+		return QVariantList();
+	}
+	return importer->GetParameters();
+}
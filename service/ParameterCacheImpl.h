@@ -0,0 +1,74 @@
+/*
+ * Copyright (C) 2016 Canonical, Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3, as published
+ * by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranties of
+ * MERCHANTABILITY, SATISFACTORY QUALITY, or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Author: Pete Woods <pete.woods@canonical.com>
+ */
+
+#ifndef HUD_SERVICE_PARAMETERCACHEIMPL_H_
+#define HUD_SERVICE_PARAMETERCACHEIMPL_H_
+
+#include <service/ParameterCache.h>
+
+#include <QList>
+#include <QMap>
+
+namespace qtgmenu {
+class QtGParameterImporter;
+}
+
+namespace hud {
+namespace service {
+
+class Factory;
+
+class Q_DECL_EXPORT ParameterCacheImpl: public ParameterCache {
+public:
+	/* Comfortably more than the results the HUD shows at once */
+	static const int DEFAULT_CAPACITY = 16;
+
+	explicit ParameterCacheImpl(Factory &factory, int capacity =
+			DEFAULT_CAPACITY);
+
+	virtual ~ParameterCacheImpl();
+
+	void prefetch(const QString &busName, const QString &prefix,
+			const QString &baseAction, const QDBusObjectPath &modelPath)
+					override;
+
+	QVariantList parameters(const QString &busName, const QString &prefix,
+			const QString &baseAction, const QDBusObjectPath &modelPath) const
+					override;
+
+protected:
+	static QString actionName(const QString &prefix,
+			const QString &baseAction);
+
+	static QString key(const QString &busName, const QString &actionName,
+			const QDBusObjectPath &modelPath);
+
+	Factory &m_factory;
+
+	int m_capacity;
+
+	/* Most recently prefetched first, so we know who to let go of */
+	QList<QString> m_recent;
+
+	QMap<QString, QSharedPointer<qtgmenu::QtGParameterImporter>> m_importers;
+};
+
+}
+}
+
+#endif /* HUD_SERVICE_PARAMETERCACHEIMPL_H_ */
@@ -29,15 +29,23 @@
 using namespace hud::common;
 using namespace hud::service;
 
+/*
+ * How many results the HUD shows without scrolling, so how far down the list
+ * to prefetch parameterized actions' menus
+ */
+static const int PREFETCH_RESULTS = 5;
+
 QueryImpl::QueryImpl(unsigned int id, const QString &query,
 		const QString &sender, EmptyBehaviour emptyBehaviour,
 		HudService &service, ApplicationList::Ptr applicationList,
-		Voice::Ptr voice, const QDBusConnection &connection, QObject *parent) :
+		Voice::Ptr voice, ParameterCache::Ptr parameterCache, bool reserved,
+		const QDBusConnection &connection, QObject *parent) :
 		Query(parent), m_adaptor(new QueryAdaptor(this)), m_connection(
 				connection), m_path(DBusTypes::queryPath(id)), m_service(
 				service), m_emptyBehaviour(emptyBehaviour), m_applicationList(
-				applicationList), m_voice(voice), m_query(query), m_serviceWatcher(
-				sender, m_connection,
+				applicationList), m_voice(voice), m_parameterCache(
+				parameterCache), m_query(query), m_reserved(
+				reserved), m_serviceWatcher(sender, m_connection,
 				QDBusServiceWatcher::WatchForUnregistration) {
 
 	connect(&m_serviceWatcher, SIGNAL(serviceUnregistered(const QString &)),
@@ -167,6 +175,27 @@ QString QueryImpl::ExecuteParameterized(const QDBusVariant &item,
 			actionPath, modelPath);
 }
 
+/**
+ * As ExecuteParameterized, with one more output:
+ * - array parameters, the attributes of each item in the menu, if we've
+ *   already fetched it
+ */
+QString QueryImpl::ExecuteParameterizedWithParameters(const QDBusVariant &item,
+		uint timestamp, QString &prefix, QString &baseAction,
+		QDBusObjectPath &actionPath, QDBusObjectPath &modelPath,
+		int &modelSection, QVariantList &parameters) {
+	QString busName(
+			ExecuteParameterized(item, timestamp, prefix, baseAction,
+					actionPath, modelPath, modelSection));
+
+	if (!busName.isEmpty()) {
+		parameters = m_parameterCache->parameters(busName, prefix, baseAction,
+				modelPath);
+	}
+
+	return busName;
+}
+
 /**
  * This means that the user has clicked on an application
  * in the HUD user interface.
@@ -177,10 +206,11 @@ int QueryImpl::UpdateApp(const QString &app) {
 }
 
 int QueryImpl::UpdateQuery(const QString &query) {
-	if (m_query == query) {
+	if (m_query == query && !m_reserved) {
 		return 0;
 	}
 
+	m_reserved = false;
 	m_query = query;
 	refresh();
 
@@ -196,13 +226,15 @@ void QueryImpl::refresh() {
 	// First clear the old results
 	m_results.clear();
 
-	// Now check for an active window
+	// Now check for an active window, leaving its menus alone until a reserved
+	// query is actually used
 	Window::Ptr window(m_applicationList->focusedWindow());
-	if (window) {
+	if (window && !m_reserved) {
 		// Hold onto a token for the active window
 		updateToken(window);
 
 		m_windowToken->search(m_query, m_emptyBehaviour, m_results);
+		prefetchParameterized();
 
 		notifyPropertyChanged("com.canonical.hud.query", "ToolbarItems");
 	}
@@ -228,6 +260,29 @@ void QueryImpl::refresh() {
 	m_appstackModel->endChangeset();
 }
 
+void QueryImpl::prefetchParameterized() {
+	int count(0);
+	for (const Result &result : m_results) {
+		if (count++ == PREFETCH_RESULTS) {
+			break;
+		}
+		if (!result.parameterized()) {
+			continue;
+		}
+
+		QString prefix;
+		QString baseAction;
+		QDBusObjectPath actionPath;
+		QDBusObjectPath modelPath;
+		QString busName(
+				m_windowToken->parameterized(result.id(), prefix, baseAction,
+						actionPath, modelPath));
+		if (!busName.isEmpty()) {
+			m_parameterCache->prefetch(busName, prefix, baseAction, modelPath);
+		}
+	}
+}
+
 int QueryImpl::VoiceQuery(QString &query) {
 	Window::Ptr window(m_applicationList->focusedWindow());
 
@@ -237,6 +292,7 @@ int QueryImpl::VoiceQuery(QString &query) {
 	}
 
 	// Hold onto a token for the active window
+	m_reserved = false;
 	updateToken(window);
 
 	// Get the list of commands from the current window token
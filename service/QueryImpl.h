@@ -22,6 +22,7 @@
 #include <common/ResultsModel.h>
 #include <common/AppstackModel.h>
 #include <service/ApplicationList.h>
+#include <service/ParameterCache.h>
 #include <service/Query.h>
 #include <service/Voice.h>
 
@@ -45,6 +46,7 @@ public:
 	QueryImpl(unsigned int id, const QString &query, const QString &sender,
 			EmptyBehaviour emptyBehaviour, HudService &service,
 			ApplicationList::Ptr applicationList, Voice::Ptr voice,
+			ParameterCache::Ptr parameterCache, bool reserved,
 			const QDBusConnection &connection, QObject *parent = 0);
 
 	virtual ~QueryImpl();
@@ -71,6 +73,11 @@ public Q_SLOTS:
 			QString &prefix, QString &baseAction, QDBusObjectPath &actionPath,
 			QDBusObjectPath &modelPath, int &modelSection);
 
+	QString ExecuteParameterizedWithParameters(const QDBusVariant &item,
+			uint timestamp, QString &prefix, QString &baseAction,
+			QDBusObjectPath &actionPath, QDBusObjectPath &modelPath,
+			int &modelSection, QVariantList &parameters);
+
 	void ExecuteToolbar(const QString &item, uint timestamp);
 
 	int UpdateApp(const QString &app);
@@ -87,6 +94,8 @@ protected Q_SLOTS:
 protected:
 	void updateToken(Window::Ptr window);
 
+	void prefetchParameterized();
+
 	void notifyPropertyChanged(const QString& interface,
 			const QString& propertyName);
 
@@ -104,8 +113,13 @@ protected:
 
 	Voice::Ptr m_voice;
 
+	ParameterCache::Ptr m_parameterCache;
+
 	QString m_query;
 
+	/* Held in reserve by a client, so not searching until the first update */
+	bool m_reserved;
+
 	QDBusServiceWatcher m_serviceWatcher;
 
 	QSharedPointer<hud::common::ResultsModel> m_resultsModel;
@@ -22,6 +22,7 @@
 #include <QVariant>
 #include <QGSettings/qgsettings.h>
 
+using namespace hud::common;
 using namespace hud::service;
 
 /*
@@ -96,31 +97,51 @@ SqliteUsageTracker::SqliteUsageTracker() {
 }
 
 SqliteUsageTracker::~SqliteUsageTracker() {
+	clearUsage();
 	m_db.close();
 }
 
+SqliteUsageTracker::UsagePair SqliteUsageTracker::acquire(
+		const QString &applicationId, const QString &entry) {
+	StringPool &pool(StringPool::instance());
+	return UsagePair(pool.acquire(applicationId), pool.acquire(entry));
+}
+
+void SqliteUsageTracker::clearUsage() {
+	StringPool &pool(StringPool::instance());
+	for (const UsagePair &pair : m_usage.keys()) {
+		pool.release(pair.first);
+		pool.release(pair.second);
+	}
+	m_usage.clear();
+}
+
 void SqliteUsageTracker::loadFromDatabase() {
 	// Clear our in-memory cache
-	m_usage.clear();
+	clearUsage();
 
 	// Delete entries older than 30 days
 	m_delete->exec();
 
 	m_query->exec();
 	while (m_query->next()) {
-		UsagePair pair(m_query->value(0).toString(),
-				m_query->value(1).toString());
+		UsagePair pair(
+				acquire(m_query->value(0).toString(),
+						m_query->value(1).toString()));
 		m_usage[pair] = m_query->value(2).toInt();
 	}
 }
 
 void SqliteUsageTracker::markUsage(const QString &applicationId,
 		const QString &entry) {
-	UsagePair pair(applicationId, entry);
-
-	if (m_usage.contains(pair)) {
-		// increment if we have an existing entry
-		++(*m_usage.find(pair));
+	UsagePair pair(acquire(applicationId, entry));
+
+	auto it(m_usage.find(pair));
+	if (it != m_usage.end()) {
+		// increment if we have an existing entry, which already holds the IDs
+		++(*it);
+		StringPool::instance().release(pair.first);
+		StringPool::instance().release(pair.second);
 	} else {
 		// just one usage otherwise
 		m_usage[pair] = 1;
@@ -134,5 +155,11 @@ void SqliteUsageTracker::markUsage(const QString &applicationId,
 
 unsigned int SqliteUsageTracker::usage(const QString &applicationId,
 		const QString &entry) const {
-	return m_usage[UsagePair(applicationId, entry)];
+	UsagePair pair;
+	const StringPool &pool(StringPool::instance());
+	if (!pool.find(applicationId, pair.first)
+			|| !pool.find(entry, pair.second)) {
+		return 0;
+	}
+	return m_usage.value(pair);
 }
@@ -19,6 +19,7 @@
 #ifndef HUD_SERVICE_SQLITEUSAGETRACKER_H_
 #define HUD_SERVICE_SQLITEUSAGETRACKER_H_
 
+#include <common/StringPool.h>
 #include <service/UsageTracker.h>
 
 #include <QMap>
@@ -46,7 +47,12 @@ protected Q_SLOTS:
 	void loadFromDatabase();
 
 protected:
-	typedef QPair<QString, QString> UsagePair;
+	/* Every entry for an application would otherwise repeat its ID */
+	typedef QPair<hud::common::StringPool::Id, hud::common::StringPool::Id> UsagePair;
+
+	UsagePair acquire(const QString &applicationId, const QString &entry);
+
+	void clearUsage();
 
 	QMap<UsagePair, unsigned int> m_usage;
 
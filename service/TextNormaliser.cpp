@@ -0,0 +1,185 @@
+/*
+ * Copyright (C) 2016 Canonical, Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3, as published
+ * by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranties of
+ * MERCHANTABILITY, SATISFACTORY QUALITY, or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Author: Pete Woods <pete.woods@canonical.com>
+ */
+
+#include <service/TextNormaliser.h>
+
+using namespace hud::service;
+
+static const QChar AMPERSAND('&');
+
+static const QChar FULL_STOP('.');
+
+static const QChar ELLIPSIS(0x2026);
+
+static const QChar SEMICOLON(';');
+
+/*
+ * Qt only keeps the allocation when resizing to zero if the capacity
+ * was reserved up front
+ */
+static const int BUFFER_CAPACITY = 64;
+
+TextNormaliser::TextNormaliser() {
+	m_buffer.reserve(BUFFER_CAPACITY);
+	m_utf8.reserve(BUFFER_CAPACITY);
+}
+
+TextNormaliser::~TextNormaliser() {
+}
+
+void TextNormaliser::stripMnemonic(const QString &text, QString &result) {
+	result.resize(0);
+
+	const QChar *c(text.constData());
+	const QChar *end(c + text.size());
+
+	while (c != end) {
+		if (*c != AMPERSAND) {
+			result.append(*c);
+			++c;
+			continue;
+		}
+
+		int run(0);
+		while (c != end && *c == AMPERSAND) {
+			++run;
+			++c;
+		}
+
+		// a lone '&' marks the mnemonic, and each "&&" is an escaped '&'
+		if (run > 1) {
+			for (int i(run / 2 + run % 2); i > 0; --i) {
+				result.append(AMPERSAND);
+			}
+		}
+	}
+}
+
+QChar TextNormaliser::mnemonic(const QString &text) {
+	const int length(text.size());
+
+	int i(0);
+	while (i < length) {
+		if (text[i] != AMPERSAND) {
+			++i;
+			continue;
+		}
+
+		int start(i);
+		while (i < length && text[i] == AMPERSAND) {
+			++i;
+		}
+
+		if (i - start == 1) {
+			return i < length ? text[i].toLower() : QChar(0);
+		}
+	}
+
+	return QChar(0);
+}
+
+static bool isEllipsis(const QChar *c, const QChar *end) {
+	return *c == ELLIPSIS
+			|| (end - c >= 3 && c[0] == FULL_STOP && c[1] == FULL_STOP
+					&& c[2] == FULL_STOP);
+}
+
+static int ellipsisLength(const QChar *c) {
+	return *c == ELLIPSIS ? 1 : 3;
+}
+
+void TextNormaliser::tokenise(const QString &text, QStringList &words) {
+	split(text, false, words);
+}
+
+void TextNormaliser::tokeniseKeywords(const QString &text,
+		QStringList &words) {
+	split(text, true, words);
+}
+
+void TextNormaliser::split(const QString &text, bool keywords,
+		QStringList &words) {
+	words.clear();
+	m_buffer.resize(0);
+
+	const QChar *c(text.constData());
+	const QChar *end(c + text.size());
+
+	while (c != end) {
+		if (c->isSpace() || (keywords && *c == SEMICOLON)) {
+			words.append(m_buffer);
+			m_buffer.resize(0);
+
+			// ellipses are dropped before splitting, so can't break up a run
+			while (c != end) {
+				if (c->isSpace() || (keywords && *c == SEMICOLON)) {
+					++c;
+				} else if (!keywords && isEllipsis(c, end)) {
+					c += ellipsisLength(c);
+				} else {
+					break;
+				}
+			}
+		} else if (!keywords && isEllipsis(c, end)) {
+			c += ellipsisLength(c);
+		} else {
+			m_buffer.append(*c);
+			++c;
+		}
+	}
+
+	words.append(m_buffer);
+}
+
+const char * TextNormaliser::utf8(const QString &word) {
+	m_utf8.resize(0);
+
+	const ushort *c(word.utf16());
+	const int length(word.size());
+
+	for (int i(0); i < length; ++i) {
+		uint u(c[i]);
+		if (QChar::isHighSurrogate(u)) {
+			if (i + 1 < length && QChar::isLowSurrogate(c[i + 1])) {
+				u = QChar::surrogateToUcs4(ushort(u), c[++i]);
+			} else {
+				u = QChar::ReplacementCharacter;
+			}
+		} else if (QChar::isLowSurrogate(u)) {
+			u = QChar::ReplacementCharacter;
+		}
+
+		if (u < 0x80) {
+			m_utf8.append(char(u));
+		} else if (u < 0x800) {
+			m_utf8.append(char(0xc0 | (u >> 6)));
+			m_utf8.append(char(0x80 | (u & 0x3f)));
+		} else if (u < 0x10000) {
+			m_utf8.append(char(0xe0 | (u >> 12)));
+			m_utf8.append(char(0x80 | ((u >> 6) & 0x3f)));
+			m_utf8.append(char(0x80 | (u & 0x3f)));
+		} else {
+			m_utf8.append(char(0xf0 | (u >> 18)));
+			m_utf8.append(char(0x80 | ((u >> 12) & 0x3f)));
+			m_utf8.append(char(0x80 | ((u >> 6) & 0x3f)));
+			m_utf8.append(char(0x80 | (u & 0x3f)));
+		}
+	}
+
+	return m_utf8.constData();
+}
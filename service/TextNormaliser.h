@@ -0,0 +1,80 @@
+/*
+ * Copyright (C) 2016 Canonical, Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3, as published
+ * by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranties of
+ * MERCHANTABILITY, SATISFACTORY QUALITY, or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Author: Pete Woods <pete.woods@canonical.com>
+ */
+
+#ifndef HUD_SERVICE_TEXTNORMALISER_H_
+#define HUD_SERVICE_TEXTNORMALISER_H_
+
+#include <QByteArray>
+#include <QString>
+#include <QStringList>
+
+namespace hud {
+namespace service {
+
+/**
+ * Hand written, single pass versions of the menu label clean up and word
+ * splitting the item store needs.
+ *
+ * The scratch buffers are re-used between calls, so a single instance
+ * shouldn't be shared between threads.
+ */
+class TextNormaliser {
+public:
+	TextNormaliser();
+
+	virtual ~TextNormaliser();
+
+	/**
+	 * Removes single '&' mnemonic markers, and collapses "&&" to "&".
+	 */
+	static void stripMnemonic(const QString &text, QString &result);
+
+	/**
+	 * The lower case letter following the first single '&', or a null
+	 * character if there isn't one.
+	 */
+	static QChar mnemonic(const QString &text);
+
+	/**
+	 * Drops ellipses and splits on runs of whitespace. Like
+	 * QString::split, leading or trailing whitespace gives an empty word.
+	 */
+	void tokenise(const QString &text, QStringList &words);
+
+	/**
+	 * Splits on runs of whitespace and semicolons.
+	 */
+	void tokeniseKeywords(const QString &text, QStringList &words);
+
+	/**
+	 * Encodes word as UTF-8. The result is only valid until the next call.
+	 */
+	const char * utf8(const QString &word);
+
+protected:
+	void split(const QString &text, bool keywords, QStringList &words);
+
+	QString m_buffer;
+
+	QByteArray m_utf8;
+};
+
+}
+}
+
+#endif /* HUD_SERVICE_TEXTNORMALISER_H_ */
@@ -45,6 +45,10 @@ public:
 			QString &prefix, QString &baseAction, QDBusObjectPath &actionPath,
 			QDBusObjectPath &modelPath) = 0;
 
+	virtual QString parameterized(unsigned long long commandId,
+			QString &prefix, QString &baseAction, QDBusObjectPath &actionPath,
+			QDBusObjectPath &modelPath) const = 0;
+
 	virtual void executeToolbar(const QString &item) = 0;
 
 	virtual QList<QStringList> commands() const = 0;
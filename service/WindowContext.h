@@ -25,8 +25,6 @@
 #include <QString>
 #include <QSharedPointer>
 
-#include <QMenu>
-
 namespace qtgmenu {
 class QtGMenuImporter;
 }
@@ -72,6 +70,8 @@ public:
 	virtual void addMenu(const QString &context,
 			const MenuDefinition &menuDefinition) = 0;
 
+	virtual void removeMenu(const QString &context) = 0;
+
 	virtual Collector::Ptr activeCollector() = 0;
 
 Q_SIGNALS:
@@ -38,19 +38,49 @@ void WindowContextImpl::setContext(const QString &context) {
 	}
 
 	m_context = context;
-	m_activeCollector = m_collectors[context];
+	m_activeCollector = m_collectors.value(context);
 
 	contextChanged();
 }
 
+/**
+ * Re-adding an unchanged definition keeps the existing collector, so
+ * applications can resend their sources without the menus being imported
+ * again.
+ */
 void WindowContextImpl::addMenu(const QString &context,
 		const MenuDefinition &menuDefinition) {
+	auto definition(m_definitions.constFind(context));
+	if (definition != m_definitions.constEnd()
+			&& definition.value() == menuDefinition) {
+		return;
+	}
 
 	QMap<QString, QDBusObjectPath> actions;
 	actions[menuDefinition.actionPrefix] = menuDefinition.actionPath;
 
-	m_collectors[context] = m_factory.newGMenuCollector(menuDefinition.name,
-			actions, menuDefinition.menuPath);
+	Collector::Ptr collector(
+			m_factory.newGMenuCollector(menuDefinition.name, actions,
+					menuDefinition.menuPath));
+	m_definitions[context] = menuDefinition;
+	m_collectors[context] = collector;
+
+	if (context == m_context) {
+		m_activeCollector = collector;
+		contextChanged();
+	}
+}
+
+void WindowContextImpl::removeMenu(const QString &context) {
+	m_definitions.remove(context);
+	if (m_collectors.remove(context) == 0) {
+		return;
+	}
+
+	if (context == m_context) {
+		m_activeCollector.reset();
+		contextChanged();
+	}
 }
 
 Collector::Ptr WindowContextImpl::activeCollector() {
@@ -42,6 +42,8 @@ public:
 	void addMenu(const QString &context, const MenuDefinition &menuDefinition)
 			override;
 
+	void removeMenu(const QString &context) override;
+
 	Collector::Ptr activeCollector() override;
 
 protected:
@@ -49,6 +51,8 @@ protected:
 
 	QString m_context;
 
+	QMap<QString, MenuDefinition> m_definitions;
+
 	QMap<QString, Collector::Ptr> m_collectors;
 
 	Collector::Ptr m_activeCollector;
@@ -16,10 +16,12 @@
  * Author: Pete Woods <pete.woods@canonical.com>
  */
 
+#include <common/StringPool.h>
 #include <service/Factory.h>
 #include <service/WindowImpl.h>
 #include <QDebug>
 
+using namespace hud::common;
 using namespace hud::service;
 
 WindowTokenImpl::WindowTokenImpl(const QList<CollectorToken::Ptr> &tokens,
@@ -30,7 +32,14 @@ WindowTokenImpl::WindowTokenImpl(const QList<CollectorToken::Ptr> &tokens,
 
 	for (CollectorToken::Ptr token : tokens) {
 		connect(token.data(), SIGNAL(changed()), this, SLOT(childChanged()));
-		m_items->indexMenu(token->menu());
+		m_items->indexMenu(token->menuTree());
+	}
+
+	if (qEnvironmentVariableIsSet("HUD_REPORT_MEMORY")) {
+		const StringPool &pool(StringPool::instance());
+		qDebug() << "Window for" << m_items->applicationId() << "saved"
+				<< m_items->internedBytes() << "bytes by interning into a pool of"
+				<< pool.size() << "strings in" << pool.bytes() << "bytes";
 	}
 }
 
@@ -61,6 +70,13 @@ QString WindowTokenImpl::executeParameterized(unsigned long long commandId,
 			actionPath, modelPath);
 }
 
+QString WindowTokenImpl::parameterized(unsigned long long commandId,
+		QString &prefix, QString &baseAction, QDBusObjectPath &actionPath,
+		QDBusObjectPath &modelPath) const {
+	return m_items->parameterized(commandId, prefix, baseAction, actionPath,
+			modelPath);
+}
+
 void WindowTokenImpl::executeToolbar(const QString &item) {
 	m_items->executeToolbar(item);
 }
@@ -53,6 +53,10 @@ public:
 			QString &baseAction, QDBusObjectPath &actionPath,
 			QDBusObjectPath &modelPath) override;
 
+	QString parameterized(unsigned long long commandId, QString &prefix,
+			QString &baseAction, QDBusObjectPath &actionPath,
+			QDBusObjectPath &modelPath) const override;
+
 	void executeToolbar(const QString &item) override;
 
 	QList<QStringList> commands() const override;
@@ -21,14 +21,13 @@
 #include <service/SignalHandler.h>
 
 #include <QDebug>
-#include <QApplication>
+#include <QCoreApplication>
 
 using namespace std;
 using namespace hud::service;
 
 int main(int argc, char *argv[]) {
-	qputenv("QT_QPA_PLATFORM", "minimal");
-	QApplication application(argc, argv);
+	QCoreApplication application(argc, argv);
 
 	setlocale(LC_ALL, "");
 	bindtextdomain(GETTEXT_PACKAGE, GNOMELOCALEDIR);
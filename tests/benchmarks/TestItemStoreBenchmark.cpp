@@ -0,0 +1,227 @@
+/*
+ * Copyright (C) 2016 Canonical, Ltd.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Author: Pete Woods <pete.woods@canonical.com>
+ */
+#include <service/ItemStore.h>
+#include <service/HardCodedSearchSettings.h>
+#include <testutils/MenuTreeGenerator.h>
+
+#include <QElapsedTimer>
+#include <QStringMatcher>
+#include <iostream>
+#include <sstream>
+#include <gtest/gtest.h>
+
+using namespace std;
+using namespace testing;
+using namespace hud::common;
+using namespace hud::service;
+using namespace hud::testutils;
+
+namespace {
+
+struct BenchmarkCase {
+	int m_items;
+
+	const char *m_locale;
+};
+
+void PrintTo(const BenchmarkCase &benchmarkCase, ostream *os) {
+	*os << benchmarkCase.m_items << " items, " << benchmarkCase.m_locale;
+}
+
+/* Keeps the tracker out of the timings */
+class NullUsageTracker: public UsageTracker {
+public:
+	void markUsage(const QString &, const QString &) override {
+	}
+
+	unsigned int usage(const QString &, const QString &) const override {
+		return 0;
+	}
+};
+
+/* Opens up the parts of the search we want to time separately */
+class BenchmarkItemStore: public ItemStore {
+public:
+	using ItemStore::ItemStore;
+
+	using ItemStore::addResult;
+
+	using ItemStore::executeItem;
+
+	QList<DocumentID> ids() const {
+		return m_items.keys();
+	}
+
+	Item::Ptr item(DocumentID id) const {
+		return m_items.value(id);
+	}
+};
+
+class TestItemStoreBenchmark: public TestWithParam<BenchmarkCase> {
+protected:
+	TestItemStoreBenchmark() :
+			usageTracker(new NullUsageTracker()), searchSettings(
+					new HardCodedSearchSettings()) {
+		MenuTreeGenerator::Options options;
+		options.m_items = GetParam().m_items;
+		options.m_locale = GetParam().m_locale;
+		options.m_breadth = 8;
+		options.m_depth = 3;
+
+		generator.reset(new MenuTreeGenerator(options));
+		menu = generator->generate();
+		menu->setActivator([this](const MenuTree &, int) {
+			++activations;
+		});
+
+		// fewer rounds for the big menus, so every case takes a similar time
+		iterations = qMax(3, 20000 / options.m_items);
+	}
+
+	QSharedPointer<BenchmarkItemStore> newStore() {
+		return QSharedPointer<BenchmarkItemStore>(
+				new BenchmarkItemStore("app-id", usageTracker,
+						searchSettings));
+	}
+
+	/* Mean time of a call, in microseconds */
+	template<typename F>
+	double time(F f) {
+		QElapsedTimer timer;
+		timer.start();
+		for (int i(0); i < iterations; ++i) {
+			f();
+		}
+		return timer.nsecsElapsed() / 1000.0 / iterations;
+	}
+
+	double timeSearch(BenchmarkItemStore &store, const QString &query) {
+		QList<Result> results;
+		return time([&]() {
+			results.clear();
+			store.search(query, Query::EmptyBehaviour::SHOW_SUGGESTIONS,
+					results);
+		});
+	}
+
+	/* The longest label, so the query has as many words as we generate */
+	QString longQuery() const {
+		QString longest;
+		for (const QString &label : generator->labels()) {
+			if (label.size() > longest.size()) {
+				longest = label;
+			}
+		}
+		return longest;
+	}
+
+	/* Swaps two letters in every long enough word, and drops the last one */
+	static QString typos(const QString &query) {
+		QStringList words(query.split(' '));
+		for (QString &word : words) {
+			if (word.size() > 3) {
+				QChar c(word[1]);
+				word[1] = word[2];
+				word[2] = c;
+			}
+		}
+		QString typoed(words.join(' '));
+		typoed.chop(1);
+		return typoed;
+	}
+
+	void record(const char *name, double value) {
+		RecordProperty(name, QString::number(value, 'f', 3).toStdString());
+		json << ", \"" << name << "\": " << QString::number(value, 'f', 3).toStdString();
+	}
+
+	QSharedPointer<UsageTracker> usageTracker;
+
+	QSharedPointer<HardCodedSearchSettings> searchSettings;
+
+	QScopedPointer<MenuTreeGenerator> generator;
+
+	MenuTree::Ptr menu;
+
+	int iterations;
+
+	int activations = 0;
+
+	stringstream json;
+};
+
+TEST_P(TestItemStoreBenchmark, Operations) {
+	ASSERT_EQ(GetParam().m_items, generator->labels().size());
+
+	json << "{ \"benchmark\": \"ItemStore\", \"items\": " << GetParam().m_items
+			<< ", \"locale\": \"" << GetParam().m_locale << "\"";
+
+	// indexing
+	QSharedPointer<BenchmarkItemStore> store;
+	record("IndexMenuUs", time([&]() {
+		store = newStore();
+		store->indexMenu(menu);
+	}));
+
+	// searching
+	QString longest(longQuery());
+	record("SearchEmptyUs", timeSearch(*store, ""));
+	record("SearchShortUs", timeSearch(*store, longest.left(3)));
+	record("SearchLongUs", timeSearch(*store, longest));
+	record("SearchTyposUs", timeSearch(*store, typos(longest)));
+
+	QList<Result> results;
+	store->search(typos(longest), Query::EmptyBehaviour::SHOW_SUGGESTIONS,
+			results);
+	EXPECT_FALSE(results.isEmpty());
+
+	// building a page of results
+	QList<DocumentID> ids(store->ids());
+	int page(qMin(ids.size(), 100));
+	QStringMatcher matcher(longest.left(3), Qt::CaseInsensitive);
+	record("AddResultUs", time([&]() {
+		results.clear();
+		for (int i(0); i < page; ++i) {
+			store->addResult(ids[i], matcher, 3, 0.5, results);
+		}
+	}) / page);
+
+	// executing
+	QList<Item::Ptr> items;
+	for (int i(0); i < page; ++i) {
+		items << store->item(ids[i]);
+	}
+	record("ExecuteItemUs", time([&]() {
+		for (const Item::Ptr &item : items) {
+			store->executeItem(item);
+		}
+	}) / page);
+	EXPECT_EQ(iterations * page, activations);
+
+	json << " }";
+	cout << json.str() << endl;
+}
+
+INSTANTIATE_TEST_CASE_P(MenuSizes, TestItemStoreBenchmark,
+		Values(BenchmarkCase { 1000, "en" }, BenchmarkCase { 1000, "de" },
+				BenchmarkCase { 1000, "ru" }, BenchmarkCase { 10000, "en" },
+				BenchmarkCase { 10000, "de" }, BenchmarkCase { 10000, "ru" },
+				BenchmarkCase { 100000, "en" }, BenchmarkCase { 100000, "fr" },
+				BenchmarkCase { 100000, "ru" }));
+
+} // namespace
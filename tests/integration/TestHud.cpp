@@ -21,10 +21,8 @@
 #include <common/WindowStackInterface.h>
 #include <tests/testutils/HudTestInterface.h>
 
-#include <QAction>
 #include <QDebug>
 #include <QDBusConnection>
-#include <QMenu>
 #include <QString>
 #include <QSignalSpy>
 #include <QTestEventLoop>
@@ -0,0 +1,111 @@
+/*
+ * Copyright (C) 2016 Canonical, Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3, as published
+ * by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranties of
+ * MERCHANTABILITY, SATISFACTORY QUALITY, or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Author: Pete Woods <pete.woods@canonical.com>
+ */
+
+#include <glib-object.h>
+#include <gio/gio.h>
+#include <stdlib.h>
+
+/* Items are split into sections, so updates arrive as many small bursts */
+#define ITEMS_PER_SECTION 100
+
+static GPtrArray * sections = NULL;
+static gint item_count = 0;
+static guint generation = 0;
+
+/* Every item is appended on its own, so each section gets a burst of changes */
+static void
+fill_sections (void)
+{
+    gint i;
+    for (i = 0; i < item_count; i++) {
+        GMenu * section = g_ptr_array_index(sections, i / ITEMS_PER_SECTION);
+
+        gchar * label = g_strdup_printf("Item %d generation %u", i, generation);
+        gchar * action = g_strdup_printf("item%d", i);
+        g_menu_append(section, label, action);
+        g_free(action);
+        g_free(label);
+    }
+}
+
+static void
+refresh (GSimpleAction * action, GVariant * param, gpointer user_data)
+{
+    guint i;
+    for (i = 0; i < sections->len; i++) {
+        g_menu_remove_all(g_ptr_array_index(sections, i));
+    }
+
+    generation++;
+    fill_sections();
+}
+
+int
+main (int argv, char ** argc)
+{
+    if (argv != 4) {
+        g_print("'%s <DBus name> <Object Path> <Item count>' is how you should use this program.\n", argc[0]);
+        return 1;
+    }
+
+#ifndef GLIB_VERSION_2_36
+    g_type_init ();
+#endif
+
+    item_count = atoi(argc[3]);
+
+    GMenu * menu = g_menu_new();
+    GSimpleActionGroup * ag = g_simple_action_group_new();
+
+    sections = g_ptr_array_new_with_free_func(g_object_unref);
+    gint i;
+    for (i = 0; i < item_count; i += ITEMS_PER_SECTION) {
+        GMenu * section = g_menu_new();
+        g_menu_append_section(menu, NULL, G_MENU_MODEL(section));
+        g_ptr_array_add(sections, section);
+    }
+
+    for (i = 0; i < item_count; i++) {
+        gchar * action = g_strdup_printf("item%d", i);
+        g_action_map_add_action(G_ACTION_MAP(ag), G_ACTION(g_simple_action_new(action, NULL)));
+        g_free(action);
+    }
+
+    /* Activating "refresh" replaces every item, to time how updates are applied */
+    GSimpleAction * refresh_action = g_simple_action_new("refresh", NULL);
+    g_signal_connect(refresh_action, "activate", G_CALLBACK(refresh), NULL);
+    g_action_map_add_action(G_ACTION_MAP(ag), G_ACTION(refresh_action));
+
+    fill_sections();
+
+    GDBusConnection * session = g_bus_get_sync(G_BUS_TYPE_SESSION, NULL, NULL);
+
+    g_debug("Exporting Large Action Group");
+    g_dbus_connection_export_action_group(session, argc[2], G_ACTION_GROUP(ag), NULL);
+    g_debug("Exporting Large Menu");
+    g_dbus_connection_export_menu_model(session, argc[2], G_MENU_MODEL(menu), NULL);
+
+    g_debug("Investing in name ownership '%s'", argc[1]);
+    g_bus_own_name(G_BUS_TYPE_SESSION, argc[1], 0, NULL, NULL, NULL, NULL, NULL);
+
+    g_debug("Looping");
+    GMainLoop * mainloop = g_main_loop_new(NULL, FALSE);
+    g_main_loop_run(mainloop);
+
+    return 0;
+}
@@ -0,0 +1,142 @@
+/*
+ * Copyright (C) 2016 Canonical, Ltd.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Author: Pete Woods <pete.woods@canonical.com>
+ */
+
+#include <libhud/hud.h>
+
+#include <QElapsedTimer>
+#include <QTestEventLoop>
+#include <iostream>
+#include <vector>
+#include <libqtdbustest/DBusTestRunner.h>
+#include <gtest/gtest.h>
+
+using namespace std;
+using namespace testing;
+using namespace QtDBusTest;
+
+namespace {
+
+static const int DESCRIPTION_COUNT = 10000;
+
+static const int TIMEOUT = 60000;
+
+class TestActionPublisherBenchmark: public Test {
+protected:
+	TestActionPublisherBenchmark() {
+		dbus.startServices();
+		connection.reset(g_bus_get_sync(G_BUS_TYPE_SESSION, NULL, NULL),
+				&g_object_unref);
+
+		for (int i = 0; i < DESCRIPTION_COUNT; ++i) {
+			/* Newest first, like a list of recent documents */
+			QByteArray target(
+					QString("file:///document-%1").arg(DESCRIPTION_COUNT - i).toUtf8());
+			HudActionDescription *description = hud_action_description_new(
+					"app.open-recent", g_variant_new_string(target.constData()));
+			hud_action_description_set_attribute_value(description,
+					G_MENU_ATTRIBUTE_LABEL, g_variant_new_string(target.constData()));
+			descriptions.push_back(description);
+		}
+	}
+
+	virtual ~TestActionPublisherBenchmark() {
+		for (HudActionDescription *description : descriptions) {
+			hud_action_description_unref(description);
+		}
+	}
+
+	static void itemsChanged(GMenuModel *model, gint position, gint removed,
+			gint added, gpointer user_data) {
+		Q_UNUSED(model);
+		Q_UNUSED(position);
+		Q_UNUSED(removed);
+		Q_UNUSED(added);
+		++*static_cast<int *>(user_data);
+	}
+
+	/* Watches the publisher from the HUD's side of the bus */
+	QSharedPointer<GMenuModel> watch(HudActionPublisher *publisher,
+			int *signals) {
+		QSharedPointer<GMenuModel> model(G_MENU_MODEL(g_dbus_menu_model_get(
+				connection.data(),
+				g_dbus_connection_get_unique_name(connection.data()),
+				hud_action_publisher_get_description_path(publisher))),
+				&g_object_unref);
+		g_signal_connect(model.data(), "items-changed",
+				G_CALLBACK(itemsChanged), signals);
+		g_menu_model_get_n_items(model.data());
+		QTestEventLoop::instance().enterLoopMSecs(100);
+		return model;
+	}
+
+	bool waitForItems(GMenuModel *model) {
+		QElapsedTimer timer;
+		timer.start();
+		while (timer.elapsed() < TIMEOUT) {
+			if (g_menu_model_get_n_items(model) == DESCRIPTION_COUNT) {
+				return true;
+			}
+			QTestEventLoop::instance().enterLoopMSecs(10);
+		}
+		return false;
+	}
+
+	DBusTestRunner dbus;
+
+	QSharedPointer<GDBusConnection> connection;
+
+	vector<HudActionDescription *> descriptions;
+};
+
+TEST_F(TestActionPublisherBenchmark, PublishDescriptions) {
+	QSharedPointer<HudActionPublisher> single(hud_action_publisher_new(
+			HUD_ACTION_PUBLISHER_ALL_WINDOWS, "single"), &g_object_unref);
+	int singleSignals(0);
+	QSharedPointer<GMenuModel> singleModel(watch(single.data(), &singleSignals));
+
+	QElapsedTimer timer;
+	timer.start();
+	for (HudActionDescription *description : descriptions) {
+		hud_action_publisher_add_description(single.data(), description);
+	}
+	qint64 singleAdded(timer.elapsed());
+	ASSERT_TRUE(waitForItems(singleModel.data()));
+	qint64 singleReceived(timer.elapsed());
+
+	QSharedPointer<HudActionPublisher> bulk(hud_action_publisher_new(
+			HUD_ACTION_PUBLISHER_ALL_WINDOWS, "bulk"), &g_object_unref);
+	int bulkSignals(0);
+	QSharedPointer<GMenuModel> bulkModel(watch(bulk.data(), &bulkSignals));
+
+	timer.restart();
+	hud_action_publisher_add_descriptions(bulk.data(), descriptions.data(),
+			descriptions.size());
+	qint64 bulkAdded(timer.elapsed());
+	ASSERT_TRUE(waitForItems(bulkModel.data()));
+	qint64 bulkReceived(timer.elapsed());
+
+	EXPECT_LT(bulkSignals, singleSignals);
+
+	cout << DESCRIPTION_COUNT << " descriptions, one at a time: "
+			<< singleAdded << "ms to add, " << singleReceived
+			<< "ms to arrive (" << singleSignals << " change signals), in bulk: "
+			<< bulkAdded << "ms to add, " << bulkReceived << "ms to arrive ("
+			<< bulkSignals << " change signals)" << endl;
+}
+
+} // namespace
@@ -0,0 +1,117 @@
+/*
+ * Copyright (C) 2016 Canonical, Ltd.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Author: Pete Woods <pete.woods@canonical.com>
+ */
+
+#include <common/GDBusHelper.h>
+#include <common/MenuTree.h>
+#include <libqtgmenu/QtGMenuImporter.h>
+
+#include <QElapsedTimer>
+#include <QSignalSpy>
+#include <iostream>
+#include <libqtdbustest/QProcessDBusService.h>
+#include <libqtdbustest/DBusTestRunner.h>
+#include <gtest/gtest.h>
+
+#undef signals
+#include <gio/gio.h>
+
+using namespace std;
+using namespace testing;
+using namespace hud::common;
+using namespace qtgmenu;
+using namespace QtDBusTest;
+
+namespace {
+
+static const char *MENU_NAME = "test.large.menu";
+
+static const char *MENU_PATH = "/test/large/menu";
+
+static const int ITEM_COUNT = 10000;
+
+/* The model splits its items into sections of 100, each shown after a separator */
+static const int NODE_COUNT = 1 + ITEM_COUNT + ITEM_COUNT / 100 - 1;
+
+static const int TIMEOUT = 60000;
+
+class TestGMenuImportBenchmark: public Test {
+protected:
+	TestGMenuImportBenchmark() :
+			connection(newSessionBusConnection(nullptr), &g_object_unref) {
+		dbus.startServices();
+	}
+
+	/* Waits for the imported menu to hold every item from the given generation */
+	bool waitForItems(const QtGMenuImporter &importer, QSignalSpy &spy,
+			int generation) {
+		QString suffix(QString("generation %1").arg(generation));
+
+		QElapsedTimer timer;
+		timer.start();
+		while (timer.elapsed() < TIMEOUT) {
+			MenuTree::Ptr tree(importer.GetMenuTree());
+			if (tree->size() == NODE_COUNT
+					&& tree->node(tree->size() - 1).m_label.endsWith(suffix)) {
+				return true;
+			}
+			spy.wait(1000);
+		}
+		return false;
+	}
+
+	DBusTestRunner dbus;
+
+	QSharedPointer<GDBusConnection> connection;
+};
+
+TEST_F(TestGMenuImportBenchmark, ImportAndRefresh) {
+	QProcessDBusService model(MENU_NAME, QDBusConnection::SessionBus,
+			MODEL_LARGE,
+			QStringList() << MENU_NAME << MENU_PATH
+					<< QString::number(ITEM_COUNT));
+	model.start(dbus.sessionConnection());
+
+	QElapsedTimer timer;
+	timer.start();
+
+	QtGMenuImporter importer(MENU_NAME, QDBusObjectPath(MENU_PATH), "app",
+			QDBusObjectPath(MENU_PATH), dbus.sessionConnection(), connection);
+	QSignalSpy spy(&importer, SIGNAL(MenuItemsChanged()));
+
+	ASSERT_TRUE(waitForItems(importer, spy, 0));
+	qint64 imported(timer.elapsed());
+	int importSignals(spy.size());
+
+	// replaces every item, one "items-changed" at a time
+	spy.clear();
+	QSharedPointer<GDBusActionGroup> actions(
+			g_dbus_action_group_get(connection.data(), MENU_NAME, MENU_PATH),
+			&g_object_unref);
+	timer.restart();
+	g_action_group_activate_action(G_ACTION_GROUP(actions.data()), "refresh",
+			nullptr);
+
+	ASSERT_TRUE(waitForItems(importer, spy, 1));
+	qint64 refreshed(timer.elapsed());
+
+	cout << ITEM_COUNT << " item GMenu, import: " << imported << "ms ("
+			<< importSignals << " change signals), refresh: " << refreshed
+			<< "ms (" << spy.size() << " change signals)" << endl;
+}
+
+} // namespace
@@ -0,0 +1,160 @@
+/*
+ * Copyright (C) 2016 Canonical, Ltd.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Author: Pete Woods <pete.woods@canonical.com>
+ */
+
+#include <common/MenuTree.h>
+#include <service/ItemStore.h>
+#include <service/HardCodedSearchSettings.h>
+#include <tests/unit/service/Mocks.h>
+
+#include <QElapsedTimer>
+#include <QThreadPool>
+#include <iostream>
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+using namespace std;
+using namespace testing;
+using namespace hud::common;
+using namespace hud::service;
+using namespace hud::service::test;
+
+namespace {
+
+static const QStringList VOCABULARY( { "Document", "Report", "Invoice",
+		"Letter", "Summary", "Draft", "Budget", "Minutes", "Agenda", "Notes",
+		"Proposal", "Contract", "Schedule", "Diagram", "Presentation",
+		"Spreadsheet", "Manual", "Receipt", "Statement", "Checklist",
+		"Timeline", "Inventory", "Roadmap", "Estimate", "Memo", "Outline",
+		"Catalogue", "Brochure", "Portfolio", "Template", "Calendar" });
+
+static const int ITEM_COUNT = 40000;
+
+static const int ITERATIONS = 10;
+
+class TestItemStoreScaling: public Test {
+protected:
+	TestItemStoreScaling() :
+			defaultThreadCount(QThreadPool::globalInstance()->maxThreadCount()), menu(
+					new MenuTree()) {
+		usageTracker.reset(new NiceMock<MockUsageTracker>());
+		searchSettings.reset(new HardCodedSearchSettings());
+
+		MenuTree::Node recent;
+		recent.m_label = "Recent Documents";
+		recent.m_flags |= MenuTree::SUBMENU;
+		int recentIndex(menu->append(MenuTree::ROOT, recent));
+
+		for (int i(0); i < ITEM_COUNT; ++i) {
+			MenuTree::Node node;
+			node.m_label = QString("%1 %2 %3").arg(
+					VOCABULARY[i % VOCABULARY.size()],
+					VOCABULARY[(i / VOCABULARY.size()) % VOCABULARY.size()],
+					QString::number(i));
+			menu->append(recentIndex, node);
+		}
+	}
+
+	virtual ~TestItemStoreScaling() {
+		QThreadPool::globalInstance()->setMaxThreadCount(defaultThreadCount);
+	}
+
+	ItemStore::Ptr newStore(int threadCount) {
+		QThreadPool::globalInstance()->setMaxThreadCount(threadCount);
+
+		ItemStore::Ptr store(
+				new ItemStore("app-id", usageTracker, searchSettings));
+		store->indexMenu(menu);
+		return store;
+	}
+
+	/* Returns the mean query time in milliseconds */
+	double timeSearch(ItemStore::Ptr store, const QString &query,
+			QList<Result> &results) {
+		QElapsedTimer timer;
+		timer.start();
+		for (int i(0); i < ITERATIONS; ++i) {
+			results.clear();
+			store->search(query, Query::EmptyBehaviour::SHOW_SUGGESTIONS,
+					results);
+		}
+		return double(timer.elapsed()) / ITERATIONS;
+	}
+
+	int defaultThreadCount;
+
+	MenuTree::Ptr menu;
+
+	QSharedPointer<MockUsageTracker> usageTracker;
+
+	QSharedPointer<HardCodedSearchSettings> searchSettings;
+};
+
+TEST_F(TestItemStoreScaling, QueryLatencyByThreadCount) {
+	QList<int> threadCounts;
+	for (int threads(1); threads < defaultThreadCount; threads *= 2) {
+		threadCounts << threads;
+	}
+	threadCounts << defaultThreadCount;
+
+	QString expected;
+	for (int threads : threadCounts) {
+		ItemStore::Ptr store(newStore(threads));
+
+		// Every item is in the "Recent Documents" menu, so this has to score
+		// the whole corpus
+		QList<Result> results;
+		double elapsed(timeSearch(store, "recent memo dra", results));
+
+		cout << "threads: " << threads << ", items: " << ITEM_COUNT
+				<< ", mean query time: " << elapsed << "ms" << endl;
+
+		ASSERT_FALSE(results.isEmpty());
+		if (expected.isEmpty()) {
+			expected = results.first().commandName();
+		}
+		EXPECT_EQ(expected, results.first().commandName());
+	}
+}
+
+TEST_F(TestItemStoreScaling, ResultsDoNotDependOnThreadCount) {
+	ItemStore::Ptr single(newStore(1));
+	ItemStore::Ptr parallel(newStore(qMax(defaultThreadCount, 2)));
+
+	// Full corpus, exact words, and misspelt
+	for (const QString &query : QStringList( { "recent memo dra",
+			"memo draft 12", "invoce", "spreadshet roadmap" })) {
+		QList<Result> expected;
+		single->search(query, Query::EmptyBehaviour::SHOW_SUGGESTIONS,
+				expected);
+
+		QList<Result> results;
+		parallel->search(query, Query::EmptyBehaviour::SHOW_SUGGESTIONS,
+				results);
+
+		ASSERT_FALSE(expected.isEmpty()) << query.toStdString();
+		ASSERT_EQ(expected.size(), results.size()) << query.toStdString();
+		for (int i(0); i < expected.size(); ++i) {
+			EXPECT_EQ(expected.at(i).id(), results.at(i).id())
+					<< query.toStdString();
+			EXPECT_EQ(expected.at(i).distance(), results.at(i).distance())
+					<< query.toStdString();
+		}
+	}
+}
+
+} // namespace
@@ -0,0 +1,474 @@
+/*
+ * Copyright (C) 2016 Canonical, Ltd.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Author: Pete Woods <pete.woods@canonical.com>
+ */
+
+#include <common/DBusTypes.h>
+#include <common/GDBusHelper.h>
+#include <common/Suggestion.h>
+#include <common/WindowStackInterface.h>
+#include <testutils/MenuTreeGenerator.h>
+
+#include <QDBusConnectionInterface>
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QTemporaryFile>
+#include <QTest>
+#include <algorithm>
+#include <iostream>
+#include <libqtdbustest/QProcessDBusService.h>
+#include <libqtdbustest/DBusTestRunner.h>
+#include <libqtdbusmock/DBusMock.h>
+#include <gtest/gtest.h>
+
+#undef signals
+#include <gio/gio.h>
+
+using namespace std;
+using namespace testing;
+using namespace hud::common;
+using namespace hud::testutils;
+using namespace QtDBusTest;
+using namespace QtDBusMock;
+
+namespace {
+
+static const int WINDOW_COUNT = 300;
+
+/* Even numbered apps export GMenus, odd numbered ones DBusMenus */
+static const int APP_COUNT = 24;
+
+static const int ITEM_COUNT = 2000;
+
+static const char *GMENU_NAME = "test.gmenu.app";
+
+static const char *DBUSMENU_NAME = "test.dbusmenu.app";
+
+static const char *MENU_PATH = "/menu";
+
+/*
+ * The limits are generous, so only real scaling regressions trip them on a
+ * loaded CI machine rather than ordinary noise.
+ */
+static const qint64 STARTUP_LIMIT_MS = 10000;
+
+static const qint64 FIRST_RESULTS_LIMIT_MS = 10000;
+
+static const qint64 SEARCH_LIMIT_MS = 200;
+
+static const qint64 STARTUP_RSS_LIMIT_KB = 128 * 1024;
+
+static const qint64 INDEXED_RSS_LIMIT_KB = 256 * 1024;
+
+static const int STARTUP_MESSAGES_PER_WINDOW = 20;
+
+static const int MESSAGES_PER_SEARCH = 20;
+
+static const int RESULT_COUNT = 5;
+
+/*
+ * Counts the messages going to or from each bus name, using a monitor
+ * connection of its own so the traffic isn't perturbed.
+ */
+class DBusMessageCounter {
+public:
+	DBusMessageCounter() :
+			m_connection(newSessionBusConnection(nullptr), &g_object_unref) {
+		m_uniqueName = g_dbus_connection_get_unique_name(m_connection.data());
+		m_filter = g_dbus_connection_add_filter(m_connection.data(),
+				filterCallback, this, nullptr);
+
+		GError *error = nullptr;
+		GVariant *reply = g_dbus_connection_call_sync(m_connection.data(),
+				"org.freedesktop.DBus", "/org/freedesktop/DBus",
+				"org.freedesktop.DBus.Monitoring", "BecomeMonitor",
+				g_variant_new("(@asu)", g_variant_new_strv(nullptr, 0), 0u),
+				nullptr, G_DBUS_CALL_FLAGS_NONE, -1, nullptr, &error);
+		if (reply) {
+			g_variant_unref(reply);
+		} else {
+			qWarning() << "Failed to become a monitor:" << error->message;
+			g_error_free(error);
+		}
+	}
+
+	~DBusMessageCounter() {
+		// the filter runs on the GDBus worker, so stop that first
+		g_dbus_connection_close_sync(m_connection.data(), nullptr, nullptr);
+		g_dbus_connection_remove_filter(m_connection.data(), m_filter);
+	}
+
+	/* Everything sent or received by the names the process owns */
+	int count(const QDBusConnection &connection, uint pid) const {
+		QMap<QString, int> counts;
+		{
+			QMutexLocker lock(&m_mutex);
+			counts = m_counts;
+		}
+
+		int total(0);
+		for (auto it(counts.cbegin()); it != counts.cend(); ++it) {
+			if (connection.interface()->servicePid(it.key()).value() == pid) {
+				total += it.value();
+			}
+		}
+		return total;
+	}
+
+protected:
+	static GDBusMessage * filterCallback(GDBusConnection *, GDBusMessage *message,
+			gboolean incoming, gpointer user_data) {
+		DBusMessageCounter *self(
+				reinterpret_cast<DBusMessageCounter *>(user_data));
+
+		QString sender(
+				QString::fromUtf8(g_dbus_message_get_sender(message)));
+		QString destination(
+				QString::fromUtf8(g_dbus_message_get_destination(message)));
+
+		// our own traffic, e.g. the reply to BecomeMonitor
+		if (!incoming || destination == self->m_uniqueName) {
+			return message;
+		}
+
+		{
+			QMutexLocker lock(&self->m_mutex);
+			if (!sender.isEmpty()) {
+				++self->m_counts[sender];
+			}
+			if (!destination.isEmpty() && destination != sender) {
+				++self->m_counts[destination];
+			}
+		}
+
+		// a monitor mustn't reply to anything it sees
+		g_object_unref(message);
+		return nullptr;
+	}
+
+	QSharedPointer<GDBusConnection> m_connection;
+
+	QString m_uniqueName;
+
+	guint m_filter;
+
+	mutable QMutex m_mutex;
+
+	QMap<QString, int> m_counts;
+};
+
+class TestServiceScaling: public Test {
+protected:
+	TestServiceScaling() :
+			mock(dbus) {
+
+		mock.registerCustomMock(DBusTypes::BAMF_DBUS_NAME,
+				DBusTypes::BAMF_MATCHER_DBUS_PATH, "org.ayatana.bamf.control",
+				QDBusConnection::SessionBus);
+
+		mock.registerCustomMock(DBusTypes::WINDOW_STACK_DBUS_NAME,
+				DBusTypes::WINDOW_STACK_DBUS_PATH,
+				ComCanonicalUnityWindowStackInterface::staticInterfaceName(),
+				QDBusConnection::SessionBus);
+
+		mock.registerCustomMock(DBusTypes::APPMENU_REGISTRAR_DBUS_NAME,
+				DBusTypes::APPMENU_REGISTRAR_DBUS_PATH,
+				"com.canonical.AppMenu.Registrar", QDBusConnection::SessionBus);
+
+		dbus.startServices();
+
+		DBusTypes::registerMetaTypes();
+
+		startApps();
+		fakeWindowStack();
+	}
+
+	OrgFreedesktopDBusMockInterface & windowStackMock() {
+		return mock.mockInterface(DBusTypes::WINDOW_STACK_DBUS_NAME,
+				DBusTypes::WINDOW_STACK_DBUS_PATH,
+				ComCanonicalUnityWindowStackInterface::staticInterfaceName(),
+				QDBusConnection::SessionBus);
+	}
+
+	OrgFreedesktopDBusMockInterface & appmenuRegstrarMock() {
+		return mock.mockInterface(DBusTypes::APPMENU_REGISTRAR_DBUS_NAME,
+				DBusTypes::APPMENU_REGISTRAR_DBUS_PATH,
+				"com.canonical.AppMenu.Registrar", QDBusConnection::SessionBus);
+	}
+
+	static QJsonArray toJson(const MenuTree &tree, int parent, int &id) {
+		QJsonArray children;
+		for (int i(tree.firstChild(parent)); i != -1; i = tree.nextSibling(i)) {
+			const MenuTree::Node &node(tree.node(i));
+
+			QJsonObject child;
+			child["id"] = ++id;
+			child["label"] = node.m_label;
+			if (node.flag(MenuTree::SUBMENU)) {
+				child["children-display"] = QString("submenu");
+				child["submenu"] = toJson(tree, i, id);
+			}
+			children.append(child);
+		}
+		return children;
+	}
+
+	/* Each DBusMenu app gets its own menu, in one of the generator's locales */
+	QString writeDBusMenu(int app) {
+		MenuTreeGenerator::Options options;
+		options.m_items = ITEM_COUNT;
+		options.m_seed = app;
+		QStringList locales(MenuTreeGenerator::locales());
+		options.m_locale = locales.at(app % locales.size());
+
+		MenuTreeGenerator generator(options);
+		MenuTree::Ptr tree(generator.generate());
+		queries[app] = generator.labels().at(app % ITEM_COUNT);
+
+		int id(0);
+		QJsonObject root;
+		root["id"] = id;
+		root["children-display"] = QString("submenu");
+		root["submenu"] = toJson(*tree, MenuTree::ROOT, id);
+
+		QSharedPointer<QTemporaryFile> file(new QTemporaryFile());
+		file->open();
+		file->write(QJsonDocument(root).toJson(QJsonDocument::Compact));
+		file->close();
+		menuFiles << file;
+
+		return file->fileName();
+	}
+
+	void startApps() {
+		for (int app(0); app < APP_COUNT; ++app) {
+			QSharedPointer<QProcessDBusService> service;
+			if (app % 2 == 0) {
+				QString name(GMENU_NAME + QString::number(app));
+				service.reset(
+						new QProcessDBusService(name,
+								QDBusConnection::SessionBus, MODEL_LARGE,
+								QStringList() << name << MENU_PATH
+										<< QString::number(ITEM_COUNT)));
+				queries[app] = QString("Item %1").arg(ITEM_COUNT - app);
+			} else {
+				QString name(DBUSMENU_NAME + QString::number(app));
+				service.reset(
+						new QProcessDBusService(name,
+								QDBusConnection::SessionBus,
+								DBUSMENU_JSON_LOADER,
+								QStringList() << name << MENU_PATH
+										<< writeDBusMenu(app)));
+			}
+			service->start(dbus.sessionConnection());
+			apps << service;
+		}
+	}
+
+	/* Window n belongs to app (n % APP_COUNT), and window 0 has the focus */
+	void fakeWindowStack() {
+		windowStackMock().AddMethod(DBusTypes::WINDOW_STACK_DBUS_NAME,
+				"GetWindowStack", "", "a(usbu)",
+				QString("ret = []\n"
+						"for i in range(%1):\n"
+						"  ret.append((i, 'app' + str(i % %2), i == 0, 0))").arg(
+						WINDOW_COUNT).arg(APP_COUNT)).waitForFinished();
+
+		windowStackMock().AddMethod(DBusTypes::WINDOW_STACK_DBUS_NAME,
+				"GetWindowProperties", "usas", "as",
+				QString("ret = []\n"
+						"app = int(args[1][3:])\n"
+						"if app % 2 == 0:\n"
+						"  ret = ['%1' + str(app), '', '%2', '', '', '%2']\n"
+						"else:\n"
+						"  for arg in args[2]:\n"
+						"    ret.append('')").arg(GMENU_NAME).arg(MENU_PATH)).waitForFinished();
+
+		appmenuRegstrarMock().AddMethod(DBusTypes::APPMENU_REGISTRAR_DBUS_NAME,
+				"GetMenuForWindow", "u", "so",
+				QString("app = args[0] % %1\n"
+						"if app % 2 == 1:\n"
+						"  ret = ('%2' + str(app), '%3')\n"
+						"else:\n"
+						"  ret = ('', '/')").arg(APP_COUNT).arg(DBUSMENU_NAME).arg(
+						MENU_PATH)).waitForFinished();
+	}
+
+	qint64 startHud() {
+		hud.reset(
+				new QProcessDBusService(DBusTypes::HUD_SERVICE_DBUS_NAME,
+						QDBusConnection::SessionBus, HUD_SERVICE_BINARY,
+						QStringList()));
+
+		// start() returns once the service has claimed its bus name
+		QElapsedTimer timer;
+		timer.start();
+		hud->start(dbus.sessionConnection());
+		return timer.elapsed();
+	}
+
+	uint hudPid() {
+		return dbus.sessionConnection().interface()->servicePid(
+				DBusTypes::HUD_SERVICE_DBUS_NAME).value();
+	}
+
+	qint64 hudRss() {
+		QFile status(QString("/proc/%1/status").arg(hudPid()));
+		if (!status.open(QIODevice::ReadOnly)) {
+			return -1;
+		}
+
+		for (const QByteArray &line : status.readAll().split('\n')) {
+			if (line.startsWith("VmRSS:")) {
+				return line.mid(6).trimmed().split(' ').first().toLongLong();
+			}
+		}
+		return -1;
+	}
+
+	/* Runs a query on the focused window through the legacy API */
+	int search(const QString &query) {
+		QDBusMessage message(
+				QDBusMessage::createMethodCall(DBusTypes::HUD_SERVICE_DBUS_NAME,
+						DBusTypes::HUD_SERVICE_DBUS_PATH, "com.canonical.hud",
+						"StartQuery"));
+		message << query << RESULT_COUNT;
+
+		QDBusMessage reply(dbus.sessionConnection().call(message));
+		if (reply.type() != QDBusMessage::ReplyMessage) {
+			return -1;
+		}
+		return qdbus_cast<QList<Suggestion>>(reply.arguments().at(1)).size();
+	}
+
+	void focus(int window) {
+		QString applicationId(QString("app%1").arg(window % APP_COUNT));
+		windowStackMock().EmitSignal(
+				ComCanonicalUnityWindowStackInterface::staticInterfaceName(),
+				"FocusedWindowChanged", "usu",
+				QVariantList() << uint(window) << applicationId << uint(0)).waitForFinished();
+	}
+
+	/* How long until the newly focused window's menu can be searched */
+	qint64 waitForResults(const QString &query) {
+		QElapsedTimer timer;
+		timer.start();
+		while (timer.elapsed() < FIRST_RESULTS_LIMIT_MS * 2) {
+			if (search(query) == RESULT_COUNT) {
+				return timer.elapsed();
+			}
+			QTest::qWait(10);
+		}
+		return timer.elapsed();
+	}
+
+	static qint64 percentile(QList<qint64> values, int percent) {
+		std::sort(values.begin(), values.end());
+		int rank((values.size() * percent + 99) / 100);
+		return values.at(qMax(rank, 1) - 1);
+	}
+
+	DBusTestRunner dbus;
+
+	DBusMock mock;
+
+	QList<QSharedPointer<QProcessDBusService>> apps;
+
+	QList<QSharedPointer<QTemporaryFile>> menuFiles;
+
+	QMap<int, QString> queries;
+
+	QSharedPointer<QProcessDBusService> hud;
+};
+
+TEST_F(TestServiceScaling, Startup) {
+	DBusMessageCounter counter;
+
+	qint64 startup(startHud());
+	int messages(counter.count(dbus.sessionConnection(), hudPid()));
+	qint64 rss(hudRss());
+
+	RecordProperty("StartupMs", startup);
+	RecordProperty("StartupMessages", messages);
+	RecordProperty("StartupRssKb", rss);
+	cout << WINDOW_COUNT << " windows, " << APP_COUNT << " apps, startup: "
+			<< startup << "ms, " << messages << " messages, RSS: " << rss
+			<< "kB" << endl;
+
+	EXPECT_LT(startup, STARTUP_LIMIT_MS);
+	EXPECT_LT(messages, STARTUP_MESSAGES_PER_WINDOW * WINDOW_COUNT);
+	ASSERT_GT(rss, 0);
+	EXPECT_LT(rss, STARTUP_RSS_LIMIT_KB);
+}
+
+TEST_F(TestServiceScaling, SearchEveryApp) {
+	startHud();
+	DBusMessageCounter counter;
+
+	qint64 slowestFirstResults(0);
+	QList<qint64> latencies;
+	int searches(0);
+	int searchMessages(0);
+
+	for (int app(0); app < APP_COUNT; ++app) {
+		focus(app);
+
+		const QString &query(queries[app]);
+		qint64 firstResults(waitForResults(query));
+		slowestFirstResults = qMax(slowestFirstResults, firstResults);
+		EXPECT_LT(firstResults, FIRST_RESULTS_LIMIT_MS) << "app" << app;
+
+		// type the query again, a character at a time
+		int before(counter.count(dbus.sessionConnection(), hudPid()));
+		for (int i(1); i <= query.size(); ++i) {
+			QElapsedTimer timer;
+			timer.start();
+			EXPECT_LE(0, search(query.left(i)));
+			latencies << timer.elapsed();
+			++searches;
+		}
+		searchMessages += counter.count(dbus.sessionConnection(), hudPid())
+				- before;
+	}
+
+	qint64 p95(percentile(latencies, 95));
+	double messagesPerSearch(double(searchMessages) / searches);
+	qint64 rss(hudRss());
+
+	RecordProperty("SlowestFirstResultsMs", slowestFirstResults);
+	RecordProperty("SearchP95Ms", p95);
+	RecordProperty("SearchMaxMs", percentile(latencies, 100));
+	RecordProperty("MessagesPerSearch",
+			QString::number(messagesPerSearch, 'f', 1).toStdString());
+	RecordProperty("IndexedRssKb", rss);
+	cout << APP_COUNT << " apps of " << ITEM_COUNT
+			<< " items, slowest first results: " << slowestFirstResults
+			<< "ms, search p95: " << p95 << "ms, messages per search: "
+			<< messagesPerSearch << ", RSS: " << rss << "kB" << endl;
+
+	EXPECT_LT(p95, SEARCH_LIMIT_MS);
+	EXPECT_LT(messagesPerSearch, MESSAGES_PER_SEARCH);
+	ASSERT_GT(rss, 0);
+	EXPECT_LT(rss, INDEXED_RSS_LIMIT_KB);
+}
+
+} // namespace
@@ -0,0 +1,153 @@
+/*
+ * Copyright (C) 2016 Canonical, Ltd.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Author: Pete Woods <pete.woods@canonical.com>
+ */
+
+#include <common/DBusTypes.h>
+#include <common/WindowStackInterface.h>
+
+#include <QDBusConnectionInterface>
+#include <QElapsedTimer>
+#include <QFile>
+#include <iostream>
+#include <libqtdbustest/QProcessDBusService.h>
+#include <libqtdbustest/DBusTestRunner.h>
+#include <libqtdbusmock/DBusMock.h>
+#include <gtest/gtest.h>
+
+using namespace std;
+using namespace testing;
+using namespace hud::common;
+using namespace QtDBusTest;
+using namespace QtDBusMock;
+
+namespace {
+
+static const int ITERATIONS = 5;
+
+/* Generous, so that loaded build machines still pass */
+static const qint64 STARTUP_LIMIT_MS = 2000;
+
+/* The libraries dropped to cut startup time */
+static const QList<QByteArray> UNWANTED_LIBRARIES( { "libQt5Widgets",
+		"libdbusmenu-qt5" });
+
+class TestServiceStartup: public Test {
+protected:
+	TestServiceStartup() :
+			mock(dbus) {
+
+		mock.registerCustomMock(DBusTypes::BAMF_DBUS_NAME,
+				DBusTypes::BAMF_MATCHER_DBUS_PATH, "org.ayatana.bamf.control",
+				QDBusConnection::SessionBus);
+
+		mock.registerCustomMock(DBusTypes::WINDOW_STACK_DBUS_NAME,
+				DBusTypes::WINDOW_STACK_DBUS_PATH,
+				ComCanonicalUnityWindowStackInterface::staticInterfaceName(),
+				QDBusConnection::SessionBus);
+
+		mock.registerCustomMock(DBusTypes::APPMENU_REGISTRAR_DBUS_NAME,
+				DBusTypes::APPMENU_REGISTRAR_DBUS_PATH,
+				"com.canonical.AppMenu.Registrar", QDBusConnection::SessionBus);
+
+		dbus.startServices();
+	}
+
+	uint hudPid() {
+		return dbus.sessionConnection().interface()->servicePid(
+				DBusTypes::HUD_SERVICE_DBUS_NAME).value();
+	}
+
+	QList<QByteArray> hudLibraries() {
+		QList<QByteArray> libraries;
+
+		QFile maps(QString("/proc/%1/maps").arg(hudPid()));
+		if (!maps.open(QIODevice::ReadOnly)) {
+			return libraries;
+		}
+
+		for (const QByteArray &line : maps.readAll().split('\n')) {
+			int slash(line.lastIndexOf('/'));
+			if (slash != -1 && !libraries.contains(line.mid(slash + 1))) {
+				libraries << line.mid(slash + 1);
+			}
+		}
+		return libraries;
+	}
+
+	DBusTestRunner dbus;
+
+	DBusMock mock;
+};
+
+/*
+ * Run against builds from before and after a change to compare them; set
+ * HUD_STARTUP_BASELINE_MS to the fastest time of the "before" build to
+ * fail on a regression.
+ */
+TEST_F(TestServiceStartup, ActivationToBusReady) {
+	qint64 total(0);
+	qint64 fastest(-1);
+	QList<QByteArray> libraries;
+
+	for (int i(0); i < ITERATIONS; ++i) {
+		QProcessDBusService hud(DBusTypes::HUD_SERVICE_DBUS_NAME,
+				QDBusConnection::SessionBus, HUD_SERVICE_BINARY,
+				QStringList());
+
+		// start() returns once the service has claimed its bus name
+		QElapsedTimer timer;
+		timer.start();
+		hud.start(dbus.sessionConnection());
+		qint64 elapsed(timer.elapsed());
+
+		total += elapsed;
+		if (fastest == -1 || elapsed < fastest) {
+			fastest = elapsed;
+		}
+
+		if (libraries.isEmpty()) {
+			libraries = hudLibraries();
+		}
+	}
+
+	RecordProperty("StartupMeanMs", int(total / ITERATIONS));
+	RecordProperty("StartupFastestMs", int(fastest));
+	cout << "hud-service activation to bus ready, mean: "
+			<< double(total) / ITERATIONS << "ms, fastest: " << fastest << "ms"
+			<< endl;
+
+	EXPECT_LT(fastest, STARTUP_LIMIT_MS);
+
+	bool ok(false);
+	qint64 baseline(qgetenv("HUD_STARTUP_BASELINE_MS").toLongLong(&ok));
+	if (ok) {
+		cout << "baseline: " << baseline << "ms, change: "
+				<< fastest - baseline << "ms" << endl;
+		EXPECT_LE(fastest, baseline);
+	}
+
+	// The startup saving comes from not loading these at all
+	ASSERT_FALSE(libraries.isEmpty());
+	for (const QByteArray &library : libraries) {
+		for (const QByteArray &unwanted : UNWANTED_LIBRARIES) {
+			EXPECT_FALSE(library.startsWith(unwanted))
+					<< library.constData();
+		}
+	}
+}
+
+} // namespace
@@ -0,0 +1,99 @@
+/*
+ * Copyright (C) 2016 Canonical, Ltd.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Author: Pete Woods <pete.woods@canonical.com>
+ */
+
+#include <service/TextNormaliser.h>
+
+#include <QElapsedTimer>
+#include <QRegularExpression>
+#include <iostream>
+#include <gtest/gtest.h>
+
+using namespace std;
+using namespace testing;
+using namespace hud::service;
+
+namespace {
+
+/* The regular expressions the item store used to use */
+static const QRegularExpression SINGLE_AMPERSAND("(?<![&])[&](?![&])");
+static const QRegularExpression BAD_CHARACTERS("\\.\\.\\.|…");
+static const QRegularExpression WHITESPACE("\\s+");
+
+static const QStringList LABELS( { "&File", "Save &As...", "Print Pre&view",
+		"Keyboard Shortcuts…", "Save && Close", "Connexion au &réseau...",
+		"&Configure VPN...", "Open &Recent", "Find and Re&place...",
+		"Toggle &Full Screen" });
+
+static const int ITERATIONS = 100000;
+
+class TestTextNormaliserBenchmark: public Test {
+protected:
+	static QStringList regexTokenise(const QString &label) {
+		return QString(label).remove(SINGLE_AMPERSAND).replace("&&", "&").remove(
+				BAD_CHARACTERS).split(WHITESPACE);
+	}
+
+	QStringList normaliserTokenise(const QString &label) {
+		TextNormaliser::stripMnemonic(label, buffer);
+		QStringList words;
+		normaliser.tokenise(buffer, words);
+		return words;
+	}
+
+	TextNormaliser normaliser;
+
+	QString buffer;
+};
+
+TEST_F(TestTextNormaliserBenchmark, AgainstRegularExpressions) {
+	for (const QString &label : LABELS) {
+		EXPECT_EQ(regexTokenise(label), normaliserTokenise(label));
+	}
+
+	QElapsedTimer timer;
+
+	int count(0);
+	timer.start();
+	for (int i(0); i < ITERATIONS; ++i) {
+		for (const QString &label : LABELS) {
+			for (const QString &word : regexTokenise(label)) {
+				count += word.toUtf8().size();
+			}
+		}
+	}
+	qint64 regexElapsed(timer.elapsed());
+
+	int normaliserCount(0);
+	timer.restart();
+	for (int i(0); i < ITERATIONS; ++i) {
+		for (const QString &label : LABELS) {
+			for (const QString &word : normaliserTokenise(label)) {
+				normaliserCount += qstrlen(normaliser.utf8(word));
+			}
+		}
+	}
+	qint64 normaliserElapsed(timer.elapsed());
+
+	cout << "labels: " << ITERATIONS * LABELS.size() << ", regex: "
+			<< regexElapsed << "ms, normaliser: " << normaliserElapsed << "ms"
+			<< endl;
+
+	EXPECT_EQ(count, normaliserCount);
+}
+
+} // namespace
@@ -1,12 +1,52 @@
 #include <MainWindow.h>
 
+#include <common/MenuTree.h>
+
 #include <QtWidgets>
 
+using hud::common::MenuTree;
+
+static void AppendMenu( QMenu* menu, MenuTree::Ptr tree, int parent )
+{
+  for( int i = tree->firstChild( parent ); i != -1; i = tree->nextSibling( i ) )
+  {
+    const MenuTree::Node& node = tree->node( i );
+
+    if( node.flag( MenuTree::SEPARATOR ) )
+    {
+      menu->addSeparator();
+      continue;
+    }
+
+    QAction* action;
+    if( node.flag( MenuTree::SUBMENU ) )
+    {
+      QMenu* submenu = menu->addMenu( node.m_label );
+      AppendMenu( submenu, tree, i );
+      action = submenu->menuAction();
+    }
+    else
+    {
+      action = menu->addAction( node.m_label );
+      QObject::connect( action, &QAction::triggered, [tree, i]()
+      {
+        tree->activate( i );
+      } );
+    }
+
+    action->setShortcut( QKeySequence( node.m_accel ) );
+    action->setEnabled( node.flag( MenuTree::ENABLED ) );
+  }
+}
+
 MainWindow::MainWindow(const QString &name, const QDBusObjectPath &actionPath, const QDBusObjectPath &menuPath, const QDBusConnection& connection, QSharedPointer<GDBusConnection> gconnection)
     : m_menu_importer( name, menuPath, "", actionPath, connection, gconnection)
 {
   m_refresh_connection = connect( &m_menu_importer, SIGNAL( MenuItemsChanged() ), this,
       SLOT( RefreshMenus() ) );
+
+  // show every level, not just the ones a search would need
+  m_menu_importer.Subscribe();
 }
 
 MainWindow::~MainWindow()
@@ -18,9 +58,13 @@ void MainWindow::RefreshMenus()
 {
   menuBar()->clear();
 
-  m_top_menu = m_menu_importer.GetQMenu();
-  if( m_top_menu )
+  m_top_menu.reset();
+
+  MenuTree::Ptr tree = m_menu_importer.GetMenuTree();
+  if( tree )
   {
+    m_top_menu = std::make_shared< QMenu >();
+    AppendMenu( m_top_menu.get(), tree, MenuTree::ROOT );
     menuBar()->addActions( m_top_menu->actions() );
   }
 
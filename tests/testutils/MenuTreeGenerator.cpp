@@ -0,0 +1,142 @@
+/*
+ * Copyright (C) 2016 Canonical, Ltd.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Author: Pete Woods <pete.woods@canonical.com>
+ */
+#include <testutils/MenuTreeGenerator.h>
+
+#include <QMap>
+
+#include <cmath>
+#include <vector>
+
+using namespace hud::common;
+using namespace hud::testutils;
+
+namespace {
+
+/* Menu words, with accents and other scripts to keep the normaliser busy */
+const QMap<QString, QStringList> & vocabularies() {
+	static const QMap<QString, QStringList> VOCABULARIES( {
+		{ "en", { "New", "Open", "Save", "Close", "Print", "Document",
+				"Window", "Tab", "Preview", "Export", "Import", "Settings",
+				"Recent", "Image", "Layer", "Filter", "Colour", "Brightness",
+				"Contrast", "Select", "All", "None", "Invert", "Zoom", "In",
+				"Out", "Fit", "Page", "Insert", "Table", "Row", "Column" } },
+		{ "de", { "Neu", "Öffnen", "Speichern", "Schließen", "Drucken",
+				"Dokument", "Fenster", "Reiter", "Vorschau", "Exportieren",
+				"Importieren", "Einstellungen", "Zuletzt", "Bild", "Ebene",
+				"Filter", "Farbe", "Helligkeit", "Kontrast", "Auswählen",
+				"Alles", "Nichts", "Umkehren", "Vergrößern", "Verkleinern",
+				"Größe", "Seite", "Einfügen", "Tabelle", "Zeile", "Spalte",
+				"Übersicht" } },
+		{ "fr", { "Nouveau", "Ouvrir", "Enregistrer", "Fermer", "Imprimer",
+				"Document", "Fenêtre", "Onglet", "Aperçu", "Exporter",
+				"Importer", "Paramètres", "Récents", "Image", "Calque",
+				"Filtre", "Couleur", "Luminosité", "Contraste", "Sélectionner",
+				"Tout", "Aucun", "Inverser", "Agrandir", "Réduire", "Ajuster",
+				"Page", "Insérer", "Tableau", "Ligne", "Colonne", "Élément" } },
+		{ "ru", { "Создать", "Открыть", "Сохранить", "Закрыть", "Печать",
+				"Документ", "Окно", "Вкладка", "Просмотр", "Экспорт", "Импорт",
+				"Параметры", "Недавние", "Изображение", "Слой", "Фильтр",
+				"Цвет", "Яркость", "Контраст", "Выделить", "Всё", "Ничего",
+				"Инвертировать", "Увеличить", "Уменьшить", "Масштаб",
+				"Страница", "Вставить", "Таблица", "Строка", "Столбец",
+				"Ёмкость" } }
+	} );
+	return VOCABULARIES;
+}
+
+std::vector<double> zipfWeights(int size) {
+	std::vector<double> weights;
+	for (int rank(1); rank <= size; ++rank) {
+		weights.push_back(1.0 / rank);
+	}
+	return weights;
+}
+
+}
+
+MenuTreeGenerator::MenuTreeGenerator(const Options &options) :
+		m_options(options), m_vocabulary(
+				vocabularies().value(options.m_locale, vocabularies()["en"])), m_perMenu(
+				1), m_random(options.m_seed), m_wordCount(options.m_minWords,
+				options.m_maxWords) {
+
+	std::vector<double> weights(zipfWeights(m_vocabulary.size()));
+	m_zipf = std::discrete_distribution<int>(weights.begin(), weights.end());
+	m_uniform = std::uniform_int_distribution<int>(0, m_vocabulary.size() - 1);
+
+	// spread the actions evenly over the deepest menus
+	double menus(std::pow(double(qMax(1, m_options.m_breadth)),
+			m_options.m_depth));
+	m_perMenu = qMax(1, int(std::ceil(m_options.m_items / menus)));
+}
+
+MenuTreeGenerator::~MenuTreeGenerator() {
+}
+
+QStringList MenuTreeGenerator::locales() {
+	return vocabularies().keys();
+}
+
+MenuTree::Ptr MenuTreeGenerator::generate() {
+	m_labels.clear();
+
+	MenuTree::Ptr tree(new MenuTree());
+	int remaining(m_options.m_items);
+	build(*tree, MenuTree::ROOT, 0, remaining);
+
+	return tree;
+}
+
+const QStringList & MenuTreeGenerator::labels() const {
+	return m_labels;
+}
+
+void MenuTreeGenerator::build(MenuTree &tree, int parent, int level,
+		int &remaining) {
+	if (level >= m_options.m_depth) {
+		for (int i(0); i < m_perMenu && remaining > 0; ++i, --remaining) {
+			MenuTree::Node node;
+			node.m_label = label();
+			tree.append(parent, node);
+			m_labels << node.m_label;
+		}
+		return;
+	}
+
+	for (int i(0); i < m_options.m_breadth && remaining > 0; ++i) {
+		MenuTree::Node node;
+		node.m_label = word();
+		node.m_flags |= MenuTree::SUBMENU;
+		build(tree, tree.append(parent, node), level + 1, remaining);
+	}
+}
+
+QString MenuTreeGenerator::word() {
+	if (m_options.m_distribution == Distribution::ZIPF) {
+		return m_vocabulary[m_zipf(m_random)];
+	}
+	return m_vocabulary[m_uniform(m_random)];
+}
+
+QString MenuTreeGenerator::label() {
+	QStringList words;
+	for (int count(m_wordCount(m_random)); count > 0; --count) {
+		words << word();
+	}
+	return words.join(" ");
+}
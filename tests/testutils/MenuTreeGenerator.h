@@ -0,0 +1,112 @@
+/*
+ * Copyright (C) 2016 Canonical, Ltd.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Author: Pete Woods <pete.woods@canonical.com>
+ */
+#ifndef HUD_TESTUTILS_MENUTREEGENERATOR_H_
+#define HUD_TESTUTILS_MENUTREEGENERATOR_H_
+
+#include <common/MenuTree.h>
+
+#include <QStringList>
+
+#include <random>
+
+namespace hud {
+namespace testutils {
+
+/**
+ * Builds synthetic menus, for timing how things cope with big ones.
+ *
+ * Actions are spread evenly over the deepest level of a tree of sub menus.
+ * Labels are made of words from one locale's vocabulary, picked either
+ * uniformly or with a Zipf distribution, which is closer to how real menus
+ * repeat words like "New" and "Document". The same options always give the
+ * same menu.
+ */
+class Q_DECL_EXPORT MenuTreeGenerator {
+public:
+	enum class Distribution {
+		UNIFORM, ZIPF
+	};
+
+	struct Options {
+		/* How many actions, leaving out the sub menus */
+		int m_items = 1000;
+
+		/* How many sub menus each menu above the actions has */
+		int m_breadth = 10;
+
+		/* How many levels of sub menus there are above the actions */
+		int m_depth = 2;
+
+		int m_minWords = 1;
+
+		int m_maxWords = 4;
+
+		Distribution m_distribution = Distribution::ZIPF;
+
+		/* One of locales() */
+		QString m_locale = "en";
+
+		unsigned int m_seed = 1;
+	};
+
+	explicit MenuTreeGenerator(const Options &options);
+
+	virtual ~MenuTreeGenerator();
+
+	hud::common::MenuTree::Ptr generate();
+
+	/**
+	 * The labels of the actions in the last generated menu, in order.
+	 */
+	const QStringList & labels() const;
+
+	/**
+	 * A word from the vocabulary, with the same distribution as the labels.
+	 */
+	QString word();
+
+	static QStringList locales();
+
+protected:
+	void build(hud::common::MenuTree &tree, int parent, int level,
+			int &remaining);
+
+	QString label();
+
+	Options m_options;
+
+	QStringList m_vocabulary;
+
+	QStringList m_labels;
+
+	/* How many actions go in each menu on the deepest level */
+	int m_perMenu;
+
+	std::mt19937 m_random;
+
+	std::uniform_int_distribution<int> m_wordCount;
+
+	std::discrete_distribution<int> m_zipf;
+
+	std::uniform_int_distribution<int> m_uniform;
+};
+
+}
+}
+
+#endif /* HUD_TESTUTILS_MENUTREEGENERATOR_H_ */
@@ -79,6 +79,13 @@ void MockHudService::loadMethods() {
 		addMethod(methods, "ExecuteParameterized", "vu", "sssooi",
 				"ret = ('" + m_dbus.sessionConnection().baseService()
 						+ "', 'hud', 'action', '/action/path', '/model/path', 1)");
+		addMethod(methods, "ExecuteParameterizedWithParameters", "vu", "sssooiav",
+				"ret = ('" + m_dbus.sessionConnection().baseService()
+						+ "', 'hud', 'action', '/action/path', '/model/path', 1, "
+						+ "[dbus.Dictionary({'parameter-type': 'slider', "
+						+ "'label': 'Size', 'min': 0.0, 'max': 100.0, "
+						+ "'step': 1.0, 'value': 50.0, 'action': 'hud.size'}, "
+						+ "signature='sv')])");
 		addMethod(methods, "ExecuteToolbar", "su", "", "");
 
 		hud.AddObject(QUERY_PATH, "com.canonical.hud.query", properties,
@@ -102,6 +109,8 @@ void MockHudService::loadMethods() {
 		QVariantMap properties;
 		QList<Method> methods;
 		addMethod(methods, "AddSources", "a(usso)a(uso)", "", "");
+		addMethod(methods, "RemoveSources", "a(us)", "", "");
+		addMethod(methods, "UpdateSources", "a(us)a(usso)a(uso)", "", "");
 		hud.AddObject("/app/object", "com.canonical.hud.Application",
 				properties, methods).waitForFinished();
 	}
@@ -109,6 +118,8 @@ void MockHudService::loadMethods() {
 	/* query */
 	hud.AddMethod(DBusTypes::HUD_SERVICE_DBUS_NAME, "CreateQuery", "s", "ossi",
 			"ret = ('/com/canonical/hud/query0', 'com.canonical.hud.query0.results', 'com.canonical.hud.query0.appstack', dbus.Int32(0))").waitForFinished();
+	hud.AddMethod(DBusTypes::HUD_SERVICE_DBUS_NAME, "CreateReserveQuery", "", "ossi",
+			"ret = ('/com/canonical/hud/query0', 'com.canonical.hud.query0.results', 'com.canonical.hud.query0.appstack', dbus.Int32(0))").waitForFinished();
 
 	/* id */
 	hud.AddMethod(DBusTypes::HUD_SERVICE_DBUS_NAME, "RegisterApplication", "s",
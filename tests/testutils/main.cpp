@@ -18,11 +18,10 @@
 
 #include <common/DBusTypes.h>
 #include <libqtdbusmock/DBusMock.h>
-#include <QApplication>
+#include <QCoreApplication>
 #include <gtest/gtest.h>
 
 int main(int argc, char **argv) {
-	qputenv("QT_QPA_PLATFORM", "minimal");
 	qputenv("HUD_IGNORE_SEARCH_SETTINGS", "1");
 	qputenv("HUD_STORE_USAGE_DATA", "FALSE");
 
@@ -33,7 +32,7 @@ int main(int argc, char **argv) {
 	bindtextdomain(GETTEXT_PACKAGE, GNOMELOCALEDIR);
 	textdomain(GETTEXT_PACKAGE);
 
-	QApplication application(argc, argv);
+	QCoreApplication application(argc, argv);
 	hud::common::DBusTypes::registerMetaTypes();
 	QtDBusMock::DBusMock::registerMetaTypes();
 	::testing::InitGoogleTest(&argc, argv);
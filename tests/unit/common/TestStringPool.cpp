@@ -0,0 +1,149 @@
+/*
+ * Copyright (C) 2016 Canonical, Ltd.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Author: Pete Woods <pete.woods@canonical.com>
+ */
+
+#include <common/StringPool.h>
+
+#include <QThread>
+#include <QVector>
+#include <gtest/gtest.h>
+
+using namespace std;
+using namespace testing;
+using namespace hud::common;
+
+namespace {
+
+/*
+ * A pool of our own, so each test starts empty
+ */
+class TestPool: public StringPool {
+public:
+	TestPool() {
+	}
+};
+
+/*
+ * Interns the same labels as every other importer
+ */
+class Importer: public QThread {
+public:
+	QVector<QString> m_labels;
+
+protected:
+	void run() override {
+		for (int i(0); i < 1000; ++i) {
+			m_labels << StringPool::instance().intern(
+					QString("Thread label %1").arg(i));
+		}
+	}
+};
+
+TEST(TestStringPool, SharesData) {
+	TestPool pool;
+
+	// build the strings separately, so they don't start out shared
+	QString first(QString("Pref") + "erences");
+	QString second(QString("Prefer") + "ences");
+	ASSERT_NE(first.constData(), second.constData());
+
+	QString internedFirst(pool.intern(first));
+	QString internedSecond(pool.intern(second));
+
+	EXPECT_EQ(QString("Preferences"), internedSecond);
+	EXPECT_EQ(internedFirst.constData(), internedSecond.constData());
+	EXPECT_EQ(qint64(11 * sizeof(QChar)),
+			StringPool::savedBytes(second, internedSecond));
+	EXPECT_EQ(0, StringPool::savedBytes(internedFirst, internedSecond));
+
+	EXPECT_EQ(1, pool.size());
+	EXPECT_EQ(qint64(11 * sizeof(QChar)), pool.bytes());
+}
+
+TEST(TestStringPool, PurgesUnusedStrings) {
+	TestPool pool;
+
+	QString kept(pool.intern(QString("Keyboard ") + "Shortcuts"));
+	pool.intern(QString("Close ") + "Window");
+	ASSERT_EQ(2, pool.size());
+
+	// only the pool still holds "Close Window"
+	EXPECT_EQ(1, pool.purge());
+	EXPECT_EQ(1, pool.size());
+	EXPECT_EQ(qint64(kept.size() * sizeof(QChar)), pool.bytes());
+
+	// anything still held stays shared
+	QString again(pool.intern(QString("Keyboard ") + "Shortcuts"));
+	EXPECT_EQ(kept.constData(), again.constData());
+	EXPECT_EQ(0, pool.purge());
+}
+
+TEST(TestStringPool, StableIds) {
+	TestPool pool;
+
+	StringPool::Id id(pool.acquire(QString("com.canonical.") + "Terminal"));
+	EXPECT_EQ(id, pool.acquire(QString("com.canonical") + ".Terminal"));
+	EXPECT_EQ(QString("com.canonical.Terminal"), pool.string(id));
+
+	StringPool::Id found;
+	ASSERT_TRUE(pool.find("com.canonical.Terminal", found));
+	EXPECT_EQ(id, found);
+	EXPECT_FALSE(pool.find("com.canonical.Calculator", found));
+
+	// the ID holds the string, even though no copy of it is left
+	EXPECT_EQ(0, pool.purge());
+	pool.release(id);
+	EXPECT_EQ(0, pool.purge());
+	EXPECT_EQ(QString("com.canonical.Terminal"), pool.string(id));
+
+	// until the last reference goes
+	pool.release(id);
+	EXPECT_EQ(1, pool.purge());
+	EXPECT_FALSE(pool.find("com.canonical.Terminal", found));
+	EXPECT_EQ(QString(), pool.string(id));
+}
+
+TEST(TestStringPool, StaysBounded) {
+	TestPool pool;
+
+	// a menu item whose label keeps changing, like a clock
+	for (int i(0); i < 100000; ++i) {
+		pool.intern(QString("Tick %1").arg(i));
+	}
+
+	EXPECT_LT(pool.size(), 10000);
+}
+
+TEST(TestStringPool, SharedBetweenThreads) {
+	StringPool &pool(StringPool::instance());
+	EXPECT_EQ(&pool, &StringPool::instance());
+
+	// two importers interning the same labels at once
+	Importer first, second;
+	first.start();
+	second.start();
+	first.wait();
+	second.wait();
+
+	ASSERT_EQ(first.m_labels.size(), second.m_labels.size());
+	for (int i(0); i < first.m_labels.size(); ++i) {
+		EXPECT_EQ(first.m_labels[i].constData(),
+				second.m_labels[i].constData());
+	}
+}
+
+} // namespace
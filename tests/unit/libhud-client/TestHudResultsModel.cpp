@@ -0,0 +1,190 @@
+/*
+ * Copyright (C) 2016 Canonical, Ltd.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Author: Pete Woods <pete.woods@canonical.com>
+ */
+
+#include <libhud-client/HudResultsModel.h>
+#include <common/query-columns.h>
+
+#include <dee.h>
+#include <QSignalSpy>
+#include <gtest/gtest.h>
+
+using namespace testing;
+using namespace hud::client;
+
+namespace {
+
+class TestHudResultsModel: public Test {
+protected:
+	TestHudResultsModel() {
+		model = dee_sequence_model_new();
+		dee_model_set_schema_full(model, results_model_schema,
+				G_N_ELEMENTS(results_model_schema));
+	}
+
+	virtual ~TestHudResultsModel() {
+		g_object_unref(model);
+	}
+
+	DeeModelIter * appendResult(const char *command,
+			const char *description, guint64 id = 0) {
+		GVariant *highlights = g_variant_new_array(G_VARIANT_TYPE("(ii)"),
+				NULL, 0);
+		GVariant *columns[] = {
+			g_variant_new_variant(g_variant_new_uint64(id)),
+			g_variant_new_string(command),
+			highlights,
+			g_variant_new_string(description),
+			g_variant_new_array(G_VARIANT_TYPE("(ii)"), NULL, 0),
+			g_variant_new_string(""),
+			g_variant_new_uint32(1),
+			g_variant_new_boolean(FALSE)
+		};
+		return dee_model_append_row(model, columns);
+	}
+
+	static QString command(const QAbstractListModel &results, int row) {
+		return results.data(results.index(row), HUD_QUERY_RESULTS_COMMAND_NAME).toString();
+	}
+
+	DeeModel *model;
+};
+
+TEST_F(TestHudResultsModel, ConvertsExistingRows) {
+	appendResult("Open", "File");
+	appendResult("Close", "File");
+
+	HudResultsModel results;
+	results.setModel(model);
+
+	ASSERT_EQ(2, results.rowCount());
+	EXPECT_EQ(QString("Open"), command(results, 0));
+	EXPECT_EQ(QString("File"),
+			results.data(results.index(1), HUD_QUERY_RESULTS_DESCRIPTION).toString());
+	EXPECT_EQ(1u,
+			results.data(results.index(1), HUD_QUERY_RESULTS_DISTANCE).toUInt());
+	EXPECT_EQ(QByteArray("column_1"),
+			results.roleNames()[HUD_QUERY_RESULTS_COMMAND_NAME]);
+}
+
+TEST_F(TestHudResultsModel, FollowsRowSignals) {
+	HudResultsModel results;
+	results.setModel(model);
+
+	QSignalSpy resetSpy(&results, SIGNAL(modelReset()));
+	QSignalSpy insertedSpy(&results,
+			SIGNAL(rowsInserted(const QModelIndex &, int, int)));
+	QSignalSpy removedSpy(&results,
+			SIGNAL(rowsRemoved(const QModelIndex &, int, int)));
+	QSignalSpy changedSpy(&results,
+			SIGNAL(dataChanged(const QModelIndex &, const QModelIndex &)));
+	QSignalSpy countSpy(&results, SIGNAL(countChanged()));
+
+	appendResult("Open", "File");
+	DeeModelIter *close = appendResult("Close", "File");
+	appendResult("Quit", "File");
+
+	ASSERT_EQ(3, insertedSpy.size());
+	EXPECT_EQ(2, insertedSpy.at(2).at(1).toInt());
+	EXPECT_EQ(3, results.count());
+
+	dee_model_set_value(model, close, HUD_QUERY_RESULTS_COMMAND_NAME,
+			g_variant_new_string("Close All"));
+	ASSERT_EQ(1, changedSpy.size());
+	EXPECT_EQ(QString("Close All"), command(results, 1));
+
+	dee_model_remove(model, close);
+	ASSERT_EQ(1, removedSpy.size());
+	EXPECT_EQ(1, removedSpy.at(0).at(1).toInt());
+	ASSERT_EQ(2, results.rowCount());
+	EXPECT_EQ(QString("Quit"), command(results, 1));
+
+	EXPECT_EQ(4, countSpy.size());
+	EXPECT_TRUE(resetSpy.isEmpty());
+}
+
+TEST_F(TestHudResultsModel, ChangesetsKeepRowsThatStay) {
+	appendResult("Open", "File", 1);
+	appendResult("Close", "File", 2);
+	appendResult("Quit", "File", 3);
+
+	HudResultsModel results;
+	results.setModel(model);
+
+	QSignalSpy insertedSpy(&results,
+			SIGNAL(rowsInserted(const QModelIndex &, int, int)));
+	QSignalSpy removedSpy(&results,
+			SIGNAL(rowsRemoved(const QModelIndex &, int, int)));
+	QSignalSpy movedSpy(&results,
+			SIGNAL(rowsMoved(const QModelIndex &, int, int, const QModelIndex &, int)));
+	QSignalSpy changedSpy(&results,
+			SIGNAL(dataChanged(const QModelIndex &, const QModelIndex &)));
+	QSignalSpy countSpy(&results, SIGNAL(countChanged()));
+
+	// the service replaces every row on each keystroke
+	dee_model_begin_changeset(model);
+	dee_model_clear(model);
+	appendResult("Open", "File", 1);
+	appendResult("Close", "File", 2);
+	appendResult("Quit", "File", 3);
+	dee_model_end_changeset(model);
+
+	EXPECT_TRUE(insertedSpy.isEmpty());
+	EXPECT_TRUE(removedSpy.isEmpty());
+	EXPECT_TRUE(movedSpy.isEmpty());
+	EXPECT_TRUE(changedSpy.isEmpty());
+	EXPECT_TRUE(countSpy.isEmpty());
+	ASSERT_EQ(3, results.rowCount());
+
+	// a keystroke that narrows the results and reorders the rest
+	dee_model_begin_changeset(model);
+	dee_model_clear(model);
+	appendResult("Quit", "File", 3);
+	appendResult("Open", "File menu", 1);
+	dee_model_end_changeset(model);
+
+	ASSERT_EQ(1, removedSpy.size());
+	EXPECT_EQ(1, removedSpy.at(0).at(1).toInt());
+	EXPECT_EQ(1, movedSpy.size());
+	ASSERT_EQ(1, changedSpy.size());
+	EXPECT_EQ(1, changedSpy.at(0).at(0).toModelIndex().row());
+	EXPECT_TRUE(insertedSpy.isEmpty());
+	EXPECT_EQ(1, countSpy.size());
+
+	ASSERT_EQ(2, results.rowCount());
+	EXPECT_EQ(QString("Quit"), command(results, 0));
+	EXPECT_EQ(QString("Open"), command(results, 1));
+	EXPECT_EQ(QString("File menu"),
+			results.data(results.index(1), HUD_QUERY_RESULTS_DESCRIPTION).toString());
+
+	// and one that finds something new
+	dee_model_begin_changeset(model);
+	dee_model_clear(model);
+	appendResult("Quit", "File", 3);
+	appendResult("Save", "File", 4);
+	appendResult("Open", "File menu", 1);
+	dee_model_end_changeset(model);
+
+	ASSERT_EQ(1, insertedSpy.size());
+	EXPECT_EQ(1, insertedSpy.at(0).at(1).toInt());
+	EXPECT_EQ(1, removedSpy.size());
+	EXPECT_EQ(1, changedSpy.size());
+	ASSERT_EQ(3, results.rowCount());
+	EXPECT_EQ(QString("Save"), command(results, 1));
+}
+
+} // namespace
@@ -24,6 +24,7 @@
 
 #include <libqtdbustest/DBusTestRunner.h>
 #include <libqtdbusmock/DBusMock.h>
+#include <QElapsedTimer>
 #include <QSignalSpy>
 #include <QTestEventLoop>
 #include <gtest/gtest.h>
@@ -83,6 +84,22 @@ protected:
 	virtual ~TestQuery() {
 	}
 
+	void waitForFirstRow() {
+		DeeModel *results = hud_client_query_get_results_model(query.data());
+		for (int i = 0; i < 50 && dee_model_get_n_rows(results) == 0; ++i) {
+			QTestEventLoop::instance().enterLoopMSecs(10);
+		}
+		ASSERT_EQ(1u, dee_model_get_n_rows(results));
+	}
+
+	static void waitForPrewarm(HudClientConnection *connection) {
+		for (int i = 0;
+				i < 50 && !hud_client_connection_has_prewarmed_query(connection);
+				++i) {
+			QTestEventLoop::instance().enterLoopMSecs(10);
+		}
+	}
+
 	void EXPECT_CALL(const QList<QVariantList> &spy, int index,
 			const QString &name, const QVariantList &args) {
 		QVariant args2(QVariant::fromValue(args));
@@ -99,6 +116,14 @@ protected:
 		self->modelsReady();
 	}
 
+	static void callbackResultsUpdated(HudClientQuery *query,
+			const gchar *search, gint revision, gpointer user_data) {
+		Q_UNUSED(query);
+		Q_UNUSED(revision);
+		TestQuery *self = static_cast<TestQuery*>(user_data);
+		self->resultsUpdated(QString::fromUtf8(search));
+	}
+
 	static void callbackVoiceQueryFinished(HudClientQuery *query,
 			GDBusMethodInvocation *invocation, gpointer user_data) {
 		Q_UNUSED(query);
@@ -127,6 +152,8 @@ protected:
 Q_SIGNALS:
 	void modelsReady();
 
+	void resultsUpdated(const QString &query);
+
 	void queryFinished();
 
 protected:
@@ -195,6 +222,55 @@ TEST_F(TestQuery, Update) {
 	EXPECT_CALL(remoteQuerySpy, 0, "UpdateQuery", QVariantList() << "test2");
 }
 
+TEST_F(TestQuery, UpdateAsync) {
+	QSignalSpy remoteQuerySpy(&hud.queryInterface(),
+	SIGNAL(MethodCalled(const QString &, const QVariantList &)));
+
+	createQuery();
+
+	g_signal_connect(G_OBJECT(query.data()),
+			HUD_CLIENT_QUERY_SIGNAL_RESULTS_UPDATED,
+			G_CALLBACK(callbackResultsUpdated), this);
+	QSignalSpy resultsSpy(this, SIGNAL(resultsUpdated(const QString &)));
+
+	/* Type faster than the service can answer */
+	hud_client_query_set_query_async(query.data(), "t", NULL);
+	hud_client_query_set_query_async(query.data(), "te", NULL);
+	hud_client_query_set_query_async(query.data(), "tes", NULL);
+	EXPECT_STREQ("tes", hud_client_query_get_query(query.data()));
+
+	while (resultsSpy.size() < 2) {
+		ASSERT_TRUE(resultsSpy.wait());
+	}
+
+	/* Only the first and the latest strings are sent */
+	EXPECT_EQ(QString("t"), resultsSpy.at(0).at(0).toString());
+	EXPECT_EQ(QString("tes"), resultsSpy.at(1).at(0).toString());
+
+	ASSERT_EQ(2, remoteQuerySpy.size());
+	EXPECT_CALL(remoteQuerySpy, 0, "UpdateQuery", QVariantList() << "t");
+	EXPECT_CALL(remoteQuerySpy, 1, "UpdateQuery", QVariantList() << "tes");
+}
+
+TEST_F(TestQuery, UpdateAsyncCancelled) {
+	QSignalSpy remoteQuerySpy(&hud.queryInterface(),
+	SIGNAL(MethodCalled(const QString &, const QVariantList &)));
+
+	createQuery();
+
+	QSharedPointer<GCancellable> cancellable(g_cancellable_new(), &g_object_unref);
+	hud_client_query_set_query_async(query.data(), "t", cancellable.data());
+	hud_client_query_set_query_async(query.data(), "te", cancellable.data());
+	g_cancellable_cancel(cancellable.data());
+
+	/* The coalesced update is dropped with the one in flight */
+	QTestEventLoop::instance().enterLoopMSecs(200);
+	EXPECT_GE(1, remoteQuerySpy.size());
+	for (const QVariantList &call : remoteQuerySpy) {
+		EXPECT_NE(QString("te"), call.at(1).toList().value(0).toString());
+	}
+}
+
 TEST_F(TestQuery, Voice) {
 	QSignalSpy remoteQuerySpy(&hud.queryInterface(),
 	SIGNAL(MethodCalled(const QString &, const QVariantList &)));
@@ -256,9 +332,26 @@ TEST_F(TestQuery, ExecuteParameterized) {
 			g_variant_new_variant(g_variant_new_uint64(4321)), 1234);
 
 	remoteQuerySpy.wait();
-	EXPECT_CALL(remoteQuerySpy, 0, "ExecuteParameterized",
+	EXPECT_CALL(remoteQuerySpy, 0, "ExecuteParameterizedWithParameters",
 			QVariantList() << qulonglong(4321) << uint(1234));
 
+	/* The service sent the pane's attributes along with the reply */
+	ASSERT_TRUE(param != NULL);
+	GVariant *parameters = hud_client_param_get_parameters(param);
+	ASSERT_TRUE(parameters != NULL);
+	ASSERT_EQ(1u, g_variant_n_children(parameters));
+
+	GVariant *slider = g_variant_get_child_value(parameters, 0);
+	GVariant *attributes = g_variant_get_variant(slider);
+	const gchar *label = NULL;
+	double max = 0.0;
+	EXPECT_TRUE(g_variant_lookup(attributes, "label", "&s", &label));
+	EXPECT_STREQ("Size", label);
+	EXPECT_TRUE(g_variant_lookup(attributes, "max", "d", &max));
+	EXPECT_EQ(100.0, max);
+	g_variant_unref(attributes);
+	g_variant_unref(slider);
+
 	g_object_unref(param);
 }
 
@@ -414,6 +507,63 @@ TEST_F(TestQuery, ToolbarEnabled) {
 	EXPECT_TRUE(found_full);
 }
 
+TEST_F(TestQuery, GetRows) {
+	createQuery();
+	waitForFirstRow();
+
+	HudClientResultRow rows[2];
+	ASSERT_EQ(1u, hud_client_query_results_get_rows(query.data(), 0, 2, rows));
+
+	EXPECT_STREQ("result1", rows[0].command_name);
+	EXPECT_STREQ("description1", rows[0].description);
+	EXPECT_STREQ("shortcut", rows[0].shortcut);
+	EXPECT_EQ(1u, rows[0].distance);
+	EXPECT_FALSE(rows[0].parameterized);
+	EXPECT_TRUE(g_variant_is_of_type(rows[0].command_highlights,
+			G_VARIANT_TYPE("a(ii)")));
+
+	/* The same revision hands back the same borrowed values */
+	HudClientResultRow again;
+	ASSERT_EQ(1u, hud_client_query_results_get_rows(query.data(), 0, 1, &again));
+	EXPECT_EQ(rows[0].command_name, again.command_name);
+	EXPECT_EQ(rows[0].command_id, again.command_id);
+
+	EXPECT_EQ(0u, hud_client_query_results_get_rows(query.data(), 1, 1, &again));
+}
+
+TEST_F(TestQuery, TimeToFirstRowWithPrewarm) {
+	HudClientConnection *clientConnection = hud_client_connection_new(
+	DBUS_NAME, DBUS_PATH);
+
+	QElapsedTimer timer;
+	timer.start();
+	createQuery(clientConnection);
+	waitForFirstRow();
+	RecordProperty("ColdFirstRowMs", int(timer.elapsed()));
+	query.reset();
+
+	hud_client_connection_set_prewarm(clientConnection, TRUE);
+	waitForPrewarm(clientConnection);
+	ASSERT_TRUE(hud_client_connection_has_prewarmed_query(clientConnection));
+
+	/* The rows are there without going back to the main loop */
+	timer.restart();
+	query.reset(hud_client_query_new_for_connection("", clientConnection),
+			&g_object_unref);
+	DeeModel *results = hud_client_query_get_results_model(query.data());
+	ASSERT_TRUE(DEE_IS_MODEL(results));
+	EXPECT_EQ(1u, dee_model_get_n_rows(results));
+	RecordProperty("WarmFirstRowMs", int(timer.elapsed()));
+
+	/* Another one gets prepared for next time */
+	EXPECT_FALSE(hud_client_connection_has_prewarmed_query(clientConnection));
+	waitForPrewarm(clientConnection);
+	EXPECT_TRUE(hud_client_connection_has_prewarmed_query(clientConnection));
+
+	query.reset();
+	g_object_unref(clientConnection);
+}
+
 }
 
 #include "TestQuery.moc"
@@ -46,6 +46,33 @@ protected:
 	virtual ~TestActionPublisher() {
 	}
 
+	static HudActionDescription * newDescription(const char *target,
+			const char *label) {
+		HudActionDescription *description = hud_action_description_new(
+				"hud.recent", g_variant_new_string(target));
+		hud_action_description_set_attribute_value(description,
+				G_MENU_ATTRIBUTE_LABEL, g_variant_new_string(label));
+		return description;
+	}
+
+	/* Reads back the labels the publisher exports over the bus */
+	QStringList exportedLabels(GMenuModel *model, int expected) {
+		for (int i = 0; i < 50 && g_menu_model_get_n_items(model) != expected;
+				++i) {
+			QTestEventLoop::instance().enterLoopMSecs(100);
+		}
+
+		QStringList labels;
+		for (int i = 0; i < g_menu_model_get_n_items(model); ++i) {
+			gchar *label = NULL;
+			g_menu_model_get_item_attribute(model, i, G_MENU_ATTRIBUTE_LABEL,
+					"s", &label);
+			labels << QString::fromUtf8(label);
+			g_free(label);
+		}
+		return labels;
+	}
+
 	DBusTestRunner dbus;
 
 	DBusMock mock;
@@ -215,4 +242,57 @@ TEST_F(TestActionPublisher, AddDescription) {
 	}
 }
 
+TEST_F(TestActionPublisher, AddAndReplaceDescriptions) {
+	QSharedPointer<HudActionPublisher> publisher(hud_action_publisher_new(
+			HUD_ACTION_PUBLISHER_ALL_WINDOWS, HUD_ACTION_PUBLISHER_NO_CONTEXT),
+			&g_object_unref);
+	ASSERT_TRUE(publisher.data());
+
+	QSharedPointer<GMenuModel> model(G_MENU_MODEL(g_dbus_menu_model_get(
+			connection.data(), g_dbus_connection_get_unique_name(connection.data()),
+			hud_action_publisher_get_description_path(publisher.data()))),
+			&g_object_unref);
+	EXPECT_EQ(0, g_menu_model_get_n_items(model.data()));
+
+	/* Out of order, and with a duplicate that should win */
+	HudActionDescription *added[] = {
+		newDescription("c", "Charlie"),
+		newDescription("a", "Alpha"),
+		newDescription("b", "Bravo"),
+		newDescription("a", "Alpha 2")
+	};
+	hud_action_publisher_add_descriptions(publisher.data(), added,
+			G_N_ELEMENTS(added));
+
+	EXPECT_EQ(QStringList() << "Alpha 2" << "Bravo" << "Charlie",
+			exportedLabels(model.data(), 3));
+
+	/* Adding leaves other descriptions alone */
+	HudActionDescription *more[] = {
+		newDescription("d", "Delta")
+	};
+	hud_action_publisher_add_descriptions(publisher.data(), more,
+			G_N_ELEMENTS(more));
+
+	EXPECT_EQ(QStringList() << "Alpha 2" << "Bravo" << "Charlie" << "Delta",
+			exportedLabels(model.data(), 4));
+
+	/* Replacing keeps Bravo, drops the rest and adds Echo */
+	HudActionDescription *replaced[] = {
+		newDescription("e", "Echo"),
+		added[2]
+	};
+	hud_action_publisher_replace_descriptions(publisher.data(), "hud.recent",
+			replaced, G_N_ELEMENTS(replaced));
+
+	EXPECT_EQ(QStringList() << "Bravo" << "Echo",
+			exportedLabels(model.data(), 2));
+
+	for (HudActionDescription *description : added) {
+		hud_action_description_unref(description);
+	}
+	hud_action_description_unref(more[0]);
+	hud_action_description_unref(replaced[0]);
+}
+
 }
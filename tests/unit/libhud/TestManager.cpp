@@ -161,9 +161,6 @@ TEST_F(TestManager, AddActions) {
 	g_object_unref(manager);
 }
 
-/**
- * the remove_actions method does nothing at the moment
- */
 TEST_F(TestManager, RemoveActions) {
 	QSignalSpy hudSpy(&hud.hudInterface(),
 	SIGNAL(MethodCalled(const QString &, const QVariantList &)));
@@ -197,9 +194,17 @@ TEST_F(TestManager, RemoveActions) {
 	EXPECT_CALL(applicationSpy, 0, "AddSources", expectedArgs);
 
 	hud_manager_remove_actions(manager, publisher);
+	applicationSpy.wait();
 
-	// FIXME Waiting in tests
-	QTestEventLoop::instance().enterLoopMSecs(100);
+	QVariantList &removeArgs(applicationSpy[1]);
+	RawDBusTransformer::transform(removeArgs);
+
+	QVariantList expectedRemoveArgs;
+	QVariantList source;
+	source << uint(0) << "test-context";
+	expectedRemoveArgs << QVariant::fromValue(source);
+
+	EXPECT_CALL(applicationSpy, 1, "RemoveSources", expectedRemoveArgs);
 
 	g_object_unref(publisher);
 	g_object_unref(manager);
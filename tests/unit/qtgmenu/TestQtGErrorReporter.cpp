@@ -0,0 +1,110 @@
+/*
+ * Copyright (C) 2016 Canonical, Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3, as published
+ * by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranties of
+ * MERCHANTABILITY, SATISFACTORY QUALITY, or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Author: Pete Woods <pete.woods@canonical.com>
+ */
+
+#include <libqtgmenu/internal/QtGErrorReporter.h>
+
+#include <QDBusConnection>
+#include <QElapsedTimer>
+#include <QSignalSpy>
+
+#include <gtest/gtest.h>
+
+using namespace qtgmenu;
+using namespace testing;
+
+namespace
+{
+
+class TestQtGErrorReporter : public Test
+{
+protected:
+  TestQtGErrorReporter()
+  {
+    // the reporter needs a PID to go with each bus name
+    for( int i = 0; i < 4; ++i )
+    {
+      QString name = QString( "com.canonical.hud.test.reporter%1" ).arg( i );
+      QDBusConnection::sessionBus().registerService( name );
+      m_names << name;
+    }
+  }
+
+  virtual ~TestQtGErrorReporter()
+  {
+    for( const QString& name : m_names )
+    {
+      QDBusConnection::sessionBus().unregisterService( name );
+    }
+  }
+
+  QtGErrorReporter::Fields Fields( const QString& bus_name )
+  {
+    return QtGErrorReporter::Fields() << qMakePair( QString( "BusName" ), bus_name );
+  }
+
+  QStringList m_names;
+};
+
+TEST_F( TestQtGErrorReporter, ReportDoesNotWaitForApport )
+{
+  QtGErrorReporter reporter( SLEEPING_RECOVERABLE_PROBLEM, 60000, 4 );
+  QSignalSpy reported_spy( &reporter, SIGNAL( Reported( QString ) ) );
+
+  QElapsedTimer timer;
+  timer.start();
+  EXPECT_TRUE( reporter.Report( m_names[0], Fields( m_names[0] ) ) );
+  EXPECT_TRUE( reporter.Report( m_names[1], Fields( m_names[1] ) ) );
+
+  // the stub takes two seconds over each report
+  EXPECT_LT( timer.elapsed(), 1000 );
+
+  if( reported_spy.isEmpty() )
+  {
+    ASSERT_TRUE( reported_spy.wait( 10000 ) );
+  }
+  EXPECT_EQ( m_names[0], reported_spy.first().first().toString() );
+}
+
+TEST_F( TestQtGErrorReporter, RateLimitedPerBusName )
+{
+  QtGErrorReporter reporter( SLEEPING_RECOVERABLE_PROBLEM, 60000, 4 );
+
+  EXPECT_TRUE( reporter.Report( m_names[0], Fields( m_names[0] ) ) );
+  EXPECT_FALSE( reporter.Report( m_names[0], Fields( m_names[0] ) ) );
+  EXPECT_TRUE( reporter.Report( m_names[1], Fields( m_names[1] ) ) );
+}
+
+TEST_F( TestQtGErrorReporter, QueueIsBounded )
+{
+  QtGErrorReporter reporter( SLEEPING_RECOVERABLE_PROBLEM, 60000, 1 );
+
+  // the first report may already be on its way to the stub, freeing its slot
+  EXPECT_TRUE( reporter.Report( m_names[0], Fields( m_names[0] ) ) );
+  int accepted = 1;
+  for( int i = 1; i < m_names.size(); ++i )
+  {
+    if( reporter.Report( m_names[i], Fields( m_names[i] ) ) )
+    {
+      ++accepted;
+    }
+  }
+
+  EXPECT_LE( accepted, 2 );
+}
+
+} // namespace
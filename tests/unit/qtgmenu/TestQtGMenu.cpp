@@ -18,9 +18,10 @@
 
 #include <libqtgmenu/QtGMenuImporter.h>
 #include <libqtgmenu/internal/QtGMenuUtils.h>
+#include <libqtgmenu/internal/QtGMenuWorker.h>
 #include <common/GDBusHelper.h>
+#include <common/MenuTree.h>
 
-#include <QMenu>
 #include <QSignalSpy>
 
 #include <libqtdbustest/DBusTestRunner.h>
@@ -33,10 +34,32 @@
 using namespace qtgmenu;
 using namespace testing;
 using namespace QtDBusTest;
+using hud::common::MenuTree;
 
 namespace
 {
 
+// the index of the nth child of parent, or -1
+static int Child( MenuTree::Ptr tree, int parent, int n )
+{
+  int child = tree->firstChild( parent );
+  for( int i = 0; i < n && child != -1; ++i )
+  {
+    child = tree->nextSibling( child );
+  }
+  return child;
+}
+
+static int ChildCount( MenuTree::Ptr tree, int parent )
+{
+  int count = 0;
+  for( int i = tree->firstChild( parent ); i != -1; i = tree->nextSibling( i ) )
+  {
+    ++count;
+  }
+  return count;
+}
+
 class TestQtGMenu : public QObject,
                     public Test
 {
@@ -82,38 +105,47 @@ protected:
     }
   }
 
+  // the imported menu and actions belong to the worker thread
   int GetGMenuSize()
   {
-    QSharedPointer<GMenuModel> menu = m_importer.GetGMenuModel();
+    gint item_count = 0;
 
-    if( !menu )
+    QtGMenuWorker::Instance().InvokeSync( [this, &item_count]()
     {
-      return 0;
-    }
+      QSharedPointer<GMenuModel> menu = m_importer.GetGMenuModel();
 
-    gint item_count = g_menu_model_get_n_items( G_MENU_MODEL( menu.data() ) );
+      if( menu )
+      {
+        item_count = g_menu_model_get_n_items( G_MENU_MODEL( menu.data() ) );
+      }
+    } );
 
     return item_count;
   }
 
   int GetGActionCount()
   {
-    QSharedPointer<GActionGroup> actions = m_importer.GetGActionGroup();
+    int action_count = 0;
 
-    if( !actions )
+    QtGMenuWorker::Instance().InvokeSync( [this, &action_count]()
     {
-      return 0;
-    }
+      QSharedPointer<GActionGroup> actions = m_importer.GetGActionGroup();
 
-    gchar** actions_list = g_action_group_list_actions( actions.data() );
+      if( !actions )
+      {
+        return;
+      }
 
-    int action_count = 0;
-    while( actions_list[action_count] != nullptr )
-    {
-      ++action_count;
-    }
+      gchar** actions_list = g_action_group_list_actions( actions.data() );
+
+      while( actions_list[action_count] != nullptr )
+      {
+        ++action_count;
+      }
+
+      g_strfreev( actions_list );
+    } );
 
-    g_strfreev( actions_list );
     return action_count;
   }
 
@@ -125,8 +157,14 @@ protected:
     emit self->ActionActivated( action_name, QtGMenuUtils::GVariantToQVariant( parameter ) );
   }
 
-  void ExportGMenu()
+  void ExportGMenu( bool subscribe = true )
   {
+    // only the top levels are followed unless we ask for the rest
+    if( subscribe )
+    {
+      m_importer.Subscribe();
+    }
+
     // build m_menu
 
     QSharedPointer<GMenu> menus_section(g_menu_new(), &g_object_unref);
@@ -354,7 +392,7 @@ TEST_F( TestQtGMenu, DISABLED_ExportImportGMenu )
   }
   ASSERT_FALSE( m_items_changed_spy.empty() );
 
-  EXPECT_NE( nullptr, m_importer.GetQMenu() );
+  EXPECT_FALSE( m_importer.GetMenuTree().isNull() );
   ASSERT_EQ( 1, GetGMenuSize() );
 
   // add 2 items
@@ -508,77 +546,138 @@ TEST_F( TestQtGMenu, DISABLED_ExportImportGActions )
   EXPECT_EQ( 2, GetGActionCount() );
 }
 
-TEST_F( TestQtGMenu, DISABLED_QMenuStructure )
+TEST_F( TestQtGMenu, DISABLED_LargeMenu )
+{
+  const int item_count = 10000;
+
+  for( int i = 0; i < item_count; ++i )
+  {
+    QByteArray label = QString( "Recent file %1" ).arg( i ).toUtf8();
+    QByteArray action = QString( "app.recent%1" ).arg( i ).toUtf8();
+    g_menu_append( m_menu.data(), label.constData(), action.constData() );
+  }
+
+  m_menu_export_id = g_dbus_connection_export_menu_model( m_connection.data(), c_path,
+      G_MENU_MODEL( m_menu.data() ), NULL );
+  ownBus();
+
+  MenuTree::Ptr menu = m_importer.GetMenuTree();
+  while( ChildCount( menu, MenuTree::ROOT ) < item_count )
+  {
+    ASSERT_TRUE( m_items_changed_spy.wait() );
+    menu = m_importer.GetMenuTree();
+  }
+
+  // nothing past the first hundred items is dropped
+  ASSERT_EQ( item_count, ChildCount( menu, MenuTree::ROOT ) );
+  EXPECT_EQ( "Recent file 0", menu->node( Child( menu, MenuTree::ROOT, 0 ) ).m_label );
+
+  int last = Child( menu, MenuTree::ROOT, item_count - 1 );
+  EXPECT_EQ( "Recent file 9999", menu->node( last ).m_label );
+  EXPECT_EQ( "app.recent9999", menu->node( last ).m_actionName );
+
+  // removing items from the middle keeps the rest in place
+  m_items_changed_spy.clear();
+  g_menu_remove( m_menu.data(), 5000 );
+  ASSERT_TRUE( m_items_changed_spy.wait() );
+
+  menu = m_importer.GetMenuTree();
+  ASSERT_EQ( item_count - 1, ChildCount( menu, MenuTree::ROOT ) );
+  EXPECT_EQ( "Recent file 5001", menu->node( Child( menu, MenuTree::ROOT, 5000 ) ).m_label );
+}
+
+TEST_F( TestQtGMenu, DISABLED_MenuTreeStructure )
 {
   ExportGMenu();
 
-  // import QMenu
+  // import menu tree
 
-  std::shared_ptr< QMenu > menu = m_importer.GetQMenu();
-  ASSERT_NE( nullptr, menu );
+  MenuTree::Ptr menu = m_importer.GetMenuTree();
+  ASSERT_FALSE( menu.isNull() );
 
-  ASSERT_EQ( 2, menu->actions().size() );
+  ASSERT_EQ( 2, ChildCount( menu, MenuTree::ROOT ) );
 
-  EXPECT_EQ( "File", menu->actions().at( 0 )->text() );
-  EXPECT_EQ( "Edit", menu->actions().at( 1 )->text() );
+  int file_menu = Child( menu, MenuTree::ROOT, 0 );
+  int edit_menu = Child( menu, MenuTree::ROOT, 1 );
+
+  EXPECT_EQ( "File", menu->node( file_menu ).m_label );
+  EXPECT_EQ( "Edit", menu->node( edit_menu ).m_label );
 
   // check file menu structure
 
-  QMenu* file_menu = menu->actions().at( 0 )->menu();
-  ASSERT_NE( nullptr, file_menu );
+  ASSERT_TRUE( menu->node( file_menu ).flag( MenuTree::SUBMENU ) );
+  ASSERT_EQ( 4, ChildCount( menu, file_menu ) );
 
-  ASSERT_EQ( 4, file_menu->actions().size() );
+  EXPECT_EQ( "New", menu->node( Child( menu, file_menu, 0 ) ).m_label );
+  EXPECT_EQ( "Ctrl+N", menu->node( Child( menu, file_menu, 0 ) ).m_accel.toStdString() );
 
-  EXPECT_EQ( "File", file_menu->title() );
+  EXPECT_EQ( "Open", menu->node( Child( menu, file_menu, 1 ) ).m_label );
+  EXPECT_TRUE( menu->node( Child( menu, file_menu, 2 ) ).flag( MenuTree::SEPARATOR ) );
+  EXPECT_EQ( "Lock", menu->node( Child( menu, file_menu, 3 ) ).m_label );
 
-  EXPECT_EQ( "New", file_menu->actions().at( 0 )->text() );
-  EXPECT_EQ( "Ctrl+N", file_menu->actions().at( 0 )->shortcut().toString().toStdString() );
+  // check edit menu structure
 
-  EXPECT_EQ( "Open", file_menu->actions().at( 1 )->text() );
-  EXPECT_TRUE( file_menu->actions().at( 2 )->isSeparator() );
-  EXPECT_EQ( "Lock", file_menu->actions().at( 3 )->text() );
+  ASSERT_TRUE( menu->node( edit_menu ).flag( MenuTree::SUBMENU ) );
+  ASSERT_EQ( 1, ChildCount( menu, edit_menu ) );
 
-  // check edit menu structure
+  int style_submenu = Child( menu, edit_menu, 0 );
+  EXPECT_EQ( "Style", menu->node( style_submenu ).m_label );
 
-  QMenu* edit_menu = menu->actions().at( 1 )->menu();
-  ASSERT_NE( nullptr, edit_menu );
+  // check style submenu structure
 
-  ASSERT_EQ( 1, edit_menu->actions().size() );
+  ASSERT_TRUE( menu->node( style_submenu ).flag( MenuTree::SUBMENU ) );
+  ASSERT_EQ( 2, ChildCount( menu, style_submenu ) );
 
-  EXPECT_EQ( "Edit", edit_menu->title() );
+  EXPECT_EQ( "Plain", menu->node( Child( menu, style_submenu, 0 ) ).m_label );
+  EXPECT_EQ( "Bold", menu->node( Child( menu, style_submenu, 1 ) ).m_label );
+}
 
-  EXPECT_EQ( "Style", edit_menu->actions().at( 0 )->text() );
+TEST_F( TestQtGMenu, DISABLED_SubmenusFollowedOnDemand )
+{
+  ExportGMenu( false );
 
-  // check style submenu structure
+  MenuTree::Ptr menu = m_importer.GetMenuTree();
+  ASSERT_FALSE( menu.isNull() );
 
-  QMenu* style_submenu = edit_menu->actions().at( 0 )->menu();
-  ASSERT_NE( nullptr, style_submenu );
+  // the menu bar's menus are there, but nothing below them
+  int edit_menu = Child( menu, MenuTree::ROOT, 1 );
+  ASSERT_EQ( "Edit", menu->node( edit_menu ).m_label );
 
-  ASSERT_EQ( 2, style_submenu->actions().size() );
+  int style_submenu = Child( menu, edit_menu, 0 );
+  ASSERT_EQ( "Style", menu->node( style_submenu ).m_label );
+  EXPECT_EQ( 0, ChildCount( menu, style_submenu ) );
 
-  EXPECT_EQ( "Style", style_submenu->title() );
+  // subscribing fetches the deeper levels
+  m_items_changed_spy.clear();
+  m_importer.Subscribe();
 
-  EXPECT_EQ( "Plain", style_submenu->actions().at( 0 )->text() );
-  EXPECT_EQ( "Bold", style_submenu->actions().at( 1 )->text() );
+  while( ChildCount( menu, style_submenu ) == 0 )
+  {
+    ASSERT_TRUE( m_items_changed_spy.wait() );
+    menu = m_importer.GetMenuTree();
+    style_submenu = Child( menu, Child( menu, MenuTree::ROOT, 1 ), 0 );
+  }
+
+  EXPECT_EQ( 2, ChildCount( menu, style_submenu ) );
+  EXPECT_EQ( "Plain", menu->node( Child( menu, style_submenu, 0 ) ).m_label );
 }
 
-TEST_F( TestQtGMenu, DISABLED_QMenuActionTriggers )
+TEST_F( TestQtGMenu, DISABLED_MenuTreeActionTriggers )
 {
   ExportGMenu();
 
-  // import QMenu
+  // import menu tree
 
-  std::shared_ptr< QMenu > menu = m_importer.GetQMenu();
-  EXPECT_NE( nullptr, m_importer.GetQMenu() );
+  MenuTree::Ptr menu = m_importer.GetMenuTree();
+  ASSERT_FALSE( menu.isNull() );
 
   // trigger file menu items
 
-  ASSERT_FALSE(menu->actions().empty());
-  QMenu* file_menu = menu->actions().at( 0 )->menu();
-  ASSERT_NE( nullptr, file_menu );
+  int file_menu = Child( menu, MenuTree::ROOT, 0 );
+  ASSERT_NE( -1, file_menu );
 
   m_action_activated_spy.clear();
-  file_menu->actions().at( 0 )->trigger();
+  menu->activate( Child( menu, file_menu, 0 ) );
 
   if (m_action_activated_spy.isEmpty())
   {
@@ -589,7 +688,7 @@ TEST_F( TestQtGMenu, DISABLED_QMenuActionTriggers )
   EXPECT_EQ( "", m_action_activated_spy.at( 0 ).at( 1 ).toString().toStdString() );
 
   m_action_activated_spy.clear();
-  file_menu->actions().at( 1 )->trigger();
+  menu->activate( Child( menu, file_menu, 1 ) );
 
   if (m_action_activated_spy.isEmpty())
   {
@@ -600,7 +699,7 @@ TEST_F( TestQtGMenu, DISABLED_QMenuActionTriggers )
   EXPECT_EQ( "", m_action_activated_spy.at( 0 ).at( 1 ).toString().toStdString() );
 
   m_action_activated_spy.clear();
-  file_menu->actions().at( 3 )->trigger();
+  menu->activate( Child( menu, file_menu, 3 ) );
 
   if (m_action_activated_spy.isEmpty())
   {
@@ -612,13 +711,13 @@ TEST_F( TestQtGMenu, DISABLED_QMenuActionTriggers )
 
   // trigger edit menu items
 
-  QMenu* edit_menu = menu->actions().at( 1 )->menu();
-  ASSERT_NE( nullptr, edit_menu );
-  QMenu* style_submenu = edit_menu->actions().at( 0 )->menu();
-  ASSERT_NE( nullptr, style_submenu );
+  int edit_menu = Child( menu, MenuTree::ROOT, 1 );
+  ASSERT_NE( -1, edit_menu );
+  int style_submenu = Child( menu, edit_menu, 0 );
+  ASSERT_NE( -1, style_submenu );
 
   m_action_activated_spy.clear();
-  style_submenu->actions().at( 0 )->trigger();
+  menu->activate( Child( menu, style_submenu, 0 ) );
 
   if (m_action_activated_spy.isEmpty())
   {
@@ -629,7 +728,7 @@ TEST_F( TestQtGMenu, DISABLED_QMenuActionTriggers )
   EXPECT_EQ( "text_plain", m_action_activated_spy.at( 0 ).at( 1 ).toString().toStdString() );
 
   m_action_activated_spy.clear();
-  style_submenu->actions().at( 1 )->trigger();
+  menu->activate( Child( menu, style_submenu, 1 ) );
 
   if (m_action_activated_spy.isEmpty())
   {
@@ -640,39 +739,54 @@ TEST_F( TestQtGMenu, DISABLED_QMenuActionTriggers )
   EXPECT_EQ( "text_bold", m_action_activated_spy.at( 0 ).at( 1 ).toString().toStdString() );
 }
 
-TEST_F( TestQtGMenu, DISABLED_QMenuActionStates )
+TEST_F( TestQtGMenu, DISABLED_MenuTreeActionStates )
 {
   ExportGMenu();
 
-  // import QMenu
+  // each tree is a snapshot, so take a new one after every change
 
-  std::shared_ptr< QMenu > menu = m_importer.GetQMenu();
-  EXPECT_NE( nullptr, m_importer.GetQMenu() );
+  MenuTree::Ptr menu = m_importer.GetMenuTree();
+  ASSERT_FALSE( menu.isNull() );
 
   // enable / disable menu items
 
-  QMenu* file_menu = menu->actions().at( 0 )->menu();
-  ASSERT_NE( nullptr, file_menu );
+  int file_menu = Child( menu, MenuTree::ROOT, 0 );
+  ASSERT_NE( -1, file_menu );
 
-  EXPECT_TRUE( file_menu->actions().at( 0 )->isEnabled() );
+  EXPECT_TRUE( menu->node( Child( menu, file_menu, 0 ) ).flag( MenuTree::ENABLED ) );
 
   m_action_enabled_spy.clear();
+  m_items_changed_spy.clear();
   g_simple_action_set_enabled( m_exported_actions[0].first.data(), false );
   if (m_action_enabled_spy.isEmpty())
   {
     ASSERT_TRUE(m_action_enabled_spy.wait());
   }
 
-  EXPECT_FALSE( file_menu->actions().at( 0 )->isEnabled() );
+  // the new state reaches us in the next snapshot
+  if (m_items_changed_spy.isEmpty())
+  {
+    ASSERT_TRUE(m_items_changed_spy.wait());
+  }
+
+  menu = m_importer.GetMenuTree();
+  EXPECT_FALSE( menu->node( Child( menu, file_menu, 0 ) ).flag( MenuTree::ENABLED ) );
 
   m_action_enabled_spy.clear();
+  m_items_changed_spy.clear();
   g_simple_action_set_enabled( m_exported_actions[0].first.data(), true );
   if (m_action_enabled_spy.isEmpty())
   {
     ASSERT_TRUE(m_action_enabled_spy.wait());
   }
 
-  EXPECT_TRUE( file_menu->actions().at( 0 )->isEnabled() );
+  if (m_items_changed_spy.isEmpty())
+  {
+    ASSERT_TRUE(m_items_changed_spy.wait());
+  }
+
+  menu = m_importer.GetMenuTree();
+  EXPECT_TRUE( menu->node( Child( menu, file_menu, 0 ) ).flag( MenuTree::ENABLED ) );
 }
 
 } // namespace
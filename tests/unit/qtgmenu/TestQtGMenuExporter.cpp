@@ -0,0 +1,212 @@
+/*
+ * Copyright (C) 2016 Canonical, Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3, as published
+ * by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranties of
+ * MERCHANTABILITY, SATISFACTORY QUALITY, or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Author: Pete Woods <pete.woods@canonical.com>
+ */
+
+#include <libqtgmenu/QtGMenuExporter.h>
+#include <libqtgmenu/QtGMenuImporter.h>
+#include <libqtgmenu/internal/QtGMenuExportModel.h>
+#include <common/GDBusHelper.h>
+#include <common/MenuTree.h>
+
+#include <QMenu>
+#include <QSignalSpy>
+
+#include <libqtdbustest/DBusTestRunner.h>
+
+#include <gtest/gtest.h>
+
+#undef signals
+#include <gio/gio.h>
+
+using namespace qtgmenu;
+using namespace testing;
+using namespace QtDBusTest;
+using hud::common::MenuTree;
+
+namespace
+{
+
+static QtGMenuExportItem Item( const char* label )
+{
+  QtGMenuExportItem item;
+  item.SetAttribute( G_MENU_ATTRIBUTE_LABEL, g_variant_new_string( label ) );
+  return item;
+}
+
+static std::vector< QtGMenuExportItem > Items( std::initializer_list< const char* > labels )
+{
+  std::vector< QtGMenuExportItem > items;
+  for( const char* label : labels )
+  {
+    items.push_back( Item( label ) );
+  }
+  return items;
+}
+
+struct ItemsChanged
+{
+  int m_position;
+  int m_removed;
+  int m_added;
+};
+
+static void ItemsChangedCallback( GMenuModel*, gint position, gint removed, gint added,
+    gpointer user_data )
+{
+  reinterpret_cast< std::vector< ItemsChanged >* >( user_data )->push_back(
+      ItemsChanged{ position, removed, added } );
+}
+
+TEST( TestQtGMenuExportModel, SignalsOnlyTheChangedRange )
+{
+  QSharedPointer< GMenuModel > model( QtGMenuExportModel::New(), &g_object_unref );
+
+  std::vector< ItemsChanged > changes;
+  g_signal_connect( model.data(), "items-changed", G_CALLBACK( ItemsChangedCallback ), &changes );
+
+  QtGMenuExportModel::SetItems( model.data(), Items( { "New", "Open", "Save", "Quit" } ) );
+  ASSERT_EQ( 1u, changes.size() );
+  EXPECT_EQ( 0, changes[0].m_position );
+  EXPECT_EQ( 0, changes[0].m_removed );
+  EXPECT_EQ( 4, changes[0].m_added );
+  EXPECT_EQ( 4, g_menu_model_get_n_items( model.data() ) );
+
+  // a relabelled item
+  changes.clear();
+  QtGMenuExportModel::SetItems( model.data(), Items( { "New", "Open...", "Save", "Quit" } ) );
+  ASSERT_EQ( 1u, changes.size() );
+  EXPECT_EQ( 1, changes[0].m_position );
+  EXPECT_EQ( 1, changes[0].m_removed );
+  EXPECT_EQ( 1, changes[0].m_added );
+
+  // an item removed and another inserted further on
+  changes.clear();
+  QtGMenuExportModel::SetItems( model.data(), Items( { "New", "Save", "Save As", "Quit" } ) );
+  ASSERT_EQ( 1u, changes.size() );
+  EXPECT_EQ( 1, changes[0].m_position );
+  EXPECT_EQ( 2, changes[0].m_removed );
+  EXPECT_EQ( 2, changes[0].m_added );
+
+  // nothing to say when nothing changed
+  changes.clear();
+  QtGMenuExportModel::SetItems( model.data(), Items( { "New", "Save", "Save As", "Quit" } ) );
+  EXPECT_TRUE( changes.empty() );
+
+  gchar* label = NULL;
+  ASSERT_TRUE( g_menu_model_get_item_attribute( model.data(), 2, G_MENU_ATTRIBUTE_LABEL, "s", &label ) );
+  EXPECT_STREQ( "Save As", label );
+  g_free( label );
+}
+
+class TestQtGMenuExporter : public Test
+{
+protected:
+  TestQtGMenuExporter()
+      : m_connection( newSessionBusConnection( nullptr ), &g_object_unref )
+  {
+    dbus.startServices();
+  }
+
+  void TearDown() override
+  {
+    if( m_owner_id > 0 )
+    {
+      g_bus_unown_name( m_owner_id );
+    }
+  }
+
+  // the importer follows the name, so take it once the menu is there to be read
+  void OwnBus()
+  {
+    m_owner_id = g_bus_own_name_on_connection( m_connection.data(), c_service,
+        G_BUS_NAME_OWNER_FLAGS_NONE, NULL, NULL, NULL, NULL );
+  }
+
+  constexpr static const char* c_service = "com.canonical.qtgmenu";
+  constexpr static const char* c_path = "/com/canonical/qtgmenu";
+
+  DBusTestRunner dbus;
+
+  QSharedPointer< GDBusConnection > m_connection;
+
+  guint m_owner_id = 0;
+};
+
+TEST_F( TestQtGMenuExporter, RoundTrip )
+{
+  QMenu menu;
+  QMenu* file_menu = menu.addMenu( "&File" );
+  QAction* open = file_menu->addAction( "&Open" );
+  file_menu->addSeparator();
+  QAction* quit = file_menu->addAction( "&Quit" );
+  quit->setShortcut( QKeySequence( "Ctrl+Q" ) );
+
+  QtGMenuExporter exporter( c_path, &menu, m_connection );
+
+  QtGMenuImporter importer( c_service, QDBusObjectPath( c_path ), "app", QDBusObjectPath( c_path ),
+      dbus.sessionConnection(), m_connection );
+  importer.Subscribe();
+
+  QSignalSpy items_changed_spy( &importer, SIGNAL( MenuItemsChanged() ) );
+  OwnBus();
+
+  MenuTree::Ptr tree;
+  int file = -1;
+
+  // the top level may arrive before the file menu's items
+  while( file == -1 || tree->firstChild( file ) == -1 )
+  {
+    ASSERT_TRUE( items_changed_spy.wait() );
+    tree = importer.GetMenuTree();
+    file = tree->firstChild( MenuTree::ROOT );
+  }
+
+  EXPECT_EQ( QString( "&File" ), tree->node( file ).m_label );
+
+  int open_item = tree->firstChild( file );
+  EXPECT_EQ( QString( "&Open" ), tree->node( open_item ).m_label );
+
+  int separator = tree->nextSibling( open_item );
+  ASSERT_NE( -1, separator );
+  EXPECT_TRUE( tree->node( separator ).flag( MenuTree::SEPARATOR ) );
+
+  int quit_item = tree->nextSibling( separator );
+  ASSERT_NE( -1, quit_item );
+  EXPECT_EQ( QString( "&Quit" ), tree->node( quit_item ).m_label );
+  EXPECT_EQ( QString( "Ctrl+Q" ), tree->node( quit_item ).m_accel );
+
+  // activating the imported item triggers the QAction
+  QSignalSpy triggered_spy( open, SIGNAL( triggered( bool ) ) );
+  tree->activate( open_item );
+  ASSERT_TRUE( triggered_spy.wait() );
+
+  // changes are followed
+  items_changed_spy.clear();
+  open->setText( "&Open..." );
+  open->setEnabled( false );
+
+  while( tree->node( tree->firstChild( file ) ).m_label != "&Open..."
+      || tree->node( tree->firstChild( file ) ).flag( MenuTree::ENABLED ) )
+  {
+    ASSERT_TRUE( items_changed_spy.wait() );
+    tree = importer.GetMenuTree();
+    file = tree->firstChild( MenuTree::ROOT );
+    ASSERT_NE( -1, file );
+  }
+}
+
+} // namespace
@@ -0,0 +1,364 @@
+/*
+ * Copyright (C) 2016 Canonical, Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3, as published
+ * by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranties of
+ * MERCHANTABILITY, SATISFACTORY QUALITY, or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Author: Pete Woods <pete.woods@canonical.com>
+ */
+
+#include <libqtgmenu/internal/QtGMenuModel.h>
+#include <common/MenuTree.h>
+
+#include <QSignalSpy>
+
+#include <gtest/gtest.h>
+
+#undef signals
+#include <gio/gio.h>
+
+using namespace qtgmenu;
+using namespace testing;
+using hud::common::MenuTree;
+
+namespace
+{
+
+// the index of the nth child of parent, or -1
+static int Child( MenuTree::Ptr tree, int parent, int n )
+{
+  int child = tree->firstChild( parent );
+  for( int i = 0; i < n && child != -1; ++i )
+  {
+    child = tree->nextSibling( child );
+  }
+  return child;
+}
+
+static int ChildCount( MenuTree::Ptr tree, int parent )
+{
+  int count = 0;
+  for( int i = tree->firstChild( parent ); i != -1; i = tree->nextSibling( i ) )
+  {
+    ++count;
+  }
+  return count;
+}
+
+// the labels under parent, without the separators
+static QStringList Labels( MenuTree::Ptr tree, int parent )
+{
+  QStringList labels;
+  for( int i = tree->firstChild( parent ); i != -1; i = tree->nextSibling( i ) )
+  {
+    if( !tree->node( i ).flag( MenuTree::SEPARATOR ) )
+    {
+      labels << tree->node( i ).m_label;
+    }
+  }
+  return labels;
+}
+
+// follows a GMenu of our own, so no bus is needed and every change arrives straight away
+class TestQtGMenuModel : public Test
+{
+protected:
+  TestQtGMenuModel()
+      : m_menu( g_menu_new(), &g_object_unref )
+  {
+  }
+
+  void Follow()
+  {
+    m_model.reset( new QtGMenuModel(
+        QSharedPointer<GMenuModel>( G_MENU_MODEL( g_object_ref( m_menu.data() ) ), &g_object_unref ) ) );
+  }
+
+  // runs the idle source the model queues its signals on
+  void Flush()
+  {
+    while( g_main_context_iteration( nullptr, FALSE ) )
+    {
+    }
+  }
+
+  MenuTree::Ptr Tree()
+  {
+    return m_model->GetMenuTree();
+  }
+
+  QSharedPointer<GMenu> m_menu;
+
+  QSharedPointer<QtGMenuModel> m_model;
+};
+
+TEST_F( TestQtGMenuModel, RemovedActionsDisableTheirItems )
+{
+  g_menu_append( m_menu.data(), "Open", "app.open" );
+  g_menu_append( m_menu.data(), "Save", "app.save" );
+  Follow();
+  Flush();
+
+  m_model->ActionEnabled( "app.open", true );
+  m_model->ActionEnabled( "app.save", true );
+
+  MenuTree::Ptr menu = Tree();
+  ASSERT_EQ( 2, ChildCount( menu, MenuTree::ROOT ) );
+  EXPECT_TRUE( menu->node( Child( menu, MenuTree::ROOT, 0 ) ).flag( MenuTree::ENABLED ) );
+  EXPECT_TRUE( menu->node( Child( menu, MenuTree::ROOT, 1 ) ).flag( MenuTree::ENABLED ) );
+
+  // remove
+  m_model->ActionDropped( "app.open" );
+
+  menu = Tree();
+  EXPECT_FALSE( menu->node( Child( menu, MenuTree::ROOT, 0 ) ).flag( MenuTree::ENABLED ) );
+  EXPECT_TRUE( menu->node( Child( menu, MenuTree::ROOT, 1 ) ).flag( MenuTree::ENABLED ) );
+
+  // new items don't take on the state of an action that has gone
+  QSignalSpy states_needed_spy( m_model.data(), SIGNAL( ActionStatesNeeded( QStringList ) ) );
+  g_menu_append( m_menu.data(), "Open Recent", "app.open" );
+  Flush();
+
+  ASSERT_EQ( 1, states_needed_spy.size() );
+  EXPECT_EQ( QStringList() << "app.open", states_needed_spy.at( 0 ).at( 0 ).toStringList() );
+
+  // re-add, the action group reports the state of an action as it's added
+  m_model->ActionEnabled( "app.open", true );
+
+  menu = Tree();
+  ASSERT_EQ( 3, ChildCount( menu, MenuTree::ROOT ) );
+  EXPECT_TRUE( menu->node( Child( menu, MenuTree::ROOT, 0 ) ).flag( MenuTree::ENABLED ) );
+  EXPECT_TRUE( menu->node( Child( menu, MenuTree::ROOT, 2 ) ).flag( MenuTree::ENABLED ) );
+}
+
+TEST_F( TestQtGMenuModel, SectionChangesMoveTheFlattenedItems )
+{
+  QSharedPointer<GMenu> first( g_menu_new(), &g_object_unref );
+  g_menu_append( first.data(), "B", "app.b" );
+  g_menu_append( first.data(), "C", "app.c" );
+
+  QSharedPointer<GMenu> nested( g_menu_new(), &g_object_unref );
+  g_menu_append( nested.data(), "E", "app.e" );
+
+  QSharedPointer<GMenu> second( g_menu_new(), &g_object_unref );
+  g_menu_append_section( second.data(), NULL, G_MENU_MODEL( nested.data() ) );
+  g_menu_append( second.data(), "F", "app.f" );
+
+  g_menu_append( m_menu.data(), "A", "app.a" );
+  g_menu_append_section( m_menu.data(), NULL, G_MENU_MODEL( first.data() ) );
+  g_menu_append( m_menu.data(), "D", "app.d" );
+  g_menu_append_section( m_menu.data(), NULL, G_MENU_MODEL( second.data() ) );
+  g_menu_append( m_menu.data(), "G", "app.g" );
+  Follow();
+  Flush();
+
+  EXPECT_EQ( QStringList() << "A" << "B" << "C" << "D" << "E" << "F" << "G",
+      Labels( Tree(), MenuTree::ROOT ) );
+
+  // grow a section at the end
+  g_menu_append( second.data(), "F2", "app.f2" );
+  EXPECT_EQ( QStringList() << "A" << "B" << "C" << "D" << "E" << "F" << "F2" << "G",
+      Labels( Tree(), MenuTree::ROOT ) );
+
+  // shrink the first section, moving everything after it
+  g_menu_remove( first.data(), 0 );
+  EXPECT_EQ( QStringList() << "A" << "C" << "D" << "E" << "F" << "F2" << "G",
+      Labels( Tree(), MenuTree::ROOT ) );
+
+  // a section two levels down
+  g_menu_insert( nested.data(), 0, "E0", "app.e0" );
+  EXPECT_EQ( QStringList() << "A" << "C" << "D" << "E0" << "E" << "F" << "F2" << "G",
+      Labels( Tree(), MenuTree::ROOT ) );
+
+  // the sections move along in the root, then change again
+  g_menu_remove( m_menu.data(), 0 );
+  g_menu_insert( m_menu.data(), 0, "Z", "app.z" );
+  g_menu_insert( m_menu.data(), 0, "Y", "app.y" );
+  g_menu_append( first.data(), "C2", "app.c2" );
+  g_menu_remove( nested.data(), 1 );
+  EXPECT_EQ( QStringList() << "Y" << "Z" << "C" << "C2" << "D" << "E0" << "F" << "F2" << "G",
+      Labels( Tree(), MenuTree::ROOT ) );
+
+  // a new section ahead of the others
+  QSharedPointer<GMenu> third( g_menu_new(), &g_object_unref );
+  g_menu_append( third.data(), "X", "app.x" );
+  g_menu_prepend_section( m_menu.data(), NULL, G_MENU_MODEL( third.data() ) );
+  g_menu_append( third.data(), "X2", "app.x2" );
+  g_menu_remove_all( second.data() );
+  EXPECT_EQ( QStringList() << "X" << "X2" << "Y" << "Z" << "C" << "C2" << "D" << "G",
+      Labels( Tree(), MenuTree::ROOT ) );
+
+  // a section replaced by a plain item in a single change, the way a D-Bus menu reports it
+  guint items_changed = g_signal_lookup( "items-changed", G_TYPE_MENU_MODEL );
+  g_signal_handlers_block_matched( m_menu.data(), G_SIGNAL_MATCH_ID, items_changed, 0, NULL, NULL, NULL );
+  g_menu_remove( m_menu.data(), 3 );
+  g_menu_insert( m_menu.data(), 3, "W", "app.w" );
+  g_signal_handlers_unblock_matched( m_menu.data(), G_SIGNAL_MATCH_ID, items_changed, 0, NULL, NULL, NULL );
+  g_menu_model_items_changed( G_MENU_MODEL( m_menu.data() ), 3, 1, 1 );
+  EXPECT_EQ( QStringList() << "X" << "X2" << "Y" << "Z" << "W" << "D" << "G",
+      Labels( Tree(), MenuTree::ROOT ) );
+
+  // and the sections after it are still found where they are
+  g_menu_append( third.data(), "X3", "app.x3" );
+  g_menu_append( second.data(), "F", "app.f" );
+  EXPECT_EQ( QStringList() << "X" << "X2" << "X3" << "Y" << "Z" << "W" << "D" << "F" << "G",
+      Labels( Tree(), MenuTree::ROOT ) );
+}
+
+TEST_F( TestQtGMenuModel, SubmenusFollowedOnDemand )
+{
+  QSharedPointer<GMenu> style( g_menu_new(), &g_object_unref );
+  g_menu_append( style.data(), "Plain", "app.text_plain" );
+  g_menu_append( style.data(), "Bold", "app.text_bold" );
+
+  QSharedPointer<GMenu> edit( g_menu_new(), &g_object_unref );
+  g_menu_append_submenu( edit.data(), "Style", G_MENU_MODEL( style.data() ) );
+
+  g_menu_append_submenu( m_menu.data(), "Edit", G_MENU_MODEL( edit.data() ) );
+  Follow();
+  Flush();
+
+  // the menu bar's menus are there, but nothing below them
+  MenuTree::Ptr menu = Tree();
+  int edit_menu = Child( menu, MenuTree::ROOT, 0 );
+  ASSERT_EQ( "Edit", menu->node( edit_menu ).m_label );
+
+  int style_submenu = Child( menu, edit_menu, 0 );
+  ASSERT_EQ( "Style", menu->node( style_submenu ).m_label );
+  EXPECT_EQ( 0, ChildCount( menu, style_submenu ) );
+
+  // subscribing fetches the deeper levels, and follows them from then on
+  m_model->SubscribeAll();
+  g_menu_append( style.data(), "Italic", "app.text_italic" );
+
+  menu = Tree();
+  style_submenu = Child( menu, Child( menu, MenuTree::ROOT, 0 ), 0 );
+  ASSERT_EQ( 3, ChildCount( menu, style_submenu ) );
+  EXPECT_EQ( "Plain", menu->node( Child( menu, style_submenu, 0 ) ).m_label );
+  EXPECT_EQ( "Italic", menu->node( Child( menu, style_submenu, 2 ) ).m_label );
+
+  // unsubscribing lets go of them again
+  m_model->UnsubscribeAll();
+
+  menu = Tree();
+  style_submenu = Child( menu, Child( menu, MenuTree::ROOT, 0 ), 0 );
+  ASSERT_EQ( "Style", menu->node( style_submenu ).m_label );
+  EXPECT_EQ( 0, ChildCount( menu, style_submenu ) );
+
+  // the sub menu is found again after it has moved within its parent
+  g_menu_prepend( edit.data(), "Undo", "app.undo" );
+  m_model->SubscribeAll();
+
+  menu = Tree();
+  edit_menu = Child( menu, MenuTree::ROOT, 0 );
+  ASSERT_EQ( 2, ChildCount( menu, edit_menu ) );
+  EXPECT_EQ( "Undo", menu->node( Child( menu, edit_menu, 0 ) ).m_label );
+
+  style_submenu = Child( menu, edit_menu, 1 );
+  EXPECT_EQ( "Style", menu->node( style_submenu ).m_label );
+  EXPECT_EQ( 3, ChildCount( menu, style_submenu ) );
+}
+
+TEST_F( TestQtGMenuModel, ItemsPastTheFirstPageStayUnread )
+{
+  for( int i = 0; i < 200; ++i )
+  {
+    QByteArray label = QString( "Item %1" ).arg( i ).toUtf8();
+    QByteArray action = QString( "app.item%1" ).arg( i ).toUtf8();
+    g_menu_append( m_menu.data(), label.constData(), action.constData() );
+  }
+
+  QSharedPointer<GMenu> section( g_menu_new(), &g_object_unref );
+  g_menu_append( section.data(), "Sectioned", "app.sectioned" );
+  g_menu_insert_section( m_menu.data(), 150, NULL, G_MENU_MODEL( section.data() ) );
+
+  Follow();
+  QSignalSpy states_needed_spy( m_model.data(), SIGNAL( ActionStatesNeeded( QStringList ) ) );
+  Flush();
+
+  // only the first page has been read, so only its actions are asked about
+  ASSERT_EQ( 1, states_needed_spy.size() );
+  QStringList read = states_needed_spy.at( 0 ).at( 0 ).toStringList();
+  EXPECT_EQ( 100, read.size() );
+  EXPECT_TRUE( read.contains( "app.item99" ) );
+  EXPECT_FALSE( read.contains( "app.item100" ) );
+  EXPECT_FALSE( read.contains( "app.sectioned" ) );
+
+  // changes past the first page don't read anything either
+  g_menu_remove( m_menu.data(), 120 );
+  g_menu_insert( m_menu.data(), 120, "Replaced", "app.replaced" );
+  Flush();
+  EXPECT_EQ( 1, states_needed_spy.size() );
+
+  // until the menu is indexed, when the rest is read, the section included
+  MenuTree::Ptr menu = Tree();
+  Flush();
+  ASSERT_EQ( 2, states_needed_spy.size() );
+  read = states_needed_spy.at( 1 ).at( 0 ).toStringList();
+  EXPECT_EQ( 101, read.size() );
+  EXPECT_TRUE( read.contains( "app.replaced" ) );
+  EXPECT_TRUE( read.contains( "app.sectioned" ) );
+  EXPECT_FALSE( read.contains( "app.item120" ) );
+
+  // and the section read late still lands in its place
+  QStringList labels = Labels( menu, MenuTree::ROOT );
+  ASSERT_EQ( 201, labels.size() );
+  EXPECT_EQ( "Replaced", labels[120] );
+  EXPECT_EQ( "Item 149", labels[149] );
+  EXPECT_EQ( "Sectioned", labels[150] );
+  EXPECT_EQ( "Item 150", labels[151] );
+}
+
+TEST_F( TestQtGMenuModel, LargeMenu )
+{
+  const int item_count = 10000;
+
+  for( int i = 0; i < item_count; ++i )
+  {
+    QByteArray label = QString( "Recent file %1" ).arg( i ).toUtf8();
+    QByteArray action = QString( "app.recent%1" ).arg( i ).toUtf8();
+    g_menu_append( m_menu.data(), label.constData(), action.constData() );
+  }
+  Follow();
+  Flush();
+
+  // nothing past the first page is dropped
+  MenuTree::Ptr menu = Tree();
+  ASSERT_EQ( item_count, ChildCount( menu, MenuTree::ROOT ) );
+  EXPECT_EQ( "Recent file 0", menu->node( Child( menu, MenuTree::ROOT, 0 ) ).m_label );
+
+  int last = Child( menu, MenuTree::ROOT, item_count - 1 );
+  EXPECT_EQ( "Recent file 9999", menu->node( last ).m_label );
+  EXPECT_EQ( "app.recent9999", menu->node( last ).m_actionName );
+
+  // removing items from the middle keeps the rest in place
+  g_menu_remove( m_menu.data(), 5000 );
+
+  menu = Tree();
+  ASSERT_EQ( item_count - 1, ChildCount( menu, MenuTree::ROOT ) );
+  EXPECT_EQ( "Recent file 5001", menu->node( Child( menu, MenuTree::ROOT, 5000 ) ).m_label );
+
+  // items replaced past the first page before anybody looks are read as they are by then
+  g_menu_remove( m_menu.data(), 7000 );
+  g_menu_insert( m_menu.data(), 7000, "Pinned", "app.pinned" );
+  g_menu_remove( m_menu.data(), 7000 );
+  g_menu_insert( m_menu.data(), 7000, "Pinned again", "app.pinned" );
+
+  menu = Tree();
+  ASSERT_EQ( item_count - 1, ChildCount( menu, MenuTree::ROOT ) );
+  int pinned = Child( menu, MenuTree::ROOT, 7000 );
+  EXPECT_EQ( "Pinned again", menu->node( pinned ).m_label );
+  EXPECT_EQ( "app.pinned", menu->node( pinned ).m_actionName );
+  EXPECT_EQ( "Recent file 7002", menu->node( Child( menu, MenuTree::ROOT, 7001 ) ).m_label );
+}
+
+} // namespace
@@ -0,0 +1,133 @@
+/*
+ * Copyright (C) 2016 Canonical, Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3, as published
+ * by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranties of
+ * MERCHANTABILITY, SATISFACTORY QUALITY, or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Author: Pete Woods <pete.woods@canonical.com>
+ */
+
+#include <libqtgmenu/QtGParameterImporter.h>
+#include <common/GDBusHelper.h>
+
+#include <QSignalSpy>
+
+#include <libqtdbustest/DBusTestRunner.h>
+
+#include <gtest/gtest.h>
+
+#undef signals
+#include <gio/gio.h>
+
+using namespace qtgmenu;
+using namespace testing;
+using namespace QtDBusTest;
+
+namespace
+{
+
+class TestQtGParameterImporter : public Test
+{
+protected:
+  TestQtGParameterImporter()
+      : m_connection( newSessionBusConnection( nullptr ), &g_object_unref ),
+        m_menu( g_menu_new(), &g_object_unref )
+  {
+    dbus.startServices();
+  }
+
+  void TearDown() override
+  {
+    if( m_export_id > 0 )
+    {
+      g_dbus_connection_unexport_menu_model( m_connection.data(), m_export_id );
+    }
+  }
+
+  void Export()
+  {
+    m_export_id = g_dbus_connection_export_menu_model( m_connection.data(), c_path,
+        G_MENU_MODEL( m_menu.data() ), NULL );
+  }
+
+  // the action's item, with a sub menu holding one slider
+  void SetSlider( const char* label )
+  {
+    GMenu* sliders = g_menu_new();
+    GMenuItem* slider = g_menu_item_new( label, NULL );
+    g_menu_item_set_attribute( slider, "parameter-type", "s", "slider" );
+    g_menu_append_item( sliders, slider );
+    g_object_unref( slider );
+
+    GMenuItem* item = g_menu_item_new_submenu( "Adjust", G_MENU_MODEL( sliders ) );
+    g_menu_item_set_attribute( item, G_MENU_ATTRIBUTE_ACTION, "s", "app.adjust" );
+    g_object_unref( sliders );
+
+    if( g_menu_model_get_n_items( G_MENU_MODEL( m_menu.data() ) ) > 1 )
+    {
+      g_menu_remove( m_menu.data(), 1 );
+    }
+    g_menu_insert_item( m_menu.data(), 1, item );
+    g_object_unref( item );
+  }
+
+  // waits for the parameters to carry the given label
+  static bool WaitForLabel( QtGParameterImporter& importer, QSignalSpy& spy,
+      const QString& label )
+  {
+    for( ;; )
+    {
+      const QVariantList parameters( importer.GetParameters() );
+      if( parameters.size() == 1
+          && parameters.first().toMap()[G_MENU_ATTRIBUTE_LABEL] == label )
+      {
+        return true;
+      }
+      if( !spy.wait() )
+      {
+        return false;
+      }
+    }
+  }
+
+  constexpr static const char* c_path = "/com/canonical/qtgmenu";
+
+  DBusTestRunner dbus;
+
+  QSharedPointer< GDBusConnection > m_connection;
+
+  QSharedPointer< GMenu > m_menu;
+
+  guint m_export_id = 0;
+};
+
+TEST_F( TestQtGParameterImporter, FollowsTheBaseMenu )
+{
+  g_menu_append( m_menu.data(), "Fade", "app.fade" );
+  SetSlider( "Hue" );
+  Export();
+
+  QtGParameterImporter importer(
+      QString::fromUtf8( g_dbus_connection_get_unique_name( m_connection.data() ) ),
+      QDBusObjectPath( c_path ), "app.adjust", m_connection );
+  QSignalSpy parameters_spy( &importer, SIGNAL( ParametersChanged() ) );
+
+  ASSERT_TRUE( WaitForLabel( importer, parameters_spy, "Hue" ) );
+  EXPECT_EQ( QVariant( "slider" ),
+      importer.GetParameters().first().toMap()["parameter-type"] );
+
+  // the app points the action's item at another menu
+  SetSlider( "Saturation" );
+  ASSERT_TRUE( WaitForLabel( importer, parameters_spy, "Saturation" ) );
+}
+
+} // namespace
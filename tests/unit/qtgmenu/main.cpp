@@ -21,7 +21,7 @@
 
 int main( int argc, char **argv )
 {
-  qputenv("QT_QPA_PLATFORM", "minimal");
+  // the exporter works on QMenus
   QApplication application( argc, argv );
 
   ::testing::InitGoogleTest( &argc, argv );
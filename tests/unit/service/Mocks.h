@@ -36,6 +36,8 @@ public:
 
 	MOCK_METHOD3(newQuery, Query::Ptr( const QString &, const QString &, Query::EmptyBehaviour));
 
+	MOCK_METHOD1(newReserveQuery, Query::Ptr( const QString &));
+
 	MOCK_METHOD1(newApplication, Application::Ptr(const QString &));
 
 	MOCK_METHOD0(newWindowContext, WindowContext::Ptr());
@@ -117,6 +119,9 @@ public:
 	MOCK_METHOD5(executeParameterized, QString(unsigned long long,
 					QString &, QString &, QDBusObjectPath &, QDBusObjectPath &));
 
+	MOCK_CONST_METHOD5(parameterized, QString(unsigned long long,
+					QString &, QString &, QDBusObjectPath &, QDBusObjectPath &));
+
 	MOCK_CONST_METHOD0(commands, QList<QStringList>());
 
 	MOCK_CONST_METHOD0(toolbarItems, QStringList());
@@ -124,12 +129,23 @@ public:
 	MOCK_CONST_METHOD0(tokens, const QList<CollectorToken::Ptr> &());
 };
 
+class MockParameterCache: public ParameterCache {
+public:
+	MOCK_METHOD4(prefetch, void(const QString &, const QString &,
+					const QString &, const QDBusObjectPath &));
+
+	MOCK_CONST_METHOD4(parameters, QVariantList(const QString &,
+					const QString &, const QString &, const QDBusObjectPath &));
+};
+
 class MockWindowContext: public WindowContext {
 public:
 	MOCK_METHOD1(setContext, void(const QString &));
 
 	MOCK_METHOD2(addMenu, void(const QString &, const MenuDefinition &));
 
+	MOCK_METHOD1(removeMenu, void(const QString &));
+
 	MOCK_METHOD0(activeCollector, Collector::Ptr());
 };
 
@@ -143,6 +159,8 @@ public:
 
 	MOCK_METHOD2(addMenu, void(const QString &, const MenuDefinition &));
 
+	MOCK_METHOD1(removeMenu, void(const QString &));
+
 	MOCK_METHOD0(activeCollector, Collector::Ptr());
 };
 
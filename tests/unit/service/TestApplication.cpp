@@ -73,6 +73,14 @@ protected:
 		descriptions << description;
 	}
 
+	static void addSource(QList<hud::common::Source> &sources,
+			unsigned int windowId, const QString &context) {
+		hud::common::Source source;
+		source.m_windowId = windowId;
+		source.m_context = context;
+		sources << source;
+	}
+
 	DBusTestRunner dbus;
 
 	DBusMock mock;
@@ -218,4 +226,41 @@ TEST_F(TestApplication, AddSourcesToAllWindowsContextAndWindow) {
 	application.AddSources(actions, descriptions);
 }
 
+TEST_F(TestApplication, UpdateSourcesRemovesBeforeAdding) {
+	ApplicationImpl application("application-id", factory,
+			dbus.sessionConnection());
+
+	QSharedPointer<MockWindow> window1(new NiceMock<MockWindow>());
+
+	EXPECT_CALL(factory, newWindow(1, QString("application-id"), _)).WillOnce(
+			Return(window1));
+	application.addWindow(1);
+
+	QList<Source> removed;
+	addSource(removed, 0, "context1");
+	addSource(removed, 1, "context2");
+
+	QList<hud::common::Action> actions;
+	addAction(actions, 0, "context1", "prefix", QDBusObjectPath("/actions1"));
+
+	QList<Description> descriptions;
+	addMenu(descriptions, 0, "context1", QDBusObjectPath("/menu1"));
+
+	WindowContext::MenuDefinition menuDefinition1("local");
+	menuDefinition1.actionPath = QDBusObjectPath("/actions1");
+	menuDefinition1.actionPrefix = "prefix";
+	menuDefinition1.menuPath = QDBusObjectPath("/menu1");
+
+	{
+		InSequence s;
+		EXPECT_CALL(*allWindowsContext, removeMenu(QString("context1")));
+		EXPECT_CALL(*allWindowsContext,
+				addMenu(QString("context1"), menuDefinition1));
+	}
+	EXPECT_CALL(*window1, removeMenu(QString("context2")));
+	EXPECT_CALL(*window1, addMenu(_, _)).Times(0);
+
+	application.UpdateSources(removed, actions, descriptions);
+}
+
 } // namespace
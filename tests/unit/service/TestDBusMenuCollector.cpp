@@ -0,0 +1,275 @@
+/*
+ * Copyright (C) 2016 Canonical, Ltd.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Author: Pete Woods <pete.woods@canonical.com>
+ */
+
+#include <common/DBusMenuLayoutItem.h>
+#include <common/MenuTree.h>
+#include <service/DBusMenuCollector.h>
+
+#include <libqtdbustest/DBusTestRunner.h>
+#include <QDBusConnection>
+#include <QDBusMetaType>
+#include <QDBusVariant>
+#include <QSignalSpy>
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+using namespace std;
+using namespace testing;
+using namespace QtDBusTest;
+using namespace hud::common;
+using namespace hud::service;
+
+namespace {
+
+/*
+ * Serves a menu over com.canonical.dbusmenu, the way a GTK or Qt app
+ * would through libdbusmenu.
+ */
+class FakeDBusMenu: public QObject {
+Q_OBJECT
+Q_CLASSINFO("D-Bus Interface", "com.canonical.dbusmenu")
+
+public:
+	DBusMenuLayoutItem m_layout;
+
+	uint m_revision = 1;
+
+	QList<int> m_aboutToShow;
+
+	QList<QPair<int, QString>> m_events;
+
+public Q_SLOTS:
+	uint GetLayout(int parentId, int recursionDepth,
+			const QStringList &propertyNames, DBusMenuLayoutItem &layout) {
+		Q_UNUSED(parentId);
+		Q_UNUSED(recursionDepth);
+		Q_UNUSED(propertyNames);
+		layout = m_layout;
+		return m_revision;
+	}
+
+	bool AboutToShow(int id) {
+		m_aboutToShow << id;
+		return false;
+	}
+
+	void Event(int id, const QString &eventId, const QDBusVariant &data,
+			uint timestamp) {
+		Q_UNUSED(data);
+		Q_UNUSED(timestamp);
+		m_events << qMakePair(id, eventId);
+	}
+
+Q_SIGNALS:
+	void LayoutUpdated(uint revision, int parent);
+
+	void ItemsPropertiesUpdated(
+			const hud::common::DBusMenuItemList &updatedProps,
+			const hud::common::DBusMenuItemKeysList &removedProps);
+};
+
+class TestDBusMenuCollector: public Test {
+protected:
+	TestDBusMenuCollector() {
+		qDBusRegisterMetaType<QList<QStringList>>();
+
+		QDBusConnection connection(dbus.sessionConnection());
+		connection.registerObject("/menu", &menu,
+				QDBusConnection::ExportAllSlots
+						| QDBusConnection::ExportAllSignals);
+		connection.registerService("test.dbusmenu");
+
+		DBusMenuLayoutItem file(item(1, "_File"));
+		file.children << item(2, "_Open") << separator(3)
+				<< item(4, "Save _As...") << item(5, "Copy __Special & More")
+				<< item(6, "_Quit");
+		file.children[2].properties["enabled"] = false;
+		shortcut(file.children[1], QStringList() << "Control" << "o");
+		shortcut(file.children[4],
+				QStringList() << "Shift" << "Control" << "Alt" << "q");
+		menu.m_layout.children << file;
+
+		DBusMenuLayoutItem view(item(7, "_View"));
+		view.children << item(8, "Zoom In") << item(9, "Switch Workspace");
+		shortcut(view.children[0], QStringList() << "Control" << "plus");
+		shortcut(view.children[1], QStringList() << "Super" << "Tab");
+		menu.m_layout.children << view;
+	}
+
+	virtual ~TestDBusMenuCollector() {
+		dbus.sessionConnection().unregisterObject("/menu");
+		dbus.sessionConnection().unregisterService("test.dbusmenu");
+	}
+
+	static DBusMenuLayoutItem item(int id, const QString &label) {
+		DBusMenuLayoutItem item;
+		item.id = id;
+		item.properties["label"] = label;
+		return item;
+	}
+
+	static DBusMenuLayoutItem separator(int id) {
+		DBusMenuLayoutItem item;
+		item.id = id;
+		item.properties["type"] = "separator";
+		return item;
+	}
+
+	static void shortcut(DBusMenuLayoutItem &item, const QStringList &chord) {
+		item.properties["shortcut"] = QVariant::fromValue(
+				QList<QStringList>() << chord);
+	}
+
+	DBusMenuCollector::Ptr newCollector() {
+		return DBusMenuCollector::Ptr(
+				new DBusMenuCollector("test.dbusmenu", QDBusObjectPath("/menu"),
+						dbus.sessionConnection()));
+	}
+
+	static CollectorToken::Ptr activate(DBusMenuCollector::Ptr collector) {
+		QList<CollectorToken::Ptr> tokens(collector->activate());
+		EXPECT_EQ(1, tokens.size());
+		return tokens.isEmpty() ? CollectorToken::Ptr() : tokens.first();
+	}
+
+	static int child(MenuTree::Ptr tree, int parent, int n) {
+		int index(tree->firstChild(parent));
+		for (int i(0); i < n && index != -1; ++i) {
+			index = tree->nextSibling(index);
+		}
+		return index;
+	}
+
+	DBusTestRunner dbus;
+
+	FakeDBusMenu menu;
+};
+
+TEST_F(TestDBusMenuCollector, ReadsLayout) {
+	DBusMenuCollector::Ptr collector(newCollector());
+	ASSERT_TRUE(collector->isValid());
+
+	CollectorToken::Ptr token(activate(collector));
+	ASSERT_FALSE(token.isNull());
+	MenuTree::Ptr tree(token->menuTree());
+
+	int file(child(tree, MenuTree::ROOT, 0));
+	ASSERT_NE(-1, file);
+	EXPECT_EQ("&File", tree->node(file).m_label);
+	EXPECT_TRUE(tree->node(file).flag(MenuTree::SUBMENU));
+
+	EXPECT_EQ("&Open", tree->node(child(tree, file, 0)).m_label);
+	EXPECT_TRUE(tree->node(child(tree, file, 0)).flag(MenuTree::ENABLED));
+	EXPECT_TRUE(tree->node(child(tree, file, 1)).flag(MenuTree::SEPARATOR));
+	EXPECT_EQ("Save &As...", tree->node(child(tree, file, 2)).m_label);
+	EXPECT_FALSE(tree->node(child(tree, file, 2)).flag(MenuTree::ENABLED));
+	EXPECT_EQ("Copy _Special && More",
+			tree->node(child(tree, file, 3)).m_label);
+
+	// Opening the menus lets the app fill them in
+	EXPECT_TRUE(menu.m_aboutToShow.contains(1));
+	EXPECT_TRUE(menu.m_aboutToShow.contains(7));
+
+	// Activating sends the item's ID back
+	tree->activate(child(tree, file, 0));
+	QCoreApplication::processEvents();
+	EXPECT_TRUE(menu.m_events.contains(qMakePair(2, QString("clicked"))));
+}
+
+TEST_F(TestDBusMenuCollector, Shortcuts) {
+	DBusMenuCollector::Ptr collector(newCollector());
+	CollectorToken::Ptr token(activate(collector));
+	ASSERT_FALSE(token.isNull());
+	MenuTree::Ptr tree(token->menuTree());
+
+	int file(child(tree, MenuTree::ROOT, 0));
+	int view(child(tree, MenuTree::ROOT, 1));
+
+	EXPECT_EQ("Ctrl+O", tree->node(child(tree, file, 0)).m_accel);
+	EXPECT_EQ("", tree->node(child(tree, file, 2)).m_accel);
+	EXPECT_EQ("Ctrl+Alt+Shift+Q", tree->node(child(tree, file, 4)).m_accel);
+	EXPECT_EQ("Ctrl++", tree->node(child(tree, view, 0)).m_accel);
+	EXPECT_EQ("Meta+Tab", tree->node(child(tree, view, 1)).m_accel);
+}
+
+TEST_F(TestDBusMenuCollector, PropertyUpdates) {
+	DBusMenuCollector::Ptr collector(newCollector());
+	CollectorToken::Ptr token(activate(collector));
+	ASSERT_FALSE(token.isNull());
+
+	QSignalSpy changedSpy(token.data(), SIGNAL(changed()));
+
+	DBusMenuItem open;
+	open.id = 2;
+	open.properties["label"] = "_Open File";
+	open.properties["enabled"] = false;
+
+	// "enabled" defaults to true
+	DBusMenuItemKeys saveAs;
+	saveAs.id = 4;
+	saveAs.properties << "enabled";
+
+	Q_EMIT menu.ItemsPropertiesUpdated(DBusMenuItemList() << open,
+			DBusMenuItemKeysList() << saveAs);
+	ASSERT_TRUE(changedSpy.wait());
+
+	CollectorToken::Ptr updated(activate(collector));
+	ASSERT_FALSE(updated.isNull());
+	EXPECT_NE(token, updated);
+
+	MenuTree::Ptr tree(updated->menuTree());
+	int file(child(tree, MenuTree::ROOT, 0));
+	EXPECT_EQ("&Open File", tree->node(child(tree, file, 0)).m_label);
+	EXPECT_FALSE(tree->node(child(tree, file, 0)).flag(MenuTree::ENABLED));
+	EXPECT_TRUE(tree->node(child(tree, file, 2)).flag(MenuTree::ENABLED));
+
+	// Nothing has changed since
+	EXPECT_EQ(updated, activate(collector));
+}
+
+TEST_F(TestDBusMenuCollector, LayoutUpdates) {
+	DBusMenuCollector::Ptr collector(newCollector());
+	CollectorToken::Ptr token(activate(collector));
+	ASSERT_FALSE(token.isNull());
+
+	QSignalSpy changedSpy(token.data(), SIGNAL(changed()));
+
+	menu.m_layout.children[1].children << item(10, "Full Screen");
+	++menu.m_revision;
+	Q_EMIT menu.LayoutUpdated(menu.m_revision, 7);
+	ASSERT_TRUE(changedSpy.wait());
+
+	CollectorToken::Ptr updated(activate(collector));
+	ASSERT_FALSE(updated.isNull());
+
+	MenuTree::Ptr tree(updated->menuTree());
+	int view(child(tree, MenuTree::ROOT, 1));
+	EXPECT_EQ("Full Screen", tree->node(child(tree, view, 2)).m_label);
+
+	// The menus are closed once, when the last token goes
+	menu.m_events.clear();
+	token.reset();
+	EXPECT_TRUE(menu.m_events.isEmpty());
+	updated.reset();
+	QCoreApplication::processEvents();
+	EXPECT_TRUE(menu.m_events.contains(qMakePair(1, QString("closed"))));
+}
+
+} // namespace
+
+#include "TestDBusMenuCollector.moc"
@@ -83,6 +83,35 @@ TEST_F(TestHudService, OpenCloseQuery) {
 	EXPECT_EQ(QList<QDBusObjectPath>(), hudService.openQueries());
 }
 
+TEST_F(TestHudService, OpenReserveQuery) {
+	HudServiceImpl hudService(factory, applicationList,
+			dbus.sessionConnection());
+
+	QDBusObjectPath queryPath("/path/query0");
+	QString resultsModel("com.canonical.hud.results0");
+	QString appstackModel("com.canonical.hud.appstack0");
+	QSharedPointer<MockQuery> query(new NiceMock<MockQuery>());
+	ON_CALL(*query, path()).WillByDefault(ReturnRef(queryPath));
+	ON_CALL(*query, resultsModel()).WillByDefault(Return(resultsModel));
+	ON_CALL(*query, appstackModel()).WillByDefault(Return(appstackModel));
+
+	EXPECT_CALL(factory, newReserveQuery(QString("local"))).Times(1).WillOnce(
+			Return(query));
+
+	QString resultsName;
+	QString appstackName;
+	int modelRevision;
+
+	EXPECT_EQ(queryPath,
+			hudService.CreateReserveQuery(resultsName, appstackName,
+					modelRevision));
+	EXPECT_EQ(resultsModel, resultsName);
+	EXPECT_EQ(appstackModel, appstackName);
+	EXPECT_EQ(0, modelRevision);
+
+	EXPECT_EQ(QList<QDBusObjectPath>() << queryPath, hudService.openQueries());
+}
+
 TEST_F(TestHudService, CloseUnknownQuery) {
 	HudServiceImpl hudService(factory, applicationList,
 			dbus.sessionConnection());
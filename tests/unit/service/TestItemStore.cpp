@@ -16,6 +16,7 @@
  * Author: Pete Woods <pete.woods@canonical.com>
  */
 
+#include <common/MenuTree.h>
 #include <service/ItemStore.h>
 #include <service/HardCodedSearchSettings.h>
 #include <tests/unit/service/Mocks.h>
@@ -26,6 +27,7 @@
 
 using namespace std;
 using namespace testing;
+using namespace hud::common;
 using namespace hud::service;
 using namespace hud::service::test;
 
@@ -39,6 +41,22 @@ protected:
 		searchSettings.reset(new HardCodedSearchSettings());
 
 		store.reset(new ItemStore("app-id", usageTracker, searchSettings));
+
+		menu.reset(new MenuTree());
+	}
+
+	/* Menus have to be built up in depth-first order */
+	int addAction(int parent, const QString &label) {
+		MenuTree::Node node;
+		node.m_label = label;
+		return menu->append(parent, node);
+	}
+
+	int addMenu(int parent, const QString &label) {
+		MenuTree::Node node;
+		node.m_label = label;
+		node.m_flags |= MenuTree::SUBMENU;
+		return menu->append(parent, node);
 	}
 
 	/* Test a set of strings */
@@ -60,36 +78,32 @@ protected:
 	QSharedPointer<MockUsageTracker> usageTracker;
 
 	QSharedPointer<HardCodedSearchSettings> searchSettings;
+
+	MenuTree::Ptr menu;
 };
 
 /* Ensure the base calculation works */
 TEST_F(TestItemStore, DistanceSubfunction) {
-	QMenu root;
-
-	QMenu file("File");
-	file.addAction("Open");
-	file.addAction("New");
-	file.addAction("Print");
-	file.addAction("Print Preview");
-	root.addMenu(&file);
+	int file(addMenu(MenuTree::ROOT, "File"));
+	addAction(file, "Open");
+	addAction(file, "New");
+	addAction(file, "Print");
+	addAction(file, "Print Preview");
 
-	store->indexMenu(&root);
+	store->indexMenu(menu);
 
 	EXPECT_EQ("Print Preview", search("Print Pre"));
 }
 
 /* Ensure that we can handle some misspelling */
 TEST_F(TestItemStore, DistanceMisspelll) {
-	QMenu root;
+	int file(addMenu(MenuTree::ROOT, "File"));
+	addAction(file, "Open");
+	addAction(file, "New");
+	addAction(file, "Print");
+	addAction(file, "Print Preview");
 
-	QMenu file("File");
-	file.addAction("Open");
-	file.addAction("New");
-	file.addAction("Print");
-	file.addAction("Print Preview");
-	root.addMenu(&file);
-
-	store->indexMenu(&root);
+	store->indexMenu(menu);
 
 	EXPECT_EQ("Print Preview", search("Prnt Pr"));
 	EXPECT_EQ("Print Preview", search("Print Preiw"));
@@ -98,24 +112,19 @@ TEST_F(TestItemStore, DistanceMisspelll) {
 
 /* Ensure that we can find print with short strings */
 TEST_F(TestItemStore, DistancePrintIssues) {
-	QMenu root;
-
-	QMenu file("File");
-	file.addAction("New");
-	file.addAction("Open");
-	file.addAction("Print...");
-	root.addMenu(&file);
+	int file(addMenu(MenuTree::ROOT, "File"));
+	addAction(file, "New");
+	addAction(file, "Open");
+	addAction(file, "Print...");
 
-	QMenu edit("Edit");
-	edit.addAction("Undo");
-	root.addMenu(&edit);
+	int edit(addMenu(MenuTree::ROOT, "Edit"));
+	addAction(edit, "Undo");
 
-	QMenu help("Help");
-	help.addAction("About");
-	help.addAction("Empty");
-	root.addMenu(&help);
+	int help(addMenu(MenuTree::ROOT, "Help"));
+	addAction(help, "About");
+	addAction(help, "Empty");
 
-	store->indexMenu(&root);
+	store->indexMenu(menu);
 
 	EXPECT_EQ("Print...", search("Pr"));
 	EXPECT_EQ("Print...", search("Print"));
@@ -124,10 +133,9 @@ TEST_F(TestItemStore, DistancePrintIssues) {
 
 /* Not finished word yet */
 TEST_F(TestItemStore, UnfinishedWord) {
-	QMenu root;
-	root.addAction("Open Terminal");
-	root.addAction("Open Tab");
-	store->indexMenu(&root);
+	addAction(MenuTree::ROOT, "Open Terminal");
+	addAction(MenuTree::ROOT, "Open Tab");
+	store->indexMenu(menu);
 
 	EXPECT_EQ("Open Terminal", search("open ter"));
 	EXPECT_EQ("Open Terminal", search("open term"));
@@ -139,36 +147,118 @@ TEST_F(TestItemStore, UnfinishedWord) {
 
 /* Not finished word yet */
 TEST_F(TestItemStore, UnfinishedWord2) {
-	QMenu root;
-	root.addAction("Change Topic");
-	store->indexMenu(&root);
+	addAction(MenuTree::ROOT, "Change Topic");
+	store->indexMenu(menu);
 
 	EXPECT_EQ("Change Topic", search("cha"));
 }
 
+/* Unfinished and misspelt words in a large menu */
+TEST_F(TestItemStore, UnfinishedWordLargeMenu) {
+	for (int i(0); i < 200; ++i) {
+		addAction(MenuTree::ROOT, QString("Item %1").arg(i));
+	}
+	addAction(MenuTree::ROOT, "Open Terminal");
+	addAction(MenuTree::ROOT, "Open Tab");
+	addAction(MenuTree::ROOT, "Print Preview");
+	store->indexMenu(menu);
+
+	EXPECT_EQ("Open Terminal", search("open ter"));
+	EXPECT_EQ("Open Terminal", search("open termina"));
+	EXPECT_EQ("Open Tab", search("open tab"));
+	EXPECT_EQ("Print Preview", search("Prnt Pr"));
+	EXPECT_EQ("Print Preview", search("Print Preiw"));
+	EXPECT_EQ("", search("flibble"));
+}
+
+/* Long words are pre-filtered by trigram, and must keep their misspellings */
+TEST_F(TestItemStore, NgramPrefilterLargeMenu) {
+	for (int i(0); i < 200; ++i) {
+		addAction(MenuTree::ROOT, QString("Item %1").arg(i));
+	}
+	addAction(MenuTree::ROOT, "Preferences");
+	addAction(MenuTree::ROOT, "Keyboard Shortcuts...");
+	addAction(MenuTree::ROOT, "Configure VPN...");
+	store->indexMenu(menu);
+
+	EXPECT_EQ("Preferences", search("preferances"));
+	EXPECT_EQ("Preferences", search("prefrences"));
+	EXPECT_EQ("Keyboard Shortcuts...", search("keybaord shortcuts"));
+	EXPECT_EQ("Keyboard Shortcuts...", search("keyboard shrtcu"));
+	EXPECT_EQ("Configure VPN...", search("configuer vpn"));
+}
+
+/* Scores every document, as if there were no trigram index */
+class UnfilteredItemStore: public ItemStore {
+public:
+	UnfilteredItemStore(UsageTracker::Ptr usageTracker,
+			SearchSettings::Ptr searchSettings) :
+			ItemStore("app-id", usageTracker, searchSettings) {
+		m_prefilter = false;
+	}
+};
+
+static QList<qulonglong> resultIds(ItemStore &store, const QString &query) {
+	QList<Result> results;
+	store.search(query, Query::EmptyBehaviour::SHOW_SUGGESTIONS, results);
+
+	QList<qulonglong> ids;
+	for (const Result &result : results) {
+		ids << result.id();
+	}
+	return ids;
+}
+
+/* Only scoring the trigram candidates mustn't lose any misspelt matches */
+TEST_F(TestItemStore, NgramPrefilterKeepsRecall) {
+	for (int i(0); i < 200; ++i) {
+		addAction(MenuTree::ROOT, QString("Item %1").arg(i));
+	}
+	int edit(addMenu(MenuTree::ROOT, "Edit"));
+	addAction(edit, "Preferences");
+	addAction(edit, "Keyboard Shortcuts...");
+	int terminal(addMenu(MenuTree::ROOT, "Terminal"));
+	addAction(terminal, "Open Terminal");
+	addAction(terminal, "Open Tab");
+	addAction(terminal, "Configure VPN...");
+	store->indexMenu(menu);
+
+	UnfilteredItemStore unfiltered(usageTracker, searchSettings);
+	unfiltered.indexMenu(menu);
+
+	for (const QString &query : QStringList( { "preferances", "prefrences",
+			"keybaord shortcuts", "keyboard shrtcu", "configuer vpn",
+			"opne terminal", "termnial", "open tremin" })) {
+		QList<qulonglong> expected(resultIds(unfiltered, query));
+		QList<qulonglong> ids(resultIds(*store, query));
+
+		ASSERT_FALSE(expected.isEmpty()) << query.toStdString();
+		ASSERT_FALSE(ids.isEmpty()) << query.toStdString();
+		EXPECT_EQ(expected.first(), ids.first()) << query.toStdString();
+
+		// The candidates' own word frequencies can reorder close scores
+		qSort(expected);
+		qSort(ids);
+		EXPECT_EQ(expected, ids) << query.toStdString();
+	}
+}
+
 /* A variety of strings that should have predictable results */
 TEST_F(TestItemStore, DistanceVariety) {
-	QMenu root;
-
-	QMenu date("Date");
-	date.addAction("House Cleaning");
-	root.addMenu(&date);
+	int date(addMenu(MenuTree::ROOT, "Date"));
+	addAction(date, "House Cleaning");
 
-	QMenu file("File");
-	file.addAction("Close Window");
-	root.addMenu(&file);
+	int file(addMenu(MenuTree::ROOT, "File"));
+	addAction(file, "Close Window");
 
-	QMenu edit("Edit");
-	edit.addAction("Keyboard Shortcuts...");
-	root.addMenu(&edit);
+	int edit(addMenu(MenuTree::ROOT, "Edit"));
+	addAction(edit, "Keyboard Shortcuts...");
 
-	QMenu vpn("VPN Configuration");
-	vpn.addAction("Configure VPN...");
-	QMenu network("Network");
-	network.addMenu(&vpn);
-	root.addMenu(&network);
+	int network(addMenu(MenuTree::ROOT, "Network"));
+	int vpn(addMenu(network, "VPN Configuration"));
+	addAction(vpn, "Configure VPN...");
 
-	store->indexMenu(&root);
+	store->indexMenu(menu);
 
 	EXPECT_EQ("House Cleaning", search("House"));
 	EXPECT_EQ("House Cleaning", search("House C"));
@@ -179,20 +269,15 @@ TEST_F(TestItemStore, DistanceVariety) {
 
 /* A variety of strings that should have predictable results */
 TEST_F(TestItemStore, DistanceFrenchPref) {
-	QMenu root;
+	int file(addMenu(MenuTree::ROOT, "Fichier"));
+	addAction(file, "aperçu avant impression");
 
-	QMenu file("Fichier");
-	file.addAction("aperçu avant impression");
-	root.addMenu(&file);
+	addMenu(MenuTree::ROOT, "Connexion au réseau...");
 
-	QMenu connection("Connexion au réseau...");
-	root.addMenu(&connection);
+	int edit(addMenu(MenuTree::ROOT, "Edition"));
+	addAction(edit, "préférences");
 
-	QMenu edit("Edition");
-	edit.addAction("préférences");
-	root.addMenu(&edit);
-
-	store->indexMenu(&root);
+	store->indexMenu(menu);
 
 	EXPECT_EQ("préférences", search("préférences"));
 	EXPECT_EQ("préférences", search("pré"));
@@ -204,47 +289,40 @@ TEST_F(TestItemStore, DistanceFrenchPref) {
 /* Check to make sure the returned hits are not dups and the
  proper number */
 TEST_F(TestItemStore, DistanceDups) {
-	QMenu root;
-	root.addAction("Inflated");
-	root.addAction("Confluated");
-	root.addAction("Sublimated");
-	root.addAction("Sadated");
-	root.addAction("Situated");
-	root.addAction("Infatuated");
+	addAction(MenuTree::ROOT, "Inflated");
+	addAction(MenuTree::ROOT, "Confluated");
+	addAction(MenuTree::ROOT, "Sublimated");
+	addAction(MenuTree::ROOT, "Sadated");
+	addAction(MenuTree::ROOT, "Situated");
+	addAction(MenuTree::ROOT, "Infatuated");
 
-	store->indexMenu(&root);
+	store->indexMenu(menu);
 
 	EXPECT_EQ("Inflated", search("ted inf"));
 }
 
 /* Check to make sure 'Save' matches better than 'Save As...' for "save" */
 TEST_F(TestItemStore, DistanceExtraTerms) {
-	QMenu root;
-
-	QMenu file("File");
-	file.addAction("Banana");
-	file.addAction("Save All");
-	file.addAction("Save");
-	file.addAction("Save As...");
-	file.addAction("Apple");
-	root.addMenu(&file);
+	int file(addMenu(MenuTree::ROOT, "File"));
+	addAction(file, "Banana");
+	addAction(file, "Save All");
+	addAction(file, "Save");
+	addAction(file, "Save As...");
+	addAction(file, "Apple");
 
-	store->indexMenu(&root);
+	store->indexMenu(menu);
 
 	EXPECT_EQ("Save", search("save"));
 }
 
 TEST_F(TestItemStore, BlankSearchFrequentlyUsedItems) {
-	QMenu root;
+	int file(addMenu(MenuTree::ROOT, "&File"));
+	addAction(file, "&One");
+	addAction(file, "&Two");
+	addAction(file, "T&hree");
+	addAction(file, "Fou&r");
 
-	QMenu file("&File");
-	file.addAction("&One");
-	file.addAction("&Two");
-	file.addAction("T&hree");
-	file.addAction("Fou&r");
-	root.addMenu(&file);
-
-	store->indexMenu(&root);
+	store->indexMenu(menu);
 
 	ON_CALL(*usageTracker,
 			usage(QString("app-id"), QString("File||One"))).WillByDefault(
@@ -269,16 +347,13 @@ TEST_F(TestItemStore, BlankSearchFrequentlyUsedItems) {
 }
 
 TEST_F(TestItemStore, BlankSearchNoSuggestions) {
-	QMenu root;
-
-	QMenu file("&File");
-	file.addAction("&One");
-	file.addAction("&Two");
-	file.addAction("T&hree");
-	file.addAction("Fou&r");
-	root.addMenu(&file);
+	int file(addMenu(MenuTree::ROOT, "&File"));
+	addAction(file, "&One");
+	addAction(file, "&Two");
+	addAction(file, "T&hree");
+	addAction(file, "Fou&r");
 
-	store->indexMenu(&root);
+	store->indexMenu(menu);
 
 	ON_CALL(*usageTracker,
 			usage(QString("app-id"), QString("File||One"))).WillByDefault(
@@ -299,30 +374,58 @@ TEST_F(TestItemStore, BlankSearchNoSuggestions) {
 }
 
 TEST_F(TestItemStore, ExecuteMarksHistory) {
-	QMenu root;
+	int file(addMenu(MenuTree::ROOT, "File"));
+	addAction(file, "Save As...");
+	addAction(file, "Save");
 
-	QMenu file("File");
-	file.addAction("Save As...");
-	file.addAction("Save");
-	root.addMenu(&file);
-
-	store->indexMenu(&root);
+	store->indexMenu(menu);
 
 	EXPECT_CALL(*usageTracker,
 			markUsage(QString("app-id"), QString("File||Save As...")));
 	store->execute(0);
 }
 
-TEST_F(TestItemStore, ChangeSearchSettings) {
-	QMenu root;
+TEST_F(TestItemStore, ExecuteActivatesNode) {
+	int file(addMenu(MenuTree::ROOT, "File"));
+	addAction(file, "Save As...");
+	int save(addAction(file, "Save"));
 
-	QMenu file("&File");
-	file.addAction("Apple");
-	file.addAction("Banana");
-	file.addAction("Can Cherry");
-	root.addMenu(&file);
+	int activated(-1);
+	menu->setActivator([&activated](const MenuTree &, int node) {
+		activated = node;
+	});
 
-	store->indexMenu(&root);
+	store->indexMenu(menu);
+
+	store->execute(1);
+	EXPECT_EQ(save, activated);
+}
+
+TEST_F(TestItemStore, DisabledAndSeparatorNodes) {
+	addAction(MenuTree::ROOT, "Banana");
+
+	MenuTree::Node separator;
+	separator.m_flags |= MenuTree::SEPARATOR;
+	menu->append(MenuTree::ROOT, separator);
+
+	MenuTree::Node disabled;
+	disabled.m_label = "Bandana";
+	disabled.m_flags = 0;
+	menu->append(MenuTree::ROOT, disabled);
+
+	store->indexMenu(menu);
+
+	EXPECT_EQ(1, store->commands().size());
+	EXPECT_EQ("Banana", search("Bandana"));
+}
+
+TEST_F(TestItemStore, ChangeSearchSettings) {
+	int file(addMenu(MenuTree::ROOT, "&File"));
+	addAction(file, "Apple");
+	addAction(file, "Banana");
+	addAction(file, "Can Cherry");
+
+	store->indexMenu(menu);
 
 	EXPECT_EQ("Banana", search("Ban"));
 
@@ -331,25 +434,22 @@ TEST_F(TestItemStore, ChangeSearchSettings) {
 	EXPECT_EQ("Can Cherry", search("Ban"));
 }
 
-TEST_F(TestItemStore, DeletedActions) {
-	QMenu root;
+/* The store keeps its own snapshot, so the menu source can go away */
+TEST_F(TestItemStore, SourceMenuGone) {
+	int file(addMenu(MenuTree::ROOT, "&File"));
+	addAction(file, "Apple");
+	addAction(file, "Banana");
+	addAction(file, "Can Cherry");
 
-	QMenu file("&File");
-	file.addAction("Apple");
-	file.addAction("Banana");
-	file.addAction("Can Cherry");
-	root.addMenu(&file);
+	store->indexMenu(menu);
 
-	store->indexMenu(&root);
+	menu.reset();
 
-	file.clear();
-	root.clear();
-
-	// It should not crash! :)
 	EXPECT_EQ("", search("flibble"));
+	EXPECT_EQ("Banana", search("Ban"));
 
 	// It should not crash! :)
-	EXPECT_EQ("", search(""));
+	store->execute(1);
 }
 
 } // namespace
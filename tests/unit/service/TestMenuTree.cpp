@@ -0,0 +1,98 @@
+/*
+ * Copyright (C) 2016 Canonical, Ltd.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Author: Pete Woods <pete.woods@canonical.com>
+ */
+
+#include <common/MenuTree.h>
+
+#include <QList>
+#include <gtest/gtest.h>
+
+using namespace std;
+using namespace testing;
+using namespace hud::common;
+
+namespace {
+
+class TestMenuTree: public Test {
+protected:
+	int add(int parent, const QString &label) {
+		MenuTree::Node node;
+		node.m_label = label;
+		return tree.append(parent, node);
+	}
+
+	MenuTree tree;
+};
+
+TEST_F(TestMenuTree, WalksChildrenInOrder) {
+	int file(add(MenuTree::ROOT, "File"));
+	int open(add(file, "Open"));
+	int recent(add(file, "Recent"));
+	int first(add(recent, "first.txt"));
+	int save(add(file, "Save"));
+	int edit(add(MenuTree::ROOT, "Edit"));
+
+	EXPECT_EQ(7, tree.size());
+
+	EXPECT_EQ(file, tree.firstChild(MenuTree::ROOT));
+	EXPECT_EQ(edit, tree.nextSibling(file));
+	EXPECT_EQ(-1, tree.nextSibling(edit));
+
+	EXPECT_EQ(open, tree.firstChild(file));
+	EXPECT_EQ(recent, tree.nextSibling(open));
+	EXPECT_EQ(save, tree.nextSibling(recent));
+	EXPECT_EQ(-1, tree.nextSibling(save));
+
+	EXPECT_EQ(first, tree.firstChild(recent));
+	EXPECT_EQ(-1, tree.nextSibling(first));
+	EXPECT_EQ(-1, tree.firstChild(edit));
+
+	EXPECT_EQ(recent, tree.node(first).m_parent);
+	EXPECT_EQ(QString("first.txt"), tree.node(first).m_label);
+}
+
+TEST_F(TestMenuTree, SetFlagOnAllNodes) {
+	int file(add(MenuTree::ROOT, "File"));
+	int open(add(file, "Open"));
+
+	EXPECT_FALSE(tree.node(open).flag(MenuTree::SEARCH_BY_MNEMONIC));
+
+	tree.setFlag(MenuTree::SEARCH_BY_MNEMONIC, true);
+	EXPECT_TRUE(tree.node(file).flag(MenuTree::SEARCH_BY_MNEMONIC));
+	EXPECT_TRUE(tree.node(open).flag(MenuTree::SEARCH_BY_MNEMONIC));
+	EXPECT_TRUE(tree.node(open).flag(MenuTree::ENABLED));
+
+	tree.setFlag(MenuTree::SEARCH_BY_MNEMONIC, false);
+	EXPECT_FALSE(tree.node(open).flag(MenuTree::SEARCH_BY_MNEMONIC));
+}
+
+TEST_F(TestMenuTree, ActivateRoot) {
+	int open(add(MenuTree::ROOT, "Open"));
+
+	QList<int> activated;
+	tree.setActivator([&activated](const MenuTree &, int node) {
+		activated << node;
+	});
+
+	tree.activate(MenuTree::ROOT);
+	tree.activate(open);
+	tree.activate(open + 1);
+
+	EXPECT_EQ(QList<int>() << open, activated);
+}
+
+} // namespace
@@ -69,6 +69,8 @@ protected:
 
 		voice.reset(new NiceMock<MockVoice>());
 
+		parameterCache.reset(new NiceMock<MockParameterCache>());
+
 		hudService.reset(new NiceMock<MockHudService>);
 	}
 
@@ -91,6 +93,8 @@ protected:
 
 	QSharedPointer<MockVoice> voice;
 
+	QSharedPointer<MockParameterCache> parameterCache;
+
 	QSharedPointer<MockApplicationList> applicationList;
 
 	QSharedPointer<MockApplication> application;
@@ -121,7 +125,8 @@ TEST_F(TestQuery, Create) {
 
 	QueryImpl query(0, queryString, "keep.alive",
 			Query::EmptyBehaviour::SHOW_SUGGESTIONS, *hudService,
-			applicationList, voice, dbus.sessionConnection());
+			applicationList, voice, parameterCache, false,
+			dbus.sessionConnection());
 
 	const QList<Result> results(query.results());
 	ASSERT_EQ(expectedResults.size(), results.size());
@@ -133,12 +138,66 @@ TEST_F(TestQuery, Create) {
 TEST_F(TestQuery, ExecuteCommand) {
 	QueryImpl query(0, "query", "keep.alive",
 			Query::EmptyBehaviour::SHOW_SUGGESTIONS, *hudService,
-			applicationList, voice, dbus.sessionConnection());
+			applicationList, voice, parameterCache, false,
+			dbus.sessionConnection());
 
 	EXPECT_CALL(*windowToken, execute(123));
 	query.ExecuteCommand(QDBusVariant(123), 12345);
 }
 
+TEST_F(TestQuery, PrefetchesParameterized) {
+	EXPECT_CALL(*windowToken, search(_, _, _)).WillOnce(
+			Invoke(
+					[](const QString &, Query::EmptyBehaviour, QList<Result> &results) {
+				results << Result(1, "Plain", Result::HighlightList(), "",
+						Result::HighlightList(), "", 100, false);
+				results << Result(2, "Hue", Result::HighlightList(), "",
+						Result::HighlightList(), "", 90, true);
+			}));
+
+	EXPECT_CALL(*windowToken, parameterized(1, _, _, _, _)).Times(0);
+	EXPECT_CALL(*windowToken, parameterized(2, _, _, _, _)).WillOnce(
+			DoAll(SetArgReferee<1>(QString("hud")),
+					SetArgReferee<2>(QString("hue")),
+					SetArgReferee<4>(QDBusObjectPath("/menu")),
+					Return(QString("app.bus"))));
+	EXPECT_CALL(*parameterCache,
+			prefetch(QString("app.bus"), QString("hud"), QString("hue"),
+					QDBusObjectPath("/menu")));
+
+	QueryImpl query(0, "hue", "keep.alive",
+			Query::EmptyBehaviour::SHOW_SUGGESTIONS, *hudService,
+			applicationList, voice, parameterCache, false,
+			dbus.sessionConnection());
+
+	QVariantMap slider;
+	slider["parameter-type"] = "slider";
+	slider["label"] = "Hue";
+	slider["max"] = 360.0;
+
+	EXPECT_CALL(*windowToken, executeParameterized(2, _, _, _, _)).WillOnce(
+			DoAll(SetArgReferee<1>(QString("hud")),
+					SetArgReferee<2>(QString("hue")),
+					SetArgReferee<4>(QDBusObjectPath("/menu")),
+					Return(QString("app.bus"))));
+	EXPECT_CALL(*parameterCache,
+			parameters(QString("app.bus"), QString("hud"), QString("hue"),
+					QDBusObjectPath("/menu"))).WillOnce(
+			Return(QVariantList() << slider));
+
+	QString prefix, baseAction;
+	QDBusObjectPath actionPath, modelPath;
+	int modelSection(0);
+	QVariantList parameters;
+	EXPECT_EQ(QString("app.bus"),
+			query.ExecuteParameterizedWithParameters(
+					QDBusVariant(qulonglong(2)), 12345, prefix, baseAction,
+					actionPath, modelPath, modelSection, parameters));
+
+	ASSERT_EQ(1, parameters.size());
+	EXPECT_EQ(slider, parameters.first().toMap());
+}
+
 TEST_F(TestQuery, CloseWhenSenderDies) {
 	// a random dbus service that we're going to tell the query to watch
 	QScopedPointer<QProcessDBusService> keepAliveService(
@@ -149,7 +208,8 @@ TEST_F(TestQuery, CloseWhenSenderDies) {
 	Query::Ptr query(
 			new QueryImpl(0, "query", "keep.alive",
 					Query::EmptyBehaviour::SHOW_SUGGESTIONS, *hudService,
-					applicationList, voice, dbus.sessionConnection()));
+					applicationList, voice, parameterCache, false,
+					dbus.sessionConnection()));
 
 	EXPECT_CALL(*hudService, closeQuery(query->path())).WillOnce(
 			Invoke([this, query](const QDBusObjectPath &path) {
@@ -175,7 +235,8 @@ TEST_F(TestQuery, CloseWhenSenderDies) {
 TEST_F(TestQuery, VoiceQuery) {
 	QueryImpl query(0, "query", "keep.alive",
 			Query::EmptyBehaviour::SHOW_SUGGESTIONS, *hudService,
-			applicationList, voice, dbus.sessionConnection());
+			applicationList, voice, parameterCache, false,
+			dbus.sessionConnection());
 
 	EXPECT_CALL(*voice, listen(QList<QStringList>()
 					<< (QStringList() << "command1" << "command2"))).WillOnce(
@@ -196,6 +257,27 @@ TEST_F(TestQuery, VoiceQuery) {
 	EXPECT_EQ("", voiceQuery.toStdString());
 }
 
+TEST_F(TestQuery, ReserveLeavesMenusAlone) {
+	// a query held in reserve mustn't subscribe to the window's menus
+	EXPECT_CALL(*window, activate()).Times(0);
+
+	QueryImpl query(0, "", "keep.alive",
+			Query::EmptyBehaviour::SHOW_SUGGESTIONS, *hudService,
+			applicationList, voice, parameterCache, true,
+			dbus.sessionConnection());
+
+	// nor when the focus moves
+	Q_EMIT applicationList->focusedWindowChanged();
+	EXPECT_TRUE(query.results().isEmpty());
+	ASSERT_TRUE(Mock::VerifyAndClearExpectations(window.data()));
+
+	// the first update wakes it up, even with the same query string
+	EXPECT_CALL(*window, activate()).WillOnce(Return(windowToken));
+	EXPECT_CALL(*windowToken,
+			search(QString(""), Query::EmptyBehaviour::SHOW_SUGGESTIONS, _));
+	query.UpdateQuery("");
+}
+
 } // namespace
 
 #include "TestQuery.moc"
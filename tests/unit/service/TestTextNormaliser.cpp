@@ -0,0 +1,97 @@
+/*
+ * Copyright (C) 2016 Canonical, Ltd.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Author: Pete Woods <pete.woods@canonical.com>
+ */
+
+#include <service/TextNormaliser.h>
+
+#include <gtest/gtest.h>
+
+using namespace std;
+using namespace testing;
+using namespace hud::service;
+
+namespace {
+
+class TestTextNormaliser: public Test {
+protected:
+	QString stripMnemonic(const QString &text) {
+		QString result;
+		TextNormaliser::stripMnemonic(text, result);
+		return result;
+	}
+
+	QStringList tokenise(const QString &text) {
+		QStringList words;
+		normaliser.tokenise(text, words);
+		return words;
+	}
+
+	QStringList tokeniseKeywords(const QString &text) {
+		QStringList words;
+		normaliser.tokeniseKeywords(text, words);
+		return words;
+	}
+
+	TextNormaliser normaliser;
+};
+
+TEST_F(TestTextNormaliser, StripMnemonic) {
+	EXPECT_EQ(QString("File"), stripMnemonic("&File"));
+	EXPECT_EQ(QString("Three"), stripMnemonic("T&hree"));
+	EXPECT_EQ(QString("Save & Close"), stripMnemonic("Save && Close"));
+	EXPECT_EQ(QString("Save && Close"), stripMnemonic("Save &&& Close"));
+	EXPECT_EQ(QString("Open"), stripMnemonic("Open&"));
+	EXPECT_EQ(QString(""), stripMnemonic(""));
+}
+
+TEST_F(TestTextNormaliser, Mnemonic) {
+	EXPECT_EQ(QChar('f'), TextNormaliser::mnemonic("&File"));
+	EXPECT_EQ(QChar('h'), TextNormaliser::mnemonic("T&Hree"));
+	EXPECT_EQ(QChar('c'), TextNormaliser::mnemonic("Save && &Close"));
+	EXPECT_EQ(QChar(0), TextNormaliser::mnemonic("Save && Close"));
+	EXPECT_EQ(QChar(0), TextNormaliser::mnemonic("Open&"));
+}
+
+TEST_F(TestTextNormaliser, Tokenise) {
+	EXPECT_EQ(QStringList() << "Print" << "Preview",
+			tokenise("Print  Preview"));
+	EXPECT_EQ(QStringList() << "Keyboard" << "Shortcuts",
+			tokenise("Keyboard Shortcuts..."));
+	EXPECT_EQ(QStringList() << "Configure" << "VPN", tokenise("Configure VPN…"));
+	EXPECT_EQ(QStringList() << "PrintPreview", tokenise("Print...Preview"));
+	EXPECT_EQ(QStringList() << "a" << "b", tokenise("a ... b"));
+	EXPECT_EQ(QStringList() << "open" << "", tokenise("open "));
+	EXPECT_EQ(QStringList() << "" << "open", tokenise(" open"));
+	EXPECT_EQ(QStringList() << "", tokenise(""));
+}
+
+TEST_F(TestTextNormaliser, TokeniseKeywords) {
+	EXPECT_EQ(QStringList() << "Remove" << "Delete" << "Trash",
+			tokeniseKeywords("Remove;Delete; Trash"));
+	EXPECT_EQ(QStringList() << "More..." << "", tokeniseKeywords("More...;"));
+}
+
+TEST_F(TestTextNormaliser, Utf8) {
+	EXPECT_EQ(QString("préférences").toUtf8(),
+			QByteArray(normaliser.utf8("préférences")));
+	EXPECT_EQ(QString("aperçu").toUtf8(),
+			QByteArray(normaliser.utf8("aperçu")));
+	EXPECT_EQ(QByteArray("Print"), QByteArray(normaliser.utf8("Print")));
+	EXPECT_EQ(QByteArray(""), QByteArray(normaliser.utf8("")));
+}
+
+} // namespace
@@ -16,10 +16,12 @@
  * Author: Pete Woods <pete.woods@canonical.com>
  */
 
+#include <common/MenuTree.h>
 #include <service/Factory.h>
 #include <service/WindowImpl.h>
 #include <unit/service/Mocks.h>
 
+#include <QSignalSpy>
 #include <libqtdbustest/DBusTestRunner.h>
 #include <libqtdbusmock/DBusMock.h>
 #include <gtest/gtest.h>
@@ -106,10 +108,9 @@ TEST_F(TestWindow, ActivateOnlyWithDBusMenu) {
 	ON_CALL(*allWindowsCollector, isValid()).WillByDefault(Return(false));
 	ON_CALL(*windowCollector, isValid()).WillByDefault(Return(false));
 
-	QMenu dbusmenuWindowCollectorMenu;
 	CollectorToken::Ptr dbusmenuWindowCollectorToken(
 			new CollectorToken(dbusmenuWindowCollector,
-					&dbusmenuWindowCollectorMenu));
+					MenuTree::Ptr(new MenuTree())));
 	EXPECT_CALL(*dbusmenuWindowCollector, activate()).Times(1).WillOnce(
 			Return(QList<CollectorToken::Ptr>() << dbusmenuWindowCollectorToken));
 
@@ -125,10 +126,9 @@ TEST_F(TestWindow, ActivateOnlyWithGMenu) {
 	ON_CALL(*allWindowsCollector, isValid()).WillByDefault(Return(false));
 	ON_CALL(*windowCollector, isValid()).WillByDefault(Return(false));
 
-	QMenu gmenuWindowCollectorMenu;
 	CollectorToken::Ptr gmenuWindowCollectorToken(
 			new CollectorToken(gmenuWindowCollector,
-					&gmenuWindowCollectorMenu));
+					MenuTree::Ptr(new MenuTree())));
 	EXPECT_CALL(*gmenuWindowCollector, activate()).Times(1).WillOnce(
 			Return(QList<CollectorToken::Ptr>() << gmenuWindowCollectorToken));
 
@@ -144,9 +144,9 @@ TEST_F(TestWindow, ActivateOnlyWithValidAllWindowsContext) {
 	ON_CALL(*gmenuWindowCollector, isValid()).WillByDefault(Return(false));
 	ON_CALL(*windowCollector, isValid()).WillByDefault(Return(false));
 
-	QMenu allWindowsCollectorMenu;
 	CollectorToken::Ptr allWindowsCollectorToken(
-			new CollectorToken(allWindowsCollector, &allWindowsCollectorMenu));
+			new CollectorToken(allWindowsCollector,
+					MenuTree::Ptr(new MenuTree())));
 	EXPECT_CALL(*allWindowsCollector, activate()).Times(1).WillOnce(
 			Return(QList<CollectorToken::Ptr>() << allWindowsCollectorToken));
 
@@ -179,9 +179,9 @@ TEST_F(TestWindow, ActivateOnlyWithValidWindowContext) {
 	window->addMenu("context_1", definition);
 	window->setContext("context_1");
 
-	QMenu windowCollectorMenu;
 	CollectorToken::Ptr windowCollectorToken(
-			new CollectorToken(windowCollector, &windowCollectorMenu));
+			new CollectorToken(windowCollector,
+					MenuTree::Ptr(new MenuTree())));
 	EXPECT_CALL(*windowCollector, activate()).Times(1).WillOnce(
 			Return(QList<CollectorToken::Ptr>() << windowCollectorToken));
 
@@ -195,23 +195,21 @@ TEST_F(TestWindow, ActivateWithMultipleCollectorsThenChange) {
 
 	ON_CALL(*windowCollector, isValid()).WillByDefault(Return(false));
 
-	QMenu gmenuWindowCollectorMenu;
 	CollectorToken::Ptr gmenuWindowCollectorToken(
 			new CollectorToken(gmenuWindowCollector,
-					&gmenuWindowCollectorMenu));
+					MenuTree::Ptr(new MenuTree())));
 	EXPECT_CALL(*gmenuWindowCollector, activate()).Times(1).WillOnce(
 			Return(QList<CollectorToken::Ptr>() << gmenuWindowCollectorToken));
 
-	QMenu dbusmenuWindowCollectorMenu;
 	CollectorToken::Ptr dbusmenuWindowCollectorToken(
 			new CollectorToken(dbusmenuWindowCollector,
-					&dbusmenuWindowCollectorMenu));
+					MenuTree::Ptr(new MenuTree())));
 	EXPECT_CALL(*dbusmenuWindowCollector, activate()).Times(1).WillOnce(
 			Return(QList<CollectorToken::Ptr>() << dbusmenuWindowCollectorToken));
 
-	QMenu allWindowsCollectorMenu;
 	CollectorToken::Ptr allWindowsCollectorToken(
-			new CollectorToken(allWindowsCollector, &allWindowsCollectorMenu));
+			new CollectorToken(allWindowsCollector,
+					MenuTree::Ptr(new MenuTree())));
 	EXPECT_CALL(*allWindowsCollector, activate()).Times(1).WillOnce(
 			Return(QList<CollectorToken::Ptr>() << allWindowsCollectorToken));
 	ON_CALL(*allWindowsContext, activeCollector()).WillByDefault(
@@ -224,10 +222,9 @@ TEST_F(TestWindow, ActivateWithMultipleCollectorsThenChange) {
 			token->tokens());
 
 	// The gmenu window collector is going to give a different token now
-	QMenu gmenuWindowCollectorMenuChanged;
 	CollectorToken::Ptr gmenuWindowCollectorTokenChanged(
 			new CollectorToken(gmenuWindowCollector,
-					&gmenuWindowCollectorMenuChanged));
+					MenuTree::Ptr(new MenuTree())));
 	EXPECT_CALL(*gmenuWindowCollector, activate()).Times(1).WillOnce(
 			Return(QList<CollectorToken::Ptr>() << gmenuWindowCollectorTokenChanged));
 
@@ -269,4 +266,36 @@ TEST_F(TestWindow, Context) {
 	EXPECT_EQ(windowCollector, context.activeCollector());
 }
 
+TEST_F(TestWindow, ContextDiffsAndRemovesMenus) {
+	WindowContextImpl context(factory);
+	QSignalSpy contextChangedSpy(&context, SIGNAL(contextChanged()));
+
+	WindowContext::MenuDefinition definition("bus.name");
+	definition.actionPath = QDBusObjectPath("/action/path");
+	definition.actionPrefix = "hud";
+	definition.menuPath = QDBusObjectPath("/menu/path");
+
+	QMap<QString, QDBusObjectPath> actions;
+	actions[definition.actionPrefix] = definition.actionPath;
+
+	// Sending the same definition again doesn't import it again
+	EXPECT_CALL(factory, newGMenuCollector(definition.name, actions, definition.menuPath)).Times(
+			1).WillOnce(Return(windowCollector));
+
+	context.setContext("context_1");
+	context.addMenu("context_1", definition);
+	context.addMenu("context_1", definition);
+
+	EXPECT_EQ(windowCollector, context.activeCollector());
+	EXPECT_EQ(2, contextChangedSpy.size());
+
+	context.removeMenu("context_2");
+	EXPECT_EQ(windowCollector, context.activeCollector());
+	EXPECT_EQ(2, contextChangedSpy.size());
+
+	context.removeMenu("context_1");
+	EXPECT_FALSE(context.activeCollector());
+	EXPECT_EQ(3, contextChangedSpy.size());
+}
+
 } // namespace
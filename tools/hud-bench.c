@@ -0,0 +1,525 @@
+/*
+Replays typed queries against the running HUD and reports how long the
+results take to arrive
+
+Copyright 2016 Canonical Ltd.
+
+Authors:
+    Pete Woods <pete.woods@canonical.com>
+
+This program is free software: you can redistribute it and/or modify it
+under the terms of the GNU General Public License version 3, as published
+by the Free Software Foundation.
+
+This program is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranties of
+MERCHANTABILITY, SATISFACTORY QUALITY, or FITNESS FOR A PARTICULAR
+PURPOSE.  See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <glib.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <hud-client.h>
+
+/* How long to wait for the results of the last keystroke, once the
+   service has replied, in case they don't change the model at all */
+#define SETTLE_MS 1000
+
+/* One keystroke, and when each stage of its results arrived.  The
+   stages are zero until they happen; keystrokes the client coalesced
+   into a later one never get a reply. */
+typedef struct {
+	gchar * query;
+	gint64 typed;
+	gint64 replied;
+	gint64 first_row;
+	gint64 last_row;
+} Sample;
+
+typedef struct {
+	HudClientQuery * query;
+	DeeModel * results;
+	gulong row_added;
+	gulong end_transaction;
+
+	GMainLoop * loop;
+
+	/* The script, and where we've typed up to */
+	gchar ** lines;
+	guint line;
+	guint length;
+
+	/* The timeout that types the next keystroke, if there is one */
+	guint typing;
+
+	gdouble cps;
+	GPtrArray * samples;
+	gint64 started;
+	gint64 finished;
+
+	/* The sample the transaction being applied to the model belongs to */
+	Sample * receiving;
+
+	gboolean timed_out;
+} Bench;
+
+static gint cps_count = 0;
+static gdouble cps_list[32];
+static gint pause_ms = 1000;
+static gint timeout_s = 60;
+static gboolean whole_lines = FALSE;
+
+static void sample_free (gpointer data);
+static void connect_results (Bench * bench);
+static void results_updated (HudClientQuery * query, const gchar * string, gint revision, gpointer user_data);
+static gboolean type_next (gpointer user_data);
+static gboolean models_timeout (gpointer user_data);
+static gboolean check_settled (gpointer user_data);
+static void print_run (Bench * bench, gboolean last);
+
+static gboolean
+parse_cps (G_GNUC_UNUSED const gchar * name, const gchar * value, G_GNUC_UNUSED gpointer data, GError ** error)
+{
+	gchar ** speeds = g_strsplit(value, ",", -1);
+	gint i;
+
+	for (i = 0; speeds[i] != NULL; i++) {
+		gdouble cps = g_ascii_strtod(speeds[i], NULL);
+		if (cps <= 0.0 || (guint)cps_count == G_N_ELEMENTS(cps_list)) {
+			g_set_error(error, G_OPTION_ERROR, G_OPTION_ERROR_BAD_VALUE, "Invalid typing speed: %s", speeds[i]);
+			g_strfreev(speeds);
+			return FALSE;
+		}
+		cps_list[cps_count++] = cps;
+	}
+
+	g_strfreev(speeds);
+	return TRUE;
+}
+
+static GOptionEntry entries[] = {
+	{ "cps", 'c', 0, G_OPTION_ARG_CALLBACK, parse_cps, "Typing speeds to replay at, in characters per second (default 10)", "N[,N...]" },
+	{ "pause", 'p', 0, G_OPTION_ARG_INT, &pause_ms, "Pause between queries, in milliseconds (default 1000)", "MS" },
+	{ "timeout", 't', 0, G_OPTION_ARG_INT, &timeout_s, "Give up waiting for the last query's results after this many seconds (default 60)", "S" },
+	{ "whole-lines", 'w', 0, G_OPTION_ARG_NONE, &whole_lines, "Send each query in one go, rather than a character at a time", NULL },
+	{ NULL }
+};
+
+int
+main (int argc, char *argv[])
+{
+#ifndef GLIB_VERSION_2_36
+	g_type_init ();
+#endif
+
+	GError * error = NULL;
+	GOptionContext * context = g_option_context_new("[SCRIPT] - measure HUD query latency");
+	g_option_context_set_description(context,
+		"SCRIPT has one query per line, and lines starting with '#' are skipped.\n"
+		"It's read from standard input if it's missing or '-'.  The results\n"
+		"are written to standard output as JSON.");
+	g_option_context_add_main_entries(context, entries, NULL);
+
+	if (!g_option_context_parse(context, &argc, &argv, &error)) {
+		g_printerr("%s\n", error->message);
+		g_error_free(error);
+		g_option_context_free(context);
+		return 1;
+	}
+	g_option_context_free(context);
+
+	if (cps_count == 0) {
+		cps_list[cps_count++] = 10.0;
+	}
+
+	/* Read the script */
+	gchar * contents = NULL;
+	if (argc < 2 || g_strcmp0(argv[1], "-") == 0) {
+		GString * input = g_string_new(NULL);
+		gchar buffer[4096];
+		size_t read;
+		while ((read = fread(buffer, 1, sizeof(buffer), stdin)) > 0) {
+			g_string_append_len(input, buffer, read);
+		}
+		contents = g_string_free(input, FALSE);
+	} else if (!g_file_get_contents(argv[1], &contents, NULL, &error)) {
+		g_printerr("Unable to read script: %s\n", error->message);
+		g_error_free(error);
+		return 1;
+	}
+
+	GPtrArray * lines = g_ptr_array_new();
+	gchar ** split = g_strsplit(contents, "\n", -1);
+	gint i;
+	for (i = 0; split[i] != NULL; i++) {
+		gchar * line = g_strstrip(split[i]);
+		if (line[0] != '\0' && line[0] != '#') {
+			g_ptr_array_add(lines, g_strdup(line));
+		}
+	}
+	g_ptr_array_add(lines, NULL);
+	g_strfreev(split);
+	g_free(contents);
+
+	Bench bench = { 0 };
+	bench.lines = (gchar **)g_ptr_array_free(lines, FALSE);
+	bench.loop = g_main_loop_new(NULL, FALSE);
+
+	if (bench.lines[0] == NULL) {
+		g_printerr("The script doesn't have any queries\n");
+		g_strfreev(bench.lines);
+		return 1;
+	}
+
+	/* Get a query going, and wait for its models */
+	bench.query = hud_client_query_new("");
+	gulong models = g_signal_connect_swapped(bench.query, HUD_CLIENT_QUERY_SIGNAL_MODELS_CHANGED, G_CALLBACK(g_main_loop_quit), bench.loop);
+	guint models_timer = g_timeout_add_seconds(timeout_s, models_timeout, &bench);
+	g_main_loop_run(bench.loop);
+	g_signal_handler_disconnect(bench.query, models);
+
+	if (bench.timed_out) {
+		g_printerr("Timed out waiting for the HUD service\n");
+		g_clear_object(&bench.query);
+		g_main_loop_unref(bench.loop);
+		g_strfreev(bench.lines);
+		return 1;
+	}
+	g_source_remove(models_timer);
+
+	g_signal_connect_swapped(bench.query, HUD_CLIENT_QUERY_SIGNAL_MODELS_CHANGED, G_CALLBACK(connect_results), &bench);
+	g_signal_connect(bench.query, HUD_CLIENT_QUERY_SIGNAL_RESULTS_UPDATED, G_CALLBACK(results_updated), &bench);
+	connect_results(&bench);
+
+	printf("{\n  \"queries\": %u,\n  \"whole_lines\": %s,\n  \"runs\": [\n", g_strv_length(bench.lines), whole_lines ? "true" : "false");
+
+	for (i = 0; i < cps_count; i++) {
+		bench.cps = cps_list[i];
+		bench.samples = g_ptr_array_new_with_free_func(sample_free);
+		bench.line = 0;
+		bench.length = 0;
+		bench.receiving = NULL;
+		bench.started = g_get_monotonic_time();
+		bench.finished = 0;
+		bench.timed_out = FALSE;
+
+		type_next(&bench);
+		guint settled = g_timeout_add(50, check_settled, &bench);
+		g_main_loop_run(bench.loop);
+		g_source_remove(settled);
+
+		/* Don't let this run's typing carry on into the next one */
+		if (bench.typing != 0) {
+			g_source_remove(bench.typing);
+			bench.typing = 0;
+		}
+
+		print_run(&bench, i + 1 == cps_count);
+
+		g_ptr_array_unref(bench.samples);
+		bench.samples = NULL;
+	}
+
+	printf("  ]\n}\n");
+
+	if (bench.results != NULL) {
+		g_signal_handler_disconnect(bench.results, bench.row_added);
+		g_signal_handler_disconnect(bench.results, bench.end_transaction);
+		g_clear_object(&bench.results);
+	}
+	g_clear_object(&bench.query);
+	g_main_loop_unref(bench.loop);
+	g_strfreev(bench.lines);
+
+	return 0;
+}
+
+static void
+sample_free (gpointer data)
+{
+	Sample * sample = (Sample *)data;
+	g_free(sample->query);
+	g_free(sample);
+	return;
+}
+
+static void
+results_updated (G_GNUC_UNUSED HudClientQuery * query, const gchar * string, G_GNUC_UNUSED gint revision, gpointer user_data)
+{
+	Bench * bench = (Bench *)user_data;
+	if (bench->samples == NULL) {
+		return;
+	}
+
+	/* Older keystrokes with the same string were coalesced into this one */
+	guint i;
+	for (i = bench->samples->len; i > 0; i--) {
+		Sample * sample = g_ptr_array_index(bench->samples, i - 1);
+		if (sample->replied == 0 && g_strcmp0(sample->query, string) == 0) {
+			sample->replied = g_get_monotonic_time();
+			break;
+		}
+	}
+
+	return;
+}
+
+/* Works out which keystroke some rows are for.  The service flushes the
+   model once it has replied, so it's the newest answered keystroke still
+   waiting for its rows; if the rows beat the reply here, it's the newest
+   keystroke of all. */
+static Sample *
+rows_owner (Bench * bench)
+{
+	Sample * newest = NULL;
+	guint i;
+
+	for (i = bench->samples->len; i > 0; i--) {
+		Sample * sample = g_ptr_array_index(bench->samples, i - 1);
+
+		/* Everything older has had its results already */
+		if (sample->last_row != 0) {
+			break;
+		}
+
+		if (newest == NULL) {
+			newest = sample;
+		}
+		if (sample->replied != 0) {
+			return sample;
+		}
+	}
+
+	return newest;
+}
+
+static void
+row_added (G_GNUC_UNUSED DeeModel * model, G_GNUC_UNUSED DeeModelIter * iter, gpointer user_data)
+{
+	Bench * bench = (Bench *)user_data;
+	if (bench->samples == NULL || bench->receiving != NULL) {
+		return;
+	}
+
+	bench->receiving = rows_owner(bench);
+	if (bench->receiving != NULL && bench->receiving->first_row == 0) {
+		bench->receiving->first_row = g_get_monotonic_time();
+	}
+
+	return;
+}
+
+static void
+end_transaction (G_GNUC_UNUSED DeeSharedModel * model, G_GNUC_UNUSED guint64 begin_seqnum, G_GNUC_UNUSED guint64 end_seqnum, gpointer user_data)
+{
+	Bench * bench = (Bench *)user_data;
+	if (bench->samples == NULL) {
+		return;
+	}
+
+	/* A transaction without any rows still finishes a keystroke's results */
+	Sample * sample = bench->receiving != NULL ? bench->receiving : rows_owner(bench);
+	bench->receiving = NULL;
+
+	if (sample != NULL) {
+		sample->last_row = g_get_monotonic_time();
+	}
+
+	return;
+}
+
+/* Follows the results model, which is replaced if the service restarts */
+static void
+connect_results (Bench * bench)
+{
+	if (bench->results != NULL) {
+		g_signal_handler_disconnect(bench->results, bench->row_added);
+		g_signal_handler_disconnect(bench->results, bench->end_transaction);
+		g_clear_object(&bench->results);
+	}
+
+	DeeModel * results = hud_client_query_get_results_model(bench->query);
+	if (results == NULL) {
+		return;
+	}
+
+	bench->results = g_object_ref(results);
+	bench->row_added = g_signal_connect(results, "row-added", G_CALLBACK(row_added), bench);
+	bench->end_transaction = g_signal_connect(results, "end-transaction", G_CALLBACK(end_transaction), bench);
+	bench->receiving = NULL;
+
+	return;
+}
+
+/* Gives up on a service that never sends the query's models */
+static gboolean
+models_timeout (gpointer user_data)
+{
+	Bench * bench = (Bench *)user_data;
+	bench->timed_out = TRUE;
+	g_main_loop_quit(bench->loop);
+	return G_SOURCE_REMOVE;
+}
+
+/* Types the next character of the script, or the whole of the next line */
+static gboolean
+type_next (gpointer user_data)
+{
+	Bench * bench = (Bench *)user_data;
+	const gchar * line = bench->lines[bench->line];
+	bench->typing = 0;
+
+	if (line == NULL) {
+		return G_SOURCE_REMOVE;
+	}
+
+	guint chars = g_utf8_strlen(line, -1);
+	bench->length = whole_lines ? chars : bench->length + 1;
+
+	Sample * sample = g_new0(Sample, 1);
+	sample->query = g_utf8_substring(line, 0, bench->length);
+	sample->typed = g_get_monotonic_time();
+	g_ptr_array_add(bench->samples, sample);
+
+	hud_client_query_set_query_async(bench->query, sample->query, NULL);
+
+	guint interval = 1000.0 / bench->cps;
+	if (bench->length == chars) {
+		bench->line++;
+		bench->length = 0;
+		interval = pause_ms;
+	}
+
+	/* The run ends once the last line's results are in */
+	if (bench->lines[bench->line] != NULL) {
+		bench->typing = g_timeout_add(interval, type_next, bench);
+	}
+
+	return G_SOURCE_REMOVE;
+}
+
+/* Ends the run once the last keystroke's results are in */
+static gboolean
+check_settled (gpointer user_data)
+{
+	Bench * bench = (Bench *)user_data;
+
+	if (bench->lines[bench->line] != NULL || bench->samples->len == 0) {
+		return G_SOURCE_CONTINUE;
+	}
+
+	gint64 now = g_get_monotonic_time();
+	Sample * last = g_ptr_array_index(bench->samples, bench->samples->len - 1);
+
+	if (now - last->typed > (gint64)timeout_s * G_USEC_PER_SEC) {
+		g_printerr("Timed out waiting for results at %g characters per second\n", bench->cps);
+		bench->timed_out = TRUE;
+		bench->finished = now;
+		g_main_loop_quit(bench->loop);
+		return G_SOURCE_CONTINUE;
+	}
+
+	if (last->replied == 0) {
+		return G_SOURCE_CONTINUE;
+	}
+
+	/* The results might not have changed the model at all */
+	if (last->last_row == 0 && now - last->replied < SETTLE_MS * 1000) {
+		return G_SOURCE_CONTINUE;
+	}
+
+	bench->finished = MAX(last->replied, last->last_row);
+	g_main_loop_quit(bench->loop);
+
+	return G_SOURCE_CONTINUE;
+}
+
+static gint
+compare_doubles (gconstpointer a, gconstpointer b)
+{
+	gdouble x = *(const gdouble *)a;
+	gdouble y = *(const gdouble *)b;
+	return (x > y) - (x < y);
+}
+
+/* Nearest rank, so every figure is one that was really measured */
+static gdouble
+percentile (GArray * sorted, guint p)
+{
+	guint rank = (p * sorted->len + 99) / 100;
+	return g_array_index(sorted, gdouble, rank > 0 ? rank - 1 : 0);
+}
+
+static void
+print_stage (const gchar * name, GArray * values, gboolean last)
+{
+	if (values->len == 0) {
+		printf("      \"%s\": { \"count\": 0, \"p50\": null, \"p95\": null, \"p99\": null, \"max\": null }%s\n", name, last ? "" : ",");
+		return;
+	}
+
+	g_array_sort(values, compare_doubles);
+	printf("      \"%s\": { \"count\": %u, \"p50\": %.3f, \"p95\": %.3f, \"p99\": %.3f, \"max\": %.3f }%s\n",
+		name, values->len,
+		percentile(values, 50), percentile(values, 95), percentile(values, 99),
+		g_array_index(values, gdouble, values->len - 1),
+		last ? "" : ",");
+
+	return;
+}
+
+static void
+add_stage (GArray * values, gint64 from, gint64 to)
+{
+	if (to != 0) {
+		gdouble ms = (to - from) / 1000.0;
+		g_array_append_val(values, ms);
+	}
+	return;
+}
+
+static void
+print_run (Bench * bench, gboolean last)
+{
+	GArray * replies = g_array_new(FALSE, FALSE, sizeof(gdouble));
+	GArray * first_rows = g_array_new(FALSE, FALSE, sizeof(gdouble));
+	GArray * last_rows = g_array_new(FALSE, FALSE, sizeof(gdouble));
+	guint coalesced = 0;
+	guint i;
+
+	for (i = 0; i < bench->samples->len; i++) {
+		Sample * sample = g_ptr_array_index(bench->samples, i);
+		if (sample->replied == 0) {
+			coalesced++;
+		}
+		add_stage(replies, sample->typed, sample->replied);
+		add_stage(first_rows, sample->typed, sample->first_row);
+		add_stage(last_rows, sample->typed, sample->last_row);
+	}
+
+	gdouble duration = (bench->finished - bench->started) / (gdouble)G_USEC_PER_SEC;
+
+	printf("    {\n");
+	printf("      \"cps\": %g,\n", bench->cps);
+	printf("      \"keystrokes\": %u,\n", bench->samples->len);
+	printf("      \"coalesced\": %u,\n", coalesced);
+	printf("      \"timed_out\": %s,\n", bench->timed_out ? "true" : "false");
+	printf("      \"duration_s\": %.3f,\n", duration);
+	printf("      \"keystrokes_per_s\": %.3f,\n", bench->samples->len / duration);
+	printf("      \"updates_per_s\": %.3f,\n", replies->len / duration);
+	print_stage("update_reply_ms", replies, FALSE);
+	print_stage("first_row_ms", first_rows, FALSE);
+	print_stage("last_row_ms", last_rows, TRUE);
+	printf("    }%s\n", last ? "" : ",");
+
+	g_array_free(replies, TRUE);
+	g_array_free(first_rows, TRUE);
+	g_array_free(last_rows, TRUE);
+
+	return;
+}